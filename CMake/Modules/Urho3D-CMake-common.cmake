@@ -127,6 +127,7 @@ if (CMAKE_PROJECT_NAME STREQUAL Urho3D)
     mark_as_advanced (URHO3D_UPDATE_SOURCE_TREE URHO3D_BINDINGS URHO3D_CLANG_TOOLS)
     cmake_dependent_option (URHO3D_TOOLS "Build tools (native and RPI only)" TRUE "NOT IOS AND NOT ANDROID AND NOT EMSCRIPTEN" FALSE)
     cmake_dependent_option (URHO3D_EXTRAS "Build extras (native and RPI only)" FALSE "NOT IOS AND NOT ANDROID AND NOT EMSCRIPTEN" FALSE)
+    cmake_dependent_option (URHO3D_BENCHMARKS "Build micro-benchmarks (native and RPI only)" FALSE "NOT IOS AND NOT ANDROID AND NOT EMSCRIPTEN" FALSE)
     option (URHO3D_DOCS "Generate documentation as part of normal build")
     option (URHO3D_DOCS_QUIET "Generate documentation as part of normal build, suppress generation process from sending anything to stdout")
     option (URHO3D_PCH "Enable PCH support" TRUE)
@@ -146,6 +147,7 @@ endif ()
 option (URHO3D_PACKAGING "Enable resources packaging support, on Emscripten default to 1, on other platforms default to 0" ${EMSCRIPTEN})
 option (URHO3D_PROFILING "Enable profiling support" TRUE)
 option (URHO3D_LOGGING "Enable logging support" TRUE)
+option (URHO3D_TRACK_MEMORY "Enable heap allocation tracking per memory category")
 # Emscripten thread support is yet experimental; default false
 if (NOT EMSCRIPTEN)
     option (URHO3D_THREADING "Enable threading support" TRUE)
@@ -365,6 +367,11 @@ if (URHO3D_LOGGING)
     add_definitions (-DURHO3D_LOGGING)
 endif ()
 
+# Enable heap allocation tracking. If enabled, the global allocation operators are replaced and the MemoryTracker subsystem is instantiated.
+if (URHO3D_TRACK_MEMORY)
+    add_definitions (-DURHO3D_TRACK_MEMORY)
+endif ()
+
 # Enable threading by default, except for Emscripten.
 if (URHO3D_THREADING)
     add_definitions (-DURHO3D_THREADING)
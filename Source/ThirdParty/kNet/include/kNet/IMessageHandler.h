@@ -53,6 +53,13 @@ public:
 		// The default behavior is to not have a content ID on any message.
 		return 0;
 	}
+
+	// Urho3D: notify of connection state changes
+	/// Called by the network library when the state of the connection has changed. May be called from the worker thread,
+	/// so the implementation must only signal the main thread to check the new state with MessageConnection::GetConnectionState().
+	virtual void ConnectionStateChanged(MessageConnection * UNUSED(source))
+	{
+	}
 };
 
 } // ~kNet
@@ -495,6 +495,10 @@ protected:
 	/// Specifies the current connection state.
 	ConnectionState connectionState; // [main and worker thread]
 
+	// Urho3D: set the connection state and notify the inbound message handler, so that it does not need to poll the state
+	/// Sets the current connection state.
+	void SetConnectionState(ConnectionState state); // [main and worker thread]
+
 	/// If true, all sends to the socket are on hold, until ResumeOutboundSends() is called.
 	bool bOutboundSendsPaused; // [set by main thread, read by worker thread]
 
@@ -264,7 +264,7 @@ void MessageConnection::Close(int maxMSecsToWait) // [main thread]
 		socket = 0; // Worker thread assumes access to the socket pointer, so can't have the thread running any more when we are doing this.
 	}
 
-	connectionState = ConnectionClosed;
+	SetConnectionState(ConnectionClosed);
 
 	if (outboundAcceptQueue.Size() > 0)
 		KNET_LOG(LogVerbose, "MessageConnection::Close(): Had %d messages in outboundAcceptQueue!", (int)outboundAcceptQueue.Size());
@@ -309,13 +309,13 @@ void MessageConnection::SetPeerClosed()
 	{
 	case ConnectionPending:
 		KNET_LOG(LogVerbose, "Peer closed connection when in ConnectionPending state!"); 
-		connectionState = ConnectionClosed; // Just tear it down, the peer rejected the connection.
+		SetConnectionState(ConnectionClosed); // Just tear it down, the peer rejected the connection.
 		break;
 	case ConnectionOK:
-		connectionState = ConnectionPeerClosed;
+		SetConnectionState(ConnectionPeerClosed);
 		break;
 	case ConnectionDisconnecting:
-		connectionState = ConnectionClosed;
+		SetConnectionState(ConnectionClosed);
 		break;
 	case ConnectionPeerClosed:
 	case ConnectionClosed:
@@ -382,7 +382,7 @@ void MessageConnection::DetectConnectionTimeOut()
 	{
 		KNET_LOG(LogInfo, "It's been %.2fms since last heard from other end. connectionLostTimeout=%.2fms, so closing connection.",
 			lastHeardSince, connectionLostTimeout);
-		connectionState = ConnectionClosed;
+		SetConnectionState(ConnectionClosed);
 	}
 }
 
@@ -756,7 +756,7 @@ void MessageConnection::Process(int maxMessagesToProcess)
 	{
 		if (socket)
 			Close(); ///\todo This will block, since it is called with the default time period.
-		connectionState = ConnectionClosed;
+		SetConnectionState(ConnectionClosed);
 		return;
 	}
 
@@ -1110,6 +1110,19 @@ void MessageConnection::SetMaximumDataSendRate(int /*numBytesPerSec*/, int /*num
 {
 }
 
+void MessageConnection::SetConnectionState(ConnectionState state)
+{
+	if (connectionState == state)
+		return;
+
+	connectionState = state;
+
+	// Urho3D: notify of the state change
+	IMessageHandler *handler = inboundMessageHandler;
+	if (handler)
+		handler->ConnectionStateChanged(this);
+}
+
 void MessageConnection::RegisterInboundMessageHandler(IMessageHandler *handler)
 { 
 	AssertInMainThreadContext();
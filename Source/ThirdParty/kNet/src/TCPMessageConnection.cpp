@@ -168,9 +168,9 @@ MessageConnection::PacketSendResult TCPMessageConnection::SendOutPacket()
 	{
 		KNET_LOG(LogVerbose, "TCPMessageConnection::SendOutPacket: Socket is not write open %p!", socket);
 		if (connectionState == ConnectionOK) ///\todo This is slightly annoying to manually update the state here,
-			connectionState = ConnectionPeerClosed; /// reorganize to be able to have this automatically apply.
+			SetConnectionState(ConnectionPeerClosed); /// reorganize to be able to have this automatically apply.
 		if (connectionState == ConnectionDisconnecting)
-			connectionState = ConnectionClosed;
+			SetConnectionState(ConnectionClosed);
 		return PacketSendSocketClosed;
 	}
 
@@ -357,7 +357,7 @@ void TCPMessageConnection::ExtractMessages()
 		KNET_LOG(LogError, "TCPMessageConnection::ExtractMessages() caught a network exception: \"%s\"!", e.what());
 		if (socket)
 			socket->Close();
-		connectionState = ConnectionClosed;
+		SetConnectionState(ConnectionClosed);
 	}
 }
 
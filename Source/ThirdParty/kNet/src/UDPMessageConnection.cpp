@@ -138,7 +138,7 @@ UDPMessageConnection::SocketReadResult UDPMessageConnection::ReadSocket(size_t &
 	///\todo Replace with ConnectSyn,ConnectSynAck and ConnectAck.
 	if (bytesRead > 0 && connectionState == ConnectionPending)
 	{
-		connectionState = ConnectionOK;
+		SetConnectionState(ConnectionOK);
 		KNET_LOG(LogUser, "UDPMessageConnection::ReadSocket: Received data from socket %s. Transitioned from ConnectionPending to ConnectionOK state.", 
 			(socket ? socket->ToString().c_str() : "(null)"));
 	}
@@ -630,9 +630,9 @@ MessageConnection::PacketSendResult UDPMessageConnection::SendOutPacket()
 	if (sentDisconnectMessage)
 	{
 		if (connectionState != ConnectionClosed && connectionState != ConnectionPeerClosed)
-			connectionState = ConnectionDisconnecting;
+			SetConnectionState(ConnectionDisconnecting);
 		if (connectionState == ConnectionPeerClosed)
-			connectionState = ConnectionClosed;
+			SetConnectionState(ConnectionClosed);
 		if (socket)
 			socket->MarkWriteClosed();
 		KNET_LOG(LogInfo, "UDPMessageConnection::SendOutPacket: Send Disconnect from connection %s.", ToString().c_str());
@@ -645,7 +645,7 @@ MessageConnection::PacketSendResult UDPMessageConnection::SendOutPacket()
 			socket->MarkReadClosed();
 			socket->MarkWriteClosed();
 		}
-		connectionState = ConnectionClosed;
+		SetConnectionState(ConnectionClosed);
 		KNET_LOG(LogInfo, "UDPMessageConnection::SendOutPacket: Send DisconnectAck from connection %s.", ToString().c_str());
 	}
 
@@ -1160,7 +1160,7 @@ void UDPMessageConnection::HandleDisconnectMessage()
 	AssertInWorkerThreadContext();
 
 	if (connectionState != ConnectionClosed)
-		connectionState = ConnectionDisconnecting;
+		SetConnectionState(ConnectionDisconnecting);
 	else
 		KNET_LOG(LogError, "UDPMessageConnection::HandleDisconnectMessage: Received Disconnect message when in ConnectionClosed state!");
 
@@ -1187,7 +1187,7 @@ void UDPMessageConnection::HandleDisconnectAckMessage()
 	else
 		KNET_LOG(LogInfo, "UDPMessageConnection::HandleDisconnectAckMessage: Connection closed to %s.", ToString().c_str());
 
-	connectionState = ConnectionClosed;
+	SetConnectionState(ConnectionClosed);
 }
 
 void UDPMessageConnection::ComputePacketLoss()
@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+
+#include "Benchmark.h"
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <cstdio>
+
+#include <Urho3D/DebugNew.h>
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+static unsigned checksum = 0;
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    // Skip options such as the -timeout passed when run as a test
+    Vector<String> positional;
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].StartsWith("-"))
+            ++i;
+        else
+            positional.Push(arguments[i]);
+    }
+
+    String group = positional.Size() > 0 ? positional[0].ToLower() : String("all");
+    unsigned scale = positional.Size() > 1 ? ToUInt(positional[1]) : 1;
+    if (!scale)
+        ErrorExit("Usage: Benchmark [group] [scale]\nGroups: all container string occlusion replication workqueue\n");
+
+    // The time subsystem sets up the high-resolution timer
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+
+    bool found = false;
+    if (group == "all" || group == "container")
+    {
+        RunContainerBenchmarks(scale);
+        found = true;
+    }
+    if (group == "all" || group == "string")
+    {
+        RunStringBenchmarks(scale);
+        found = true;
+    }
+    if (group == "all" || group == "occlusion")
+    {
+        RunOcclusionBenchmarks(scale);
+        found = true;
+    }
+    if (group == "all" || group == "replication")
+    {
+        RunReplicationBenchmarks(scale);
+        found = true;
+    }
+    if (group == "all" || group == "workqueue")
+    {
+        RunWorkQueueBenchmarks(scale);
+        found = true;
+    }
+
+    if (!found)
+        ErrorExit("Unknown benchmark group " + group);
+
+    // Print the accumulated checksum so that the compiler has to keep all benchmarked work
+    PrintLine("\nChecksum " + String(checksum));
+}
+
+void RunBenchmark(const String& name, BenchmarkFunction function, unsigned count)
+{
+    // Warm up caches and allocators with one untimed repetition
+    checksum += function(1);
+
+    HiresTimer timer;
+    checksum += function(count);
+    long long usec = timer.GetUSec(false);
+
+    char line[256];
+    sprintf(line, "%-48s %10.3f us", name.CString(), (double)usec / (double)count);
+    PrintLine(line);
+}
+
+void PrintBenchmarkResult(const String& name, double value, const char* unit)
+{
+    char line[256];
+    sprintf(line, "%-48s %10.3f %s", name.CString(), value, unit);
+    PrintLine(line);
+}
+
+void PrintBenchmarkGroup(const String& name)
+{
+    PrintLine("\n" + name);
+}
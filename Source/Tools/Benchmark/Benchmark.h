@@ -0,0 +1,48 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/Str.h>
+
+using namespace Urho3D;
+
+/// Benchmark function. Performs the measured work count times and returns a checksum so that the work cannot be optimized away.
+typedef unsigned (*BenchmarkFunction)(unsigned count);
+
+/// Time a benchmark function over count repetitions and print the time per repetition.
+void RunBenchmark(const String& name, BenchmarkFunction function, unsigned count);
+/// Print a benchmark result that is not a time measurement.
+void PrintBenchmarkResult(const String& name, double value, const char* unit);
+/// Print a benchmark group heading.
+void PrintBenchmarkGroup(const String& name);
+
+/// Run the hash container benchmarks.
+void RunContainerBenchmarks(unsigned scale);
+/// Run the string benchmarks.
+void RunStringBenchmarks(unsigned scale);
+/// Run the occlusion buffer rasterization benchmarks.
+void RunOcclusionBenchmarks(unsigned scale);
+/// Run the scene replication bandwidth benchmarks.
+void RunReplicationBenchmarks(unsigned scale);
+/// Run the work queue parallel reduction checks and benchmarks.
+void RunWorkQueueBenchmarks(unsigned scale);
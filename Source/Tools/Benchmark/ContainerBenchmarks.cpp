@@ -0,0 +1,203 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Container/FlatHashMap.h>
+#include <Urho3D/Container/FlatHashSet.h>
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/Math/Random.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+static const unsigned MAX_KEYS = 65536;
+
+static PODVector<unsigned> keys;
+static PODVector<unsigned> missingKeys;
+static PODVector<unsigned> pointerTargets;
+
+static void InitializeKeys()
+{
+    if (!keys.Empty())
+        return;
+
+    // Random keys to insert, and a second random sequence that is very unlikely to hit any of them
+    SetRandomSeed(1);
+    keys.Resize(MAX_KEYS);
+    missingKeys.Resize(MAX_KEYS);
+    for (unsigned i = 0; i < MAX_KEYS; ++i)
+        keys[i] = (unsigned)Rand() << 16 | (unsigned)Rand();
+    for (unsigned i = 0; i < MAX_KEYS; ++i)
+        missingKeys[i] = (unsigned)Rand() << 16 | (unsigned)Rand();
+
+    pointerTargets.Resize(MAX_KEYS);
+}
+
+/// Fill a map that is cleared and reused on each repetition, like the per-frame batch maps.
+template <class MapType, unsigned N> unsigned InsertReused(unsigned count)
+{
+    static MapType map;
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        map.Clear();
+        for (unsigned j = 0; j < N; ++j)
+            map[keys[j]] = j;
+        result += map.Size();
+    }
+    return result;
+}
+
+/// Fill a newly constructed map on each repetition.
+template <class MapType, unsigned N> unsigned InsertNew(unsigned count)
+{
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        MapType map;
+        for (unsigned j = 0; j < N; ++j)
+            map[keys[j]] = j;
+        result += map.Size();
+    }
+    return result;
+}
+
+/// Look up keys that exist in the map.
+template <class MapType, unsigned N> unsigned FindHit(unsigned count)
+{
+    static MapType map;
+    if (map.Empty())
+    {
+        for (unsigned j = 0; j < N; ++j)
+            map[keys[j]] = j;
+    }
+
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        for (unsigned j = 0; j < N; ++j)
+            result += map.Find(keys[j])->second_;
+    }
+    return result;
+}
+
+/// Look up keys that do not exist in the map.
+template <class MapType, unsigned N> unsigned FindMiss(unsigned count)
+{
+    static MapType map;
+    if (map.Empty())
+    {
+        for (unsigned j = 0; j < N; ++j)
+            map[keys[j]] = j;
+    }
+
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        for (unsigned j = 0; j < N; ++j)
+            result += map.Contains(missingKeys[j]) ? 1 : 0;
+    }
+    return result;
+}
+
+/// Iterate over all pairs.
+template <class MapType, unsigned N> unsigned Iterate(unsigned count)
+{
+    static MapType map;
+    if (map.Empty())
+    {
+        for (unsigned j = 0; j < N; ++j)
+            map[keys[j]] = j;
+    }
+
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        for (typename MapType::ConstIterator j = map.Begin(); j != map.End(); ++j)
+            result += j->second_;
+    }
+    return result;
+}
+
+/// Fill a map, then erase all keys.
+template <class MapType, unsigned N> unsigned InsertErase(unsigned count)
+{
+    static MapType map;
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        for (unsigned j = 0; j < N; ++j)
+            map[keys[j]] = j;
+        for (unsigned j = 0; j < N; ++j)
+            result += map.Erase(keys[j]) ? 1 : 0;
+    }
+    return result;
+}
+
+/// Insert and look up pointer keys, like the sets of drawables and nodes.
+template <class SetType, unsigned N> unsigned PointerSet(unsigned count)
+{
+    static SetType set;
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        set.Clear();
+        for (unsigned j = 0; j < N; ++j)
+            set.Insert(&pointerTargets[keys[j] % MAX_KEYS]);
+        for (unsigned j = 0; j < N; ++j)
+            result += set.Contains(&pointerTargets[j]) ? 1 : 0;
+    }
+    return result;
+}
+
+template <unsigned N> void RunHashBenchmarks(unsigned count)
+{
+    typedef HashMap<unsigned, unsigned> ChainedMap;
+    typedef FlatHashMap<unsigned, unsigned> FlatMap;
+
+    PrintBenchmarkGroup("Hash containers with " + String(N) + " elements (time per repetition)");
+    RunBenchmark("HashMap insert, reused map", InsertReused<ChainedMap, N>, count);
+    RunBenchmark("FlatHashMap insert, reused map", InsertReused<FlatMap, N>, count);
+    RunBenchmark("HashMap insert, new map", InsertNew<ChainedMap, N>, count);
+    RunBenchmark("FlatHashMap insert, new map", InsertNew<FlatMap, N>, count);
+    RunBenchmark("HashMap find existing", FindHit<ChainedMap, N>, count);
+    RunBenchmark("FlatHashMap find existing", FindHit<FlatMap, N>, count);
+    RunBenchmark("HashMap find missing", FindMiss<ChainedMap, N>, count);
+    RunBenchmark("FlatHashMap find missing", FindMiss<FlatMap, N>, count);
+    RunBenchmark("HashMap iterate", Iterate<ChainedMap, N>, count);
+    RunBenchmark("FlatHashMap iterate", Iterate<FlatMap, N>, count);
+    RunBenchmark("HashMap insert and erase", InsertErase<ChainedMap, N>, count);
+    RunBenchmark("FlatHashMap insert and erase", InsertErase<FlatMap, N>, count);
+    RunBenchmark("HashSet pointers", PointerSet<HashSet<unsigned*>, N>, count);
+    RunBenchmark("FlatHashSet pointers", PointerSet<FlatHashSet<unsigned*>, N>, count);
+}
+
+void RunContainerBenchmarks(unsigned scale)
+{
+    InitializeKeys();
+
+    // Keep the total amount of work roughly equal between the sizes
+    RunHashBenchmarks<16>(20000 * scale);
+    RunHashBenchmarks<1024>(400 * scale);
+    RunHashBenchmarks<MAX_KEYS>(4 * scale);
+}
@@ -0,0 +1,158 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/OcclusionBuffer.h>
+#include <Urho3D/Math/Random.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+static const unsigned NUM_RESOLUTIONS = 3;
+static const int resolutions[NUM_RESOLUTIONS][2] =
+{
+    { 256, 128 }, { 512, 256 }, { 1024, 512 }
+};
+
+static const unsigned NUM_OCCLUDER_COUNTS = 2;
+static const unsigned occluderCounts[NUM_OCCLUDER_COUNTS] = { 100, 1000 };
+
+/// Box occluder as a triangle list.
+static PODVector<Vector3> boxVertices;
+/// Occluder transforms in view space.
+static PODVector<Matrix3x4> occluderTransforms;
+/// Occlusion buffer being benchmarked.
+static SharedPtr<OcclusionBuffer> occlusionBuffer;
+/// Number of occluders to draw per repetition.
+static unsigned numOccluders = 0;
+
+/// Build the box triangle list.
+static void CreateBoxVertices()
+{
+    static const unsigned faces[6][4] =
+    {
+        { 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 2, 6, 4 }, { 1, 5, 7, 3 }
+    };
+
+    Vector3 corners[8];
+    for (unsigned i = 0; i < 8; ++i)
+        corners[i] = Vector3(i & 4 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 1 ? 0.5f : -0.5f);
+
+    boxVertices.Clear();
+    for (unsigned i = 0; i < 6; ++i)
+    {
+        boxVertices.Push(corners[faces[i][0]]);
+        boxVertices.Push(corners[faces[i][1]]);
+        boxVertices.Push(corners[faces[i][2]]);
+        boxVertices.Push(corners[faces[i][0]]);
+        boxVertices.Push(corners[faces[i][2]]);
+        boxVertices.Push(corners[faces[i][3]]);
+    }
+}
+
+/// Scatter random box occluders in front of the camera, like a city block seen from street level.
+static void CreateOccluders(unsigned count)
+{
+    SetRandomSeed(1);
+    occluderTransforms.Resize(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        float z = Random(5.0f, 200.0f);
+        Vector3 position(Random(-z, z), Random(-0.5f * z, 0.5f * z), z);
+        Quaternion rotation(Random(360.0f), Vector3::UP);
+        Vector3 scale(Random(1.0f, 10.0f), Random(1.0f, 20.0f), Random(1.0f, 10.0f));
+        occluderTransforms[i] = Matrix3x4(position, rotation, scale);
+    }
+}
+
+/// Rasterize the occluders and build the depth hierarchy, like View does each frame.
+static unsigned DrawOccluders(unsigned count)
+{
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        occlusionBuffer->Clear();
+        for (unsigned j = 0; j < numOccluders; ++j)
+            occlusionBuffer->AddTriangles(occluderTransforms[j], &boxVertices[0], sizeof(Vector3), 0, boxVertices.Size());
+        occlusionBuffer->DrawTriangles();
+        occlusionBuffer->BuildDepthHierarchy();
+        result += occlusionBuffer->GetNumTriangles() + occlusionBuffer->IsVisible(BoundingBox(Vector3(-1.0f, -1.0f, 300.0f),
+            Vector3(1.0f, 1.0f, 301.0f)));
+    }
+    return result;
+}
+
+void RunOcclusionBenchmarks(unsigned scale)
+{
+    SharedPtr<Context> context(new Context());
+    WorkQueue* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    unsigned numThreads = GetNumPhysicalCPUs() - 1;
+    if (numThreads)
+        queue->CreateThreads(numThreads);
+
+    SharedPtr<Camera> camera(new Camera(context));
+    camera->SetFarClip(1000.0f);
+
+    occlusionBuffer = new OcclusionBuffer(context);
+    occlusionBuffer->SetMaxTriangles(M_MAX_UNSIGNED);
+    occlusionBuffer->SetCullMode(CULL_CCW);
+
+    CreateBoxVertices();
+    CreateOccluders(occluderCounts[NUM_OCCLUDER_COUNTS - 1]);
+
+    PrintBenchmarkGroup("Occlusion (" + String(numThreads) + " worker threads)");
+    for (unsigned i = 0; i < NUM_RESOLUTIONS; ++i)
+    {
+        int width = resolutions[i][0];
+        int height = resolutions[i][1];
+        camera->SetAspectRatio((float)width / (float)height);
+
+        for (unsigned j = 0; j < NUM_OCCLUDER_COUNTS; ++j)
+        {
+            numOccluders = occluderCounts[j];
+            unsigned count = 100 * scale * occluderCounts[0] / numOccluders;
+            String name = String(width) + "x" + String(height) + ", " + String(numOccluders) + " occluders";
+
+            occlusionBuffer->SetSize(width, height, false);
+            occlusionBuffer->SetView(camera);
+            RunBenchmark(name + ", single-threaded", DrawOccluders, count);
+
+            if (numThreads)
+            {
+                occlusionBuffer->SetSize(width, height, true);
+                if (!occlusionBuffer->IsThreaded())
+                    ErrorExit("Occlusion buffer did not switch to threaded rasterization");
+                occlusionBuffer->SetView(camera);
+                RunBenchmark(name + ", threaded", DrawOccluders, count);
+            }
+        }
+    }
+
+    occlusionBuffer.Reset();
+    occluderTransforms.Clear();
+    boxVertices.Clear();
+}
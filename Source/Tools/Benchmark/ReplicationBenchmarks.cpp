@@ -0,0 +1,169 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Number of moving objects, like the players' balls rolling around in the scene replication sample.
+static const unsigned NUM_OBJECTS = 100;
+/// Network updates per second.
+static const unsigned UPDATE_FPS = 30;
+/// Half size of the area the objects move in.
+static const float AREA_SIZE = 100.0f;
+/// Ball radius for deriving the rolling rotation.
+static const float BALL_RADIUS = 0.5f;
+
+/// Scene being replicated.
+static SharedPtr<Scene> scene;
+/// Moving objects.
+static PODVector<Node*> objects;
+/// Object velocities.
+static PODVector<Vector3> velocities;
+/// Buffer for the encoded latest data messages.
+static VectorBuffer updateBuffer;
+
+/// Place the objects at their initial positions.
+static void ResetObjects()
+{
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < objects.Size(); ++i)
+    {
+        objects[i]->SetPosition(Vector3(Random(-AREA_SIZE, AREA_SIZE), BALL_RADIUS, Random(-AREA_SIZE, AREA_SIZE)));
+        objects[i]->SetRotation(Quaternion::IDENTITY);
+        velocities[i] = Quaternion(Random(360.0f), Vector3::UP) * Vector3(0.0f, 0.0f, Random(1.0f, 10.0f));
+    }
+    scene->PrepareNetworkUpdate();
+}
+
+/// Roll the objects forward, bouncing from the area edges.
+static void MoveObjects(float timeStep)
+{
+    for (unsigned i = 0; i < objects.Size(); ++i)
+    {
+        Node* object = objects[i];
+        Vector3& velocity = velocities[i];
+        Vector3 position = object->GetPosition() + velocity * timeStep;
+        if (Abs(position.x_) > AREA_SIZE)
+            velocity.x_ = -velocity.x_;
+        if (Abs(position.z_) > AREA_SIZE)
+            velocity.z_ = -velocity.z_;
+
+        float speed = velocity.Length();
+        Vector3 axis = Vector3::UP.CrossProduct(velocity).Normalized();
+        object->SetPosition(position);
+        object->Rotate(Quaternion(speed * timeStep / BALL_RADIUS * M_RADTODEG, axis), TS_WORLD);
+    }
+}
+
+/// Move the objects and encode their latest data messages, like the server does for each network update.
+static unsigned EncodeUpdates(unsigned count)
+{
+    unsigned bytes = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        MoveObjects(1.0f / (float)UPDATE_FPS);
+        scene->PrepareNetworkUpdate();
+
+        updateBuffer.Clear();
+        for (unsigned j = 0; j < objects.Size(); ++j)
+        {
+            updateBuffer.WriteNetID(objects[j]->GetID());
+            objects[j]->WriteLatestDataUpdate(updateBuffer, 0);
+        }
+        bytes += updateBuffer.GetSize();
+    }
+    return bytes;
+}
+
+/// Move the objects and encode their latest data messages as the engine did before encoding hints: the rotation was a buffer
+/// attribute holding a packed quaternion with 16 bits per component.
+static unsigned EncodeBaselineUpdates(unsigned count)
+{
+    unsigned bytes = 0;
+    VectorBuffer rotationBuffer;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        MoveObjects(1.0f / (float)UPDATE_FPS);
+        scene->PrepareNetworkUpdate();
+
+        updateBuffer.Clear();
+        for (unsigned j = 0; j < objects.Size(); ++j)
+        {
+            Node* object = objects[j];
+            updateBuffer.WriteNetID(object->GetID());
+            updateBuffer.WriteUByte(0);
+            updateBuffer.WriteVector3(object->GetPosition());
+            rotationBuffer.Clear();
+            rotationBuffer.WritePackedQuaternion(object->GetRotation());
+            updateBuffer.WriteBuffer(rotationBuffer.GetBuffer());
+        }
+        bytes += updateBuffer.GetSize();
+    }
+    return bytes;
+}
+
+/// Measure the bandwidth and encoding time of an update encoding function.
+static void RunReplicationBenchmark(const String& name, BenchmarkFunction function, unsigned scale)
+{
+    ResetObjects();
+    unsigned bytes = function(UPDATE_FPS);
+    PrintBenchmarkResult(name + ", bandwidth", (double)bytes / 1024.0, "KB/s");
+
+    ResetObjects();
+    RunBenchmark(name + ", encode update", function, 100 * scale);
+}
+
+void RunReplicationBenchmarks(unsigned scale)
+{
+    SharedPtr<Context> context(new Context());
+    RegisterSceneLibrary(context);
+
+    scene = new Scene(context);
+    objects.Resize(NUM_OBJECTS);
+    velocities.Resize(NUM_OBJECTS);
+    for (unsigned i = 0; i < NUM_OBJECTS; ++i)
+        objects[i] = scene->CreateChild("Ball");
+
+    PrintBenchmarkGroup("Replication (" + String(NUM_OBJECTS) + " rolling objects, " + String(UPDATE_FPS) +
+        " updates per second, payload only)");
+
+    RunReplicationBenchmark("Packed rotation buffer (before hints)", EncodeBaselineUpdates, scale);
+    RunReplicationBenchmark("16-bit smallest-three rotation (default)", EncodeUpdates, scale);
+
+    context->SetAttributeNetworkHint<Node>("Network Rotation", NetworkEncodingHint(NE_SMALLEST_THREE, 10));
+    RunReplicationBenchmark("10-bit smallest-three rotation", EncodeUpdates, scale);
+
+    context->SetAttributeNetworkHint<Node>("Network Position", NetworkEncodingHint(NE_QUANTIZED, 16, -AREA_SIZE - 10.0f,
+        AREA_SIZE + 10.0f));
+    RunReplicationBenchmark("10-bit rotation, 16-bit position", EncodeUpdates, scale);
+
+    objects.Clear();
+    velocities.Clear();
+    scene.Reset();
+}
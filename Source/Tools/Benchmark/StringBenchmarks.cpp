@@ -0,0 +1,235 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Math/StringHash.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Baseline string that always allocates its buffer from the heap, like String did before the short string optimization.
+class HeapString
+{
+public:
+    /// Construct empty.
+    HeapString() :
+        length_(0),
+        buffer_(0)
+    {
+    }
+
+    /// Construct from a C string.
+    HeapString(const char* str) :
+        length_(0),
+        buffer_(0)
+    {
+        Assign(str, String::CStringLength(str));
+    }
+
+    /// Copy-construct.
+    HeapString(const HeapString& str) :
+        length_(0),
+        buffer_(0)
+    {
+        Assign(str.buffer_, str.length_);
+    }
+
+    /// Destruct.
+    ~HeapString()
+    {
+        delete[] buffer_;
+    }
+
+    /// Assign another string.
+    HeapString& operator =(const HeapString& rhs)
+    {
+        if (&rhs != this)
+            Assign(rhs.buffer_, rhs.length_);
+        return *this;
+    }
+
+    /// Add-assign a C string.
+    HeapString& operator +=(const char* rhs)
+    {
+        unsigned rhsLength = String::CStringLength(rhs);
+        char* newBuffer = new char[length_ + rhsLength + 1];
+        if (length_)
+            memcpy(newBuffer, buffer_, length_);
+        memcpy(newBuffer + length_, rhs, rhsLength + 1);
+        delete[] buffer_;
+        buffer_ = newBuffer;
+        length_ += rhsLength;
+        return *this;
+    }
+
+    /// Return length.
+    unsigned Length() const { return length_; }
+
+    /// Return the C string.
+    const char* CString() const { return buffer_ ? buffer_ : ""; }
+
+private:
+    /// Replace the contents.
+    void Assign(const char* str, unsigned length)
+    {
+        delete[] buffer_;
+        buffer_ = 0;
+        length_ = length;
+        if (length)
+        {
+            buffer_ = new char[length + 1];
+            memcpy(buffer_, str, length + 1);
+        }
+    }
+
+    /// String length.
+    unsigned length_;
+    /// String buffer.
+    char* buffer_;
+};
+
+static const char* shortNames[] =
+{
+    "Node", "Camera", "Position", "Rotation", "Scale", "Model", "Material", "Is Enabled", "name", "value", "attribute",
+    "component", "Text", "Button", "Window", "Color"
+};
+
+static const char* longNames[] =
+{
+    "Models/Mushroom.mdl", "Materials/StoneTiled.xml", "Textures/UI/DefaultStyle.png", "Cast Shadows", "Draw Distance",
+    "Shadow Distance", "Occlusion LOD Level", "Animation Enabled", "UI/DefaultStyle.xml", "Network Position",
+    "Scripts/Utilities/Sample.as", "Light Mask", "Zone Mask", "Max Lights", "Is Occluder", "Can Be Occluded"
+};
+
+static const unsigned NUM_NAMES = sizeof(shortNames) / sizeof(shortNames[0]);
+static const unsigned BATCH_SIZE = 1024;
+
+/// Construct and destroy strings from C strings, like reading names from XML.
+template <class StringType, bool Long> unsigned ConstructStrings(unsigned count)
+{
+    const char** names = Long ? longNames : shortNames;
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        for (unsigned j = 0; j < BATCH_SIZE; ++j)
+        {
+            StringType str(names[j % NUM_NAMES]);
+            result += str.Length();
+        }
+    }
+    return result;
+}
+
+/// Copy a vector of strings, like copying attribute infos.
+template <class StringType, bool Long> unsigned CopyStrings(unsigned count)
+{
+    const char** names = Long ? longNames : shortNames;
+    Vector<StringType> source;
+    for (unsigned j = 0; j < BATCH_SIZE; ++j)
+        source.Push(StringType(names[j % NUM_NAMES]));
+
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        Vector<StringType> copy(source);
+        result += copy.Back().Length();
+    }
+    return result;
+}
+
+/// Build short strings by appending, like forming node names.
+template <class StringType> unsigned AppendStrings(unsigned count)
+{
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        for (unsigned j = 0; j < BATCH_SIZE; ++j)
+        {
+            StringType str(shortNames[j % NUM_NAMES]);
+            str += "_";
+            str += "1";
+            result += str.Length();
+        }
+    }
+    return result;
+}
+
+/// Hash strings without interning.
+unsigned HashStrings(unsigned count)
+{
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        for (unsigned j = 0; j < BATCH_SIZE; ++j)
+            result += StringHash(longNames[j % NUM_NAMES]).Value();
+    }
+    return result;
+}
+
+/// Hash and intern strings that are already in the intern table.
+unsigned InternStrings(unsigned count)
+{
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        for (unsigned j = 0; j < BATCH_SIZE; ++j)
+            result += StringHash::Intern(longNames[j % NUM_NAMES]).Value();
+    }
+    return result;
+}
+
+/// Look up interned strings by hash.
+unsigned ReverseHashes(unsigned count)
+{
+    StringHash hashes[NUM_NAMES];
+    for (unsigned j = 0; j < NUM_NAMES; ++j)
+        hashes[j] = StringHash::Intern(longNames[j]);
+
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        for (unsigned j = 0; j < BATCH_SIZE; ++j)
+            result += hashes[j % NUM_NAMES].Reverse().Length();
+    }
+    return result;
+}
+
+void RunStringBenchmarks(unsigned scale)
+{
+    unsigned count = 200 * scale;
+
+    PrintBenchmarkGroup("Strings, " + String(BATCH_SIZE) + " per repetition (time per repetition)");
+    RunBenchmark("Heap string construct, short", ConstructStrings<HeapString, false>, count);
+    RunBenchmark("String construct, short", ConstructStrings<String, false>, count);
+    RunBenchmark("Heap string construct, long", ConstructStrings<HeapString, true>, count);
+    RunBenchmark("String construct, long", ConstructStrings<String, true>, count);
+    RunBenchmark("Heap string copy, short", CopyStrings<HeapString, false>, count);
+    RunBenchmark("String copy, short", CopyStrings<String, false>, count);
+    RunBenchmark("Heap string copy, long", CopyStrings<HeapString, true>, count);
+    RunBenchmark("String copy, long", CopyStrings<String, true>, count);
+    RunBenchmark("Heap string append, short", AppendStrings<HeapString>, count);
+    RunBenchmark("String append, short", AppendStrings<String>, count);
+    RunBenchmark("StringHash construct", HashStrings, count);
+    RunBenchmark("StringHash intern", InternStrings, count);
+    RunBenchmark("StringHash reverse", ReverseHashes, count);
+}
@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Math/Random.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Sum, minimum and maximum of a range of values.
+struct ReduceResult
+{
+    /// Construct undefined.
+    ReduceResult()
+    {
+    }
+
+    /// Construct with values.
+    ReduceResult(long long sum, int min, int max) :
+        sum_(sum),
+        min_(min),
+        max_(max)
+    {
+    }
+
+    /// Test for equality with another result.
+    bool operator ==(const ReduceResult& rhs) const { return sum_ == rhs.sum_ && min_ == rhs.min_ && max_ == rhs.max_; }
+
+    /// Sum of values.
+    long long sum_;
+    /// Minimum value.
+    int min_;
+    /// Maximum value.
+    int max_;
+};
+
+static const ReduceResult REDUCE_IDENTITY(0, M_MAX_INT, M_MIN_INT);
+
+static const unsigned NUM_RANGE_SIZES = 5;
+static const unsigned rangeSizes[NUM_RANGE_SIZES] = { 1, 7, 1001, 65537, 1000003 };
+
+/// Values to reduce.
+static PODVector<int> values;
+/// Per-thread accumulators.
+static ParallelAccumulator<ReduceResult> accumulator;
+/// Work queue being benchmarked.
+static WorkQueue* workQueue = 0;
+
+/// Return the cost of processing a value. Varies per element so that the chunks take uneven time and the workers have to steal.
+static int ProcessValue(int value)
+{
+    int result = value;
+    for (int i = 0; i < (value & 63); ++i)
+        result = (result * 31 + i) % 1000003;
+    return value + (result & 1);
+}
+
+static ReduceResult CombineResults(const ReduceResult& lhs, const ReduceResult& rhs)
+{
+    return ReduceResult(lhs.sum_ + rhs.sum_, Min(lhs.min_, rhs.min_), Max(lhs.max_, rhs.max_));
+}
+
+static void ReduceWork(const WorkItem* item, unsigned threadIndex)
+{
+    ParallelAccumulator<ReduceResult>* results = reinterpret_cast<ParallelAccumulator<ReduceResult>*>(item->aux_);
+    ReduceResult& result = results->values_[threadIndex];
+    int* start = reinterpret_cast<int*>(item->start_);
+    int* end = reinterpret_cast<int*>(item->end_);
+
+    while (start != end)
+    {
+        int value = ProcessValue(*start++);
+        result.sum_ += value;
+        result.min_ = Min(result.min_, value);
+        result.max_ = Max(result.max_, value);
+    }
+}
+
+static ReduceResult ReduceSerial(unsigned size)
+{
+    ReduceResult result = REDUCE_IDENTITY;
+    for (unsigned i = 0; i < size; ++i)
+    {
+        int value = ProcessValue(values[i]);
+        result.sum_ += value;
+        result.min_ = Min(result.min_, value);
+        result.max_ = Max(result.max_, value);
+    }
+    return result;
+}
+
+static ReduceResult ReduceParallel(unsigned size)
+{
+    return workQueue->ParallelReduce(ReduceWork, &values[0], size, sizeof(int), accumulator, REDUCE_IDENTITY, CombineResults);
+}
+
+template <unsigned N> unsigned SumSerial(unsigned count)
+{
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+        result += (unsigned)ReduceSerial(N).sum_;
+    return result;
+}
+
+template <unsigned N> unsigned SumParallel(unsigned count)
+{
+    unsigned result = 0;
+    for (unsigned i = 0; i < count; ++i)
+        result += (unsigned)ReduceParallel(N).sum_;
+    return result;
+}
+
+void RunWorkQueueBenchmarks(unsigned scale)
+{
+    SharedPtr<Context> context(new Context());
+    workQueue = new WorkQueue(context);
+    context->RegisterSubsystem(workQueue);
+    // Use at least a few worker threads so that the reduction is exercised on single-core machines as well
+    unsigned numThreads = Max((int)GetNumLogicalCPUs() - 1, 3);
+    workQueue->CreateThreads(numThreads);
+
+    // Random values of both signs, so that the minimum and maximum are not found at the range ends
+    SetRandomSeed(1);
+    values.Resize(rangeSizes[NUM_RANGE_SIZES - 1]);
+    for (unsigned i = 0; i < values.Size(); ++i)
+        values[i] = Rand() - 16384;
+
+    // Check the parallel reduction against the serial result before timing anything
+    for (unsigned i = 0; i < NUM_RANGE_SIZES; ++i)
+    {
+        ReduceResult expected = ReduceSerial(rangeSizes[i]);
+        for (unsigned j = 0; j < 10; ++j)
+        {
+            ReduceResult result = ReduceParallel(rangeSizes[i]);
+            if (!(result == expected))
+            {
+                ErrorExit("ParallelReduce over " + String(rangeSizes[i]) + " elements returned sum " + String(result.sum_) +
+                    " min " + String(result.min_) + " max " + String(result.max_) + ", expected sum " + String(expected.sum_) +
+                    " min " + String(expected.min_) + " max " + String(expected.max_));
+            }
+        }
+    }
+
+    PrintBenchmarkGroup("WorkQueue (" + String(workQueue->GetNumThreads()) + " worker threads)");
+    RunBenchmark("Reduce 1001 elements, serial", SumSerial<1001>, 1000 * scale);
+    RunBenchmark("Reduce 1001 elements, ParallelReduce", SumParallel<1001>, 1000 * scale);
+    RunBenchmark("Reduce 65537 elements, serial", SumSerial<65537>, 20 * scale);
+    RunBenchmark("Reduce 65537 elements, ParallelReduce", SumParallel<65537>, 20 * scale);
+    RunBenchmark("Reduce 1000003 elements, serial", SumSerial<1000003>, 2 * scale);
+    RunBenchmark("Reduce 1000003 elements, ParallelReduce", SumParallel<1000003>, 2 * scale);
+
+    workQueue = 0;
+    values.Clear();
+}
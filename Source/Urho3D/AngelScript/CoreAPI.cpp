@@ -72,7 +72,9 @@ static void RegisterStringHash(asIScriptEngine* engine)
     engine->RegisterObjectMethod("StringHash", "int opCmp(const StringHash&in) const", asFUNCTION(StringHashCmp), asCALL_CDECL_OBJFIRST);
     engine->RegisterObjectMethod("StringHash", "StringHash opAdd(const StringHash&in) const", asMETHOD(StringHash, operator +), asCALL_THISCALL);
     engine->RegisterObjectMethod("StringHash", "String ToString() const", asMETHOD(StringHash, ToString), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StringHash", "const String& Reverse() const", asMETHOD(StringHash, Reverse), asCALL_THISCALL);
     engine->RegisterObjectMethod("StringHash", "uint get_value()", asMETHOD(StringHash, Value), asCALL_THISCALL);
+    engine->RegisterGlobalFunction("StringHash InternStringHash(const String&in)", asFUNCTION(StringHash::Intern), asCALL_CDECL);
 }
 
 static void ConstructResourceRef(ResourceRef* ptr)
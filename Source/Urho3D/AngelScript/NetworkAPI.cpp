@@ -86,7 +86,15 @@ static void RegisterConnection(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Connection", "const Vector3& get_position() const", asMETHOD(Connection, GetPosition), asCALL_THISCALL);
     engine->RegisterObjectMethod("Connection", "void set_rotation(const Quaternion&in)", asMETHOD(Connection, SetRotation), asCALL_THISCALL);
     engine->RegisterObjectMethod("Connection", "const Quaternion& get_rotation() const", asMETHOD(Connection, GetRotation), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "void set_interestRadius(float)", asMETHOD(Connection, SetInterestRadius), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "float get_interestRadius() const", asMETHOD(Connection, GetInterestRadius), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "void set_interestExitFactor(float)", asMETHOD(Connection, SetInterestExitFactor), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "float get_interestExitFactor() const", asMETHOD(Connection, GetInterestExitFactor), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "bool IsNodeRelevant(Node@+) const", asMETHOD(Connection, IsNodeRelevant), asCALL_THISCALL);
     engine->RegisterObjectMethod("Connection", "void SendPackageToClient(PackageFile@+)", asMETHOD(Connection, SendPackageToClient), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "uint ReplayControls(uint8)", asMETHOD(Connection, ReplayControls), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "uint8 get_ackedTimeStamp() const", asMETHOD(Connection, GetAckedTimeStamp), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "uint get_numPendingControls() const", asMETHOD(Connection, GetNumPendingControls), asCALL_THISCALL);
     engine->RegisterObjectProperty("Connection", "Controls controls", offsetof(Connection, controls_));
     engine->RegisterObjectProperty("Connection", "uint8 timeStamp", offsetof(Connection, timeStamp_));
     engine->RegisterObjectProperty("Connection", "VariantMap identity", offsetof(Connection, identity_));
@@ -184,6 +192,8 @@ void RegisterNetwork(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Network", "void SendPackageToClients(Scene@+, PackageFile@+)", asMETHOD(Network, SendPackageToClients), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "void set_updateFps(int)", asMETHOD(Network, SetUpdateFps), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "int get_updateFps() const", asMETHOD(Network, GetUpdateFps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Network", "void set_interestCellSize(float)", asMETHOD(Network, SetInterestCellSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Network", "float get_interestCellSize() const", asMETHOD(Network, GetInterestCellSize), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "void set_simulatedLatency(int)", asMETHOD(Network, SetSimulatedLatency), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "int get_simulatedLatency() const", asMETHOD(Network, GetSimulatedLatency), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "void set_simulatedPacketLoss(float)", asMETHOD(Network, SetSimulatedPacketLoss), asCALL_THISCALL);
@@ -237,6 +237,9 @@ static void RegisterSmoothedTransform(asIScriptEngine* engine)
     engine->RegisterObjectMethod("SmoothedTransform", "void set_targetWorldRotation(const Quaternion&in)", asMETHOD(SmoothedTransform, SetTargetWorldRotation), asCALL_THISCALL);
     engine->RegisterObjectMethod("SmoothedTransform", "Quaternion get_targetWorldRotation() const", asMETHOD(SmoothedTransform, GetTargetWorldRotation), asCALL_THISCALL);
     engine->RegisterObjectMethod("SmoothedTransform", "bool get_inProgress() const", asMETHOD(SmoothedTransform, IsInProgress), asCALL_THISCALL);
+    engine->RegisterObjectMethod("SmoothedTransform", "void set_interpolationDelay(float)", asMETHOD(SmoothedTransform, SetInterpolationDelay), asCALL_THISCALL);
+    engine->RegisterObjectMethod("SmoothedTransform", "float get_interpolationDelay() const", asMETHOD(SmoothedTransform, GetInterpolationDelay), asCALL_THISCALL);
+    engine->RegisterObjectMethod("SmoothedTransform", "uint get_numSnapshots() const", asMETHOD(SmoothedTransform, GetNumSnapshots), asCALL_THISCALL);
 }
 
 static void RegisterSplinePath(asIScriptEngine* engine)
@@ -27,6 +27,7 @@
 #include "../AngelScript/ScriptInstance.h"
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/MemoryTracker.h"
 #include "../Core/Profiler.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
@@ -286,6 +287,7 @@ bool ScriptFile::Execute(const String& declaration, const VariantVector& paramet
 bool ScriptFile::Execute(asIScriptFunction* function, const VariantVector& parameters, bool unprepare)
 {
     URHO3D_PROFILE(ExecuteFunction);
+    URHO3D_MEMORY_CATEGORY(MEMCAT_SCRIPT);
 
     if (!compiled_ || !function)
         return false;
@@ -327,6 +329,7 @@ bool ScriptFile::Execute(asIScriptObject* object, const String& declaration, con
 bool ScriptFile::Execute(asIScriptObject* object, asIScriptFunction* method, const VariantVector& parameters, bool unprepare)
 {
     URHO3D_PROFILE(ExecuteMethod);
+    URHO3D_MEMORY_CATEGORY(MEMCAT_SCRIPT);
 
     if (!compiled_ || !object || !method)
         return false;
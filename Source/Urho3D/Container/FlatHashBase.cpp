@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/FlatHashBase.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+unsigned FlatHashBase::CalculateNumSlots(unsigned numElements)
+{
+    unsigned numSlots = MIN_SLOTS;
+    while (numElements * 4 > numSlots * 3)
+        numSlots <<= 1;
+    return numSlots;
+}
+
+void FlatHashBase::AllocateSlots(unsigned numSlots)
+{
+    FlatHashSlot* oldSlots = slots_;
+    unsigned oldNumSlots = numSlots_;
+
+    slots_ = new FlatHashSlot[numSlots];
+    numSlots_ = numSlots;
+    ResetSlots();
+
+    // Reinsert using the stored hashes, so that keys do not need to be rehashed
+    if (oldSlots)
+    {
+        for (unsigned i = 0; i < oldNumSlots; ++i)
+        {
+            if (oldSlots[i].index_ != EMPTY_SLOT)
+                InsertSlot(oldSlots[i].hash_, oldSlots[i].index_);
+        }
+
+        delete[] oldSlots;
+    }
+}
+
+void FlatHashBase::ResetSlots()
+{
+    for (unsigned i = 0; i < numSlots_; ++i)
+        slots_[i].index_ = EMPTY_SLOT;
+}
+
+void FlatHashBase::FreeSlots()
+{
+    delete[] slots_;
+    slots_ = 0;
+    numSlots_ = 0;
+}
+
+void FlatHashBase::InsertSlot(unsigned hash, unsigned index)
+{
+    unsigned mask = numSlots_ - 1;
+    unsigned pos = hash & mask;
+    unsigned distance = 0;
+
+    for (;;)
+    {
+        FlatHashSlot& slot = slots_[pos];
+        if (slot.index_ == EMPTY_SLOT)
+        {
+            slot.hash_ = hash;
+            slot.index_ = index;
+            return;
+        }
+
+        // Robin Hood: take the place of an entry that is closer to its home position, and continue inserting that one
+        unsigned existingDistance = ProbeDistance(slot.hash_, pos);
+        if (existingDistance < distance)
+        {
+            Urho3D::Swap(slot.hash_, hash);
+            Urho3D::Swap(slot.index_, index);
+            distance = existingDistance;
+        }
+
+        pos = (pos + 1) & mask;
+        ++distance;
+    }
+}
+
+void FlatHashBase::EraseSlot(unsigned pos)
+{
+    unsigned mask = numSlots_ - 1;
+    unsigned next = (pos + 1) & mask;
+
+    while (slots_[next].index_ != EMPTY_SLOT && ProbeDistance(slots_[next].hash_, next) != 0)
+    {
+        slots_[pos] = slots_[next];
+        pos = next;
+        next = (next + 1) & mask;
+    }
+
+    slots_[pos].index_ = EMPTY_SLOT;
+}
+
+unsigned FlatHashBase::FindSlotByIndex(unsigned hash, unsigned index) const
+{
+    unsigned mask = numSlots_ - 1;
+    unsigned pos = hash & mask;
+
+    while (slots_[pos].index_ != index)
+        pos = (pos + 1) & mask;
+
+    return pos;
+}
+
+unsigned char* FlatHashBase::AllocateEntries(unsigned size)
+{
+    return new unsigned char[size];
+}
+
+}
@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#ifdef URHO3D_IS_BUILDING
+#include "Urho3D.h"
+#else
+#include <Urho3D/Urho3D.h>
+#endif
+
+#include "../Container/Hash.h"
+#include "../Container/Swap.h"
+
+namespace Urho3D
+{
+
+/// Open addressing hash set/map slot. Refers to an entry in the dense entry array.
+struct FlatHashSlot
+{
+    /// Mixed hash of the entry's key.
+    unsigned hash_;
+    /// Entry index, or FlatHashBase::EMPTY_SLOT if the slot is unused.
+    unsigned index_;
+};
+
+/// Open addressing hash set/map base class.
+/** Entries are stored inline in a dense array in insertion order (erasing moves the last entry into the hole), and are
+    located through a power-of-two slot table using Robin Hood linear probing. Inserting may reallocate the entry array, so
+    pointers and iterators to entries are only stable while the container is not modified. Like %HashBase, %FlatHashBase
+    intentionally does not declare a virtual destructor and therefore %FlatHashBase pointers should never be used.
+  */
+class URHO3D_API FlatHashBase
+{
+public:
+    /// Initial amount of slots.
+    static const unsigned MIN_SLOTS = 8;
+    /// Initial entry capacity.
+    static const unsigned MIN_CAPACITY = 4;
+    /// Slot index marker for an unused slot.
+    static const unsigned EMPTY_SLOT = 0xffffffff;
+
+    /// Construct.
+    FlatHashBase() :
+        entries_(0),
+        slots_(0),
+        size_(0),
+        capacity_(0),
+        numSlots_(0)
+    {
+    }
+
+    /// Swap with another hash set or map.
+    void Swap(FlatHashBase& rhs)
+    {
+        Urho3D::Swap(entries_, rhs.entries_);
+        Urho3D::Swap(slots_, rhs.slots_);
+        Urho3D::Swap(size_, rhs.size_);
+        Urho3D::Swap(capacity_, rhs.capacity_);
+        Urho3D::Swap(numSlots_, rhs.numSlots_);
+    }
+
+    /// Return number of elements.
+    unsigned Size() const { return size_; }
+
+    /// Return number of elements that fit without reallocating the entry array.
+    unsigned Capacity() const { return capacity_; }
+
+    /// Return number of slots.
+    unsigned NumSlots() const { return numSlots_; }
+
+    /// Return whether has no elements.
+    bool Empty() const { return size_ == 0; }
+
+protected:
+    /// Scramble a key hash so that sequential integers and aligned pointers spread evenly over the slots.
+    static unsigned MixHash(unsigned hash)
+    {
+        hash *= 0x9e3779b9;
+        return hash ^ (hash >> 16);
+    }
+
+    /// Return the slot count needed to hold the specified number of elements below the maximum load factor.
+    static unsigned CalculateNumSlots(unsigned numElements);
+
+    /// Return whether one more element can be inserted without growing the slot table.
+    bool HasFreeSlot() const { return (size_ + 1) * 4 <= numSlots_ * 3; }
+
+    /// Return the probe distance of a slot from its home position.
+    unsigned ProbeDistance(unsigned hash, unsigned pos) const { return (pos - hash) & (numSlots_ - 1); }
+
+    /// Reallocate the slot table, which must be a power of two in size, and reinsert the existing entry indices.
+    void AllocateSlots(unsigned numSlots);
+    /// Mark all slots unused.
+    void ResetSlots();
+    /// Free the slot table.
+    void FreeSlots();
+    /// Insert an entry index into the slot table. There must be a free slot.
+    void InsertSlot(unsigned hash, unsigned index);
+    /// Remove a slot, shifting the following slots of the probe sequence backward.
+    void EraseSlot(unsigned pos);
+    /// Return the position of the slot referring to an entry index.
+    unsigned FindSlotByIndex(unsigned hash, unsigned index) const;
+
+    /// Allocate raw entry memory.
+    static unsigned char* AllocateEntries(unsigned size);
+
+    /// Dense entry array.
+    unsigned char* entries_;
+    /// Slot table.
+    FlatHashSlot* slots_;
+    /// Number of elements.
+    unsigned size_;
+    /// Entry array capacity.
+    unsigned capacity_;
+    /// Number of slots.
+    unsigned numSlots_;
+};
+
+}
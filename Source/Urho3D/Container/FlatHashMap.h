@@ -0,0 +1,390 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+#include "../Container/Pair.h"
+#include "../Container/Vector.h"
+
+#include <cassert>
+#include <new>
+
+namespace Urho3D
+{
+
+/// Open addressing hash map template class. Faster than %HashMap for lookup-heavy use, but does not keep pointers stable.
+template <class T, class U> class FlatHashMap : public FlatHashBase
+{
+public:
+    typedef T KeyType;
+    typedef U ValueType;
+
+    /// Hash map key-value pair with const key.
+    class KeyValue
+    {
+    public:
+        /// Construct with default key.
+        KeyValue() :
+            first_(T())
+        {
+        }
+
+        /// Construct with key and value.
+        KeyValue(const T& first, const U& second) :
+            first_(first),
+            second_(second)
+        {
+        }
+
+        /// Copy-construct.
+        KeyValue(const KeyValue& value) :
+            first_(value.first_),
+            second_(value.second_)
+        {
+        }
+
+        /// Test for equality with another pair.
+        bool operator ==(const KeyValue& rhs) const { return first_ == rhs.first_ && second_ == rhs.second_; }
+
+        /// Test for inequality with another pair.
+        bool operator !=(const KeyValue& rhs) const { return first_ != rhs.first_ || second_ != rhs.second_; }
+
+        /// Key.
+        const T first_;
+        /// Value.
+        U second_;
+
+    private:
+        /// Prevent assignment.
+        KeyValue& operator =(const KeyValue& rhs);
+    };
+
+    typedef RandomAccessIterator<KeyValue> Iterator;
+    typedef RandomAccessConstIterator<KeyValue> ConstIterator;
+
+    /// Construct empty.
+    FlatHashMap()
+    {
+    }
+
+    /// Construct from another hash map.
+    FlatHashMap(const FlatHashMap<T, U>& map)
+    {
+        Reserve(map.Size());
+        Insert(map);
+    }
+
+    /// Destruct.
+    ~FlatHashMap()
+    {
+        Clear();
+        delete[] entries_;
+        FreeSlots();
+    }
+
+    /// Assign a hash map.
+    FlatHashMap& operator =(const FlatHashMap<T, U>& rhs)
+    {
+        if (&rhs != this)
+        {
+            Clear();
+            Reserve(rhs.Size());
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Add-assign a pair.
+    FlatHashMap& operator +=(const Pair<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a hash map.
+    FlatHashMap& operator +=(const FlatHashMap<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another hash map.
+    bool operator ==(const FlatHashMap<T, U>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            ConstIterator j = rhs.Find(i->first_);
+            if (j == rhs.End() || j->second_ != i->second_)
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another hash map.
+    bool operator !=(const FlatHashMap<T, U>& rhs) const { return !(*this == rhs); }
+
+    /// Index the map. Create a new pair if key not found.
+    U& operator [](const T& key)
+    {
+        unsigned hash = MixHash(MakeHash(key));
+        unsigned pos = FindSlot(key, hash);
+        // Insert first, as inserting may reallocate the entries
+        unsigned index = pos != EMPTY_SLOT ? slots_[pos].index_ : InsertEntry(key, U(), hash);
+        return Entries()[index].second_;
+    }
+
+    /// Index the map. Return null if key is not found, does not create a new pair.
+    U* operator [](const T& key) const
+    {
+        unsigned pos = FindSlot(key, MixHash(MakeHash(key)));
+        return pos != EMPTY_SLOT ? &Entries()[slots_[pos].index_].second_ : 0;
+    }
+
+    /// Insert a pair. Return an iterator to it.
+    Iterator Insert(const Pair<T, U>& pair)
+    {
+        unsigned hash = MixHash(MakeHash(pair.first_));
+        unsigned pos = FindSlot(pair.first_, hash);
+        if (pos != EMPTY_SLOT)
+        {
+            KeyValue* entry = Entries() + slots_[pos].index_;
+            entry->second_ = pair.second_;
+            return Iterator(entry);
+        }
+
+        unsigned index = InsertEntry(pair.first_, pair.second_, hash);
+        return Iterator(Entries() + index);
+    }
+
+    /// Insert a map.
+    void Insert(const FlatHashMap<T, U>& map)
+    {
+        for (ConstIterator i = map.Begin(); i != map.End(); ++i)
+            Insert(MakePair(i->first_, i->second_));
+    }
+
+    /// Erase a pair by key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned pos = FindSlot(key, MixHash(MakeHash(key)));
+        if (pos == EMPTY_SLOT)
+            return false;
+
+        EraseEntry(pos);
+        return true;
+    }
+
+    /// Erase a pair by iterator. Return iterator to the next pair, which is the former last pair moved into its place.
+    Iterator Erase(const Iterator& it)
+    {
+        unsigned index = (unsigned)(it.ptr_ - Entries());
+        assert(index < size_);
+        EraseEntry(FindSlotByIndex(MixHash(MakeHash(it->first_)), index));
+        return Iterator(Entries() + index);
+    }
+
+    /// Clear the map. Keeps the entry and slot storage allocated for reuse.
+    void Clear()
+    {
+        KeyValue* entries = Entries();
+        for (unsigned i = 0; i < size_; ++i)
+            (entries + i)->~KeyValue();
+
+        size_ = 0;
+        ResetSlots();
+    }
+
+    /// Reserve room for the specified number of pairs, so that inserting them does not reallocate.
+    void Reserve(unsigned numElements)
+    {
+        if (numElements > capacity_)
+            ReallocateEntries(numElements);
+
+        unsigned numSlots = CalculateNumSlots(numElements);
+        if (numSlots > numSlots_)
+            AllocateSlots(numSlots);
+    }
+
+    /// Return iterator to the pair with key, or end iterator if not found.
+    Iterator Find(const T& key)
+    {
+        unsigned pos = FindSlot(key, MixHash(MakeHash(key)));
+        return pos != EMPTY_SLOT ? Iterator(Entries() + slots_[pos].index_) : End();
+    }
+
+    /// Return const iterator to the pair with key, or end iterator if not found.
+    ConstIterator Find(const T& key) const
+    {
+        unsigned pos = FindSlot(key, MixHash(MakeHash(key)));
+        return pos != EMPTY_SLOT ? ConstIterator(Entries() + slots_[pos].index_) : End();
+    }
+
+    /// Return whether contains a pair with key.
+    bool Contains(const T& key) const { return FindSlot(key, MixHash(MakeHash(key))) != EMPTY_SLOT; }
+
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(size_);
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->first_);
+        return result;
+    }
+
+    /// Return all the values.
+    Vector<U> Values() const
+    {
+        Vector<U> result;
+        result.Reserve(size_);
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->second_);
+        return result;
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(Entries()); }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(Entries()); }
+
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(Entries() + size_); }
+
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(Entries() + size_); }
+
+    /// Return first key.
+    const T& Front() const { return Begin()->first_; }
+
+    /// Return last key.
+    const T& Back() const { return (End() - 1)->first_; }
+
+private:
+    /// Return the entry array.
+    KeyValue* Entries() const { return reinterpret_cast<KeyValue*>(entries_); }
+
+    /// Return the slot position of a key, or EMPTY_SLOT if not found.
+    unsigned FindSlot(const T& key, unsigned hash) const
+    {
+        if (!size_)
+            return EMPTY_SLOT;
+
+        unsigned mask = numSlots_ - 1;
+        unsigned pos = hash & mask;
+        KeyValue* entries = Entries();
+
+        for (unsigned distance = 0;; ++distance)
+        {
+            const FlatHashSlot& slot = slots_[pos];
+            // The key would have displaced any slot closer to its home position, so can stop at one
+            if (slot.index_ == EMPTY_SLOT || ProbeDistance(slot.hash_, pos) < distance)
+                return EMPTY_SLOT;
+            if (slot.hash_ == hash && entries[slot.index_].first_ == key)
+                return pos;
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    /// Append a new pair that is known not to exist. Return its entry index.
+    unsigned InsertEntry(const T& key, const U& value, unsigned hash)
+    {
+        if (!HasFreeSlot())
+            AllocateSlots(numSlots_ ? numSlots_ << 1 : MIN_SLOTS);
+
+        if (size_ == capacity_)
+        {
+            // Construct the new pair before freeing the old entries, in case the key or value refers to them
+            unsigned newCapacity = capacity_ ? capacity_ << 1 : MIN_CAPACITY;
+            unsigned char* newEntries = AllocateEntries(newCapacity * sizeof(KeyValue));
+            new(reinterpret_cast<KeyValue*>(newEntries) + size_) KeyValue(key, value);
+            MoveEntries(newEntries, newCapacity);
+        }
+        else
+            new(Entries() + size_) KeyValue(key, value);
+
+        InsertSlot(hash, size_);
+        return size_++;
+    }
+
+    /// Remove the pair referred to by a slot. Moves the last pair into the freed entry.
+    void EraseEntry(unsigned pos)
+    {
+        unsigned index = slots_[pos].index_;
+        unsigned last = size_ - 1;
+        KeyValue* entries = Entries();
+
+        EraseSlot(pos);
+        (entries + index)->~KeyValue();
+
+        if (index != last)
+        {
+            slots_[FindSlotByIndex(MixHash(MakeHash(entries[last].first_)), last)].index_ = index;
+            new(entries + index) KeyValue(entries[last]);
+            (entries + last)->~KeyValue();
+        }
+
+        --size_;
+    }
+
+    /// Reallocate the entry array to a new capacity.
+    void ReallocateEntries(unsigned newCapacity)
+    {
+        MoveEntries(AllocateEntries(newCapacity * sizeof(KeyValue)), newCapacity);
+    }
+
+    /// Copy the existing pairs to a new entry array and free the old one.
+    void MoveEntries(unsigned char* newEntries, unsigned newCapacity)
+    {
+        KeyValue* src = Entries();
+        KeyValue* dest = reinterpret_cast<KeyValue*>(newEntries);
+        for (unsigned i = 0; i < size_; ++i)
+        {
+            new(dest + i) KeyValue(src[i]);
+            (src + i)->~KeyValue();
+        }
+
+        delete[] entries_;
+        entries_ = newEntries;
+        capacity_ = newCapacity;
+    }
+};
+
+}
+
+namespace std
+{
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::ConstIterator begin(const Urho3D::FlatHashMap<T, U>& v) { return v.Begin(); }
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::ConstIterator end(const Urho3D::FlatHashMap<T, U>& v) { return v.End(); }
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::Iterator begin(Urho3D::FlatHashMap<T, U>& v) { return v.Begin(); }
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::Iterator end(Urho3D::FlatHashMap<T, U>& v) { return v.End(); }
+
+}
@@ -0,0 +1,296 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+#include "../Container/VectorBase.h"
+
+#include <cassert>
+#include <new>
+
+namespace Urho3D
+{
+
+/// Open addressing hash set template class. Faster than %HashSet for lookup-heavy use, but does not keep pointers stable.
+template <class T> class FlatHashSet : public FlatHashBase
+{
+public:
+    /// Keys are not modifiable through iterators, as that would break the hashing.
+    typedef RandomAccessConstIterator<T> Iterator;
+    typedef RandomAccessConstIterator<T> ConstIterator;
+
+    /// Construct empty.
+    FlatHashSet()
+    {
+    }
+
+    /// Construct from another hash set.
+    FlatHashSet(const FlatHashSet<T>& set)
+    {
+        Reserve(set.Size());
+        Insert(set);
+    }
+
+    /// Destruct.
+    ~FlatHashSet()
+    {
+        Clear();
+        delete[] entries_;
+        FreeSlots();
+    }
+
+    /// Assign a hash set.
+    FlatHashSet& operator =(const FlatHashSet<T>& rhs)
+    {
+        if (&rhs != this)
+        {
+            Clear();
+            Reserve(rhs.Size());
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Add-assign a value.
+    FlatHashSet& operator +=(const T& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a hash set.
+    FlatHashSet& operator +=(const FlatHashSet<T>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another hash set.
+    bool operator ==(const FlatHashSet<T>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            if (!rhs.Contains(*i))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another hash set.
+    bool operator !=(const FlatHashSet<T>& rhs) const { return !(*this == rhs); }
+
+    /// Insert a key. Return an iterator to it.
+    Iterator Insert(const T& key)
+    {
+        unsigned hash = MixHash(MakeHash(key));
+        unsigned pos = FindSlot(key, hash);
+        // Insert first, as inserting may reallocate the entries
+        unsigned index = pos != EMPTY_SLOT ? slots_[pos].index_ : InsertEntry(key, hash);
+        return Iterator(Entries() + index);
+    }
+
+    /// Insert a key. Return an iterator and set exists flag according to whether the key already existed.
+    Iterator Insert(const T& key, bool& exists)
+    {
+        unsigned hash = MixHash(MakeHash(key));
+        unsigned pos = FindSlot(key, hash);
+        exists = pos != EMPTY_SLOT;
+        unsigned index = exists ? slots_[pos].index_ : InsertEntry(key, hash);
+        return Iterator(Entries() + index);
+    }
+
+    /// Insert a set.
+    void Insert(const FlatHashSet<T>& set)
+    {
+        for (ConstIterator i = set.Begin(); i != set.End(); ++i)
+            Insert(*i);
+    }
+
+    /// Erase a key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned pos = FindSlot(key, MixHash(MakeHash(key)));
+        if (pos == EMPTY_SLOT)
+            return false;
+
+        EraseEntry(pos);
+        return true;
+    }
+
+    /// Erase a key by iterator. Return iterator to the next key, which is the former last key moved into its place.
+    Iterator Erase(const Iterator& it)
+    {
+        unsigned index = (unsigned)(it.ptr_ - Entries());
+        assert(index < size_);
+        EraseEntry(FindSlotByIndex(MixHash(MakeHash(*it)), index));
+        return Iterator(Entries() + index);
+    }
+
+    /// Clear the set. Keeps the entry and slot storage allocated for reuse.
+    void Clear()
+    {
+        T* entries = Entries();
+        for (unsigned i = 0; i < size_; ++i)
+            (entries + i)->~T();
+
+        size_ = 0;
+        ResetSlots();
+    }
+
+    /// Reserve room for the specified number of keys, so that inserting them does not reallocate.
+    void Reserve(unsigned numElements)
+    {
+        if (numElements > capacity_)
+            ReallocateEntries(numElements);
+
+        unsigned numSlots = CalculateNumSlots(numElements);
+        if (numSlots > numSlots_)
+            AllocateSlots(numSlots);
+    }
+
+    /// Return iterator to the key, or end iterator if not found.
+    Iterator Find(const T& key) const
+    {
+        unsigned pos = FindSlot(key, MixHash(MakeHash(key)));
+        return pos != EMPTY_SLOT ? Iterator(Entries() + slots_[pos].index_) : End();
+    }
+
+    /// Return whether contains a key.
+    bool Contains(const T& key) const { return FindSlot(key, MixHash(MakeHash(key))) != EMPTY_SLOT; }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() const { return Iterator(Entries()); }
+
+    /// Return iterator to the end.
+    Iterator End() const { return Iterator(Entries() + size_); }
+
+    /// Return first key.
+    const T& Front() const { return *Begin(); }
+
+    /// Return last key.
+    const T& Back() const { return *(End() - 1); }
+
+private:
+    /// Return the entry array.
+    T* Entries() const { return reinterpret_cast<T*>(entries_); }
+
+    /// Return the slot position of a key, or EMPTY_SLOT if not found.
+    unsigned FindSlot(const T& key, unsigned hash) const
+    {
+        if (!size_)
+            return EMPTY_SLOT;
+
+        unsigned mask = numSlots_ - 1;
+        unsigned pos = hash & mask;
+        T* entries = Entries();
+
+        for (unsigned distance = 0;; ++distance)
+        {
+            const FlatHashSlot& slot = slots_[pos];
+            // The key would have displaced any slot closer to its home position, so can stop at one
+            if (slot.index_ == EMPTY_SLOT || ProbeDistance(slot.hash_, pos) < distance)
+                return EMPTY_SLOT;
+            if (slot.hash_ == hash && entries[slot.index_] == key)
+                return pos;
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    /// Append a new key that is known not to exist. Return its entry index.
+    unsigned InsertEntry(const T& key, unsigned hash)
+    {
+        if (!HasFreeSlot())
+            AllocateSlots(numSlots_ ? numSlots_ << 1 : MIN_SLOTS);
+
+        if (size_ == capacity_)
+        {
+            // Construct the new key before freeing the old entries, in case the key refers to them
+            unsigned newCapacity = capacity_ ? capacity_ << 1 : MIN_CAPACITY;
+            unsigned char* newEntries = AllocateEntries(newCapacity * sizeof(T));
+            new(reinterpret_cast<T*>(newEntries) + size_) T(key);
+            MoveEntries(newEntries, newCapacity);
+        }
+        else
+            new(Entries() + size_) T(key);
+
+        InsertSlot(hash, size_);
+        return size_++;
+    }
+
+    /// Remove the key referred to by a slot. Moves the last key into the freed entry.
+    void EraseEntry(unsigned pos)
+    {
+        unsigned index = slots_[pos].index_;
+        unsigned last = size_ - 1;
+        T* entries = Entries();
+
+        EraseSlot(pos);
+        (entries + index)->~T();
+
+        if (index != last)
+        {
+            slots_[FindSlotByIndex(MixHash(MakeHash(entries[last])), last)].index_ = index;
+            new(entries + index) T(entries[last]);
+            (entries + last)->~T();
+        }
+
+        --size_;
+    }
+
+    /// Reallocate the entry array to a new capacity.
+    void ReallocateEntries(unsigned newCapacity)
+    {
+        MoveEntries(AllocateEntries(newCapacity * sizeof(T)), newCapacity);
+    }
+
+    /// Copy the existing keys to a new entry array and free the old one.
+    void MoveEntries(unsigned char* newEntries, unsigned newCapacity)
+    {
+        T* src = Entries();
+        T* dest = reinterpret_cast<T*>(newEntries);
+        for (unsigned i = 0; i < size_; ++i)
+        {
+            new(dest + i) T(src[i]);
+            (src + i)->~T();
+        }
+
+        delete[] entries_;
+        entries_ = newEntries;
+        capacity_ = newCapacity;
+    }
+};
+
+}
+
+namespace std
+{
+
+template <class T> typename Urho3D::FlatHashSet<T>::ConstIterator begin(const Urho3D::FlatHashSet<T>& v) { return v.Begin(); }
+
+template <class T> typename Urho3D::FlatHashSet<T>::ConstIterator end(const Urho3D::FlatHashSet<T>& v) { return v.End(); }
+
+}
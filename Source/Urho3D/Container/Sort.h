@@ -141,4 +141,63 @@ template <class T, class U> void Sort(RandomAccessIterator<T> begin, RandomAcces
     InsertionSort(begin, end, compare);
 }
 
+/// Key and value pair for radix sort.
+template <class T> struct RadixSortItem
+{
+    /// Sort key.
+    unsigned long long key_;
+    /// Value.
+    T value_;
+};
+
+/// Sort stably in ascending key order using a least significant digit radix sort. The temporary buffer must be as large as the array. Digits which are the same in all keys are skipped.
+template <class T> void RadixSort(RadixSortItem<T>* items, RadixSortItem<T>* temp, unsigned count)
+{
+    if (count < 2)
+        return;
+
+    // Build the histograms of all 8 digits in one pass
+    unsigned histograms[8][256];
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        for (unsigned j = 0; j < 256; ++j)
+            histograms[i][j] = 0;
+    }
+    for (unsigned i = 0; i < count; ++i)
+    {
+        unsigned long long key = items[i].key_;
+        for (unsigned j = 0; j < 8; ++j)
+            ++histograms[j][(key >> (j * 8)) & 0xff];
+    }
+
+    RadixSortItem<T>* src = items;
+    RadixSortItem<T>* dest = temp;
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        unsigned shift = i * 8;
+        unsigned* offsets = histograms[i];
+        if (offsets[(src[0].key_ >> shift) & 0xff] == count)
+            continue;
+
+        unsigned offset = 0;
+        for (unsigned j = 0; j < 256; ++j)
+        {
+            unsigned digitCount = offsets[j];
+            offsets[j] = offset;
+            offset += digitCount;
+        }
+
+        for (unsigned j = 0; j < count; ++j)
+            dest[offsets[(src[j].key_ >> shift) & 0xff]++] = src[j];
+
+        Swap(src, dest);
+    }
+
+    if (src != items)
+    {
+        for (unsigned i = 0; i < count; ++i)
+            items[i] = src[i];
+    }
+}
+
 }
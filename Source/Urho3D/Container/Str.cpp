@@ -35,14 +35,16 @@
 namespace Urho3D
 {
 
-char String::endZero = 0;
-
 const String String::EMPTY;
 
+// The heap buffer pointer must fit in the inline storage, and String must not grow beyond the Variant value storage
+typedef char StringBufferSizeCheck[sizeof(char*) <= String::SHORT_STRING_BUFFER_SIZE ? 1 : -1];
+typedef char StringSizeCheck[sizeof(String) == 2 * sizeof(unsigned) + String::SHORT_STRING_BUFFER_SIZE ? 1 : -1];
+
 String::String(const WString& str) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     SetUTF8FromWChar(str.CString());
 }
@@ -50,7 +52,7 @@ String::String(const WString& str) :
 String::String(int value) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%d", value);
@@ -60,7 +62,7 @@ String::String(int value) :
 String::String(short value) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%d", value);
@@ -70,7 +72,7 @@ String::String(short value) :
 String::String(long value) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%ld", value);
@@ -80,7 +82,7 @@ String::String(long value) :
 String::String(long long value) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%lld", value);
@@ -90,7 +92,7 @@ String::String(long long value) :
 String::String(unsigned value) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%u", value);
@@ -100,7 +102,7 @@ String::String(unsigned value) :
 String::String(unsigned short value) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%u", value);
@@ -110,7 +112,7 @@ String::String(unsigned short value) :
 String::String(unsigned long value) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%lu", value);
@@ -120,7 +122,7 @@ String::String(unsigned long value) :
 String::String(unsigned long long value) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%llu", value);
@@ -130,7 +132,7 @@ String::String(unsigned long long value) :
 String::String(float value) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%g", value);
@@ -140,7 +142,7 @@ String::String(float value) :
 String::String(double value) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%.15g", value);
@@ -150,7 +152,7 @@ String::String(double value) :
 String::String(bool value) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     if (value)
         *this = "true";
@@ -161,20 +163,21 @@ String::String(bool value) :
 String::String(char value) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     Resize(1);
-    buffer_[0] = value;
+    Buffer()[0] = value;
 }
 
 String::String(char value, unsigned length) :
     length_(0),
     capacity_(0),
-    buffer_(&endZero)
+    buffer_(0)
 {
     Resize(length);
+    char* buffer = Buffer();
     for (unsigned i = 0; i < length; ++i)
-        buffer_[i] = value;
+        buffer[i] = value;
 }
 
 String& String::operator +=(int rhs)
@@ -229,12 +232,14 @@ String& String::operator +=(bool rhs)
 
 void String::Replace(char replaceThis, char replaceWith, bool caseSensitive)
 {
+    char* buffer = Buffer();
+
     if (caseSensitive)
     {
         for (unsigned i = 0; i < length_; ++i)
         {
-            if (buffer_[i] == replaceThis)
-                buffer_[i] = replaceWith;
+            if (buffer[i] == replaceThis)
+                buffer[i] = replaceWith;
         }
     }
     else
@@ -242,8 +247,8 @@ void String::Replace(char replaceThis, char replaceWith, bool caseSensitive)
         replaceThis = (char)tolower(replaceThis);
         for (unsigned i = 0; i < length_; ++i)
         {
-            if (tolower(buffer_[i]) == replaceThis)
-                buffer_[i] = replaceWith;
+            if (tolower(buffer[i]) == replaceThis)
+                buffer[i] = replaceWith;
         }
     }
 }
@@ -268,7 +273,7 @@ void String::Replace(unsigned pos, unsigned length, const String& replaceWith)
     if (pos + length > length_)
         return;
 
-    Replace(pos, length, replaceWith.buffer_, replaceWith.length_);
+    Replace(pos, length, replaceWith.Buffer(), replaceWith.length_);
 }
 
 void String::Replace(unsigned pos, unsigned length, const char* replaceWith)
@@ -326,7 +331,7 @@ String& String::Append(const char* str, unsigned length)
     {
         unsigned oldLength = length_;
         Resize(oldLength + length);
-        CopyChars(&buffer_[oldLength], str, length);
+        CopyChars(&Buffer()[oldLength], str, length);
     }
     return *this;
 }
@@ -354,7 +359,7 @@ void String::Insert(unsigned pos, char c)
         unsigned oldLength = length_;
         Resize(length_ + 1);
         MoveRange(pos + 1, pos, oldLength - pos);
-        buffer_[pos] = c;
+        Buffer()[pos] = c;
     }
 }
 
@@ -417,52 +422,53 @@ String::Iterator String::Erase(const String::Iterator& start, const String::Iter
 
 void String::Resize(unsigned newLength)
 {
-    if (!capacity_)
+    if (IsShort())
     {
-        // If zero length requested, do not allocate buffer yet
-        if (!newLength)
-            return;
+        // Move the characters from the inline storage to the heap when they no longer fit. A heap buffer is never freed
+        // when shrinking, so that characters of the string itself stay valid as a source for assignment
+        if (newLength > SHORT_STRING_CAPACITY)
+        {
+            unsigned newCapacity = newLength + 1;
+            if (newCapacity < MIN_CAPACITY)
+                newCapacity = MIN_CAPACITY;
 
-        // Calculate initial capacity
-        capacity_ = newLength + 1;
-        if (capacity_ < MIN_CAPACITY)
-            capacity_ = MIN_CAPACITY;
+            char* newBuffer = new char[newCapacity];
+            CopyChars(newBuffer, shortBuffer_, length_);
 
-        buffer_ = new char[capacity_];
+            capacity_ = newCapacity;
+            buffer_ = newBuffer;
+        }
     }
-    else
+    else if (capacity_ < newLength + 1)
     {
-        if (newLength && capacity_ < newLength + 1)
-        {
-            // Increase the capacity with half each time it is exceeded
-            while (capacity_ < newLength + 1)
-                capacity_ += (capacity_ + 1) >> 1;
-
-            char* newBuffer = new char[capacity_];
-            // Move the existing data to the new buffer, then delete the old buffer
-            if (length_)
-                CopyChars(newBuffer, buffer_, length_);
-            delete[] buffer_;
+        // Increase the capacity with half each time it is exceeded
+        while (capacity_ < newLength + 1)
+            capacity_ += (capacity_ + 1) >> 1;
 
-            buffer_ = newBuffer;
-        }
+        char* newBuffer = new char[capacity_];
+        // Move the existing data to the new buffer, then delete the old buffer
+        CopyChars(newBuffer, buffer_, length_);
+        delete[] buffer_;
+
+        buffer_ = newBuffer;
     }
 
-    buffer_[newLength] = 0;
     length_ = newLength;
+    Buffer()[newLength] = 0;
 }
 
 void String::Reserve(unsigned newCapacity)
 {
     if (newCapacity < length_ + 1)
         newCapacity = length_ + 1;
-    if (newCapacity == capacity_)
+    // The inline storage already provides capacity for short strings
+    if (IsShort() ? newCapacity <= SHORT_STRING_BUFFER_SIZE : newCapacity == capacity_)
         return;
 
     char* newBuffer = new char[newCapacity];
     // Move the existing data to the new buffer, then delete the old buffer
-    CopyChars(newBuffer, buffer_, length_ + 1);
-    if (capacity_)
+    CopyChars(newBuffer, Buffer(), length_ + 1);
+    if (!IsShort())
         delete[] buffer_;
 
     capacity_ = newCapacity;
@@ -471,7 +477,18 @@ void String::Reserve(unsigned newCapacity)
 
 void String::Compact()
 {
-    if (capacity_)
+    if (IsShort())
+        return;
+
+    if (length_ <= SHORT_STRING_CAPACITY)
+    {
+        // Move the characters back to the inline storage, which overwrites the buffer pointer, then free the heap buffer
+        char* heapBuffer = buffer_;
+        CopyChars(shortBuffer_, heapBuffer, length_ + 1);
+        delete[] heapBuffer;
+        capacity_ = 0;
+    }
+    else
         Reserve(length_ + 1);
 }
 
@@ -484,7 +501,12 @@ void String::Swap(String& str)
 {
     Urho3D::Swap(length_, str.length_);
     Urho3D::Swap(capacity_, str.capacity_);
-    Urho3D::Swap(buffer_, str.buffer_);
+
+    // Swap the inline storage as a whole, as it holds either the characters or the heap buffer pointer
+    char temp[SHORT_STRING_BUFFER_SIZE];
+    memcpy(temp, shortBuffer_, SHORT_STRING_BUFFER_SIZE);
+    memcpy(shortBuffer_, str.shortBuffer_, SHORT_STRING_BUFFER_SIZE);
+    memcpy(str.shortBuffer_, temp, SHORT_STRING_BUFFER_SIZE);
 }
 
 String String::Substring(unsigned pos) const
@@ -493,7 +515,7 @@ String String::Substring(unsigned pos) const
     {
         String ret;
         ret.Resize(length_ - pos);
-        CopyChars(ret.buffer_, buffer_ + pos, ret.length_);
+        CopyChars(ret.Buffer(), Buffer() + pos, ret.length_);
 
         return ret;
     }
@@ -509,7 +531,7 @@ String String::Substring(unsigned pos, unsigned length) const
         if (pos + length > length_)
             length = length_ - pos;
         ret.Resize(length);
-        CopyChars(ret.buffer_, buffer_ + pos, ret.length_);
+        CopyChars(ret.Buffer(), Buffer() + pos, ret.length_);
 
         return ret;
     }
@@ -519,19 +541,20 @@ String String::Substring(unsigned pos, unsigned length) const
 
 String String::Trimmed() const
 {
+    const char* buffer = Buffer();
     unsigned trimStart = 0;
     unsigned trimEnd = length_;
 
     while (trimStart < trimEnd)
     {
-        char c = buffer_[trimStart];
+        char c = buffer[trimStart];
         if (c != ' ' && c != 9)
             break;
         ++trimStart;
     }
     while (trimEnd > trimStart)
     {
-        char c = buffer_[trimEnd - 1];
+        char c = buffer[trimEnd - 1];
         if (c != ' ' && c != 9)
             break;
         --trimEnd;
@@ -543,8 +566,9 @@ String String::Trimmed() const
 String String::ToLower() const
 {
     String ret(*this);
+    char* buffer = ret.Buffer();
     for (unsigned i = 0; i < ret.length_; ++i)
-        ret[i] = (char)tolower(buffer_[i]);
+        buffer[i] = (char)tolower(buffer[i]);
 
     return ret;
 }
@@ -552,8 +576,9 @@ String String::ToLower() const
 String String::ToUpper() const
 {
     String ret(*this);
+    char* buffer = ret.Buffer();
     for (unsigned i = 0; i < ret.length_; ++i)
-        ret[i] = (char)toupper(buffer_[i]);
+        buffer[i] = (char)toupper(buffer[i]);
 
     return ret;
 }
@@ -570,11 +595,13 @@ void String::Join(const Vector<String>& subStrings, const String& glue)
 
 unsigned String::Find(char c, unsigned startPos, bool caseSensitive) const
 {
+    const char* buffer = Buffer();
+
     if (caseSensitive)
     {
         for (unsigned i = startPos; i < length_; ++i)
         {
-            if (buffer_[i] == c)
+            if (buffer[i] == c)
                 return i;
         }
     }
@@ -583,7 +610,7 @@ unsigned String::Find(char c, unsigned startPos, bool caseSensitive) const
         c = (char)tolower(c);
         for (unsigned i = startPos; i < length_; ++i)
         {
-            if (tolower(buffer_[i]) == c)
+            if (tolower(buffer[i]) == c)
                 return i;
         }
     }
@@ -596,13 +623,15 @@ unsigned String::Find(const String& str, unsigned startPos, bool caseSensitive)
     if (!str.length_ || str.length_ > length_)
         return NPOS;
 
-    char first = str.buffer_[0];
+    const char* buffer = Buffer();
+    const char* strBuffer = str.Buffer();
+    char first = strBuffer[0];
     if (!caseSensitive)
         first = (char)tolower(first);
 
     for (unsigned i = startPos; i <= length_ - str.length_; ++i)
     {
-        char c = buffer_[i];
+        char c = buffer[i];
         if (!caseSensitive)
             c = (char)tolower(c);
 
@@ -612,8 +641,8 @@ unsigned String::Find(const String& str, unsigned startPos, bool caseSensitive)
             bool found = true;
             for (unsigned j = 1; j < str.length_; ++j)
             {
-                c = buffer_[i + j];
-                char d = str.buffer_[j];
+                c = buffer[i + j];
+                char d = strBuffer[j];
                 if (!caseSensitive)
                 {
                     c = (char)tolower(c);
@@ -644,11 +673,13 @@ unsigned String::FindLast(char c, unsigned startPos, bool caseSensitive) const
     if (startPos >= length_)
         startPos = length_ - 1;
 
+    const char* buffer = Buffer();
+
     if (caseSensitive)
     {
         for (unsigned i = startPos; i < length_; --i)
         {
-            if (buffer_[i] == c)
+            if (buffer[i] == c)
                 return i;
         }
     }
@@ -657,7 +688,7 @@ unsigned String::FindLast(char c, unsigned startPos, bool caseSensitive) const
         c = (char)tolower(c);
         for (unsigned i = startPos; i < length_; --i)
         {
-            if (tolower(buffer_[i]) == c)
+            if (tolower(buffer[i]) == c)
                 return i;
         }
     }
@@ -672,13 +703,15 @@ unsigned String::FindLast(const String& str, unsigned startPos, bool caseSensiti
     if (startPos > length_ - str.length_)
         startPos = length_ - str.length_;
 
-    char first = str.buffer_[0];
+    const char* buffer = Buffer();
+    const char* strBuffer = str.Buffer();
+    char first = strBuffer[0];
     if (!caseSensitive)
         first = (char)tolower(first);
 
     for (unsigned i = startPos; i < length_; --i)
     {
-        char c = buffer_[i];
+        char c = buffer[i];
         if (!caseSensitive)
             c = (char)tolower(c);
 
@@ -687,8 +720,8 @@ unsigned String::FindLast(const String& str, unsigned startPos, bool caseSensiti
             bool found = true;
             for (unsigned j = 1; j < str.length_; ++j)
             {
-                c = buffer_[i + j];
-                char d = str.buffer_[j];
+                c = buffer[i + j];
+                char d = strBuffer[j];
                 if (!caseSensitive)
                 {
                     c = (char)tolower(c);
@@ -781,10 +814,10 @@ unsigned String::LengthUTF8() const
 {
     unsigned ret = 0;
 
-    const char* src = buffer_;
+    const char* src = Buffer();
     if (!src)
         return ret;
-    const char* end = buffer_ + length_;
+    const char* end = Buffer() + length_;
 
     while (src < end)
     {
@@ -811,12 +844,10 @@ unsigned String::ByteOffsetUTF8(unsigned index) const
 
 unsigned String::NextUTF8Char(unsigned& byteOffset) const
 {
-    if (!buffer_)
-        return 0;
-
-    const char* src = buffer_ + byteOffset;
+    const char* buffer = Buffer();
+    const char* src = buffer + byteOffset;
     unsigned ret = DecodeUTF8(src);
-    byteOffset = (unsigned)(src - buffer_);
+    byteOffset = (unsigned)(src - buffer);
 
     return ret;
 }
@@ -1214,6 +1245,15 @@ int String::Compare(const char* lhs, const char* rhs, bool caseSensitive)
 
 void String::Replace(unsigned pos, unsigned length, const char* srcStart, unsigned srcLength)
 {
+    // If the replacement comes from this string, copy it first, as resizing may reallocate or move the characters
+    const char* buffer = Buffer();
+    if (srcStart >= buffer && srcStart < buffer + length_)
+    {
+        String src(srcStart, srcLength);
+        Replace(pos, length, src.Buffer(), srcLength);
+        return;
+    }
+
     int delta = (int)srcLength - (int)length;
 
     if (pos + length < length_)
@@ -1232,7 +1272,7 @@ void String::Replace(unsigned pos, unsigned length, const char* srcStart, unsign
     else
         Resize(length_ + delta);
 
-    CopyChars(buffer_ + pos, srcStart, srcLength);
+    CopyChars(Buffer() + pos, srcStart, srcLength);
 }
 
 WString::WString() :
@@ -47,7 +47,7 @@ public:
     String() :
         length_(0),
         capacity_(0),
-        buffer_(&endZero)
+        buffer_(0)
     {
     }
 
@@ -55,7 +55,7 @@ public:
     String(const String& str) :
         length_(0),
         capacity_(0),
-        buffer_(&endZero)
+        buffer_(0)
     {
         *this = str;
     }
@@ -64,7 +64,7 @@ public:
     String(const char* str) :
         length_(0),
         capacity_(0),
-        buffer_(&endZero)
+        buffer_(0)
     {
         *this = str;
     }
@@ -73,7 +73,7 @@ public:
     String(char* str) :
         length_(0),
         capacity_(0),
-        buffer_(&endZero)
+        buffer_(0)
     {
         *this = (const char*)str;
     }
@@ -82,17 +82,17 @@ public:
     String(const char* str, unsigned length) :
         length_(0),
         capacity_(0),
-        buffer_(&endZero)
+        buffer_(0)
     {
         Resize(length);
-        CopyChars(buffer_, str, length);
+        CopyChars(Buffer(), str, length);
     }
 
     /// Construct from a null-terminated wide character array.
     String(const wchar_t* str) :
         length_(0),
         capacity_(0),
-        buffer_(&endZero)
+        buffer_(0)
     {
         SetUTF8FromWChar(str);
     }
@@ -101,7 +101,7 @@ public:
     String(wchar_t* str) :
         length_(0),
         capacity_(0),
-        buffer_(&endZero)
+        buffer_(0)
     {
         SetUTF8FromWChar(str);
     }
@@ -140,7 +140,7 @@ public:
     template <class T> explicit String(const T& value) :
         length_(0),
         capacity_(0),
-        buffer_(&endZero)
+        buffer_(0)
     {
         *this = value.ToString();
     }
@@ -148,7 +148,7 @@ public:
     /// Destruct.
     ~String()
     {
-        if (capacity_)
+        if (!IsShort())
             delete[] buffer_;
     }
 
@@ -156,7 +156,7 @@ public:
     String& operator =(const String& rhs)
     {
         Resize(rhs.length_);
-        CopyChars(buffer_, rhs.buffer_, rhs.length_);
+        CopyChars(Buffer(), rhs.Buffer(), rhs.length_);
 
         return *this;
     }
@@ -165,8 +165,18 @@ public:
     String& operator =(const char* rhs)
     {
         unsigned rhsLength = CStringLength(rhs);
-        Resize(rhsLength);
-        CopyChars(buffer_, rhs, rhsLength);
+        const char* buffer = Buffer();
+        if (rhs >= buffer && rhs < buffer + length_)
+        {
+            // Assigning a part of this string: move the characters first, as shrinking never moves the buffer
+            MoveRange(0, (unsigned)(rhs - buffer), rhsLength);
+            Resize(rhsLength);
+        }
+        else
+        {
+            Resize(rhsLength);
+            CopyChars(Buffer(), rhs, rhsLength);
+        }
 
         return *this;
     }
@@ -175,8 +185,9 @@ public:
     String& operator +=(const String& rhs)
     {
         unsigned oldLength = length_;
-        Resize(length_ + rhs.length_);
-        CopyChars(buffer_ + oldLength, rhs.buffer_, rhs.length_);
+        unsigned rhsLength = rhs.length_;
+        Resize(length_ + rhsLength);
+        CopyChars(Buffer() + oldLength, rhs.Buffer(), rhsLength);
 
         return *this;
     }
@@ -187,7 +198,7 @@ public:
         unsigned rhsLength = CStringLength(rhs);
         unsigned oldLength = length_;
         Resize(length_ + rhsLength);
-        CopyChars(buffer_ + oldLength, rhs, rhsLength);
+        CopyChars(Buffer() + oldLength, rhs, rhsLength);
 
         return *this;
     }
@@ -197,7 +208,7 @@ public:
     {
         unsigned oldLength = length_;
         Resize(length_ + 1);
-        buffer_[oldLength] = rhs;
+        Buffer()[oldLength] = rhs;
 
         return *this;
     }
@@ -231,8 +242,8 @@ public:
     {
         String ret;
         ret.Resize(length_ + rhs.length_);
-        CopyChars(ret.buffer_, buffer_, length_);
-        CopyChars(ret.buffer_ + length_, rhs.buffer_, rhs.length_);
+        CopyChars(ret.Buffer(), Buffer(), length_);
+        CopyChars(ret.Buffer() + length_, rhs.Buffer(), rhs.length_);
 
         return ret;
     }
@@ -243,8 +254,8 @@ public:
         unsigned rhsLength = CStringLength(rhs);
         String ret;
         ret.Resize(length_ + rhsLength);
-        CopyChars(ret.buffer_, buffer_, length_);
-        CopyChars(ret.buffer_ + length_, rhs, rhsLength);
+        CopyChars(ret.Buffer(), Buffer(), length_);
+        CopyChars(ret.Buffer() + length_, rhs, rhsLength);
 
         return ret;
     }
@@ -286,28 +297,28 @@ public:
     char& operator [](unsigned index)
     {
         assert(index < length_);
-        return buffer_[index];
+        return Buffer()[index];
     }
 
     /// Return const char at index.
     const char& operator [](unsigned index) const
     {
         assert(index < length_);
-        return buffer_[index];
+        return Buffer()[index];
     }
 
     /// Return char at index.
     char& At(unsigned index)
     {
         assert(index < length_);
-        return buffer_[index];
+        return Buffer()[index];
     }
 
     /// Return const char at index.
     const char& At(unsigned index) const
     {
         assert(index < length_);
-        return buffer_[index];
+        return Buffer()[index];
     }
 
     /// Replace all occurrences of a character.
@@ -360,22 +371,22 @@ public:
     void Swap(String& str);
 
     /// Return iterator to the beginning.
-    Iterator Begin() { return Iterator(buffer_); }
+    Iterator Begin() { return Iterator(Buffer()); }
 
     /// Return const iterator to the beginning.
-    ConstIterator Begin() const { return ConstIterator(buffer_); }
+    ConstIterator Begin() const { return ConstIterator(Buffer()); }
 
     /// Return iterator to the end.
-    Iterator End() { return Iterator(buffer_ + length_); }
+    Iterator End() { return Iterator(Buffer() + length_); }
 
     /// Return const iterator to the end.
-    ConstIterator End() const { return ConstIterator(buffer_ + length_); }
+    ConstIterator End() const { return ConstIterator(Buffer() + length_); }
 
     /// Return first char, or 0 if empty.
-    char Front() const { return buffer_[0]; }
+    char Front() const { return Buffer()[0]; }
 
     /// Return last char, or 0 if empty.
-    char Back() const { return length_ ? buffer_[length_ - 1] : buffer_[0]; }
+    char Back() const { return length_ ? Buffer()[length_ - 1] : Buffer()[0]; }
 
     /// Return a substring from position to end.
     String Substring(unsigned pos) const;
@@ -405,13 +416,13 @@ public:
     bool EndsWith(const String& str, bool caseSensitive = true) const;
 
     /// Return the C string.
-    const char* CString() const { return buffer_; }
+    const char* CString() const { return Buffer(); }
 
     /// Return length.
     unsigned Length() const { return length_; }
 
     /// Return buffer capacity.
-    unsigned Capacity() const { return capacity_; }
+    unsigned Capacity() const { return IsShort() ? SHORT_STRING_CAPACITY + 1 : capacity_; }
 
     /// Return whether the string is empty.
     bool Empty() const { return length_ == 0; }
@@ -452,7 +463,7 @@ public:
     unsigned ToHash() const
     {
         unsigned hash = 0;
-        const char* ptr = buffer_;
+        const char* ptr = Buffer();
         while (*ptr)
         {
             hash = *ptr + (hash << 6) + (hash << 16) - hash;
@@ -504,6 +515,10 @@ public:
     static const unsigned NPOS = 0xffffffff;
     /// Initial dynamic allocation size.
     static const unsigned MIN_CAPACITY = 8;
+    /// Size of the inline character storage, which shares its space with the heap buffer pointer.
+    static const unsigned SHORT_STRING_BUFFER_SIZE = 8;
+    /// Maximum length of a string that is stored inline without a heap allocation.
+    static const unsigned SHORT_STRING_CAPACITY = SHORT_STRING_BUFFER_SIZE - 1;
     /// Empty string.
     static const String EMPTY;
 
@@ -512,7 +527,7 @@ private:
     void MoveRange(unsigned dest, unsigned src, unsigned count)
     {
         if (count)
-            memmove(buffer_ + dest, buffer_ + src, count);
+            memmove(Buffer() + dest, Buffer() + src, count);
     }
 
     /// Copy chars from one buffer to another.
@@ -535,15 +550,24 @@ private:
     /// Replace a substring with another substring.
     void Replace(unsigned pos, unsigned length, const char* srcStart, unsigned srcLength);
 
+    /// Return whether the characters are stored inline instead of in a heap buffer.
+    bool IsShort() const { return capacity_ == 0; }
+
+    /// Return the character buffer.
+    char* Buffer() const { return IsShort() ? const_cast<char*>(shortBuffer_) : buffer_; }
+
     /// String length.
     unsigned length_;
-    /// Capacity, zero if buffer not allocated.
+    /// Heap buffer capacity, or zero when the characters are stored inline.
     unsigned capacity_;
-    /// String buffer, null if not allocated.
-    char* buffer_;
 
-    /// End zero for empty strings.
-    static char endZero;
+    union
+    {
+        /// Heap buffer.
+        char* buffer_;
+        /// Inline characters of a short string. A null heap buffer pointer reads as an empty string.
+        char shortBuffer_[SHORT_STRING_BUFFER_SIZE];
+    };
 };
 
 /// Add a string to a C string.
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/FlatHashBase.h"
 #include "../Container/ListBase.h"
 
 namespace Urho3D
@@ -47,4 +48,9 @@ template <> void Swap<HashBase>(HashBase& first, HashBase& second)
     first.Swap(second);
 }
 
+template <> void Swap<FlatHashBase>(FlatHashBase& first, FlatHashBase& second)
+{
+    first.Swap(second);
+}
+
 }
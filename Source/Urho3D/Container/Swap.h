@@ -25,6 +25,7 @@
 namespace Urho3D
 {
 
+class FlatHashBase;
 class HashBase;
 class ListBase;
 class String;
@@ -42,5 +43,6 @@ template <> URHO3D_API void Swap<String>(String& first, String& second);
 template <> URHO3D_API void Swap<VectorBase>(VectorBase& first, VectorBase& second);
 template <> URHO3D_API void Swap<ListBase>(ListBase& first, ListBase& second);
 template <> URHO3D_API void Swap<HashBase>(HashBase& first, HashBase& second);
+template <> URHO3D_API void Swap<FlatHashBase>(FlatHashBase& first, FlatHashBase& second);
 
 }
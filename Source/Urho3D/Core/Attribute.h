@@ -49,6 +49,48 @@ static const unsigned AM_NODEIDVECTOR = 0x40;
 
 class Serializable;
 
+/// Network replication encoding of an attribute value.
+enum NetworkEncoding
+{
+    /// Full precision variant data.
+    NE_DEFAULT = 0,
+    /// Float, Vector2, Vector3 or Vector4 components clamped to a range and quantized to a number of bits each.
+    NE_QUANTIZED,
+    /// Normalized quaternion as the index of the largest component and the three smallest components quantized to a number of bits each.
+    NE_SMALLEST_THREE
+};
+
+/// Network replication encoding hint of an attribute. Both the server and the clients must use the same hints.
+struct NetworkEncodingHint
+{
+    /// Construct with full precision encoding.
+    NetworkEncodingHint() :
+        encoding_(NE_DEFAULT),
+        bits_(0),
+        minValue_(0.0f),
+        maxValue_(0.0f)
+    {
+    }
+
+    /// Construct with encoding, bits per component and the quantization range.
+    NetworkEncodingHint(NetworkEncoding encoding, unsigned bits, float minValue = 0.0f, float maxValue = 0.0f) :
+        encoding_(encoding),
+        bits_(bits),
+        minValue_(minValue),
+        maxValue_(maxValue)
+    {
+    }
+
+    /// Encoding.
+    NetworkEncoding encoding_;
+    /// Bits per quantized component.
+    unsigned bits_;
+    /// Minimum component value for quantization.
+    float minValue_;
+    /// Maximum component value for quantization.
+    float maxValue_;
+};
+
 /// Abstract base class for invoking attribute accessors.
 class URHO3D_API AttributeAccessor : public RefCounted
 {
@@ -139,6 +181,8 @@ struct AttributeInfo
     unsigned mode_;
     /// Attribute data pointer if elsewhere than in the Serializable.
     void* ptr_;
+    /// Network replication encoding hint.
+    NetworkEncodingHint networkHint_;
 };
 
 }
@@ -54,6 +54,7 @@ void RemoveNamedAttribute(HashMap<StringHash, Vector<AttributeInfo> >& attribute
 }
 
 Context::Context() :
+    typedEventSendDepth_(0),
     eventHandler_(0)
 {
 #ifdef ANDROID
@@ -137,6 +138,8 @@ void Context::RegisterAttribute(StringHash objectType, const AttributeInfo& attr
     }
 
     attributes_[objectType].Push(attr);
+    // Intern the name so that the attribute name hash can be reversed
+    StringHash::Intern(attr.name_);
 
     if (attr.mode_ & AM_NET)
         networkAttributes_[objectType].Push(attr);
@@ -155,6 +158,84 @@ void Context::UpdateAttributeDefaultValue(StringHash objectType, const char* nam
         info->defaultValue_ = defaultValue;
 }
 
+bool Context::SetAttributeNetworkHint(StringHash objectType, const char* name, const NetworkEncodingHint& hint)
+{
+    AttributeInfo* info = GetAttribute(objectType, name);
+    if (!info)
+        return false;
+
+    bool supported;
+    switch (hint.encoding_)
+    {
+    case NE_QUANTIZED:
+        supported = (info->type_ == VAR_FLOAT || info->type_ == VAR_VECTOR2 || info->type_ == VAR_VECTOR3 ||
+                     info->type_ == VAR_VECTOR4) && hint.maxValue_ > hint.minValue_;
+        break;
+
+    case NE_SMALLEST_THREE:
+        supported = info->type_ == VAR_QUATERNION;
+        break;
+
+    default:
+        supported = true;
+        break;
+    }
+
+    if (!supported)
+    {
+        URHO3D_LOGERROR("Unsupported network encoding hint for attribute " + String(name) + " of type " +
+            Variant::GetTypeName(info->type_));
+        return false;
+    }
+
+    info->networkHint_ = hint;
+
+    // The network attributes are stored separately
+    HashMap<StringHash, Vector<AttributeInfo> >::Iterator i = networkAttributes_.Find(objectType);
+    if (i != networkAttributes_.End())
+    {
+        for (Vector<AttributeInfo>::Iterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+        {
+            if (!j->name_.Compare(name, true))
+            {
+                j->networkHint_ = hint;
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+void Context::SendPostedEvents()
+{
+    {
+        MutexLock lock(postedEventsMutex_);
+        // Do nothing if called again from an event handler while sending
+        if (postedEvents_.Empty() || !sendingPostedEvents_.Empty())
+            return;
+        // Take the whole queue at once, so that the mutex is not held while sending and events posted by the handlers are sent on the next call
+        sendingPostedEvents_.Swap(postedEvents_);
+    }
+
+    for (unsigned i = 0; i < sendingPostedEvents_.Size(); ++i)
+    {
+        PostedEvent& event = sendingPostedEvents_[i];
+        // Sender is cleared if it was destroyed, possibly by a handler of an earlier event
+        if (event.sender_)
+            event.sender_->SendEvent(event.eventType_, event.eventData_);
+    }
+
+    MutexLock lock(postedEventsMutex_);
+    sendingPostedEvents_.Clear();
+}
+
+unsigned Context::GetNumPostedEvents() const
+{
+    MutexLock lock(postedEventsMutex_);
+    return postedEvents_.Size();
+}
+
 VariantMap& Context::GetEventDataMap()
 {
     unsigned nestingLevel = eventSenders_.Size();
@@ -268,4 +349,99 @@ void Context::RemoveEventReceiver(Object* receiver, Object* sender, StringHash e
         group->Erase(receiver);
 }
 
+void Context::PostEvent(Object* sender, StringHash eventType, const VariantMap& eventData, bool merge)
+{
+    MutexLock lock(postedEventsMutex_);
+
+    // If merging, replace the data of the same event from the same sender if it is still queued
+    if (merge)
+    {
+        for (unsigned i = postedEvents_.Size() - 1; i < postedEvents_.Size(); --i)
+        {
+            PostedEvent& event = postedEvents_[i];
+            if (event.sender_ == sender && event.eventType_ == eventType)
+            {
+                event.eventData_ = eventData;
+                return;
+            }
+        }
+    }
+
+    postedEvents_.Resize(postedEvents_.Size() + 1);
+    PostedEvent& event = postedEvents_.Back();
+    event.sender_ = sender;
+    event.eventType_ = eventType;
+    event.eventData_ = eventData;
+}
+
+void Context::RemovePostedEvents(Object* sender)
+{
+    // Lock also for the emptiness check, as other threads may be posting at the same time
+    MutexLock lock(postedEventsMutex_);
+
+    if (postedEvents_.Empty() && sendingPostedEvents_.Empty())
+        return;
+
+    for (Vector<PostedEvent>::Iterator i = postedEvents_.Begin(); i != postedEvents_.End(); ++i)
+    {
+        if (i->sender_ == sender)
+            i->sender_ = 0;
+    }
+    for (Vector<PostedEvent>::Iterator i = sendingPostedEvents_.Begin(); i != sendingPostedEvents_.End(); ++i)
+    {
+        if (i->sender_ == sender)
+            i->sender_ = 0;
+    }
+}
+
+void Context::AddTypedEventHandler(TypedEventHandler* handler)
+{
+    unsigned eventId = handler->GetEventId();
+    if (eventId >= typedEventHandlers_.Size())
+        typedEventHandlers_.Resize(eventId + 1);
+
+    typedEventHandlers_[eventId].Push(handler);
+}
+
+void Context::RemoveTypedEventHandler(TypedEventHandler* handler)
+{
+    unsigned eventId = handler->GetEventId();
+    if (eventId >= typedEventHandlers_.Size())
+        return;
+
+    PODVector<TypedEventHandler*>& handlers = typedEventHandlers_[eventId];
+    PODVector<TypedEventHandler*>::Iterator i = handlers.Find(handler);
+    if (i == handlers.End())
+        return;
+
+    // If sending typed events, only clear the slot so that indices stay valid for the sending loop
+    if (typedEventSendDepth_)
+    {
+        *i = 0;
+        if (!dirtyTypedEvents_.Contains(eventId))
+            dirtyTypedEvents_.Push(eventId);
+    }
+    else
+        handlers.Erase(i);
+}
+
+void Context::EndSendTypedEvent()
+{
+    if (--typedEventSendDepth_ || dirtyTypedEvents_.Empty())
+        return;
+
+    for (PODVector<unsigned>::ConstIterator i = dirtyTypedEvents_.Begin(); i != dirtyTypedEvents_.End(); ++i)
+    {
+        PODVector<TypedEventHandler*>& handlers = typedEventHandlers_[*i];
+        unsigned numHandlers = 0;
+        for (unsigned j = 0; j < handlers.Size(); ++j)
+        {
+            if (handlers[j])
+                handlers[numHandlers++] = handlers[j];
+        }
+        handlers.Resize(numHandlers);
+    }
+    dirtyTypedEvents_.Clear();
+}
+
 }
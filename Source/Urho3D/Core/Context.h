@@ -23,12 +23,24 @@
 #pragma once
 
 #include "../Core/Attribute.h"
+#include "../Core/Mutex.h"
 #include "../Core/Object.h"
 #include "../Container/HashSet.h"
 
 namespace Urho3D
 {
 
+/// Event posted to be sent later from the main thread.
+struct PostedEvent
+{
+    /// Sender. Null if destroyed before sending.
+    Object* sender_;
+    /// Event type.
+    StringHash eventType_;
+    /// Event data.
+    VariantMap eventData_;
+};
+
 /// Urho3D execution context. Provides access to subsystems, object factories and attributes, and event receivers.
 class URHO3D_API Context : public RefCounted
 {
@@ -60,8 +72,12 @@ public:
     void RemoveAttribute(StringHash objectType, const char* name);
     /// Update object attribute's default value.
     void UpdateAttributeDefaultValue(StringHash objectType, const char* name, const Variant& defaultValue);
+    /// Set object attribute's network replication encoding hint. Return true if successful.
+    bool SetAttributeNetworkHint(StringHash objectType, const char* name, const NetworkEncodingHint& hint);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap();
+    /// Send events posted from any thread since the last call. Must be called from the main thread. Called by Time at the beginning of each frame.
+    void SendPostedEvents();
 
     /// Copy base class attributes to derived class.
     void CopyBaseAttributes(StringHash baseType, StringHash derivedType);
@@ -79,6 +95,8 @@ public:
     template <class T, class U> void CopyBaseAttributes();
     /// Template version of updating an object attribute's default value.
     template <class T> void UpdateAttributeDefaultValue(const char* name, const Variant& defaultValue);
+    /// Template version of setting an object attribute's network replication encoding hint.
+    template <class T> bool SetAttributeNetworkHint(const char* name, const NetworkEncodingHint& hint);
 
     /// Return subsystem by type.
     Object* GetSubsystem(StringHash type) const;
@@ -144,6 +162,18 @@ public:
         return i != eventReceivers_.End() ? &i->second_ : 0;
     }
 
+    /// Return number of events waiting to be sent by SendPostedEvents().
+    unsigned GetNumPostedEvents() const;
+
+    /// Return number of typed event handler slots for a typed event id. Slots of handlers removed during sending are null until the send ends.
+    unsigned GetNumTypedEventHandlers(unsigned eventId) const
+    {
+        return eventId < typedEventHandlers_.Size() ? typedEventHandlers_[eventId].Size() : 0;
+    }
+
+    /// Return a typed event handler by typed event id and slot index.
+    TypedEventHandler* GetTypedEventHandler(unsigned eventId, unsigned index) const { return typedEventHandlers_[eventId][index]; }
+
 private:
     /// Add event receiver.
     void AddEventReceiver(Object* receiver, StringHash eventType);
@@ -155,6 +185,18 @@ private:
     void RemoveEventReceiver(Object* receiver, Object* sender, StringHash eventType);
     /// Remove event receiver from non-specific events.
     void RemoveEventReceiver(Object* receiver, StringHash eventType);
+    /// Add typed event handler.
+    void AddTypedEventHandler(TypedEventHandler* handler);
+    /// Remove typed event handler.
+    void RemoveTypedEventHandler(TypedEventHandler* handler);
+    /// Queue an event to be sent later from the main thread. Thread-safe.
+    void PostEvent(Object* sender, StringHash eventType, const VariantMap& eventData, bool merge);
+    /// Remove an event sender from the posted events. Called on its destruction.
+    void RemovePostedEvents(Object* sender);
+    /// Begin typed event send.
+    void BeginSendTypedEvent() { ++typedEventSendDepth_; }
+    /// End typed event send. Clean up typed event handlers removed in the meanwhile.
+    void EndSendTypedEvent();
 
     /// Set current event handler. Called by Object.
     void SetEventHandler(EventHandler* handler) { eventHandler_ = handler; }
@@ -177,6 +219,18 @@ private:
     HashMap<StringHash, HashSet<Object*> > eventReceivers_;
     /// Event receivers for specific senders' events.
     HashMap<Object*, HashMap<StringHash, HashSet<Object*> > > specificEventReceivers_;
+    /// Typed event handlers indexed by typed event id.
+    Vector<PODVector<TypedEventHandler*> > typedEventHandlers_;
+    /// Typed event ids which have had handlers removed during sending.
+    PODVector<unsigned> dirtyTypedEvents_;
+    /// Typed event send nesting depth.
+    unsigned typedEventSendDepth_;
+    /// Events posted for sending from the main thread.
+    Vector<PostedEvent> postedEvents_;
+    /// Posted events being sent.
+    Vector<PostedEvent> sendingPostedEvents_;
+    /// Mutex for posted events.
+    mutable Mutex postedEventsMutex_;
     /// Event sender stack.
     PODVector<Object*> eventSenders_;
     /// Event data stack.
@@ -211,4 +265,9 @@ template <class T> void Context::UpdateAttributeDefaultValue(const char* name, c
     UpdateAttributeDefaultValue(T::GetTypeStatic(), name, defaultValue);
 }
 
+template <class T> bool Context::SetAttributeNetworkHint(const char* name, const NetworkEncodingHint& hint)
+{
+    return SetAttributeNetworkHint(T::GetTypeStatic(), name, hint);
+}
+
 }
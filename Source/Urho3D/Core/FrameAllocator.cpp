@@ -0,0 +1,205 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/CoreEvents.h"
+#include "../Core/FrameAllocator.h"
+#include "../Core/WorkQueue.h"
+
+#include <cstring>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static inline unsigned AlignFrameArenaSize(unsigned size)
+{
+    return (size + FRAME_ARENA_ALIGNMENT - 1) & ~(FRAME_ARENA_ALIGNMENT - 1);
+}
+
+FrameArena::FrameArena(unsigned blockSize) :
+    blockSize_(AlignFrameArenaSize(Max((int)blockSize, (int)FRAME_ARENA_ALIGNMENT))),
+    currentBlock_(0),
+    offset_(0),
+    lastAllocation_(0),
+    usedBytes_(0),
+    lastUsedBytes_(0)
+{
+}
+
+FrameArena::~FrameArena()
+{
+    for (unsigned i = 0; i < blocks_.Size(); ++i)
+        delete[] blocks_[i];
+}
+
+void* FrameArena::Allocate(unsigned size)
+{
+    size = AlignFrameArenaSize(size);
+    if (!size)
+        size = FRAME_ARENA_ALIGNMENT;
+
+    if (currentBlock_ >= blocks_.Size() || offset_ + size > blockSizes_[currentBlock_])
+        NextBlock(size);
+
+    lastAllocation_ = blocks_[currentBlock_] + offset_;
+    offset_ += size;
+    usedBytes_ += size;
+    return lastAllocation_;
+}
+
+void* FrameArena::Reallocate(void* ptr, unsigned oldSize, unsigned newSize)
+{
+    if (!ptr)
+        return Allocate(newSize);
+
+    oldSize = AlignFrameArenaSize(oldSize);
+    newSize = AlignFrameArenaSize(newSize);
+    if (newSize <= oldSize)
+        return ptr;
+
+    // Grow in place if this was the most recent allocation and the block has room
+    if (ptr == lastAllocation_)
+    {
+        unsigned start = (unsigned)(lastAllocation_ - blocks_[currentBlock_]);
+        if (start + newSize <= blockSizes_[currentBlock_])
+        {
+            usedBytes_ += start + newSize - offset_;
+            offset_ = start + newSize;
+            return ptr;
+        }
+    }
+
+    void* newPtr = Allocate(newSize);
+    memcpy(newPtr, ptr, oldSize);
+    return newPtr;
+}
+
+void FrameArena::Reset()
+{
+    // If the frame needed more than one block, coalesce into one block so that the next frame has a single linear buffer
+    if (blocks_.Size() > 1)
+    {
+        unsigned totalSize = GetReservedBytes();
+        for (unsigned i = 0; i < blocks_.Size(); ++i)
+            delete[] blocks_[i];
+        blocks_.Resize(1);
+        blockSizes_.Resize(1);
+        blocks_[0] = new unsigned char[totalSize];
+        blockSizes_[0] = totalSize;
+    }
+
+    currentBlock_ = 0;
+    offset_ = 0;
+    lastAllocation_ = 0;
+    lastUsedBytes_ = usedBytes_;
+    usedBytes_ = 0;
+}
+
+unsigned FrameArena::GetReservedBytes() const
+{
+    unsigned total = 0;
+    for (unsigned i = 0; i < blockSizes_.Size(); ++i)
+        total += blockSizes_[i];
+    return total;
+}
+
+void FrameArena::NextBlock(unsigned size)
+{
+    // Skip the current block, as it is exhausted, unless nothing has been allocated from it yet
+    if (currentBlock_ < blocks_.Size() && offset_)
+        ++currentBlock_;
+
+    while (currentBlock_ < blocks_.Size() && blockSizes_[currentBlock_] < size)
+        ++currentBlock_;
+
+    if (currentBlock_ >= blocks_.Size())
+    {
+        unsigned newSize = Max((int)blockSize_, (int)size);
+        blocks_.Push(new unsigned char[newSize]);
+        blockSizes_.Push(newSize);
+        currentBlock_ = blocks_.Size() - 1;
+    }
+
+    offset_ = 0;
+}
+
+FrameAllocator::FrameAllocator(Context* context) :
+    Object(context)
+{
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    SetNumArenas(queue ? queue->GetNumThreads() + 1 : 1);
+
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(FrameAllocator, HandleEndFrame));
+}
+
+FrameAllocator::~FrameAllocator()
+{
+}
+
+void FrameAllocator::SetNumArenas(unsigned num)
+{
+    if (!num)
+        num = 1;
+
+    unsigned oldNum = arenas_.Size();
+    arenas_.Resize(num);
+    for (unsigned i = oldNum; i < num; ++i)
+        arenas_[i] = new FrameArena();
+}
+
+void* FrameAllocator::Allocate(unsigned size, unsigned threadIndex)
+{
+    FrameArena* arena = GetArena(threadIndex);
+    return arena ? arena->Allocate(size) : 0;
+}
+
+void FrameAllocator::Reset()
+{
+    for (unsigned i = 0; i < arenas_.Size(); ++i)
+        arenas_[i]->Reset();
+}
+
+unsigned FrameAllocator::GetLastUsedBytes() const
+{
+    unsigned total = 0;
+    for (unsigned i = 0; i < arenas_.Size(); ++i)
+        total += arenas_[i]->GetLastUsedBytes();
+    return total;
+}
+
+unsigned FrameAllocator::GetReservedBytes() const
+{
+    unsigned total = 0;
+    for (unsigned i = 0; i < arenas_.Size(); ++i)
+        total += arenas_[i]->GetReservedBytes();
+    return total;
+}
+
+void FrameAllocator::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    Reset();
+}
+
+}
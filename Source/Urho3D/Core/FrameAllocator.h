@@ -0,0 +1,211 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Object.h"
+
+namespace Urho3D
+{
+
+/// Default size of a frame arena memory block.
+static const unsigned DEFAULT_FRAME_ARENA_BLOCK_SIZE = 64 * 1024;
+/// Alignment of frame arena allocations.
+static const unsigned FRAME_ARENA_ALIGNMENT = 16;
+
+/// Linear memory arena for temporary allocations. Allocating bumps an offset in the current memory block, and all memory is released at once on reset. Not thread-safe, so each thread must use an arena of its own.
+class URHO3D_API FrameArena : public RefCounted
+{
+public:
+    /// Construct with the minimum memory block size.
+    FrameArena(unsigned blockSize = DEFAULT_FRAME_ARENA_BLOCK_SIZE);
+    /// Destruct. Free all memory blocks.
+    ~FrameArena();
+
+    /// Allocate memory. The memory stays valid until the arena is reset.
+    void* Allocate(unsigned size);
+    /// Grow the most recent allocation in place if possible, otherwise allocate anew and copy. Return the new memory.
+    void* Reallocate(void* ptr, unsigned oldSize, unsigned newSize);
+    /// Release all allocations. If several memory blocks were needed, replace them with one block that is large enough for all.
+    void Reset();
+
+    /// Return bytes allocated since the last reset.
+    unsigned GetUsedBytes() const { return usedBytes_; }
+    /// Return bytes used on the frame before the last reset.
+    unsigned GetLastUsedBytes() const { return lastUsedBytes_; }
+    /// Return total size of the memory blocks.
+    unsigned GetReservedBytes() const;
+
+private:
+    /// Make the next memory block current, allocating a new block if none is large enough.
+    void NextBlock(unsigned size);
+
+    /// Memory blocks.
+    PODVector<unsigned char*> blocks_;
+    /// Memory block sizes.
+    PODVector<unsigned> blockSizes_;
+    /// Minimum memory block size.
+    unsigned blockSize_;
+    /// Current memory block index.
+    unsigned currentBlock_;
+    /// Offset into the current memory block.
+    unsigned offset_;
+    /// Start of the most recent allocation.
+    unsigned char* lastAllocation_;
+    /// Bytes allocated since the last reset.
+    unsigned usedBytes_;
+    /// Bytes used on the frame before the last reset.
+    unsigned lastUsedBytes_;
+};
+
+/// Growable array of POD elements in a frame arena. The memory is not freed by the array but reclaimed when the arena is reset, so the array must not be accessed after that. Copies share the same memory and must not be grown independently.
+template <class T> class FrameVector
+{
+public:
+    typedef RandomAccessIterator<T> Iterator;
+    typedef RandomAccessConstIterator<T> ConstIterator;
+
+    /// Construct empty.
+    FrameVector(FrameArena* arena = 0) :
+        arena_(arena),
+        buffer_(0),
+        size_(0),
+        capacity_(0)
+    {
+    }
+
+    /// Set the arena and clear the array.
+    void SetArena(FrameArena* arena)
+    {
+        arena_ = arena;
+        buffer_ = 0;
+        size_ = 0;
+        capacity_ = 0;
+    }
+
+    /// Add an element at the end. The arena must have been set.
+    void Push(const T& value)
+    {
+        if (size_ == capacity_)
+            Reserve(capacity_ ? capacity_ * 2 : 8);
+        assert(buffer_);
+        buffer_[size_++] = value;
+    }
+
+    /// Reserve space for the specified number of elements. The arena must have been set.
+    void Reserve(unsigned newCapacity)
+    {
+        if (newCapacity <= capacity_)
+            return;
+
+        assert(arena_);
+        buffer_ = static_cast<T*>(arena_->Reallocate(buffer_, capacity_ * sizeof(T), newCapacity * sizeof(T)));
+        capacity_ = newCapacity;
+    }
+
+    /// Clear the array. The memory is kept for reuse.
+    void Clear() { size_ = 0; }
+
+    /// Return element at index.
+    T& operator [](unsigned index)
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Return const element at index.
+    const T& operator [](unsigned index) const
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(buffer_); }
+    /// Return const iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(buffer_); }
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(buffer_ + size_); }
+    /// Return const iterator to the end.
+    ConstIterator End() const { return ConstIterator(buffer_ + size_); }
+    /// Return number of elements.
+    unsigned Size() const { return size_; }
+    /// Return capacity.
+    unsigned Capacity() const { return capacity_; }
+    /// Return whether the array is empty.
+    bool Empty() const { return size_ == 0; }
+    /// Return the arena.
+    FrameArena* GetArena() const { return arena_; }
+
+private:
+    /// Arena the elements are allocated from.
+    FrameArena* arena_;
+    /// Element buffer.
+    T* buffer_;
+    /// Number of elements.
+    unsigned size_;
+    /// Buffer capacity in elements.
+    unsigned capacity_;
+};
+
+/// %Frame allocator subsystem. Provides a frame arena per thread for temporary memory that only needs to live until the end of the frame, and resets them on the end frame event. The arena index is the thread index given to work functions, 0 being the main thread.
+class URHO3D_API FrameAllocator : public Object
+{
+    URHO3D_OBJECT(FrameAllocator, Object);
+
+public:
+    /// Construct with an arena for the main thread and each worker thread.
+    FrameAllocator(Context* context);
+    /// Destruct.
+    virtual ~FrameAllocator();
+
+    /// Set number of arenas. Must be called while no other thread is using the allocator, for example after creating the worker threads.
+    void SetNumArenas(unsigned num);
+    /// Allocate memory from the arena of a thread. The memory stays valid until the end of the frame.
+    void* Allocate(unsigned size, unsigned threadIndex = 0);
+    /// Reset all arenas. Called automatically at the end of the frame.
+    void Reset();
+
+    /// Allocate an uninitialized array of POD elements from the arena of a thread.
+    template <class T> T* AllocateArray(unsigned count, unsigned threadIndex = 0)
+    {
+        return static_cast<T*>(Allocate(count * sizeof(T), threadIndex));
+    }
+
+    /// Return number of arenas.
+    unsigned GetNumArenas() const { return arenas_.Size(); }
+    /// Return the arena of a thread, or null if the index is out of range.
+    FrameArena* GetArena(unsigned threadIndex = 0) const { return threadIndex < arenas_.Size() ? arenas_[threadIndex].Get() : 0; }
+    /// Return bytes used by all arenas on the last frame.
+    unsigned GetLastUsedBytes() const;
+    /// Return total memory block size of all arenas.
+    unsigned GetReservedBytes() const;
+
+private:
+    /// Handle end of frame. Reset the arenas.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+
+    /// Arenas per thread.
+    Vector<SharedPtr<FrameArena> > arenas_;
+};
+
+}
@@ -0,0 +1,364 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/CoreEvents.h"
+#include "../Core/MemoryTracker.h"
+#include "../Core/StringUtils.h"
+#include "../Engine/EngineEvents.h"
+#include "../IO/Log.h"
+
+#include <SDL/SDL_atomic.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// DebugNew.h is not included, as this file replaces the global allocation operators
+
+namespace Urho3D
+{
+
+/// Allocation counters of a memory category. Plain data so that it is valid before static construction.
+struct MemoryCounters
+{
+    /// Currently allocated bytes.
+    unsigned long long memoryUse_;
+    /// Peak allocated bytes.
+    unsigned long long peakMemoryUse_;
+    /// Bytes allocated during the current frame.
+    unsigned long long frameBytes_;
+    /// Bytes allocated during the last frame.
+    unsigned long long lastFrameBytes_;
+    /// Memory budget.
+    unsigned long long memoryBudget_;
+    /// Number of live allocations.
+    unsigned numAllocations_;
+    /// Allocations made during the current frame.
+    unsigned frameAllocations_;
+    /// Allocations made during the last frame.
+    unsigned lastFrameAllocations_;
+};
+
+/// Header stored in front of each tracked allocation. Padded to keep the user data aligned as malloc() would.
+struct AllocationHeader
+{
+    /// User data size.
+    size_t size_;
+    /// Memory category.
+    unsigned category_;
+};
+
+static const size_t ALLOCATION_HEADER_SIZE = (sizeof(AllocationHeader) + 15) & ~((size_t)15);
+
+static const char* categoryNames[] =
+{
+    "Other",
+    "Scene",
+    "Resource",
+    "Graphics",
+    "Network",
+    "Script",
+    0
+};
+
+#ifdef _MSC_VER
+#define URHO3D_THREAD_LOCAL __declspec(thread)
+#else
+#define URHO3D_THREAD_LOCAL __thread
+#endif
+
+static MemoryCounters counters[MAX_MEMORY_CATEGORIES];
+static SDL_SpinLock countersLock = 0;
+static URHO3D_THREAD_LOCAL int currentCategory = MEMCAT_OTHER;
+
+#ifdef URHO3D_TRACK_MEMORY
+
+static void* AllocateTracked(size_t size)
+{
+    unsigned char* block = (unsigned char*)malloc(size + ALLOCATION_HEADER_SIZE);
+    if (!block)
+        return 0;
+
+    AllocationHeader* header = reinterpret_cast<AllocationHeader*>(block);
+    header->size_ = size;
+    header->category_ = (unsigned)currentCategory;
+
+    SDL_AtomicLock(&countersLock);
+    MemoryCounters& counter = counters[header->category_];
+    counter.memoryUse_ += size;
+    if (counter.memoryUse_ > counter.peakMemoryUse_)
+        counter.peakMemoryUse_ = counter.memoryUse_;
+    counter.frameBytes_ += size;
+    ++counter.numAllocations_;
+    ++counter.frameAllocations_;
+    SDL_AtomicUnlock(&countersLock);
+
+    return block + ALLOCATION_HEADER_SIZE;
+}
+
+static void FreeTracked(void* ptr)
+{
+    if (!ptr)
+        return;
+
+    unsigned char* block = (unsigned char*)ptr - ALLOCATION_HEADER_SIZE;
+    AllocationHeader* header = reinterpret_cast<AllocationHeader*>(block);
+
+    SDL_AtomicLock(&countersLock);
+    MemoryCounters& counter = counters[header->category_];
+    counter.memoryUse_ -= header->size_;
+    --counter.numAllocations_;
+    SDL_AtomicUnlock(&countersLock);
+
+    free(block);
+}
+
+#endif
+
+MemoryTracker::MemoryTracker(Context* context) :
+    Object(context)
+{
+    for (unsigned i = 0; i < MAX_MEMORY_CATEGORIES; ++i)
+        overBudget_[i] = false;
+
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(MemoryTracker, HandleEndFrame));
+    SubscribeToEvent(E_CONSOLECOMMAND, URHO3D_HANDLER(MemoryTracker, HandleConsoleCommand));
+}
+
+MemoryTracker::~MemoryTracker()
+{
+}
+
+void MemoryTracker::SetMemoryBudget(MemoryCategory category, unsigned long long budget)
+{
+    if (category >= MAX_MEMORY_CATEGORIES)
+        return;
+
+    SDL_AtomicLock(&countersLock);
+    counters[category].memoryBudget_ = budget;
+    SDL_AtomicUnlock(&countersLock);
+    overBudget_[category] = false;
+}
+
+void MemoryTracker::ResetPeaks()
+{
+    SDL_AtomicLock(&countersLock);
+    for (unsigned i = 0; i < MAX_MEMORY_CATEGORIES; ++i)
+        counters[i].peakMemoryUse_ = counters[i].memoryUse_;
+    SDL_AtomicUnlock(&countersLock);
+}
+
+MemoryCategoryStats MemoryTracker::GetStats(MemoryCategory category) const
+{
+    MemoryCategoryStats stats;
+    if (category >= MAX_MEMORY_CATEGORIES)
+        return stats;
+
+    SDL_AtomicLock(&countersLock);
+    const MemoryCounters& counter = counters[category];
+    stats.memoryUse_ = counter.memoryUse_;
+    stats.peakMemoryUse_ = counter.peakMemoryUse_;
+    stats.numAllocations_ = counter.numAllocations_;
+    stats.frameAllocations_ = counter.lastFrameAllocations_;
+    stats.frameBytes_ = counter.lastFrameBytes_;
+    stats.memoryBudget_ = counter.memoryBudget_;
+    SDL_AtomicUnlock(&countersLock);
+
+    return stats;
+}
+
+unsigned long long MemoryTracker::GetMemoryBudget(MemoryCategory category) const
+{
+    return category < MAX_MEMORY_CATEGORIES ? counters[category].memoryBudget_ : 0;
+}
+
+String MemoryTracker::PrintData() const
+{
+    String output = "Memory Category      Allocs     Frame  Frame Use      Peak    Budget     Total\n\n";
+    char outputLine[256];
+
+    if (!IsEnabled())
+        return output + "Allocation tracking disabled, build with URHO3D_TRACK_MEMORY\n";
+
+    MemoryCategoryStats total;
+    for (unsigned i = 0; i < MAX_MEMORY_CATEGORIES; ++i)
+    {
+        MemoryCategoryStats stats = GetStats((MemoryCategory)i);
+        total.memoryUse_ += stats.memoryUse_;
+        total.peakMemoryUse_ += stats.peakMemoryUse_;
+        total.numAllocations_ += stats.numAllocations_;
+        total.frameAllocations_ += stats.frameAllocations_;
+        total.frameBytes_ += stats.frameBytes_;
+        total.memoryBudget_ += stats.memoryBudget_;
+
+        sprintf(outputLine, "%-18s %8u %9u %10s %9s %9s %9s\n", categoryNames[i], stats.numAllocations_, stats.frameAllocations_,
+            GetFileSizeString(stats.frameBytes_).CString(), GetFileSizeString(stats.peakMemoryUse_).CString(),
+            GetFileSizeString(stats.memoryBudget_).CString(), GetFileSizeString(stats.memoryUse_).CString());
+        output += (const char*)outputLine;
+    }
+
+    sprintf(outputLine, "%-18s %8u %9u %10s %9s %9s %9s\n", "All", total.numAllocations_, total.frameAllocations_,
+        GetFileSizeString(total.frameBytes_).CString(), GetFileSizeString(total.peakMemoryUse_).CString(),
+        GetFileSizeString(total.memoryBudget_).CString(), GetFileSizeString(total.memoryUse_).CString());
+    output += (const char*)outputLine;
+
+    return output;
+}
+
+MemoryCategory MemoryTracker::SetCategory(MemoryCategory category)
+{
+    MemoryCategory previous = (MemoryCategory)currentCategory;
+    if (category < MAX_MEMORY_CATEGORIES)
+        currentCategory = category;
+    return previous;
+}
+
+MemoryCategory MemoryTracker::GetCategory()
+{
+    return (MemoryCategory)currentCategory;
+}
+
+const char* MemoryTracker::GetCategoryName(MemoryCategory category)
+{
+    return category < MAX_MEMORY_CATEGORIES ? categoryNames[category] : "";
+}
+
+bool MemoryTracker::IsEnabled()
+{
+#ifdef URHO3D_TRACK_MEMORY
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MemoryTracker::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    bool overBudget[MAX_MEMORY_CATEGORIES];
+
+    SDL_AtomicLock(&countersLock);
+    for (unsigned i = 0; i < MAX_MEMORY_CATEGORIES; ++i)
+    {
+        MemoryCounters& counter = counters[i];
+        counter.lastFrameAllocations_ = counter.frameAllocations_;
+        counter.lastFrameBytes_ = counter.frameBytes_;
+        counter.frameAllocations_ = 0;
+        counter.frameBytes_ = 0;
+        overBudget[i] = counter.memoryBudget_ && counter.memoryUse_ > counter.memoryBudget_;
+    }
+    SDL_AtomicUnlock(&countersLock);
+
+    // Log outside the lock, as logging allocates
+    for (unsigned i = 0; i < MAX_MEMORY_CATEGORIES; ++i)
+    {
+        if (overBudget[i] && !overBudget_[i])
+        {
+            MemoryCategoryStats stats = GetStats((MemoryCategory)i);
+            URHO3D_LOGWARNING("Memory category " + String(categoryNames[i]) + " exceeds its budget: " +
+                GetFileSizeString(stats.memoryUse_) + " used, budget " + GetFileSizeString(stats.memoryBudget_));
+        }
+        overBudget_[i] = overBudget[i];
+    }
+}
+
+void MemoryTracker::HandleConsoleCommand(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ConsoleCommand;
+    if (eventData[P_ID].GetString() != GetTypeName())
+        return;
+
+    Vector<String> arguments = eventData[P_COMMAND].GetString().Trimmed().Split(' ');
+    String command = arguments.Size() ? arguments[0].ToLower() : String::EMPTY;
+
+    if (command.Empty() || command == "print")
+        URHO3D_LOGRAW(PrintData());
+    else if (command == "reset")
+        ResetPeaks();
+    else if (command == "budget" && arguments.Size() == 3)
+    {
+        unsigned category = GetStringListIndex(arguments[1].CString(), categoryNames, M_MAX_UNSIGNED);
+        if (category >= MAX_MEMORY_CATEGORIES)
+        {
+            URHO3D_LOGERROR("Unknown memory category " + arguments[1]);
+            return;
+        }
+
+        // Budget is given in megabytes
+        SetMemoryBudget((MemoryCategory)category, (unsigned long long)(ToFloat(arguments[2]) * 1024.0f * 1024.0f));
+    }
+    else
+        URHO3D_LOGERROR("Unknown memory tracker command, use print, reset or budget <category> <megabytes>");
+}
+
+}
+
+#ifdef URHO3D_TRACK_MEMORY
+
+void* operator new(size_t size)
+{
+    void* ptr = Urho3D::AllocateTracked(size);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    void* ptr = Urho3D::AllocateTracked(size);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+    return Urho3D::AllocateTracked(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw()
+{
+    return Urho3D::AllocateTracked(size);
+}
+
+void operator delete(void* ptr) throw()
+{
+    Urho3D::FreeTracked(ptr);
+}
+
+void operator delete[](void* ptr) throw()
+{
+    Urho3D::FreeTracked(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) throw()
+{
+    Urho3D::FreeTracked(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) throw()
+{
+    Urho3D::FreeTracked(ptr);
+}
+
+#endif
@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Object.h"
+
+namespace Urho3D
+{
+
+/// Memory categories for allocation tracking.
+enum MemoryCategory
+{
+    MEMCAT_OTHER = 0,
+    MEMCAT_SCENE,
+    MEMCAT_RESOURCE,
+    MEMCAT_GRAPHICS,
+    MEMCAT_NETWORK,
+    MEMCAT_SCRIPT,
+    MAX_MEMORY_CATEGORIES
+};
+
+/// Allocation statistics of a memory category.
+struct URHO3D_API MemoryCategoryStats
+{
+    /// Construct with zero values.
+    MemoryCategoryStats() :
+        memoryUse_(0),
+        peakMemoryUse_(0),
+        numAllocations_(0),
+        frameAllocations_(0),
+        frameBytes_(0),
+        memoryBudget_(0)
+    {
+    }
+
+    /// Currently allocated bytes.
+    unsigned long long memoryUse_;
+    /// Peak allocated bytes since start or last peak reset.
+    unsigned long long peakMemoryUse_;
+    /// Number of live allocations.
+    unsigned numAllocations_;
+    /// Number of allocations made during the last frame.
+    unsigned frameAllocations_;
+    /// Bytes allocated during the last frame.
+    unsigned long long frameBytes_;
+    /// Memory budget in bytes, 0 for unlimited.
+    unsigned long long memoryBudget_;
+};
+
+/// %Memory tracker subsystem. Counts heap allocations by the memory category of the allocating thread. Allocations are only hooked when built with URHO3D_TRACK_MEMORY.
+class URHO3D_API MemoryTracker : public Object
+{
+    URHO3D_OBJECT(MemoryTracker, Object);
+
+public:
+    /// Construct.
+    MemoryTracker(Context* context);
+    /// Destruct.
+    virtual ~MemoryTracker();
+
+    /// Set memory budget for a category in bytes. A warning is logged when the budget is exceeded. 0 disables.
+    void SetMemoryBudget(MemoryCategory category, unsigned long long budget);
+    /// Reset peak memory use of all categories to their current memory use.
+    void ResetPeaks();
+
+    /// Return allocation statistics of a category.
+    MemoryCategoryStats GetStats(MemoryCategory category) const;
+    /// Return memory budget of a category.
+    unsigned long long GetMemoryBudget(MemoryCategory category) const;
+    /// Return allocation statistics of all categories as text.
+    String PrintData() const;
+
+    /// Set memory category for allocations made by the calling thread. Return the previous category.
+    static MemoryCategory SetCategory(MemoryCategory category);
+    /// Return memory category of the calling thread.
+    static MemoryCategory GetCategory();
+    /// Return name of a memory category.
+    static const char* GetCategoryName(MemoryCategory category);
+    /// Return whether allocations are being tracked.
+    static bool IsEnabled();
+
+private:
+    /// Handle frame end event. Finish the per-frame allocation counts and check budgets.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    /// Handle a console command.
+    void HandleConsoleCommand(StringHash eventType, VariantMap& eventData);
+
+    /// Over budget flags, so that each budget overrun is warned about once.
+    bool overBudget_[MAX_MEMORY_CATEGORIES];
+};
+
+/// Helper class for tagging allocations of the calling thread with a memory category until destroyed.
+class URHO3D_API MemoryCategoryScope
+{
+public:
+    /// Construct and set the category.
+    MemoryCategoryScope(MemoryCategory category) :
+        previous_(MemoryTracker::SetCategory(category))
+    {
+    }
+
+    /// Destruct and restore the previous category.
+    ~MemoryCategoryScope()
+    {
+        MemoryTracker::SetCategory(previous_);
+    }
+
+private:
+    /// Previous category.
+    MemoryCategory previous_;
+};
+
+#ifdef URHO3D_TRACK_MEMORY
+#define URHO3D_MEMORY_CATEGORY(category) Urho3D::MemoryCategoryScope memoryCategory_(Urho3D::category)
+#else
+#define URHO3D_MEMORY_CATEGORY(category)
+#endif
+
+}
@@ -183,6 +183,7 @@ Object::~Object()
 {
     UnsubscribeFromAllEvents();
     context_->RemoveEventSender(this);
+    context_->RemovePostedEvents(this);
 }
 
 void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData)
@@ -351,6 +352,18 @@ void Object::UnsubscribeFromAllEvents()
         else
             break;
     }
+
+    for (;;)
+    {
+        TypedEventHandler* handler = typedEventHandlers_.First();
+        if (handler)
+        {
+            context_->RemoveTypedEventHandler(handler);
+            typedEventHandlers_.Erase(handler);
+        }
+        else
+            break;
+    }
 }
 
 void Object::UnsubscribeFromAllEventsExcept(const PODVector<StringHash>& exceptions, bool onlyUserData)
@@ -490,6 +503,18 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     context->EndSendEvent();
 }
 
+void Object::PostEvent(StringHash eventType, bool merge)
+{
+    VariantMap noEventData;
+
+    PostEvent(eventType, noEventData, merge);
+}
+
+void Object::PostEvent(StringHash eventType, const VariantMap& eventData, bool merge)
+{
+    context_->PostEvent(this, eventType, eventData, merge);
+}
+
 VariantMap& Object::GetEventDataMap() const
 {
     return context_->GetEventDataMap();
@@ -610,4 +635,109 @@ void Object::RemoveEventSender(Object* sender)
     }
 }
 
+void Object::AddTypedEventHandler(TypedEventHandler* handler)
+{
+    // Remove old event handler first
+    RemoveTypedEventHandler(handler->GetEventId());
+
+    typedEventHandlers_.InsertFront(handler);
+
+    context_->AddTypedEventHandler(handler);
+}
+
+void Object::RemoveTypedEventHandler(unsigned eventId)
+{
+    TypedEventHandler* previous;
+    TypedEventHandler* handler = FindTypedEventHandler(eventId, &previous);
+    if (handler)
+    {
+        context_->RemoveTypedEventHandler(handler);
+        typedEventHandlers_.Erase(handler, previous);
+    }
+}
+
+TypedEventHandler* Object::FindTypedEventHandler(unsigned eventId, TypedEventHandler** previous) const
+{
+    TypedEventHandler* handler = typedEventHandlers_.First();
+    if (previous)
+        *previous = 0;
+
+    while (handler)
+    {
+        if (handler->GetEventId() == eventId)
+            return handler;
+        if (previous)
+            *previous = handler;
+        handler = typedEventHandlers_.Next(handler);
+    }
+
+    return 0;
+}
+
+void Object::SendTypedEvent(unsigned eventId, const void* eventData)
+{
+    if (!Thread::IsMainThread())
+    {
+        URHO3D_LOGERROR("Sending events is only supported from the main thread");
+        return;
+    }
+
+    Context* context = context_;
+    // Handlers subscribed during sending are not invoked until the next send
+    unsigned numHandlers = context->GetNumTypedEventHandlers(eventId);
+    if (!numHandlers)
+        return;
+
+    // Make a weak pointer to self to check for destruction during event handling
+    WeakPtr<Object> self(this);
+
+    context->BeginSendEvent(this);
+    context->BeginSendTypedEvent();
+
+    for (unsigned i = 0; i < numHandlers; ++i)
+    {
+        // Slot is null if the handler was removed during sending
+        TypedEventHandler* handler = context->GetTypedEventHandler(eventId, i);
+        if (!handler)
+            continue;
+
+        handler->Invoke(eventData);
+
+        // If self has been destroyed as a result of event handling, exit
+        if (self.Expired())
+            break;
+    }
+
+    context->EndSendTypedEvent();
+    context->EndSendEvent();
+}
+
+bool Object::HasEventReceivers(StringHash eventType) const
+{
+    const HashSet<Object*>* group = context_->GetEventReceivers(const_cast<Object*>(this), eventType);
+    if (group && !group->Empty())
+        return true;
+
+    group = context_->GetEventReceivers(eventType);
+    return group && !group->Empty();
+}
+
+bool Object::HasTypedEventReceivers(unsigned eventId) const
+{
+    return context_->GetNumTypedEventHandlers(eventId) != 0;
+}
+
+unsigned GetTypedEventId(const char* eventName)
+{
+    static HashMap<String, unsigned> typedEventIds;
+
+    HashMap<String, unsigned>::ConstIterator i = typedEventIds.Find(String(eventName));
+    if (i != typedEventIds.End())
+        return i->second_;
+
+    unsigned eventId = typedEventIds.Size();
+    typedEventIds[String(eventName)] = eventId;
+    return eventId;
+}
+
 }
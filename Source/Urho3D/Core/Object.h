@@ -30,6 +30,7 @@ namespace Urho3D
 
 class Context;
 class EventHandler;
+class TypedEventHandler;
 struct AttributeInfo;
 class AttributeProperty;
 
@@ -166,8 +167,18 @@ public:
     void SendEvent(StringHash eventType);
     /// Send event with parameters to all subscribers.
     void SendEvent(StringHash eventType, VariantMap& eventData);
+    /// Queue an event to be sent from the main thread at the beginning of the next frame. Can be called from any thread. If merge is true and the same event from this sender is still queued, only that event is kept with its data replaced.
+    void PostEvent(StringHash eventType, bool merge = false);
+    /// Queue an event with parameters to be sent from the main thread at the beginning of the next frame. Can be called from any thread, but outside the main thread the parameters must not contain RefCounted pointers. If merge is true and the same event from this sender is still queued, only that event is kept with its data replaced.
+    void PostEvent(StringHash eventType, const VariantMap& eventData, bool merge = false);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap() const;
+    /// Subscribe to a typed event. The handler function receives the event payload by const reference.
+    template <class T, class E> void SubscribeToTypedEvent(void (T::*function)(const E&));
+    /// Unsubscribe from a typed event.
+    template <class E> void UnsubscribeFromTypedEvent() { RemoveTypedEventHandler(E::GetEventIdStatic()); }
+    /// Send a typed event to all subscribers. Does not allocate memory.
+    template <class E> void SendTypedEvent(const E& eventData) { SendTypedEvent(E::GetEventIdStatic(), &eventData); }
 
     /// Return execution context.
     Context* GetContext() const { return context_; }
@@ -184,7 +195,13 @@ public:
     bool HasSubscribedToEvent(Object* sender, StringHash eventType) const;
 
     /// Return whether has subscribed to any event.
-    bool HasEventHandlers() const { return !eventHandlers_.Empty(); }
+    bool HasEventHandlers() const { return !eventHandlers_.Empty() || !typedEventHandlers_.Empty(); }
+    /// Return whether has subscribed to a typed event.
+    template <class E> bool HasSubscribedToTypedEvent() const { return FindTypedEventHandler(E::GetEventIdStatic()) != 0; }
+    /// Return whether a typed event has any subscribers. Can be used to skip filling the payload.
+    template <class E> bool HasTypedEventReceivers() const { return HasTypedEventReceivers(E::GetEventIdStatic()); }
+    /// Return whether an event sent by this object has any receivers, either specific to this sender or non-specific. Can be used to skip filling the event data.
+    bool HasEventReceivers(StringHash eventType) const;
 
     /// Template version of returning a subsystem.
     template <class T> T* GetSubsystem() const;
@@ -204,9 +221,21 @@ private:
     EventHandler* FindSpecificEventHandler(Object* sender, StringHash eventType, EventHandler** previous = 0) const;
     /// Remove event handlers related to a specific sender.
     void RemoveEventSender(Object* sender);
+    /// Add a typed event handler, replacing an existing handler of the same event.
+    void AddTypedEventHandler(TypedEventHandler* handler);
+    /// Remove the handler of a typed event.
+    void RemoveTypedEventHandler(unsigned eventId);
+    /// Find the handler of a typed event.
+    TypedEventHandler* FindTypedEventHandler(unsigned eventId, TypedEventHandler** previous = 0) const;
+    /// Send a typed event by id.
+    void SendTypedEvent(unsigned eventId, const void* eventData);
+    /// Return whether a typed event has any subscribers.
+    bool HasTypedEventReceivers(unsigned eventId) const;
 
     /// Event handlers. Sender is null for non-specific handlers.
     LinkedList<EventHandler> eventHandlers_;
+    /// Typed event handlers.
+    LinkedList<TypedEventHandler> typedEventHandlers_;
 };
 
 template <class T> T* Object::GetSubsystem() const { return static_cast<T*>(GetSubsystem(T::GetTypeStatic())); }
@@ -359,6 +388,71 @@ private:
     HandlerFunctionPtr function_;
 };
 
+/// Internal helper class for invoking typed event handler functions.
+class URHO3D_API TypedEventHandler : public LinkedListNode
+{
+public:
+    /// Construct with specified receiver and event id.
+    TypedEventHandler(Object* receiver, unsigned eventId) :
+        receiver_(receiver),
+        eventId_(eventId)
+    {
+        assert(receiver_);
+    }
+
+    /// Destruct.
+    virtual ~TypedEventHandler() { }
+
+    /// Invoke event handler function.
+    virtual void Invoke(const void* eventData) = 0;
+
+    /// Return event receiver.
+    Object* GetReceiver() const { return receiver_; }
+
+    /// Return event id.
+    unsigned GetEventId() const { return eventId_; }
+
+protected:
+    /// Event receiver.
+    Object* receiver_;
+    /// Event id.
+    unsigned eventId_;
+};
+
+/// Template implementation of the typed event handler invoke helper (stores a function pointer of specific class and payload type.)
+template <class T, class E> class TypedEventHandlerImpl : public TypedEventHandler
+{
+public:
+    typedef void (T::*HandlerFunctionPtr)(const E&);
+
+    /// Construct with receiver and function pointers.
+    TypedEventHandlerImpl(T* receiver, HandlerFunctionPtr function) :
+        TypedEventHandler(receiver, E::GetEventIdStatic()),
+        function_(function)
+    {
+        assert(function_);
+    }
+
+    /// Invoke event handler function.
+    virtual void Invoke(const void* eventData)
+    {
+        T* receiver = static_cast<T*>(receiver_);
+        (receiver->*function_)(*static_cast<const E*>(eventData));
+    }
+
+private:
+    /// Class-specific pointer to handler function.
+    HandlerFunctionPtr function_;
+};
+
+template <class T, class E> void Object::SubscribeToTypedEvent(void (T::*function)(const E&))
+{
+    AddTypedEventHandler(new TypedEventHandlerImpl<T, E>(static_cast<T*>(this), function));
+}
+
+/// Return the process-wide id of a typed event by name, allocating a new id on first use.
+URHO3D_API unsigned GetTypedEventId(const char* eventName);
+
 template <class T>
 T* TypeInfoCast(Object* obj)
 {
@@ -393,6 +487,8 @@ SharedPtr<T> TypeInfoCast(const SharedPtr<Object>& obj)
 #define URHO3D_EVENT(eventID, eventName) static const Urho3D::StringHash eventID(#eventName); namespace eventName
 /// Describe an event's parameter hash ID. Should be used inside an event namespace.
 #define URHO3D_PARAM(paramID, paramName) static const Urho3D::StringHash paramID(#paramName)
+/// Describe a typed event. Should be used inside the event's payload struct, which should be plain data.
+#define URHO3D_TYPED_EVENT(eventName) static unsigned GetEventIdStatic() { static const unsigned eventId = Urho3D::GetTypedEventId(#eventName); return eventId; }
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function.
 #define URHO3D_HANDLER(className, function) (new Urho3D::EventHandlerImpl<className>(this, &className::function))
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function, and also defines a userdata pointer.
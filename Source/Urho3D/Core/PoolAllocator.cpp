@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/PoolAllocator.h"
+
+#include <SDL/SDL_atomic.h>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+PoolAllocator::PoolAllocator(unsigned initialCapacity) :
+    initialCapacity_(initialCapacity),
+    heapLock_(0)
+{
+    for (unsigned i = 0; i < NUM_POOL_SIZE_CLASSES; ++i)
+    {
+        allocators_[i] = 0;
+        locks_[i] = 0;
+        numAllocations_[i] = 0;
+    }
+    numAllocations_[NUM_POOL_SIZE_CLASSES] = 0;
+}
+
+PoolAllocator::~PoolAllocator()
+{
+    for (unsigned i = 0; i < NUM_POOL_SIZE_CLASSES; ++i)
+        AllocatorUninitialize(allocators_[i]);
+}
+
+void* PoolAllocator::Allocate(unsigned size)
+{
+    unsigned sizeClass = GetSizeClass(size);
+    if (sizeClass < NUM_POOL_SIZE_CLASSES)
+    {
+        SDL_AtomicLock(&locks_[sizeClass]);
+        if (!allocators_[sizeClass])
+            allocators_[sizeClass] = AllocatorInitialize(MIN_POOL_BLOCK_SIZE << sizeClass, initialCapacity_);
+        void* ptr = AllocatorReserve(allocators_[sizeClass]);
+        ++numAllocations_[sizeClass];
+        SDL_AtomicUnlock(&locks_[sizeClass]);
+        return ptr;
+    }
+    else
+    {
+        SDL_AtomicLock(&heapLock_);
+        ++numAllocations_[NUM_POOL_SIZE_CLASSES];
+        SDL_AtomicUnlock(&heapLock_);
+        return new unsigned char[size];
+    }
+}
+
+void PoolAllocator::Free(void* ptr, unsigned size)
+{
+    if (!ptr)
+        return;
+
+    unsigned sizeClass = GetSizeClass(size);
+    if (sizeClass < NUM_POOL_SIZE_CLASSES)
+    {
+        SDL_AtomicLock(&locks_[sizeClass]);
+        AllocatorFree(allocators_[sizeClass], ptr);
+        --numAllocations_[sizeClass];
+        SDL_AtomicUnlock(&locks_[sizeClass]);
+    }
+    else
+    {
+        delete[] static_cast<unsigned char*>(ptr);
+        SDL_AtomicLock(&heapLock_);
+        --numAllocations_[NUM_POOL_SIZE_CLASSES];
+        SDL_AtomicUnlock(&heapLock_);
+    }
+}
+
+unsigned PoolAllocator::GetNumAllocations() const
+{
+    unsigned total = 0;
+    for (unsigned i = 0; i <= NUM_POOL_SIZE_CLASSES; ++i)
+        total += numAllocations_[i];
+    return total;
+}
+
+unsigned PoolAllocator::GetSizeClass(unsigned size)
+{
+    unsigned sizeClass = 0;
+    unsigned blockSize = MIN_POOL_BLOCK_SIZE;
+
+    while (blockSize < size && sizeClass < NUM_POOL_SIZE_CLASSES)
+    {
+        blockSize <<= 1;
+        ++sizeClass;
+    }
+
+    return sizeClass;
+}
+
+}
@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Allocator.h"
+
+namespace Urho3D
+{
+
+/// Number of size classes in a pool allocator.
+static const unsigned NUM_POOL_SIZE_CLASSES = 8;
+/// Size of the smallest pool allocator size class. The following classes double in size.
+static const unsigned MIN_POOL_BLOCK_SIZE = 16;
+/// Size of the largest pool allocator size class. Larger allocations go to the heap.
+static const unsigned MAX_POOL_BLOCK_SIZE = MIN_POOL_BLOCK_SIZE << (NUM_POOL_SIZE_CLASSES - 1);
+
+/// Thread-safe allocator of small memory blocks. Allocations are rounded up to a power of two size class, and each class has a fixed-size allocator of its own guarded by a spin lock, so that threads allocating different sizes do not contend. A size class reserves memory only once it is first used.
+class URHO3D_API PoolAllocator
+{
+public:
+    /// Construct with the initial capacity of each size class once it is used.
+    PoolAllocator(unsigned initialCapacity = 16);
+    /// Destruct. Free all blocks.
+    ~PoolAllocator();
+
+    /// Allocate memory of the specified size.
+    void* Allocate(unsigned size);
+    /// Free memory previously allocated with the same size.
+    void Free(void* ptr, unsigned size);
+
+    /// Return number of live allocations, including those which went to the heap.
+    unsigned GetNumAllocations() const;
+
+    /// Return the size class index of an allocation size, or NUM_POOL_SIZE_CLASSES if too large for the pool.
+    static unsigned GetSizeClass(unsigned size);
+
+private:
+    /// Prevent copy construction.
+    PoolAllocator(const PoolAllocator& rhs);
+    /// Prevent assignment.
+    PoolAllocator& operator =(const PoolAllocator& rhs);
+
+    /// Fixed-size allocators per size class, null until first used.
+    AllocatorBlock* allocators_[NUM_POOL_SIZE_CLASSES];
+    /// Initial capacity of the size classes.
+    unsigned initialCapacity_;
+    /// Spin locks per size class.
+    int locks_[NUM_POOL_SIZE_CLASSES];
+    /// Live allocation counts per size class, the last one counting heap allocations. Guarded by the size class locks.
+    unsigned numAllocations_[NUM_POOL_SIZE_CLASSES + 1];
+    /// Spin lock for the heap allocation count.
+    int heapLock_;
+};
+
+}
@@ -24,6 +24,10 @@
 
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../IO/File.h"
+#include "../IO/FileSystem.h"
+#include "../IO/Log.h"
+#include "../IO/Serializer.h"
 
 #include <cstdio>
 
@@ -40,14 +44,37 @@ Profiler::Profiler(Context* context) :
     current_(0),
     root_(0),
     intervalFrames_(0),
-    totalFrames_(0)
+    totalFrames_(0),
+    captureStartTime_(0),
+    capturing_(false),
+    historyIndex_(0),
+    numHistoryFrames_(0),
+    spikeBudget_(0.0f),
+    spikeFrameNumber_(0),
+    spikeDumpCountdown_(0)
 {
     root_ = new ProfilerBlock(0, "Root");
     current_ = root_;
+
+    // The main thread's blocks are kept in the main block tree
+    threads_[0] = new ProfilerThread();
+    threads_[0]->id_ = Thread::GetCurrentThreadID();
+    threads_[0]->root_ = root_;
+    threads_[0]->current_ = root_;
+    SDL_AtomicSet(&numThreads_, 1);
 }
 
 Profiler::~Profiler()
 {
+    unsigned numThreads = GetNumThreads();
+    for (unsigned i = 1; i < numThreads; ++i)
+    {
+        delete threads_[i]->root_;
+        delete threads_[i]->localRoot_;
+        delete threads_[i];
+    }
+    delete threads_[0];
+
     delete root_;
     root_ = 0;
 }
@@ -71,6 +98,16 @@ void Profiler::EndFrame()
             ++totalFrames_;
         root_->EndFrame();
         current_ = root_;
+
+        unsigned numThreads = GetNumThreads();
+        for (unsigned i = 1; i < numThreads; ++i)
+        {
+            ProcessThreadEvents(threads_[i]);
+            threads_[i]->root_->EndFrame();
+        }
+
+        if (!frameHistory_.Empty())
+            RecordFrame();
     }
 }
 
@@ -78,6 +115,139 @@ void Profiler::BeginInterval()
 {
     root_->BeginInterval();
     intervalFrames_ = 0;
+
+    unsigned numThreads = GetNumThreads();
+    for (unsigned i = 1; i < numThreads; ++i)
+        threads_[i]->root_->BeginInterval();
+}
+
+void Profiler::StartCapture(unsigned maxEventsPerThread)
+{
+    // Events that were written before the capture started go only to the block trees
+    StopCapture();
+
+    unsigned numThreads = GetNumThreads();
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        MutexLock lock(threads_[i]->mutex_);
+        threads_[i]->events_.Resize(maxEventsPerThread);
+        threads_[i]->numEvents_ = 0;
+    }
+
+    captureStartTime_ = eventTimer_.GetUSec(false);
+    capturing_ = true;
+}
+
+void Profiler::StopCapture()
+{
+    // Include the events that the other threads have written so far
+    if (capturing_)
+    {
+        unsigned numThreads = GetNumThreads();
+        for (unsigned i = 1; i < numThreads; ++i)
+            ProcessThreadEvents(threads_[i]);
+    }
+
+    capturing_ = false;
+}
+
+bool Profiler::SaveChromeTrace(Serializer& dest) const
+{
+    String output = "{\"traceEvents\":[\n";
+    bool first = true;
+
+    unsigned numThreads = GetNumThreads();
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        ProfilerThread* thread = threads_[i];
+        MutexLock lock(thread->mutex_);
+        String threadName = i ? "Thread " + String(i) : String("Main thread");
+
+        if (!first)
+            output += ",\n";
+        first = false;
+        output += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" + String(i) + ",\"args\":{\"name\":\"" +
+            threadName + "\"}}";
+
+        unsigned numEvents = thread->numEvents_;
+        for (unsigned j = 0; j < numEvents; ++j)
+        {
+            const ProfilerEvent& event = thread->events_[j];
+            // Block names are C identifiers or resource names; escape the characters that would break the JSON string
+            String name(event.name_);
+            name.Replace("\\", "\\\\");
+            name.Replace("\"", "\\\"");
+            output += ",\n{\"name\":\"" + name + (event.begin_ ? "\",\"ph\":\"B\",\"ts\":" : "\",\"ph\":\"E\",\"ts\":") +
+                String(event.time_) + ",\"pid\":0,\"tid\":" + String(i) + "}";
+
+            // Flush periodically to avoid building the whole capture in memory
+            if (output.Length() > 65536)
+            {
+                if (dest.Write(output.CString(), output.Length()) != output.Length())
+                    return false;
+                output.Clear();
+            }
+        }
+    }
+
+    output += "\n]}\n";
+    return dest.Write(output.CString(), output.Length()) == output.Length();
+}
+
+void Profiler::SetFrameHistorySize(unsigned frames)
+{
+    frameHistory_.Clear();
+    frameHistory_.Resize(frames);
+    historyIndex_ = 0;
+    numHistoryFrames_ = 0;
+    spikeFrameNumber_ = 0;
+}
+
+void Profiler::SetSpikeDump(float budgetMs, const String& directory)
+{
+    spikeBudget_ = Max(budgetMs, 0.0f);
+    spikeDumpDirectory_ = directory.Empty() ? String::EMPTY : AddTrailingSlash(directory);
+    spikeFrameNumber_ = 0;
+}
+
+bool Profiler::SaveFrameHistory(Serializer& dest) const
+{
+    String output = "{\"spikeBudgetMs\":" + String(spikeBudget_) + ",\"spikeFrame\":" + String(spikeFrameNumber_) +
+        ",\"frames\":[";
+
+    for (unsigned i = numHistoryFrames_ - 1; i < numHistoryFrames_; --i)
+    {
+        const ProfilerFrame& frame = *GetHistoryFrame(i);
+
+        output += "\n{\"frame\":" + String(frame.frameNumber_) + ",\"timeMs\":" + String(frame.time_ / 1000.0f) +
+            ",\"blocks\":[";
+        for (unsigned j = 0; j < frame.blocks_.Size(); ++j)
+        {
+            const ProfilerFrameBlock& block = frame.blocks_[j];
+            String name(block.name_);
+            name.Replace("\\", "\\\\");
+            name.Replace("\"", "\\\"");
+
+            if (j)
+                output += ",";
+            output += "\n{\"name\":\"" + name + "\",\"thread\":" + String(block.thread_) + ",\"depth\":" +
+                String(block.depth_) + ",\"count\":" + String(block.count_) + ",\"timeMs\":" + String(block.time_ / 1000.0f) +
+                ",\"maxMs\":" + String(block.maxTime_ / 1000.0f) + "}";
+        }
+        output += i ? "]}," : "]}";
+    }
+
+    output += "\n]}\n";
+    return dest.Write(output.CString(), output.Length()) == output.Length();
+}
+
+const ProfilerFrame* Profiler::GetHistoryFrame(unsigned index) const
+{
+    if (index >= numHistoryFrames_)
+        return 0;
+
+    unsigned size = frameHistory_.Size();
+    return &frameHistory_[(historyIndex_ + size - 1 - index) % size];
 }
 
 String Profiler::PrintData(bool showUnused, bool showTotal, unsigned maxDepth) const
@@ -97,6 +267,16 @@ String Profiler::PrintData(bool showUnused, bool showTotal, unsigned maxDepth) c
 
     PrintData(root_, output, 0, maxDepth, showUnused, showTotal);
 
+    unsigned numThreads = GetNumThreads();
+    for (unsigned i = 1; i < numThreads; ++i)
+    {
+        if (showUnused || !threads_[i]->root_->children_.Empty())
+        {
+            output += "\nThread " + String(i) + "\n\n";
+            PrintData(threads_[i]->root_, output, 0, maxDepth, showUnused, showTotal);
+        }
+    }
+
     return output;
 }
 
@@ -111,8 +291,8 @@ void Profiler::PrintData(ProfilerBlock* block, String& output, unsigned depth, u
     if (depth >= maxDepth)
         return;
 
-    // Do not print the root block as it does not collect any actual data
-    if (block != root_)
+    // Do not print the root blocks as they do not collect any actual data
+    if (block->parent_)
     {
         if (showUnused || block->intervalCount_ || (showTotal && block->totalCount_))
         {
@@ -156,4 +336,211 @@ void Profiler::PrintData(ProfilerBlock* block, String& output, unsigned depth, u
         PrintData(*i, output, depth, maxDepth, showUnused, showTotal);
 }
 
+unsigned Profiler::GetNumThreads() const
+{
+    unsigned numThreads = (unsigned)SDL_AtomicGet(const_cast<SDL_atomic_t*>(&numThreads_));
+    // Pairs with the release barrier in GetCurrentThread(), so that the data of the counted threads is visible
+    SDL_MemoryBarrierAcquire();
+    return numThreads;
+}
+
+void Profiler::BeginThreadBlock(const char* name)
+{
+    ProfilerThread* thread = GetCurrentThread();
+    if (!thread)
+        return;
+
+    // The thread's own block tree keeps a copy of the name, which stays valid after the caller's string is gone
+    thread->localCurrent_ = thread->localCurrent_->GetChild(name);
+
+    // Write the begin event only if the end events of all open blocks still fit afterward. Otherwise drop the block along
+    // with the blocks nested in it
+    unsigned head = (unsigned)SDL_AtomicGet(&thread->ringHead_);
+    unsigned tail = (unsigned)SDL_AtomicGet(&thread->ringTail_);
+    if (!thread->droppedBlocks_ && thread->ring_.Size() - (head - tail) >= thread->openBlocks_ + 2)
+    {
+        ProfilerEvent& event = thread->ring_[head & (thread->ring_.Size() - 1)];
+        event.name_ = thread->localCurrent_->name_;
+        event.time_ = eventTimer_.GetUSec(false);
+        event.begin_ = true;
+        // Publish the event only after it has been written
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&thread->ringHead_, (int)(head + 1));
+        ++thread->openBlocks_;
+    }
+    else
+        ++thread->droppedBlocks_;
+}
+
+void Profiler::EndThreadBlock()
+{
+    ProfilerThread* thread = GetCurrentThread();
+    if (!thread || thread->localCurrent_ == thread->localRoot_)
+        return;
+
+    if (thread->droppedBlocks_)
+        --thread->droppedBlocks_;
+    else
+    {
+        // Room for the end event was ensured when the block began
+        unsigned head = (unsigned)SDL_AtomicGet(&thread->ringHead_);
+        ProfilerEvent& event = thread->ring_[head & (thread->ring_.Size() - 1)];
+        event.name_ = thread->localCurrent_->name_;
+        event.time_ = eventTimer_.GetUSec(false);
+        event.begin_ = false;
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&thread->ringHead_, (int)(head + 1));
+        --thread->openBlocks_;
+    }
+
+    thread->localCurrent_ = thread->localCurrent_->parent_;
+}
+
+ProfilerThread* Profiler::GetCurrentThread()
+{
+    ThreadID id = Thread::GetCurrentThreadID();
+
+    // Threads are only ever added, and are counted only after their data has been written, so they can be searched without locking
+    unsigned numThreads = GetNumThreads();
+    for (unsigned i = 1; i < numThreads; ++i)
+    {
+        if (threads_[i]->id_ == id)
+            return threads_[i];
+    }
+
+    MutexLock lock(threadsMutex_);
+
+    numThreads = GetNumThreads();
+    if (numThreads >= MAX_PROFILER_THREADS)
+        return 0;
+
+    ProfilerThread* thread = new ProfilerThread();
+    thread->id_ = id;
+    thread->root_ = new ProfilerBlock(0, "Root");
+    thread->current_ = thread->root_;
+    thread->localRoot_ = new ProfilerBlock(0, "Root");
+    thread->localCurrent_ = thread->localRoot_;
+    thread->ring_.Resize(PROFILER_THREAD_RING_EVENTS);
+    threads_[numThreads] = thread;
+    // Make the new thread's data visible before it is counted
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&numThreads_, (int)(numThreads + 1));
+
+    return thread;
+}
+
+void Profiler::ProcessThreadEvents(ProfilerThread* thread)
+{
+    unsigned head = (unsigned)SDL_AtomicGet(&thread->ringHead_);
+    // Pairs with the release barrier after writing an event, so that the events up to the head are visible
+    SDL_MemoryBarrierAcquire();
+    unsigned tail = (unsigned)SDL_AtomicGet(&thread->ringTail_);
+    if (head == tail)
+        return;
+
+    // The capture buffer may be exported from another thread
+    MutexLock lock(thread->mutex_);
+    // A thread that registered during the capture gets a buffer like the existing threads' buffers
+    if (capturing_ && thread->events_.Size() < threads_[0]->events_.Size())
+        thread->events_.Resize(threads_[0]->events_.Size());
+
+    for (; tail != head; ++tail)
+    {
+        const ProfilerEvent& event = thread->ring_[tail & (thread->ring_.Size() - 1)];
+        if (event.begin_)
+        {
+            thread->current_ = thread->current_->GetChild(event.name_);
+            thread->beginTimes_.Push(event.time_);
+        }
+        else if (thread->current_ != thread->root_)
+        {
+            thread->current_->AddTime(event.time_ - thread->beginTimes_.Back());
+            thread->beginTimes_.Pop();
+            thread->current_ = thread->current_->parent_;
+        }
+
+        if (capturing_ && event.time_ >= captureStartTime_)
+            RecordEvent(thread, event.name_, event.time_ - captureStartTime_, event.begin_);
+    }
+
+    // Hand the read slots back to the thread only after they have been read
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&thread->ringTail_, (int)tail);
+}
+
+void Profiler::RecordFrame()
+{
+    // Reuse the oldest frame's storage, so that no allocation happens once the history has filled up
+    ProfilerFrame& frame = frameHistory_[historyIndex_];
+    frame.frameNumber_ = totalFrames_;
+    frame.time_ = 0;
+    frame.blocks_.Clear();
+
+    for (PODVector<ProfilerBlock*>::ConstIterator i = root_->children_.Begin(); i != root_->children_.End(); ++i)
+        frame.time_ += (*i)->frameTime_;
+
+    RecordFrameBlocks(frame, root_, 0, 0);
+    unsigned numThreads = GetNumThreads();
+    for (unsigned i = 1; i < numThreads; ++i)
+        RecordFrameBlocks(frame, threads_[i]->root_, i, 0);
+
+    historyIndex_ = (historyIndex_ + 1) % frameHistory_.Size();
+    if (numHistoryFrames_ < frameHistory_.Size())
+        ++numHistoryFrames_;
+
+    // Detect a spike, then wait until it is in the middle of the history so that the frames around it are included
+    if (spikeFrameNumber_)
+    {
+        if (!--spikeDumpCountdown_)
+        {
+            DumpFrameHistory();
+            spikeFrameNumber_ = 0;
+        }
+    }
+    else if (spikeBudget_ > 0.0f && frame.time_ > (long long)(spikeBudget_ * 1000.0f))
+    {
+        spikeFrameNumber_ = frame.frameNumber_;
+        spikeDumpCountdown_ = frameHistory_.Size() / 2;
+        if (!spikeDumpCountdown_)
+        {
+            DumpFrameHistory();
+            spikeFrameNumber_ = 0;
+        }
+    }
+}
+
+void Profiler::RecordFrameBlocks(ProfilerFrame& frame, ProfilerBlock* block, unsigned thread, unsigned depth)
+{
+    for (PODVector<ProfilerBlock*>::ConstIterator i = block->children_.Begin(); i != block->children_.End(); ++i)
+    {
+        ProfilerBlock* child = *i;
+        if (!child->frameCount_)
+            continue;
+
+        ProfilerFrameBlock record;
+        record.name_ = child->name_;
+        record.thread_ = thread;
+        record.depth_ = depth;
+        record.count_ = child->frameCount_;
+        record.time_ = child->frameTime_;
+        record.maxTime_ = child->frameMaxTime_;
+        frame.blocks_.Push(record);
+
+        RecordFrameBlocks(frame, child, thread, depth + 1);
+    }
+}
+
+void Profiler::DumpFrameHistory()
+{
+    if (spikeDumpDirectory_.Empty())
+        return;
+
+    String fileName = spikeDumpDirectory_ + "ProfilerSpike_" + String(spikeFrameNumber_) + ".json";
+    File file(context_, fileName, FILE_WRITE);
+    if (file.IsOpen() && SaveFrameHistory(file))
+        URHO3D_LOGINFO("Frame " + String(spikeFrameNumber_) + " exceeded the frame time budget, wrote profiler history to " + fileName);
+    else
+        URHO3D_LOGERROR("Could not write profiler history to " + fileName);
+}
+
 }
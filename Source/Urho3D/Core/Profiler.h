@@ -23,12 +23,17 @@
 #pragma once
 
 #include "../Container/Str.h"
+#include "../Core/Mutex.h"
 #include "../Core/Thread.h"
 #include "../Core/Timer.h"
 
+#include <SDL/SDL_atomic.h>
+
 namespace Urho3D
 {
 
+class Serializer;
+
 /// Profiling data for one block in the profiling tree.
 class URHO3D_API ProfilerBlock
 {
@@ -86,6 +91,15 @@ public:
         time_ += time;
     }
     
+    /// Add a call that was timed elsewhere.
+    void AddTime(long long time)
+    {
+        ++count_;
+        if (time > maxTime_)
+            maxTime_ = time;
+        time_ += time;
+    }
+    
     /// End profiling frame and update interval and total values.
     void EndFrame()
     {
@@ -168,6 +182,100 @@ public:
     unsigned totalCount_;
 };
 
+/// Block begin or end event recorded during a profiler capture.
+struct ProfilerEvent
+{
+    /// Block name. Points to the name owned by the profiling block.
+    const char* name_;
+    /// Time in microseconds since the capture started, or since the profiler was created in the thread event ring buffers.
+    long long time_;
+    /// Whether the block began (true) or ended (false).
+    bool begin_;
+};
+
+/// Profiling data of one thread.
+struct ProfilerThread
+{
+    /// Construct.
+    ProfilerThread() :
+        id_(0),
+        root_(0),
+        current_(0),
+        localRoot_(0),
+        localCurrent_(0),
+        openBlocks_(0),
+        droppedBlocks_(0),
+        numEvents_(0)
+    {
+        SDL_AtomicSet(&ringHead_, 0);
+        SDL_AtomicSet(&ringTail_, 0);
+    }
+
+    /// Operating system thread ID.
+    ThreadID id_;
+    /// Root profiling block. Other threads than the main thread have their tree built by the main thread from the ring buffer events.
+    ProfilerBlock* root_;
+    /// Current profiling block.
+    ProfilerBlock* current_;
+    /// Begin times of the blocks being built from the ring buffer events, innermost last.
+    PODVector<long long> beginTimes_;
+    /// Root of the block tree owned by the thread itself. Keeps the block names referred to by the ring buffer events.
+    ProfilerBlock* localRoot_;
+    /// Current block in the thread's own block tree.
+    ProfilerBlock* localCurrent_;
+    /// Number of blocks whose begin event was written to the ring buffer and end event is still to be written.
+    unsigned openBlocks_;
+    /// Number of innermost blocks whose events were dropped because the ring buffer was full.
+    unsigned droppedBlocks_;
+    /// Block begin and end event ring buffer. Written by the owning thread and read by the main thread without locking.
+    PODVector<ProfilerEvent> ring_;
+    /// Number of events written to the ring buffer. Modified only by the owning thread.
+    SDL_atomic_t ringHead_;
+    /// Number of events read from the ring buffer. Modified only by the main thread.
+    SDL_atomic_t ringTail_;
+    /// Mutex for the capture event buffer, taken when capturing and exporting.
+    Mutex mutex_;
+    /// Capture event buffer.
+    PODVector<ProfilerEvent> events_;
+    /// Number of events written to the capture buffer.
+    unsigned numEvents_;
+};
+
+/// Timing of one profiling block on one frame, recorded into the frame history.
+struct ProfilerFrameBlock
+{
+    /// Block name. Points to the name owned by the profiling block.
+    const char* name_;
+    /// Thread index, 0 being the main thread.
+    unsigned thread_;
+    /// Depth in the block tree.
+    unsigned depth_;
+    /// Calls on the frame.
+    unsigned count_;
+    /// Time on the frame.
+    long long time_;
+    /// Maximum time on the frame.
+    long long maxTime_;
+};
+
+/// Profiling block timings of one frame.
+struct ProfilerFrame
+{
+    /// Frame number.
+    unsigned frameNumber_;
+    /// Total time of the main thread blocks.
+    long long time_;
+    /// Blocks that were called on the frame, in depth-first order.
+    PODVector<ProfilerFrameBlock> blocks_;
+};
+
+/// Maximum number of threads that can be profiled, including the main thread.
+static const unsigned MAX_PROFILER_THREADS = 64;
+/// Default capture event buffer size per thread.
+static const unsigned DEFAULT_PROFILER_CAPTURE_EVENTS = 65536;
+/// Block begin and end event ring buffer size of other threads than the main thread. Must be a power of two.
+static const unsigned PROFILER_THREAD_RING_EVENTS = 8192;
+
 /// Hierarchical performance profiler subsystem.
 class URHO3D_API Profiler : public Object
 {
@@ -179,36 +287,75 @@ public:
     /// Destruct.
     virtual ~Profiler();
     
-    /// Begin timing a profiling block.
+    /// Begin timing a profiling block. Blocks of other threads than the main thread are collected into per-thread trees.
     void BeginBlock(const char* name)
     {
-        // Profiler supports only the main thread currently
         if (!Thread::IsMainThread())
+        {
+            BeginThreadBlock(name);
             return;
+        }
         
         current_ = current_->GetChild(name);
         current_->Begin();
+        if (capturing_)
+            RecordEvent(threads_[0], current_->name_, eventTimer_.GetUSec(false) - captureStartTime_, true);
     }
     
     /// End timing the current profiling block.
     void EndBlock()
     {
         if (!Thread::IsMainThread())
+        {
+            EndThreadBlock();
             return;
+        }
         
         if (current_ != root_)
         {
             current_->End();
+            if (capturing_)
+                RecordEvent(threads_[0], current_->name_, eventTimer_.GetUSec(false) - captureStartTime_, false);
             current_ = current_->parent_;
         }
     }
     
     /// Begin the profiling frame. Called by HandleBeginFrame().
     void BeginFrame();
-    /// End the profiling frame. Called by HandleEndFrame().
+    /// End the profiling frame and update the other threads' block trees from their events. Called by HandleEndFrame().
     void EndFrame();
     /// Begin a new interval.
     void BeginInterval();
+    /// Start capturing block begin and end events of all threads with timestamps comparable across threads. Previously captured events are discarded. Call from the main thread.
+    void StartCapture(unsigned maxEventsPerThread = DEFAULT_PROFILER_CAPTURE_EVENTS);
+    /// Stop capturing events. The captured events are retained until the next capture starts. Call from the main thread.
+    void StopCapture();
+    /// Write the captured events in Chrome trace event JSON format, viewable in chrome://tracing. Return true if successful.
+    bool SaveChromeTrace(Serializer& dest) const;
+    /// Set number of frames of block timings to keep in the frame history ring buffer. 0 (default) disables.
+    void SetFrameHistorySize(unsigned frames);
+    /// Set frame time budget in milliseconds and the directory to write the frame history to when a frame exceeds the budget. The dump is written once the over-budget frame is in the middle of the history. Zero budget (default) disables.
+    void SetSpikeDump(float budgetMs, const String& directory);
+    /// Write the frame history in JSON format, oldest frame first. Return true if successful.
+    bool SaveFrameHistory(Serializer& dest) const;
+    
+    /// Return frame history size.
+    unsigned GetFrameHistorySize() const { return frameHistory_.Size(); }
+    /// Return number of recorded frames in the history.
+    unsigned GetNumHistoryFrames() const { return numHistoryFrames_; }
+    /// Return a recorded frame from the history, 0 being the most recent. Return null if out of range.
+    const ProfilerFrame* GetHistoryFrame(unsigned index) const;
+    /// Return frame time budget in milliseconds for spike dumps.
+    float GetSpikeBudget() const { return spikeBudget_; }
+    /// Return spike dump directory.
+    const String& GetSpikeDumpDirectory() const { return spikeDumpDirectory_; }
+    
+    /// Return whether is capturing events.
+    bool IsCapturing() const { return capturing_; }
+    /// Return number of profiled threads, including the main thread.
+    unsigned GetNumThreads() const;
+    /// Return the root profiling block of a thread. Index 0 is the main thread.
+    const ProfilerBlock* GetThreadRootBlock(unsigned index) const { return index < GetNumThreads() ? threads_[index]->root_ : 0; }
     
     /// Return profiling data as text output.
     String PrintData(bool showUnused = false, bool showTotal = false, unsigned maxDepth = M_MAX_UNSIGNED) const;
@@ -220,6 +367,34 @@ public:
 private:
     /// Return profiling data as text output for a specified profiling block.
     void PrintData(ProfilerBlock* block, String& output, unsigned depth, unsigned maxDepth, bool showUnused, bool showTotal) const;
+    /// Begin timing a profiling block outside the main thread.
+    void BeginThreadBlock(const char* name);
+    /// End timing the current profiling block outside the main thread.
+    void EndThreadBlock();
+    /// Return the profiling data of the calling thread, registering it on first use. Return null if too many threads.
+    ProfilerThread* GetCurrentThread();
+    /// Update a thread's block tree, and the capture if ongoing, from the events in its ring buffer. Called only from the main thread.
+    void ProcessThreadEvents(ProfilerThread* thread);
+    /// Record the block timings of the frame that just ended into the frame history, and dump it if a spike was detected.
+    void RecordFrame();
+    /// Record the block timings of a block tree into a frame.
+    void RecordFrameBlocks(ProfilerFrame& frame, ProfilerBlock* block, unsigned thread, unsigned depth);
+    /// Write the frame history to a file in the spike dump directory.
+    void DumpFrameHistory();
+    
+    /// Record a capture event into a thread's buffer. Events that do not fit are dropped.
+    void RecordEvent(ProfilerThread* thread, const char* name, long long time, bool begin)
+    {
+        unsigned index = thread->numEvents_;
+        if (index < thread->events_.Size())
+        {
+            ProfilerEvent& event = thread->events_[index];
+            event.name_ = name;
+            event.time_ = time;
+            event.begin_ = begin;
+            thread->numEvents_ = index + 1;
+        }
+    }
     
     /// Current profiling block.
     ProfilerBlock* current_;
@@ -229,6 +404,32 @@ private:
     unsigned intervalFrames_;
     /// Total frames.
     unsigned totalFrames_;
+    /// Per-thread profiling data, index 0 being the main thread.
+    ProfilerThread* threads_[MAX_PROFILER_THREADS];
+    /// Number of registered threads. Raised only after the new thread's data has been written.
+    SDL_atomic_t numThreads_;
+    /// Mutex for registering new threads.
+    Mutex threadsMutex_;
+    /// Event timer shared by all threads. Never reset, so that the ring buffer events stay comparable.
+    HiresTimer eventTimer_;
+    /// Event timer value when the capture started.
+    long long captureStartTime_;
+    /// Capturing flag.
+    volatile bool capturing_;
+    /// Frame history ring buffer.
+    Vector<ProfilerFrame> frameHistory_;
+    /// Ring buffer index of the next frame to record.
+    unsigned historyIndex_;
+    /// Number of recorded frames in the history.
+    unsigned numHistoryFrames_;
+    /// Frame time budget in milliseconds for spike dumps.
+    float spikeBudget_;
+    /// Spike dump directory.
+    String spikeDumpDirectory_;
+    /// Frame number of the pending spike dump, or 0 if none.
+    unsigned spikeFrameNumber_;
+    /// Frames left to record before the pending spike dump is written.
+    unsigned spikeDumpCountdown_;
 };
 
 /// Helper class for automatically beginning and ending a profiling block
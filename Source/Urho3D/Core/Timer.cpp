@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
 
@@ -95,6 +96,11 @@ static long long HiresTick()
         return timeGetTime();
 #elif __EMSCRIPTEN__
     return (unsigned)(emscripten_get_now()*1000.0);
+#elif defined(CLOCK_MONOTONIC) && !defined(__APPLE__)
+    // Monotonic clock does not jump with system time adjustments, so profiler timestamps stay comparable across threads
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000000LL + time.tv_nsec / 1000;
 #else
     struct timeval time;
     gettimeofday(&time, NULL);
@@ -117,6 +123,9 @@ void Time::BeginFrame(float timeStep)
     {
         URHO3D_PROFILE(BeginFrame);
 
+        // Send events posted from other threads since the last frame
+        context_->SendPostedEvents();
+
         // Frame begin event
         using namespace BeginFrame;
 
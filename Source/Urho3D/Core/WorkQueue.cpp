@@ -28,9 +28,37 @@
 #include "../Core/WorkQueue.h"
 #include "../IO/Log.h"
 
+#include <SDL/SDL_atomic.h>
+
 namespace Urho3D
 {
 
+/// Number of chunks per thread that parallel work is split into at most, for balancing uneven work by stealing.
+static const unsigned PARALLEL_CHUNKS_PER_THREAD = 4;
+
+/// Work function of the item that completes after all chunks of parallel work.
+static void CompleteParallelWork(const WorkItem* item, unsigned threadIndex)
+{
+}
+
+/// Prioritized queue of ready work items owned by one thread. Other threads steal from it when their own queue runs dry.
+class WorkerQueue : public RefCounted
+{
+public:
+    /// Construct.
+    WorkerQueue()
+    {
+        SDL_AtomicSet(&numItems_, 0);
+    }
+
+    /// Queue mutex.
+    Mutex mutex_;
+    /// Work items sorted by descending priority.
+    List<WorkItem*> items_;
+    /// Number of work items. Modified while holding the mutex, but can be read without it to skip empty queues.
+    SDL_atomic_t numItems_;
+};
+
 /// Worker thread managed by the work queue.
 class WorkerThread : public Thread, public RefCounted
 {
@@ -62,6 +90,7 @@ private:
 
 WorkQueue::WorkQueue(Context* context) :
     Object(context),
+    nextQueue_(0),
     shutDown_(false),
     pausing_(false),
     paused_(false),
@@ -70,6 +99,9 @@ WorkQueue::WorkQueue(Context* context) :
     lastSize_(0),
     maxNonThreadedWorkMs_(5)
 {
+    // The main thread queue always exists, and receives all work when there are no worker threads
+    queues_.Push(SharedPtr<WorkerQueue>(new WorkerQueue()));
+
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(WorkQueue, HandleBeginFrame));
 }
 
@@ -94,6 +126,10 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     // Start threads in paused mode
     Pause();
 
+    // Create the queues before any thread runs, as the threads may steal from each other's queues
+    for (unsigned i = 0; i < numThreads; ++i)
+        queues_.Push(SharedPtr<WorkerQueue>(new WorkerQueue()));
+
     for (unsigned i = 0; i < numThreads; ++i)
     {
         SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
@@ -138,30 +174,38 @@ void WorkQueue::AddWorkItem(SharedPtr<WorkItem> item)
     workItems_.Push(item);
     item->completed_ = false;
 
-    // Make sure worker threads' list is safe to modify
-    if (threads_.Size() && !paused_)
-        queueMutex_.Acquire();
-
-    // Find position for new item
-    if (queue_.Empty())
-        queue_.Push(item);
-    else
+    // Register with the dependencies that are still incomplete. The last one to complete will queue the item
+    if (!item->dependencies_.Empty())
     {
-        for (List<WorkItem*>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
+        MutexLock lock(dependencyMutex_);
+
+        for (PODVector<WorkItem*>::ConstIterator i = item->dependencies_.Begin(); i != item->dependencies_.End(); ++i)
         {
-            if ((*i)->priority_ <= item->priority_)
+            WorkItem* dependency = *i;
+            if (!dependency->completed_)
             {
-                queue_.Insert(i, item);
-                break;
+                dependency->dependents_.Push(item);
+                ++item->pendingDependencies_;
             }
         }
+
+        item->dependencies_.Clear();
+        if (item->pendingDependencies_)
+            return;
     }
 
+    // Distribute items round-robin to the worker threads. Without worker threads, everything goes to the main thread queue
+    unsigned queueIndex = 0;
     if (threads_.Size())
     {
-        queueMutex_.Release();
-        paused_ = false;
+        nextQueue_ = nextQueue_ % threads_.Size() + 1;
+        queueIndex = nextQueue_;
     }
+
+    QueueItem(item, queueIndex);
+
+    if (threads_.Size())
+        Resume();
 }
 
 bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
@@ -169,19 +213,29 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
     if (!item)
         return false;
 
-    MutexLock lock(queueMutex_);
+    MutexLock dependencyLock(dependencyMutex_);
 
-    // Can only remove successfully if the item was not yet taken by threads for execution
-    List<WorkItem*>::Iterator i = queue_.Find(item.Get());
-    if (i != queue_.End())
+    // Can only remove successfully if the item was not yet taken by threads for execution, and nothing waits for it
+    if (!item->dependents_.Empty())
+        return false;
+
+    for (unsigned i = 0; i < queues_.Size(); ++i)
     {
-        List<SharedPtr<WorkItem> >::Iterator j = workItems_.Find(item);
-        if (j != workItems_.End())
+        WorkerQueue* queue = queues_[i];
+        MutexLock lock(queue->mutex_);
+
+        List<WorkItem*>::Iterator j = queue->items_.Find(item.Get());
+        if (j != queue->items_.End())
         {
-            queue_.Erase(i);
-            ReturnToPool(item);
-            workItems_.Erase(j);
-            return true;
+            List<SharedPtr<WorkItem> >::Iterator k = workItems_.Find(item);
+            if (k != workItems_.End())
+            {
+                queue->items_.Erase(j);
+                SDL_AtomicAdd(&queue->numItems_, -1);
+                ReturnToPool(item);
+                workItems_.Erase(k);
+                return true;
+            }
         }
     }
 
@@ -190,23 +244,12 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
 
 unsigned WorkQueue::RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items)
 {
-    MutexLock lock(queueMutex_);
     unsigned removed = 0;
 
     for (Vector<SharedPtr<WorkItem> >::ConstIterator i = items.Begin(); i != items.End(); ++i)
     {
-        List<WorkItem*>::Iterator j = queue_.Find(i->Get());
-        if (j != queue_.End())
-        {
-            List<SharedPtr<WorkItem> >::Iterator k = workItems_.Find(*i);
-            if (k != workItems_.End())
-            {
-                queue_.Erase(j);
-                ReturnToPool(*k);
-                workItems_.Erase(k);
-                ++removed;
-            }
-        }
+        if (RemoveWorkItem(*i))
+            ++removed;
     }
 
     return removed;
@@ -218,7 +261,7 @@ void WorkQueue::Pause()
     {
         pausing_ = true;
 
-        queueMutex_.Acquire();
+        pauseMutex_.Acquire();
         paused_ = true;
 
         pausing_ = false;
@@ -229,7 +272,7 @@ void WorkQueue::Resume()
 {
     if (paused_)
     {
-        queueMutex_.Release();
+        pauseMutex_.Release();
         paused_ = false;
     }
 }
@@ -243,50 +286,123 @@ void WorkQueue::Complete(unsigned priority)
     {
         Resume();
 
-        // Take work items also in the main thread until queue empty or no high-priority items anymore
-        while (!queue_.Empty())
+        // Take work items also in the main thread until no high-priority items are available, then wait for threaded work
+        // to complete. Keep checking for items, as completing work may release items that depend on it
+        for (;;)
         {
-            queueMutex_.Acquire();
-            if (!queue_.Empty() && queue_.Front()->priority_ >= priority)
-            {
-                WorkItem* item = queue_.Front();
-                queue_.PopFront();
-                queueMutex_.Release();
-                item->workFunction_(item, 0);
-                item->completed_ = true;
-            }
-            else
-            {
-                queueMutex_.Release();
+            WorkItem* item = TakeItem(0, priority);
+            if (item)
+                ExecuteItem(item, 0);
+            else if (IsCompleted(priority))
                 break;
-            }
-        }
-
-        // Wait for threaded work to complete
-        while (!IsCompleted(priority))
-        {
         }
 
         // If no work at all remaining, pause worker threads by leaving the mutex locked
-        if (queue_.Empty())
+        if (IsQueueEmpty())
             Pause();
     }
     else
     {
         // No worker threads: ensure all high-priority items are completed in the main thread
-        while (!queue_.Empty() && queue_.Front()->priority_ >= priority)
+        while (WorkItem* item = TakeItem(0, priority))
+            ExecuteItem(item, 0);
+    }
+
+    PurgeCompleted(priority);
+    completing_ = false;
+}
+
+void WorkQueue::CompleteItem(WorkItem* item)
+{
+    if (!item)
+        return;
+
+    completing_ = true;
+
+    if (threads_.Size())
+        Resume();
+
+    // Help with work of at least the same priority until the item is done. Its dependencies are necessarily among that work
+    while (!item->completed_)
+    {
+        WorkItem* next = TakeItem(0, item->priority_);
+        if (next)
+            ExecuteItem(next, 0);
+        else if (threads_.Empty())
         {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            URHO3D_LOGERROR("Work item can not complete, as it depends on work with lower priority");
+            break;
         }
     }
 
-    PurgeCompleted(priority);
+    // If no work at all remaining, pause worker threads by leaving the mutex locked
+    if (threads_.Size() && IsQueueEmpty())
+        Pause();
+
     completing_ = false;
 }
 
+SharedPtr<WorkItem> WorkQueue::AddParallelWork(void (*workFunction)(const WorkItem*, unsigned), void* start, unsigned count,
+    unsigned elementSize, void* aux, unsigned minChunkSize, unsigned priority)
+{
+    SharedPtr<WorkItem> joinItem = GetFreeItem();
+    joinItem->priority_ = priority;
+    joinItem->workFunction_ = CompleteParallelWork;
+
+    if (count)
+    {
+        unsigned maxChunks = (threads_.Size() + 1) * PARALLEL_CHUNKS_PER_THREAD;
+        unsigned numChunks = minChunkSize > 1 ? count / minChunkSize : count;
+        if (!numChunks)
+            numChunks = 1;
+        else if (numChunks > maxChunks)
+            numChunks = maxChunks;
+
+        unsigned char* elements = reinterpret_cast<unsigned char*>(start);
+        unsigned chunkStart = 0;
+        for (unsigned i = 0; i < numChunks; ++i)
+        {
+            // Distribute the remainder over the first chunks
+            unsigned chunkEnd = chunkStart + count / numChunks + (i < count % numChunks ? 1 : 0);
+
+            SharedPtr<WorkItem> item = GetFreeItem();
+            item->priority_ = priority;
+            item->workFunction_ = workFunction;
+            item->start_ = elements + chunkStart * elementSize;
+            item->end_ = elements + chunkEnd * elementSize;
+            item->aux_ = aux;
+            AddWorkItem(item);
+            joinItem->AddDependency(item);
+
+            chunkStart = chunkEnd;
+        }
+    }
+
+    AddWorkItem(joinItem);
+    return joinItem;
+}
+
+void WorkQueue::ParallelFor(void (*workFunction)(const WorkItem*, unsigned), void* start, unsigned count, unsigned elementSize,
+    void* aux, unsigned minChunkSize)
+{
+    if (!count)
+        return;
+
+    // Without worker threads, process the whole range at once without going through the queue
+    if (threads_.Empty())
+    {
+        WorkItem item;
+        item.workFunction_ = workFunction;
+        item.start_ = start;
+        item.end_ = reinterpret_cast<unsigned char*>(start) + count * elementSize;
+        item.aux_ = aux;
+        workFunction(&item, 0);
+        return;
+    }
+
+    CompleteItem(AddParallelWork(workFunction, start, count, elementSize, aux, minChunkSize));
+}
+
 bool WorkQueue::IsCompleted(unsigned priority) const
 {
     for (List<SharedPtr<WorkItem> >::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
@@ -311,28 +427,97 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
             Time::Sleep(0);
         else
         {
-            queueMutex_.Acquire();
-            if (!queue_.Empty())
+            WorkItem* item = TakeItem(threadIndex, 0);
+            if (item)
             {
                 wasActive = true;
-
-                WorkItem* item = queue_.Front();
-                queue_.PopFront();
-                queueMutex_.Release();
-                item->workFunction_(item, threadIndex);
-                item->completed_ = true;
+                ExecuteItem(item, threadIndex);
             }
             else
             {
                 wasActive = false;
 
-                queueMutex_.Release();
+                // Block here for as long as the main thread keeps the queue paused
+                pauseMutex_.Acquire();
+                pauseMutex_.Release();
                 Time::Sleep(0);
             }
         }
     }
 }
 
+void WorkQueue::QueueItem(WorkItem* item, unsigned queueIndex)
+{
+    WorkerQueue* queue = queues_[queueIndex];
+    MutexLock lock(queue->mutex_);
+
+    // Keep the queue sorted by descending priority. Items of equal priority execute in the order they were queued
+    List<WorkItem*>& items = queue->items_;
+    if (items.Empty() || items.Back()->priority_ >= item->priority_)
+        items.Push(item);
+    else
+    {
+        List<WorkItem*>::Iterator i = items.Begin();
+        while ((*i)->priority_ >= item->priority_)
+            ++i;
+        items.Insert(i, item);
+    }
+
+    SDL_AtomicAdd(&queue->numItems_, 1);
+}
+
+WorkItem* WorkQueue::TakeItem(unsigned threadIndex, unsigned priority)
+{
+    // Visit the thread's own queue first, then the others starting from the next thread to spread out the stealing
+    unsigned numQueues = queues_.Size();
+    for (unsigned i = 0; i < numQueues; ++i)
+    {
+        WorkerQueue* queue = queues_[(threadIndex + i) % numQueues];
+        // Peek at the item count without locking to skip empty queues, then check again while holding the lock
+        if (!SDL_AtomicGet(&queue->numItems_))
+            continue;
+
+        MutexLock lock(queue->mutex_);
+        if (!queue->items_.Empty() && queue->items_.Front()->priority_ >= priority)
+        {
+            WorkItem* item = queue->items_.Front();
+            queue->items_.PopFront();
+            SDL_AtomicAdd(&queue->numItems_, -1);
+            return item;
+        }
+    }
+
+    return 0;
+}
+
+void WorkQueue::ExecuteItem(WorkItem* item, unsigned threadIndex)
+{
+    item->workFunction_(item, threadIndex);
+
+    MutexLock lock(dependencyMutex_);
+
+    // Queue the items that were waiting only for this one to the executing thread, as they likely touch the same data
+    for (PODVector<WorkItem*>::ConstIterator i = item->dependents_.Begin(); i != item->dependents_.End(); ++i)
+    {
+        if (!--(*i)->pendingDependencies_)
+            QueueItem(*i, threadIndex);
+    }
+
+    item->dependents_.Clear();
+    item->completed_ = true;
+}
+
+bool WorkQueue::IsQueueEmpty() const
+{
+    for (unsigned i = 0; i < queues_.Size(); ++i)
+    {
+        if (SDL_AtomicGet(&queues_[i]->numItems_))
+            return false;
+    }
+
+    return true;
+}
+
 void WorkQueue::PurgeCompleted(unsigned priority)
 {
     // Purge completed work items and send completion events. Do not signal items lower than priority threshold,
@@ -386,7 +571,10 @@ void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
         item->workFunction_ = 0;
         item->priority_ = M_MAX_UNSIGNED;
         item->sendEvent_ = false;
-        item->completed_ = false;
+        // The completed flag is left set, so that a held reference still reads as complete when used as a dependency
+        item->dependencies_.Clear();
+        item->dependents_.Clear();
+        item->pendingDependencies_ = 0;
 
         poolItems_.Push(item);
     }
@@ -395,18 +583,18 @@ void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
 void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
     // If no worker threads, complete low-priority work here
-    if (threads_.Empty() && !queue_.Empty())
+    if (threads_.Empty() && !IsQueueEmpty())
     {
         URHO3D_PROFILE(CompleteWorkNonthreaded);
 
         HiresTimer timer;
 
-        while (!queue_.Empty() && timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000)
+        while (timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000)
         {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            WorkItem* item = TakeItem(0, 0);
+            if (!item)
+                break;
+            ExecuteItem(item, 0);
         }
     }
 
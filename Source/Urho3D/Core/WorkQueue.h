@@ -36,6 +36,7 @@ URHO3D_EVENT(E_WORKITEMCOMPLETED, WorkItemCompleted)
 }
 
 class WorkerThread;
+class WorkerQueue;
 
 /// Work queue item.
 struct WorkItem : public RefCounted
@@ -48,10 +49,18 @@ public:
         priority_(0),
         sendEvent_(false),
         completed_(false),
-        pooled_(false)
+        pooled_(false),
+        pendingDependencies_(0)
     {
     }
 
+    /// Add a work item that must complete before this item may execute. Must be called before this item is added to the work queue, and the dependency must have been added first. The dependency should have at least the same priority.
+    void AddDependency(WorkItem* item)
+    {
+        if (item && item != this)
+            dependencies_.Push(item);
+    }
+
     /// Work function. Called with the work item and thread index (0 = main thread) as parameters.
     void (* workFunction_)(const WorkItem*, unsigned);
     /// Data start pointer.
@@ -68,7 +77,23 @@ public:
     volatile bool completed_;
 
 private:
+    /// Pooled flag.
     bool pooled_;
+    /// Work items this item waits for. Resolved and cleared when the item is added to the work queue.
+    PODVector<WorkItem*> dependencies_;
+    /// Work items waiting for this item to complete. Guarded by the work queue's dependency mutex.
+    PODVector<WorkItem*> dependents_;
+    /// Number of dependencies not yet completed. Guarded by the work queue's dependency mutex.
+    unsigned pendingDependencies_;
+};
+
+/// Per-thread accumulators for a parallel reduction. Work functions accumulate into the value of their thread index, so that no locking is needed.
+template <class T> struct ParallelAccumulator
+{
+    /// Auxiliary data pointer for the work function.
+    void* aux_;
+    /// Accumulated values per thread, index 0 being the main thread.
+    Vector<T> values_;
 };
 
 /// Work queue subsystem for multithreading.
@@ -88,9 +113,9 @@ public:
     void CreateThreads(unsigned numThreads);
     /// Get pointer to an usable WorkItem from the item pool. Allocate one if no more free items.
     SharedPtr<WorkItem> GetFreeItem();
-    /// Add a work item and resume worker threads.
+    /// Add a work item and resume worker threads. If the item has dependencies, it is held back until they have completed.
     void AddWorkItem(SharedPtr<WorkItem> item);
-    /// Remove a work item before it has started executing. Return true if successfully removed.
+    /// Remove a work item before it has started executing. Items still waiting for dependencies, or having other items depend on them, can not be removed. Return true if successfully removed.
     bool RemoveWorkItem(SharedPtr<WorkItem> item);
     /// Remove a number of work items before they have started executing. Return the number of items successfully removed.
     unsigned RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items);
@@ -100,6 +125,46 @@ public:
     void Resume();
     /// Finish all queued work which has at least the specified priority. Main thread will also execute priority work. Pause worker threads if no more work remains.
     void Complete(unsigned priority);
+    /// Finish the specified work item and the work it depends on, without waiting for unrelated work. Main thread will also execute work with at least the item's priority while waiting.
+    void CompleteItem(WorkItem* item);
+    /// Split an array of elements into chunks processed by the work function in parallel. The chunk's first and one-past-last elements are passed as the start and end pointers. More chunks are created than there are threads, so that threads finishing early steal the remaining chunks. Return an item that completes after all chunks, to be passed to CompleteItem() or used as a dependency.
+    SharedPtr<WorkItem> AddParallelWork(void (*workFunction)(const WorkItem*, unsigned), void* start, unsigned count,
+        unsigned elementSize, void* aux, unsigned minChunkSize = 1, unsigned priority = M_MAX_UNSIGNED);
+    /// Process an array of elements with the work function in parallel, and wait for completion. Main thread will also process chunks.
+    void ParallelFor(void (*workFunction)(const WorkItem*, unsigned), void* start, unsigned count, unsigned elementSize, void* aux,
+        unsigned minChunkSize = 1);
+
+    /// Process a vector of elements with the work function in parallel, and wait for completion.
+    template <class T> void ParallelFor(void (*workFunction)(const WorkItem*, unsigned), PODVector<T>& elements, void* aux,
+        unsigned minChunkSize = 1)
+    {
+        ParallelFor(workFunction, elements.Begin().ptr_, elements.Size(), sizeof(T), aux, minChunkSize);
+    }
+
+    /// Process an array of elements in parallel, accumulating per thread, and return the accumulated values combined in the main thread. The work function receives the accumulator as the auxiliary data.
+    template <class T> T ParallelReduce(void (*workFunction)(const WorkItem*, unsigned), void* start, unsigned count,
+        unsigned elementSize, ParallelAccumulator<T>& accumulator, const T& identity, T (*combine)(const T&, const T&),
+        unsigned minChunkSize = 1)
+    {
+        accumulator.values_.Resize(threads_.Size() + 1);
+        for (unsigned i = 0; i < accumulator.values_.Size(); ++i)
+            accumulator.values_[i] = identity;
+
+        ParallelFor(workFunction, start, count, elementSize, &accumulator, minChunkSize);
+
+        T result = identity;
+        for (unsigned i = 0; i < accumulator.values_.Size(); ++i)
+            result = combine(result, accumulator.values_[i]);
+        return result;
+    }
+
+    /// Process a vector of elements in parallel, accumulating per thread, and return the combined result.
+    template <class T, class U> T ParallelReduce(void (*workFunction)(const WorkItem*, unsigned), PODVector<U>& elements,
+        ParallelAccumulator<T>& accumulator, const T& identity, T (*combine)(const T&, const T&), unsigned minChunkSize = 1)
+    {
+        return ParallelReduce(workFunction, elements.Begin().ptr_, elements.Size(), sizeof(U), accumulator, identity, combine,
+            minChunkSize);
+    }
 
     /// Set the pool telerance before it starts deleting pool items.
     void SetTolerance(int tolerance) { tolerance_ = tolerance; }
@@ -124,6 +189,14 @@ public:
 private:
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(unsigned threadIndex);
+    /// Insert a ready work item into a thread's queue.
+    void QueueItem(WorkItem* item, unsigned queueIndex);
+    /// Take a work item with at least the specified priority, first from the thread's own queue, then by stealing from the other threads. Return null if none available.
+    WorkItem* TakeItem(unsigned threadIndex, unsigned priority);
+    /// Execute a work item, then mark it completed and release the items waiting for it.
+    void ExecuteItem(WorkItem* item, unsigned threadIndex);
+    /// Return whether all thread queues are empty.
+    bool IsQueueEmpty() const;
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
     void PurgeCompleted(unsigned priority);
     /// Purge the pool to reduce allocation where its unneeded.
@@ -139,15 +212,19 @@ private:
     List<SharedPtr<WorkItem> > poolItems_;
     /// Work item collection. Accessed only by the main thread.
     List<SharedPtr<WorkItem> > workItems_;
-    /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems.)
-    List<WorkItem*> queue_;
-    /// Worker queue mutex.
-    Mutex queueMutex_;
+    /// Per-thread prioritized queues of ready work items, index 0 belonging to the main thread. Pointers are guaranteed to be valid (point to workItems.)
+    Vector<SharedPtr<WorkerQueue> > queues_;
+    /// Pause mutex. Held by the main thread while the worker threads are paused.
+    Mutex pauseMutex_;
+    /// Dependency mutex. Guards the dependency bookkeeping and completion of work items.
+    Mutex dependencyMutex_;
+    /// Next worker thread queue to receive items added from the main thread.
+    unsigned nextQueue_;
     /// Shutting down flag.
     volatile bool shutDown_;
     /// Pausing flag. Indicates the worker threads should not contend for the queue mutex.
     volatile bool pausing_;
-    /// Paused flag. Indicates the queue mutex being locked to prevent worker threads using up CPU time.
+    /// Paused flag. Indicates the pause mutex being locked to prevent worker threads using up CPU time.
     bool paused_;
     /// Completing work in the main thread flag.
     bool completing_;
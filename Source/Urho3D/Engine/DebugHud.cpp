@@ -23,6 +23,7 @@
 #include "../Precompiled.h"
 
 #include "../Core/CoreEvents.h"
+#include "../Core/MemoryTracker.h"
 #include "../Core/Profiler.h"
 #include "../Engine/DebugHud.h"
 #include "../Engine/Engine.h"
@@ -186,7 +187,11 @@ void DebugHud::Update()
     if (memoryText_->IsVisible())
     {
         ResourceCache* cache = GetSubsystem<ResourceCache>();
-        memoryText_->SetText(cache->PrintMemoryUsage());
+        String memoryOutput = cache->PrintMemoryUsage();
+        MemoryTracker* tracker = GetSubsystem<MemoryTracker>();
+        if (tracker)
+            memoryOutput += "\n" + tracker->PrintData();
+        memoryText_->SetText(memoryOutput);
     }
 }
 
@@ -25,6 +25,8 @@
 #include "../Audio/Audio.h"
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/FrameAllocator.h"
+#include "../Core/MemoryTracker.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
 #include "../Core/WorkQueue.h"
@@ -115,8 +117,12 @@ Engine::Engine(Context* context) :
     // Create subsystems which do not depend on engine initialization or startup parameters
     context_->RegisterSubsystem(new Time(context_));
     context_->RegisterSubsystem(new WorkQueue(context_));
+    context_->RegisterSubsystem(new FrameAllocator(context_));
 #ifdef URHO3D_PROFILING
     context_->RegisterSubsystem(new Profiler(context_));
+#endif
+#ifdef URHO3D_TRACK_MEMORY
+    context_->RegisterSubsystem(new MemoryTracker(context_));
 #endif
     context_->RegisterSubsystem(new FileSystem(context_));
 #ifdef URHO3D_LOGGING
@@ -203,6 +209,7 @@ bool Engine::Initialize(const VariantMap& parameters)
     if (numThreads)
     {
         GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+        GetSubsystem<FrameAllocator>()->SetNumArenas(numThreads + 1);
 
         URHO3D_LOGINFOF("Created %u worker thread%s", numThreads, numThreads > 1 ? "s" : "");
     }
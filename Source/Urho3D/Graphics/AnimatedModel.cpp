@@ -69,6 +69,7 @@ AnimatedModel::AnimatedModel(Context* context) :
     morphsDirty_(false),
     skinningDirty_(true),
     boneBoundingBoxDirty_(true),
+    boneTransformsDirty_(true),
     isMaster_(true),
     loading_(false),
     assignBonesPending_(false),
@@ -698,7 +699,10 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
                 }
             }
             if (compatible)
+            {
+                boneTransformsDirty_ = true;
                 return;
+            }
         }
 
         RemoveAllAnimationStates();
@@ -764,10 +768,41 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
         }
     }
 
-    // Reserve space for skinning matrices
+    // Reserve space for skinning matrices and bone transforms
     skinMatrices_.Resize(skeleton_.GetNumBones());
+    boneTransforms_.Resize(skeleton_.GetNumBones());
+    boneTransformsDirty_ = true;
     SetGeometryBoneMappings();
 
+    // Sort the bones by hierarchy depth, so that bone transforms can be accumulated in one pass
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    PODVector<unsigned> depths(bones.Size());
+    unsigned maxDepth = 0;
+    for (unsigned i = 0; i < bones.Size(); ++i)
+    {
+        unsigned depth = 0;
+        unsigned index = i;
+        // Guard against a malformed skeleton with a parent loop
+        while (bones[index].parentIndex_ != index && bones[index].parentIndex_ < bones.Size() && depth < bones.Size())
+        {
+            index = bones[index].parentIndex_;
+            ++depth;
+        }
+        depths[i] = depth;
+        if (depth > maxDepth)
+            maxDepth = depth;
+    }
+
+    boneUpdateOrder_.Clear();
+    for (unsigned depth = 0; depth <= maxDepth && boneUpdateOrder_.Size() < bones.Size(); ++depth)
+    {
+        for (unsigned i = 0; i < bones.Size(); ++i)
+        {
+            if (depths[i] == depth)
+                boneUpdateOrder_.Push(i);
+        }
+    }
+
     assignBonesPending_ = !createBones;
 }
 
@@ -893,11 +928,16 @@ void AnimatedModel::OnMarkedDirty(Node* node)
 {
     Drawable::OnMarkedDirty(node);
 
-    // If the scene node or any of the bone nodes move, mark skinning and the bone bounding box dirty
+    // If the scene node or any of the bone nodes move, mark skinning dirty. Moving the model's own node does not change
+    // the bones relative to it, unless the bones belong to the master model
     if (skeleton_.GetNumBones())
     {
         skinningDirty_ = true;
-        boneBoundingBoxDirty_ = true;
+        if (node != node_ || !isMaster_)
+        {
+            boneTransformsDirty_ = true;
+            boneBoundingBoxDirty_ = true;
+        }
     }
 }
 
@@ -1168,9 +1208,22 @@ void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
         for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
             (*i)->Apply();
 
-        // Skeleton reset and animations apply the node transforms "silently" to avoid repeated marking dirty. Mark dirty now
+        // Skeleton reset and animations apply the node transforms "silently" to avoid repeated marking dirty. Mark dirty now.
+        // Bone nodes whose world transforms nobody has read since are still dirty, so the recursion stops at them
+        boneTransformsDirty_ = true;
+        skinningDirty_ = true;
         node_->MarkDirty();
 
+        // If the model's own node was already dirty, the marking stopped right away and did not reach the non-master models
+        // sharing these bones, so notify them directly
+        const Vector<SharedPtr<Component> >& components = node_->GetComponents();
+        for (Vector<SharedPtr<Component> >::ConstIterator i = components.Begin(); i != components.End(); ++i)
+        {
+            Component* component = *i;
+            if (component != this && component->GetType() == GetTypeStatic())
+                static_cast<AnimatedModel*>(component)->OnMarkedDirty(node_);
+        }
+
         // Calculate new bone bounding box
         UpdateBoneBoundingBox();
     }
@@ -1178,27 +1231,78 @@ void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
     animationDirty_ = false;
 }
 
+void AnimatedModel::UpdateBoneTransforms()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+
+    // While animations drive the skeleton, accumulate the animated bones' local transforms without touching the world
+    // transforms of the bone nodes; those will be calculated on demand if read. Bones that are not animated may be moved
+    // from outside, for example by physics, so read their world transforms to keep them clean and notifying of changes.
+    // With no animations, always read the bone nodes so that posing them manually works
+    AnimatedModel* master = isMaster_ ? this : node_->GetComponent<AnimatedModel>();
+    bool useLocalTransforms = master && master->GetNumAnimationStates();
+    Matrix3x4 inverseNodeTransform;
+    bool inverseNodeTransformValid = false;
+
+    for (unsigned i = 0; i < boneUpdateOrder_.Size(); ++i)
+    {
+        unsigned index = boneUpdateOrder_[i];
+        const Bone& bone = bones[index];
+        Node* boneNode = bone.node_;
+        if (!boneNode)
+        {
+            boneTransforms_[index] = Matrix3x4::IDENTITY;
+            continue;
+        }
+
+        unsigned parentIndex = bone.parentIndex_;
+        bool isRoot = parentIndex == index || parentIndex >= bones.Size();
+        Node* parentNode = isRoot ? node_ : bones[parentIndex].node_.Get();
+
+        if (useLocalTransforms && bone.animated_ && boneNode->GetParent() == parentNode)
+        {
+            if (isRoot)
+                boneTransforms_[index] = boneNode->GetTransform();
+            else
+                boneTransforms_[index] = boneTransforms_[parentIndex] * boneNode->GetTransform();
+        }
+        else
+        {
+            if (!inverseNodeTransformValid)
+            {
+                inverseNodeTransform = node_->GetWorldTransform().Inverse();
+                inverseNodeTransformValid = true;
+            }
+            boneTransforms_[index] = inverseNodeTransform * boneNode->GetWorldTransform();
+        }
+    }
+
+    boneTransformsDirty_ = false;
+}
+
 void AnimatedModel::UpdateBoneBoundingBox()
 {
     if (skeleton_.GetNumBones())
     {
-        // The bone bounding box is in local space, so need the node's inverse transform
+        if (boneTransformsDirty_)
+            UpdateBoneTransforms();
+
+        // The bone bounding box is in the model node's local space, like the bone transforms
         boneBoundingBox_.Clear();
-        Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
 
         const Vector<Bone>& bones = skeleton_.GetBones();
-        for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
+        for (unsigned i = 0; i < bones.Size(); ++i)
         {
-            Node* boneNode = i->node_;
-            if (!boneNode)
+            const Bone& bone = bones[i];
+            if (!bone.node_)
                 continue;
 
             // Use hitbox if available. If not, use only half of the sphere radius
             /// \todo The sphere radius should be multiplied with bone scale
-            if (i->collisionMask_ & BONECOLLISION_BOX)
-                boneBoundingBox_.Merge(i->boundingBox_.Transformed(inverseNodeTransform * boneNode->GetWorldTransform()));
-            else if (i->collisionMask_ & BONECOLLISION_SPHERE)
-                boneBoundingBox_.Merge(Sphere(inverseNodeTransform * boneNode->GetWorldPosition(), i->radius_ * 0.5f));
+            if (bone.collisionMask_ & BONECOLLISION_BOX)
+                boneBoundingBox_.Merge(bone.boundingBox_.Transformed(boneTransforms_[i]));
+            else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
+                boneBoundingBox_.Merge(Sphere(boneTransforms_[i].Translation(), bone.radius_ * 0.5f));
         }
     }
 
@@ -1213,6 +1317,9 @@ void AnimatedModel::UpdateSkinning()
     // Use model's world transform in case a bone is missing
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
 
+    if (boneTransformsDirty_)
+        UpdateBoneTransforms();
+
     // Skinning with global matrices only
     if (!geometrySkinMatrices_.Size())
     {
@@ -1220,7 +1327,7 @@ void AnimatedModel::UpdateSkinning()
         {
             const Bone& bone = bones[i];
             if (bone.node_)
-                skinMatrices_[i] = bone.node_->GetWorldTransform() * bone.offsetMatrix_;
+                skinMatrices_[i] = worldTransform * (boneTransforms_[i] * bone.offsetMatrix_);
             else
                 skinMatrices_[i] = worldTransform;
         }
@@ -1232,7 +1339,7 @@ void AnimatedModel::UpdateSkinning()
         {
             const Bone& bone = bones[i];
             if (bone.node_)
-                skinMatrices_[i] = bone.node_->GetWorldTransform() * bone.offsetMatrix_;
+                skinMatrices_[i] = worldTransform * (boneTransforms_[i] * bone.offsetMatrix_);
             else
                 skinMatrices_[i] = worldTransform;
 
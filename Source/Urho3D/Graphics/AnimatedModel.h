@@ -190,6 +190,8 @@ private:
     void CopyMorphVertices(void* dest, void* src, unsigned vertexCount, VertexBuffer* clone, VertexBuffer* original);
     /// Recalculate animations. Called from Update().
     void UpdateAnimation(const FrameInfo& frame);
+    /// Recalculate the model-space bone transforms.
+    void UpdateBoneTransforms();
     /// Recalculate the bone bounding box.
     void UpdateBoneBoundingBox();
     /// Recalculate skinning.
@@ -212,6 +214,10 @@ private:
     Vector<SharedPtr<AnimationState> > animationStates_;
     /// Skinning matrices.
     PODVector<Matrix3x4> skinMatrices_;
+    /// Bone transforms relative to the model's scene node.
+    PODVector<Matrix3x4> boneTransforms_;
+    /// Bone indices sorted by hierarchy depth, so that parents are updated before children.
+    PODVector<unsigned> boneUpdateOrder_;
     /// Mapping of subgeometry bone indices, used if more bones than skinning shader can manage.
     Vector<PODVector<unsigned> > geometryBoneMappings_;
     /// Subgeometry skinning matrices, used if more bones than skinning shader can manage.
@@ -244,6 +250,8 @@ private:
     bool skinningDirty_;
     /// Bone bounding box dirty flag.
     bool boneBoundingBoxDirty_;
+    /// Bone transforms dirty flag.
+    bool boneTransformsDirty_;
     /// Master model flag.
     bool isMaster_;
     /// Loading flag. During loading bone nodes are not created, as they will be serialized as child nodes.
@@ -40,44 +40,54 @@
 namespace Urho3D
 {
 
-inline bool CompareBatchesState(Batch* lhs, Batch* rhs)
+inline bool CompareInstancesFrontToBack(const InstanceData& lhs, const InstanceData& rhs)
 {
-    if (lhs->renderOrder_ != rhs->renderOrder_)
-        return lhs->renderOrder_ < rhs->renderOrder_;
-    else if (lhs->sortKey_ != rhs->sortKey_)
-        return lhs->sortKey_ < rhs->sortKey_;
-    else
-        return lhs->distance_ < rhs->distance_;
+    return lhs.distance_ < rhs.distance_;
 }
 
-inline bool CompareBatchesFrontToBack(Batch* lhs, Batch* rhs)
+/// Convert a float to an unsigned integer that sorts in the same order.
+inline unsigned FloatToSortableBits(float value)
 {
-    if (lhs->renderOrder_ != rhs->renderOrder_)
-        return lhs->renderOrder_ < rhs->renderOrder_;
-    else if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ < rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    unsigned bits = *((unsigned*)&value);
+    return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
 }
 
-inline bool CompareBatchesBackToFront(Batch* lhs, Batch* rhs)
+/// Return radix sort key for ordering by render order, then distance, then the shader bits of the batch sort key.
+inline unsigned long long GetDistanceSortKey(const Batch* batch, bool backToFront)
 {
-    if (lhs->renderOrder_ != rhs->renderOrder_)
-        return lhs->renderOrder_ < rhs->renderOrder_;
-    else if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ > rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    unsigned distance = FloatToSortableBits(batch->distance_);
+    if (backToFront)
+        distance = ~distance;
+    return (((unsigned long long)batch->renderOrder_) << 56) | (((unsigned long long)distance) << 24) | (batch->sortKey_ >> 40);
 }
 
-inline bool CompareInstancesFrontToBack(const InstanceData& lhs, const InstanceData& rhs)
+/// Return radix sort key for ordering by render order, then shader, light, material and geometry.
+inline unsigned long long GetStateSortKey(unsigned char renderOrder, unsigned shaderID, unsigned lightQueueID, unsigned materialID,
+    unsigned geometryID)
 {
-    return lhs.distance_ < rhs.distance_;
+    return (((unsigned long long)renderOrder) << 56) | (((unsigned long long)(shaderID & 0xffff)) << 40) |
+           (((unsigned long long)(lightQueueID & 0xff)) << 32) | ((materialID & 0xffff) << 16) | (geometryID & 0xffff);
 }
 
-inline bool CompareBatchGroupOrder(BatchGroup* lhs, BatchGroup* rhs)
+/// Return the remapped ID for a sort ID, assigning the next free one on first occurrence.
+inline unsigned RemapSortID(PODVector<unsigned short>& remapping, unsigned id, unsigned& freeID)
 {
-    return lhs->renderOrder_ < rhs->renderOrder_;
+    if (id >= remapping.Size())
+    {
+        unsigned oldSize = remapping.Size();
+        remapping.Resize(id + 1);
+        for (unsigned i = oldSize; i <= id; ++i)
+            remapping[i] = 0;
+    }
+
+    unsigned short& remappedID = remapping[id];
+    if (!remappedID)
+    {
+        if (freeID < 0xffff)
+            ++freeID;
+        remappedID = (unsigned short)freeID;
+    }
+    return remappedID - 1u;
 }
 
 void CalculateShadowMatrix(Matrix4& dest, LightBatchQueue* queue, unsigned split, Renderer* renderer, const Vector3& translation)
@@ -163,17 +173,19 @@ void CalculateSpotMatrix(Matrix4& dest, Light* light, const Vector3& translation
 
 void Batch::CalculateSortKey()
 {
-    unsigned shaderID = (unsigned)(
-        ((*((unsigned*)&vertexShader_) / sizeof(ShaderVariation)) + (*((unsigned*)&pixelShader_) / sizeof(ShaderVariation))) &
-        0x3fff);
+    // Use the stable sort IDs, which stay small and do not depend on the allocation addresses. The shader IDs are combined
+    // into 14 bits; a collision only makes the state sorting less optimal
+    unsigned vertexShaderID = vertexShader_ ? vertexShader_->GetSortID() : 0;
+    unsigned pixelShaderID = pixelShader_ ? pixelShader_->GetSortID() : 0;
+    unsigned shaderID = (vertexShaderID * 131 + pixelShaderID) & 0x3fff;
     if (!isBase_)
         shaderID |= 0x8000;
     if (pass_ && pass_->GetAlphaMask())
         shaderID |= 0x4000;
 
     unsigned lightQueueID = (unsigned)((*((unsigned*)&lightQueue_) / sizeof(LightBatchQueue)) & 0xffff);
-    unsigned materialID = (unsigned)((*((unsigned*)&material_) / sizeof(Material)) & 0xffff);
-    unsigned geometryID = (unsigned)((*((unsigned*)&geometry_) / sizeof(Geometry)) & 0xffff);
+    unsigned materialID = material_ ? (material_->GetSortID() & 0xffff) : 0;
+    unsigned geometryID = geometry_ ? (geometry_->GetSortID() & 0xffff) : 0;
 
     sortKey_ = (((unsigned long long)shaderID) << 48) | (((unsigned long long)lightQueueID) << 32) |
                (((unsigned long long)materialID) << 16) | geometryID;
@@ -306,254 +318,27 @@ void Batch::Prepare(View* view, Camera* camera, bool setModelTransform, bool all
     {
         if (light && graphics->NeedParameterUpdate(SP_LIGHT, lightQueue_))
         {
-            // Deferred light volume batches operate in a camera-centered space. Detect from material, zone & pass all being null
-            bool isLightVolume = !material_ && !pass_ && !zone_;
-
-            Matrix3x4 cameraEffectiveTransform = camera->GetEffectiveWorldTransform();
-            Vector3 cameraEffectivePos = cameraEffectiveTransform.Translation();
-
-            Node* lightNode = light->GetNode();
-            Matrix3 lightWorldRotation = lightNode->GetWorldRotation().RotationMatrix();
-
-            graphics->SetShaderParameter(VSP_LIGHTDIR, lightWorldRotation * Vector3::BACK);
+            // The parameters are normally recorded in worker threads before rendering. Record now if that was not done for
+            // this camera
+            if (lightQueue_->parameterCamera_ != camera)
+                lightQueue_->RecordShaderParameters(camera, renderer);
 
-            float atten = 1.0f / Max(light->GetRange(), M_EPSILON);
-            graphics->SetShaderParameter(VSP_LIGHTPOS, Vector4(lightNode->GetWorldPosition(), atten));
-
-            if (graphics->HasShaderParameter(VSP_LIGHTMATRICES))
-            {
-                switch (light->GetLightType())
-                {
-                case LIGHT_DIRECTIONAL:
-                    {
-                        Matrix4 shadowMatrices[MAX_CASCADE_SPLITS];
-                        unsigned numSplits = (unsigned)Min(MAX_CASCADE_SPLITS, (int)lightQueue_->shadowSplits_.Size());
-
-                        for (unsigned i = 0; i < numSplits; ++i)
-                            CalculateShadowMatrix(shadowMatrices[i], lightQueue_, i, renderer, Vector3::ZERO);
-
-                        graphics->SetShaderParameter(VSP_LIGHTMATRICES, shadowMatrices[0].Data(), 16 * numSplits);
-                    }
-                    break;
-
-                case LIGHT_SPOT:
-                    {
-                        Matrix4 shadowMatrices[2];
-
-                        CalculateSpotMatrix(shadowMatrices[0], light, Vector3::ZERO);
-                        bool isShadowed = shadowMap && graphics->HasTextureUnit(TU_SHADOWMAP);
-                        if (isShadowed)
-                            CalculateShadowMatrix(shadowMatrices[1], lightQueue_, 0, renderer, Vector3::ZERO);
-
-                        graphics->SetShaderParameter(VSP_LIGHTMATRICES, shadowMatrices[0].Data(), isShadowed ? 32 : 16);
-                    }
-                    break;
-
-                case LIGHT_POINT:
-                    {
-                        Matrix4 lightVecRot(lightNode->GetWorldRotation().RotationMatrix());
-                        // HLSL compiler will pack the parameters as if the matrix is only 3x4, so must be careful to not overwrite
-                        // the next parameter
-#ifdef URHO3D_OPENGL
-                        graphics->SetShaderParameter(VSP_LIGHTMATRICES, lightVecRot.Data(), 16);
-#else
-                        graphics->SetShaderParameter(VSP_LIGHTMATRICES, lightVecRot.Data(), 12);
-#endif
-                    }
-                    break;
-                }
-            }
-
-            float fade = 1.0f;
-            float fadeEnd = light->GetDrawDistance();
-            float fadeStart = light->GetFadeDistance();
-
-            // Do fade calculation for light if both fade & draw distance defined
-            if (light->GetLightType() != LIGHT_DIRECTIONAL && fadeEnd > 0.0f && fadeStart > 0.0f && fadeStart < fadeEnd)
-                fade = Min(1.0f - (light->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 1.0f);
-
-            // Negative lights will use subtract blending, so write absolute RGB values to the shader parameter
-            graphics->SetShaderParameter(PSP_LIGHTCOLOR, Color(light->GetEffectiveColor().Abs(),
-                light->GetEffectiveSpecularIntensity()) * fade);
-            graphics->SetShaderParameter(PSP_LIGHTDIR, lightWorldRotation * Vector3::BACK);
-            graphics->SetShaderParameter(PSP_LIGHTPOS,
-                Vector4((isLightVolume ? (lightNode->GetWorldPosition() - cameraEffectivePos) : lightNode->GetWorldPosition()),
-                    atten));
-
-            if (graphics->HasShaderParameter(PSP_LIGHTMATRICES))
-            {
-                switch (light->GetLightType())
-                {
-                case LIGHT_DIRECTIONAL:
-                    {
-                        Matrix4 shadowMatrices[MAX_CASCADE_SPLITS];
-                        unsigned numSplits = (unsigned)Min(MAX_CASCADE_SPLITS, (int)lightQueue_->shadowSplits_.Size());
-
-                        for (unsigned i = 0; i < numSplits; ++i)
-                        {
-                            CalculateShadowMatrix(shadowMatrices[i], lightQueue_, i, renderer, isLightVolume ? cameraEffectivePos :
-                                Vector3::ZERO);
-                        }
-                        graphics->SetShaderParameter(PSP_LIGHTMATRICES, shadowMatrices[0].Data(), 16 * numSplits);
-                    }
-                    break;
-
-                case LIGHT_SPOT:
-                    {
-                        Matrix4 shadowMatrices[2];
-
-                        CalculateSpotMatrix(shadowMatrices[0], light, cameraEffectivePos);
-                        bool isShadowed = lightQueue_->shadowMap_ != 0;
-                        if (isShadowed)
-                        {
-                            CalculateShadowMatrix(shadowMatrices[1], lightQueue_, 0, renderer, isLightVolume ? cameraEffectivePos :
-                                Vector3::ZERO);
-                        }
-
-                        graphics->SetShaderParameter(PSP_LIGHTMATRICES, shadowMatrices[0].Data(), isShadowed ? 32 : 16);
-                    }
-                    break;
-
-                case LIGHT_POINT:
-                    {
-                        Matrix4 lightVecRot(lightNode->GetWorldRotation().RotationMatrix());
-                        // HLSL compiler will pack the parameters as if the matrix is only 3x4, so must be careful to not overwrite
-                        // the next parameter
-#ifdef URHO3D_OPENGL
-                        graphics->SetShaderParameter(PSP_LIGHTMATRICES, lightVecRot.Data(), 16);
-#else
-                        graphics->SetShaderParameter(PSP_LIGHTMATRICES, lightVecRot.Data(), 12);
-#endif
-                    }
-                    break;
-                }
-            }
+            lightQueue_->shaderParameters_.Apply(graphics);
 
-            // Set shadow mapping shader parameters
-            if (shadowMap)
-            {
-                {
-                    // Calculate point light shadow sampling offsets (unrolled cube map)
-                    unsigned faceWidth = (unsigned)(shadowMap->GetWidth() / 2);
-                    unsigned faceHeight = (unsigned)(shadowMap->GetHeight() / 3);
-                    float width = (float)shadowMap->GetWidth();
-                    float height = (float)shadowMap->GetHeight();
-#ifdef URHO3D_OPENGL
-                    float mulX = (float)(faceWidth - 3) / width;
-                    float mulY = (float)(faceHeight - 3) / height;
-                    float addX = 1.5f / width;
-                    float addY = 1.5f / height;
-#else
-                    float mulX = (float)(faceWidth - 4) / width;
-                    float mulY = (float)(faceHeight - 4) / height;
-                    float addX = 2.5f / width;
-                    float addY = 2.5f / height;
-#endif
-                    // If using 4 shadow samples, offset the position diagonally by half pixel
-                    if (renderer->GetShadowQuality() & SHADOWQUALITY_HIGH_16BIT)
-                    {
-                        addX -= 0.5f / width;
-                        addY -= 0.5f / height;
-                    }
-                    graphics->SetShaderParameter(PSP_SHADOWCUBEADJUST, Vector4(mulX, mulY, addX, addY));
-                }
-
-                {
-                    // Calculate shadow camera depth parameters for point light shadows and shadow fade parameters for
-                    //  directional light shadows, stored in the same uniform
-                    Camera* shadowCamera = lightQueue_->shadowSplits_[0].shadowCamera_;
-                    float nearClip = shadowCamera->GetNearClip();
-                    float farClip = shadowCamera->GetFarClip();
-                    float q = farClip / (farClip - nearClip);
-                    float r = -q * nearClip;
-
-                    const CascadeParameters& parameters = light->GetShadowCascade();
-                    float viewFarClip = camera->GetFarClip();
-                    float shadowRange = parameters.GetShadowRange();
-                    float fadeStart = parameters.fadeStart_ * shadowRange / viewFarClip;
-                    float fadeEnd = shadowRange / viewFarClip;
-                    float fadeRange = fadeEnd - fadeStart;
-
-                    graphics->SetShaderParameter(PSP_SHADOWDEPTHFADE, Vector4(q, r, fadeStart, 1.0f / fadeRange));
-                }
-
-                {
-                    float intensity = light->GetShadowIntensity();
-                    float fadeStart = light->GetShadowFadeDistance();
-                    float fadeEnd = light->GetShadowDistance();
-                    if (fadeStart > 0.0f && fadeEnd > 0.0f && fadeEnd > fadeStart)
-                        intensity =
-                            Lerp(intensity, 1.0f, Clamp((light->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 0.0f, 1.0f));
-                    float pcfValues = (1.0f - intensity);
-                    float samples = renderer->GetShadowQuality() >= SHADOWQUALITY_HIGH_16BIT ? 4.0f : 1.0f;
-
-                    graphics->SetShaderParameter(PSP_SHADOWINTENSITY, Vector4(pcfValues / samples, intensity, 0.0f, 0.0f));
-                }
-
-                float sizeX = 1.0f / (float)shadowMap->GetWidth();
-                float sizeY = 1.0f / (float)shadowMap->GetHeight();
-                graphics->SetShaderParameter(PSP_SHADOWMAPINVSIZE, Vector4(sizeX, sizeY, 0.0f, 0.0f));
-
-                Vector4 lightSplits(M_LARGE_VALUE, M_LARGE_VALUE, M_LARGE_VALUE, M_LARGE_VALUE);
-                if (lightQueue_->shadowSplits_.Size() > 1)
-                    lightSplits.x_ = lightQueue_->shadowSplits_[0].farSplit_ / camera->GetFarClip();
-                if (lightQueue_->shadowSplits_.Size() > 2)
-                    lightSplits.y_ = lightQueue_->shadowSplits_[1].farSplit_ / camera->GetFarClip();
-                if (lightQueue_->shadowSplits_.Size() > 3)
-                    lightSplits.z_ = lightQueue_->shadowSplits_[2].farSplit_ / camera->GetFarClip();
-
-                graphics->SetShaderParameter(PSP_SHADOWSPLITS, lightSplits);
-            }
+            // Deferred light volume batches operate in a camera-centered space. Detect from material, zone & pass all being null
+            bool isLightVolume = !material_ && !pass_ && !zone_;
+            if (isLightVolume)
+                lightQueue_->volumeShaderParameters_.Apply(graphics);
+            if (shadowMap && graphics->HasTextureUnit(TU_SHADOWMAP))
+                lightQueue_->shadowedSpotShaderParameters_.Apply(graphics);
         }
         else if (lightQueue_->vertexLights_.Size() && graphics->HasShaderParameter(VSP_VERTEXLIGHTS) &&
                  graphics->NeedParameterUpdate(SP_LIGHT, lightQueue_))
         {
-            Vector4 vertexLights[MAX_VERTEX_LIGHTS * 3];
-            const PODVector<Light*>& lights = lightQueue_->vertexLights_;
-
-            for (unsigned i = 0; i < lights.Size(); ++i)
-            {
-                Light* vertexLight = lights[i];
-                Node* vertexLightNode = vertexLight->GetNode();
-                LightType type = vertexLight->GetLightType();
-
-                // Attenuation
-                float invRange, cutoff, invCutoff;
-                if (type == LIGHT_DIRECTIONAL)
-                    invRange = 0.0f;
-                else
-                    invRange = 1.0f / Max(vertexLight->GetRange(), M_EPSILON);
-                if (type == LIGHT_SPOT)
-                {
-                    cutoff = Cos(vertexLight->GetFov() * 0.5f);
-                    invCutoff = 1.0f / (1.0f - cutoff);
-                }
-                else
-                {
-                    cutoff = -1.0f;
-                    invCutoff = 1.0f;
-                }
-
-                // Color
-                float fade = 1.0f;
-                float fadeEnd = vertexLight->GetDrawDistance();
-                float fadeStart = vertexLight->GetFadeDistance();
-
-                // Do fade calculation for light if both fade & draw distance defined
-                if (vertexLight->GetLightType() != LIGHT_DIRECTIONAL && fadeEnd > 0.0f && fadeStart > 0.0f && fadeStart < fadeEnd)
-                    fade = Min(1.0f - (vertexLight->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 1.0f);
-
-                Color color = vertexLight->GetEffectiveColor() * fade;
-                vertexLights[i * 3] = Vector4(color.r_, color.g_, color.b_, invRange);
-
-                // Direction
-                vertexLights[i * 3 + 1] = Vector4(-(vertexLightNode->GetWorldDirection()), cutoff);
-
-                // Position
-                vertexLights[i * 3 + 2] = Vector4(vertexLightNode->GetWorldPosition(), invCutoff);
-            }
+            if (lightQueue_->parameterCamera_ != camera)
+                lightQueue_->RecordShaderParameters(camera, renderer);
 
-            graphics->SetShaderParameter(VSP_VERTEXLIGHTS, vertexLights[0].Data(), lights.Size() * 3 * 4);
+            lightQueue_->shaderParameters_.Apply(graphics);
         }
     }
 
@@ -613,19 +398,31 @@ void Batch::Draw(View* view, Camera* camera, bool allowDepthWrite) const
 }
 
 void BatchGroup::SetTransforms(void* lockedData, unsigned& freeIndex)
+{
+    SetInstanceIndex(freeIndex);
+    CopyTransforms(lockedData);
+}
+
+void BatchGroup::SetInstanceIndex(unsigned& freeIndex)
 {
     // Do not use up buffer space if not going to draw as instanced
     if (geometryType_ != GEOM_INSTANCED)
         return;
 
     startIndex_ = freeIndex;
+    freeIndex += instances_.Size();
+}
+
+void BatchGroup::CopyTransforms(void* lockedData) const
+{
+    if (geometryType_ != GEOM_INSTANCED)
+        return;
+
     Matrix3x4* dest = (Matrix3x4*)lockedData;
-    dest += freeIndex;
+    dest += startIndex_;
 
     for (unsigned i = 0; i < instances_.Size(); ++i)
         *dest++ = *instances_[i].worldTransform_;
-
-    freeIndex += instances_.Size();
 }
 
 void BatchGroup::Draw(View* view, Camera* camera, bool allowDepthWrite) const
@@ -691,6 +488,29 @@ void BatchQueue::Clear(int maxSortedInstances)
     maxSortedInstances_ = (unsigned)maxSortedInstances;
 }
 
+void BatchQueue::ClearInstances(int maxSortedInstances)
+{
+    batches_.Clear();
+    sortedBatches_.Clear();
+    sortedBatchGroups_.Clear();
+    // The instance buffers belong to the previous frame's arena, so detach them without touching their contents
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+        i->second_.instances_.SetArena(0);
+    maxSortedInstances_ = (unsigned)maxSortedInstances;
+}
+
+void BatchQueue::RemoveUnusedGroups()
+{
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End();)
+    {
+        // Erasing moves the last group into the erased position, so do not advance in that case
+        if (i->second_.instances_.Empty())
+            i = batchGroups_.Erase(i);
+        else
+            ++i;
+    }
+}
+
 void BatchQueue::SortBackToFront()
 {
     sortedBatches_.Resize(batches_.Size());
@@ -698,17 +518,28 @@ void BatchQueue::SortBackToFront()
     for (unsigned i = 0; i < batches_.Size(); ++i)
         sortedBatches_[i] = &batches_[i];
 
-    Sort(sortedBatches_.Begin(), sortedBatches_.End(), CompareBatchesBackToFront);
+    sortItems_.Resize(sortedBatches_.Size());
+    for (unsigned i = 0; i < sortedBatches_.Size(); ++i)
+    {
+        sortItems_[i].key_ = GetDistanceSortKey(sortedBatches_[i], true);
+        sortItems_[i].value_ = sortedBatches_[i];
+    }
+    SortByKeys(sortedBatches_);
 
     sortedBatchGroups_.Resize(batchGroups_.Size());
-    
+    sortItems_.Resize(batchGroups_.Size());
+
     unsigned index = 0;
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
-        sortedBatchGroups_[index++] = &i->second_;
-    
-    Sort(sortedBatchGroups_.Begin(), sortedBatchGroups_.End(), CompareBatchGroupOrder);
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    {
+        sortItems_[index].key_ = i->second_.renderOrder_;
+        sortItems_[index].value_ = &i->second_;
+        ++index;
+    }
+    SortByKeys(reinterpret_cast<PODVector<Batch*>& >(sortedBatchGroups_));
 }
 
+
 void BatchQueue::SortFrontToBack()
 {
     sortedBatches_.Clear();
@@ -719,7 +550,7 @@ void BatchQueue::SortFrontToBack()
     SortFrontToBack2Pass(sortedBatches_);
 
     // Sort each group front to back
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
     {
         if (i->second_.instances_.Size() <= maxSortedInstances_)
         {
@@ -730,7 +561,7 @@ void BatchQueue::SortFrontToBack()
         else
         {
             float minDistance = M_INFINITY;
-            for (PODVector<InstanceData>::ConstIterator j = i->second_.instances_.Begin(); j != i->second_.instances_.End(); ++j)
+            for (FrameVector<InstanceData>::ConstIterator j = i->second_.instances_.Begin(); j != i->second_.instances_.End(); ++j)
                 minDistance = Min(minDistance, j->distance_);
             i->second_.distance_ = minDistance;
         }
@@ -739,7 +570,7 @@ void BatchQueue::SortFrontToBack()
     sortedBatchGroups_.Resize(batchGroups_.Size());
 
     unsigned index = 0;
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
         sortedBatchGroups_[index++] = &i->second_;
 
     SortFrontToBack2Pass(reinterpret_cast<PODVector<Batch*>& >(sortedBatchGroups_));
@@ -747,70 +578,96 @@ void BatchQueue::SortFrontToBack()
 
 void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
 {
+    unsigned numBatches = batches.Size();
+    if (numBatches < 2)
+        return;
+
+    sortItems_.Resize(numBatches);
+
     // Mobile devices likely use a tiled deferred approach, with which front-to-back sorting is irrelevant. The 2-pass
     // method is also time consuming, so just sort with state having priority
 #ifdef GL_ES_VERSION_2_0
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        Batch* batch = batches[i];
+        unsigned long long sortKey = batch->sortKey_;
+        sortItems_[i].key_ = GetStateSortKey(batch->renderOrder_, (unsigned)(sortKey >> 48), (unsigned)(sortKey >> 32),
+            (unsigned)(sortKey >> 16), (unsigned)sortKey);
+        sortItems_[i].value_ = batch;
+    }
+    SortByKeys(batches);
 #else
     // For desktop, first sort by distance and remap shader/material/geometry IDs in the sort key
-    Sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        sortItems_[i].key_ = GetDistanceSortKey(batches[i], false);
+        sortItems_[i].value_ = batches[i];
+    }
+    SortByKeys(batches);
 
     unsigned freeShaderID = 0;
-    unsigned short freeMaterialID = 0;
-    unsigned short freeGeometryID = 0;
+    unsigned freeMaterialID = 0;
+    unsigned freeGeometryID = 0;
 
-    for (PODVector<Batch*>::Iterator i = batches.Begin(); i != batches.End(); ++i)
+    for (unsigned i = 0; i < numBatches; ++i)
     {
-        Batch* batch = *i;
-
-        unsigned shaderID = (unsigned)(batch->sortKey_ >> 32);
-        HashMap<unsigned, unsigned>::ConstIterator j = shaderRemapping_.Find(shaderID);
-        if (j != shaderRemapping_.End())
-            shaderID = j->second_;
-        else
-        {
-            shaderID = shaderRemapping_[shaderID] = freeShaderID | (shaderID & 0xc0000000);
-            ++freeShaderID;
-        }
+        Batch* batch = batches[i];
+        unsigned long long sortKey = batch->sortKey_;
+        unsigned shaderFlags = (unsigned)(sortKey >> 48) & 0xc000;
+        unsigned shaderID = RemapSortID(shaderRemapping_, (unsigned)(sortKey >> 48) & 0x3fff, freeShaderID);
+        unsigned materialID = RemapSortID(materialRemapping_, (unsigned)(sortKey >> 16) & 0xffff, freeMaterialID);
+        unsigned geometryID = RemapSortID(geometryRemapping_, (unsigned)sortKey & 0xffff, freeGeometryID);
+
+        sortItems_[i].key_ = GetStateSortKey(batch->renderOrder_, shaderFlags | (shaderID & 0x3fff), (unsigned)(sortKey >> 32),
+            materialID, geometryID);
+        sortItems_[i].value_ = batch;
+    }
 
-        unsigned short materialID = (unsigned short)(batch->sortKey_ & 0xffff0000);
-        HashMap<unsigned short, unsigned short>::ConstIterator k = materialRemapping_.Find(materialID);
-        if (k != materialRemapping_.End())
-            materialID = k->second_;
-        else
-        {
-            materialID = materialRemapping_[materialID] = freeMaterialID;
-            ++freeMaterialID;
-        }
+    // Reset only the remapping entries that were used, so that the tables do not need to be cleared as a whole
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        unsigned long long sortKey = batches[i]->sortKey_;
+        shaderRemapping_[(unsigned)(sortKey >> 48) & 0x3fff] = 0;
+        materialRemapping_[(unsigned)(sortKey >> 16) & 0xffff] = 0;
+        geometryRemapping_[(unsigned)sortKey & 0xffff] = 0;
+    }
 
-        unsigned short geometryID = (unsigned short)(batch->sortKey_ & 0xffff);
-        HashMap<unsigned short, unsigned short>::ConstIterator l = geometryRemapping_.Find(geometryID);
-        if (l != geometryRemapping_.End())
-            geometryID = l->second_;
-        else
-        {
-            geometryID = geometryRemapping_[geometryID] = freeGeometryID;
-            ++freeGeometryID;
-        }
+    // Finally sort again with the rewritten ID's. The sort is stable, so batches with the same state stay front to back
+    SortByKeys(batches);
+#endif
+}
 
-        batch->sortKey_ = (((unsigned long long)shaderID) << 32) | (((unsigned long long)materialID) << 16) | geometryID;
+void BatchQueue::SortByKeys(PODVector<Batch*>& batches)
+{
+    unsigned numBatches = sortItems_.Size();
+    if (numBatches > 1)
+    {
+        sortTemp_.Resize(numBatches);
+        RadixSort(&sortItems_[0], &sortTemp_[0], numBatches);
     }
 
-    shaderRemapping_.Clear();
-    materialRemapping_.Clear();
-    geometryRemapping_.Clear();
-
-    // Finally sort again with the rewritten ID's
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
-#endif
+    for (unsigned i = 0; i < numBatches; ++i)
+        batches[i] = sortItems_[i].value_;
 }
 
 void BatchQueue::SetTransforms(void* lockedData, unsigned& freeIndex)
 {
-    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
         i->second_.SetTransforms(lockedData, freeIndex);
 }
 
+void BatchQueue::SetInstanceIndices(unsigned& freeIndex)
+{
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+        i->second_.SetInstanceIndex(freeIndex);
+}
+
+void BatchQueue::CopyTransforms(void* lockedData) const
+{
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::ConstIterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+        i->second_.CopyTransforms(lockedData);
+}
+
 void BatchQueue::Draw(View* view, Camera* camera, bool markToStencil, bool usingLightOptimization, bool allowDepthWrite) const
 {
     Graphics* graphics = view->GetGraphics();
@@ -858,7 +715,7 @@ unsigned BatchQueue::GetNumInstances() const
 {
     unsigned total = 0;
 
-    for (HashMap<BatchGroupKey, BatchGroup>::ConstIterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+    for (FlatHashMap<BatchGroupKey, BatchGroup>::ConstIterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
     {
         if (i->second_.geometryType_ == GEOM_INSTANCED)
             total += i->second_.instances_.Size();
@@ -867,4 +724,330 @@ unsigned BatchQueue::GetNumInstances() const
     return total;
 }
 
+void ShaderParameterBlock::Clear()
+{
+    entries_.Clear();
+    data_.Clear();
+}
+
+void ShaderParameterBlock::Add(StringHash param, const float* data, unsigned count)
+{
+    if (!count)
+        return;
+
+    Entry entry;
+    entry.name_ = param;
+    entry.type_ = VAR_BUFFER;
+    entry.offset_ = data_.Size();
+    entry.count_ = count;
+    entries_.Push(entry);
+
+    data_.Resize(entry.offset_ + count);
+    for (unsigned i = 0; i < count; ++i)
+        data_[entry.offset_ + i] = data[i];
+}
+
+void ShaderParameterBlock::Add(StringHash param, const Vector3& vector)
+{
+    Add(param, vector.Data(), 3);
+    entries_.Back().type_ = VAR_VECTOR3;
+}
+
+void ShaderParameterBlock::Add(StringHash param, const Vector4& vector)
+{
+    Add(param, vector.Data(), 4);
+    entries_.Back().type_ = VAR_VECTOR4;
+}
+
+void ShaderParameterBlock::Add(StringHash param, const Color& color)
+{
+    Add(param, color.Data(), 4);
+    entries_.Back().type_ = VAR_COLOR;
+}
+
+void ShaderParameterBlock::Apply(Graphics* graphics) const
+{
+    for (PODVector<Entry>::ConstIterator i = entries_.Begin(); i != entries_.End(); ++i)
+    {
+        const float* data = &data_[i->offset_];
+
+        // Use the typed setters where the graphics API pads or converts the value
+        switch (i->type_)
+        {
+        case VAR_VECTOR3:
+            graphics->SetShaderParameter(i->name_, Vector3(data));
+            break;
+
+        case VAR_VECTOR4:
+            graphics->SetShaderParameter(i->name_, Vector4(data));
+            break;
+
+        case VAR_COLOR:
+            graphics->SetShaderParameter(i->name_, Color(data[0], data[1], data[2], data[3]));
+            break;
+
+        default:
+            graphics->SetShaderParameter(i->name_, data, i->count_);
+            break;
+        }
+    }
+}
+
+void LightBatchQueue::RecordShaderParameters(Camera* camera, Renderer* renderer)
+{
+    shaderParameters_.Clear();
+    volumeShaderParameters_.Clear();
+    shadowedSpotShaderParameters_.Clear();
+    parameterCamera_ = camera;
+
+    Light* light = light_;
+    if (!light)
+    {
+        if (vertexLights_.Empty())
+            return;
+
+        Vector4 vertexLights[MAX_VERTEX_LIGHTS * 3];
+        const PODVector<Light*>& lights = vertexLights_;
+
+        for (unsigned i = 0; i < lights.Size(); ++i)
+        {
+            Light* vertexLight = lights[i];
+            Node* vertexLightNode = vertexLight->GetNode();
+            LightType type = vertexLight->GetLightType();
+
+            // Attenuation
+            float invRange, cutoff, invCutoff;
+            if (type == LIGHT_DIRECTIONAL)
+                invRange = 0.0f;
+            else
+                invRange = 1.0f / Max(vertexLight->GetRange(), M_EPSILON);
+            if (type == LIGHT_SPOT)
+            {
+                cutoff = Cos(vertexLight->GetFov() * 0.5f);
+                invCutoff = 1.0f / (1.0f - cutoff);
+            }
+            else
+            {
+                cutoff = -1.0f;
+                invCutoff = 1.0f;
+            }
+
+            // Color
+            float fade = 1.0f;
+            float fadeEnd = vertexLight->GetDrawDistance();
+            float fadeStart = vertexLight->GetFadeDistance();
+
+            // Do fade calculation for light if both fade & draw distance defined
+            if (vertexLight->GetLightType() != LIGHT_DIRECTIONAL && fadeEnd > 0.0f && fadeStart > 0.0f && fadeStart < fadeEnd)
+                fade = Min(1.0f - (vertexLight->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 1.0f);
+
+            Color color = vertexLight->GetEffectiveColor() * fade;
+            vertexLights[i * 3] = Vector4(color.r_, color.g_, color.b_, invRange);
+
+            // Direction
+            vertexLights[i * 3 + 1] = Vector4(-(vertexLightNode->GetWorldDirection()), cutoff);
+
+            // Position
+            vertexLights[i * 3 + 2] = Vector4(vertexLightNode->GetWorldPosition(), invCutoff);
+        }
+
+        shaderParameters_.Add(VSP_VERTEXLIGHTS, vertexLights[0].Data(), lights.Size() * 3 * 4);
+        return;
+    }
+
+    Matrix3x4 cameraEffectiveTransform = camera->GetEffectiveWorldTransform();
+    Vector3 cameraEffectivePos = cameraEffectiveTransform.Translation();
+
+    Node* lightNode = light->GetNode();
+    Matrix3 lightWorldRotation = lightNode->GetWorldRotation().RotationMatrix();
+
+    shaderParameters_.Add(VSP_LIGHTDIR, lightWorldRotation * Vector3::BACK);
+
+    float atten = 1.0f / Max(light->GetRange(), M_EPSILON);
+    shaderParameters_.Add(VSP_LIGHTPOS, Vector4(lightNode->GetWorldPosition(), atten));
+
+    switch (light->GetLightType())
+    {
+    case LIGHT_DIRECTIONAL:
+        {
+            Matrix4 shadowMatrices[MAX_CASCADE_SPLITS];
+            unsigned numSplits = (unsigned)Min(MAX_CASCADE_SPLITS, (int)shadowSplits_.Size());
+
+            for (unsigned i = 0; i < numSplits; ++i)
+                CalculateShadowMatrix(shadowMatrices[i], this, i, renderer, Vector3::ZERO);
+
+            shaderParameters_.Add(VSP_LIGHTMATRICES, shadowMatrices[0].Data(), 16 * numSplits);
+        }
+        break;
+
+    case LIGHT_SPOT:
+        {
+            Matrix4 shadowMatrices[2];
+
+            CalculateSpotMatrix(shadowMatrices[0], light, Vector3::ZERO);
+            shaderParameters_.Add(VSP_LIGHTMATRICES, shadowMatrices[0].Data(), 16);
+            // The shadow matrix is only set when the shader samples the shadow map
+            if (shadowMap_)
+            {
+                CalculateShadowMatrix(shadowMatrices[1], this, 0, renderer, Vector3::ZERO);
+                shadowedSpotShaderParameters_.Add(VSP_LIGHTMATRICES, shadowMatrices[0].Data(), 32);
+            }
+        }
+        break;
+
+    case LIGHT_POINT:
+        {
+            Matrix4 lightVecRot(lightNode->GetWorldRotation().RotationMatrix());
+            // HLSL compiler will pack the parameters as if the matrix is only 3x4, so must be careful to not overwrite
+            // the next parameter
+#ifdef URHO3D_OPENGL
+            shaderParameters_.Add(VSP_LIGHTMATRICES, lightVecRot.Data(), 16);
+#else
+            shaderParameters_.Add(VSP_LIGHTMATRICES, lightVecRot.Data(), 12);
+#endif
+        }
+        break;
+    }
+
+    float fade = 1.0f;
+    float fadeEnd = light->GetDrawDistance();
+    float fadeStart = light->GetFadeDistance();
+
+    // Do fade calculation for light if both fade & draw distance defined
+    if (light->GetLightType() != LIGHT_DIRECTIONAL && fadeEnd > 0.0f && fadeStart > 0.0f && fadeStart < fadeEnd)
+        fade = Min(1.0f - (light->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 1.0f);
+
+    // Negative lights will use subtract blending, so write absolute RGB values to the shader parameter
+    shaderParameters_.Add(PSP_LIGHTCOLOR, Color(light->GetEffectiveColor().Abs(), light->GetEffectiveSpecularIntensity()) * fade);
+    shaderParameters_.Add(PSP_LIGHTDIR, lightWorldRotation * Vector3::BACK);
+    shaderParameters_.Add(PSP_LIGHTPOS, Vector4(lightNode->GetWorldPosition(), atten));
+    volumeShaderParameters_.Add(PSP_LIGHTPOS, Vector4(lightNode->GetWorldPosition() - cameraEffectivePos, atten));
+
+    switch (light->GetLightType())
+    {
+    case LIGHT_DIRECTIONAL:
+        {
+            Matrix4 shadowMatrices[MAX_CASCADE_SPLITS];
+            Matrix4 volumeShadowMatrices[MAX_CASCADE_SPLITS];
+            unsigned numSplits = (unsigned)Min(MAX_CASCADE_SPLITS, (int)shadowSplits_.Size());
+
+            for (unsigned i = 0; i < numSplits; ++i)
+            {
+                CalculateShadowMatrix(shadowMatrices[i], this, i, renderer, Vector3::ZERO);
+                CalculateShadowMatrix(volumeShadowMatrices[i], this, i, renderer, cameraEffectivePos);
+            }
+            shaderParameters_.Add(PSP_LIGHTMATRICES, shadowMatrices[0].Data(), 16 * numSplits);
+            volumeShaderParameters_.Add(PSP_LIGHTMATRICES, volumeShadowMatrices[0].Data(), 16 * numSplits);
+        }
+        break;
+
+    case LIGHT_SPOT:
+        {
+            Matrix4 shadowMatrices[2];
+
+            CalculateSpotMatrix(shadowMatrices[0], light, cameraEffectivePos);
+            bool isShadowed = shadowMap_ != 0;
+            if (isShadowed)
+                CalculateShadowMatrix(shadowMatrices[1], this, 0, renderer, Vector3::ZERO);
+            shaderParameters_.Add(PSP_LIGHTMATRICES, shadowMatrices[0].Data(), isShadowed ? 32 : 16);
+
+            if (isShadowed)
+            {
+                CalculateShadowMatrix(shadowMatrices[1], this, 0, renderer, cameraEffectivePos);
+                volumeShaderParameters_.Add(PSP_LIGHTMATRICES, shadowMatrices[0].Data(), 32);
+            }
+        }
+        break;
+
+    case LIGHT_POINT:
+        {
+            Matrix4 lightVecRot(lightNode->GetWorldRotation().RotationMatrix());
+            // HLSL compiler will pack the parameters as if the matrix is only 3x4, so must be careful to not overwrite
+            // the next parameter
+#ifdef URHO3D_OPENGL
+            shaderParameters_.Add(PSP_LIGHTMATRICES, lightVecRot.Data(), 16);
+#else
+            shaderParameters_.Add(PSP_LIGHTMATRICES, lightVecRot.Data(), 12);
+#endif
+        }
+        break;
+    }
+
+    // Set shadow mapping shader parameters
+    Texture2D* shadowMap = shadowMap_;
+    if (shadowMap)
+    {
+        {
+            // Calculate point light shadow sampling offsets (unrolled cube map)
+            unsigned faceWidth = (unsigned)(shadowMap->GetWidth() / 2);
+            unsigned faceHeight = (unsigned)(shadowMap->GetHeight() / 3);
+            float width = (float)shadowMap->GetWidth();
+            float height = (float)shadowMap->GetHeight();
+#ifdef URHO3D_OPENGL
+            float mulX = (float)(faceWidth - 3) / width;
+            float mulY = (float)(faceHeight - 3) / height;
+            float addX = 1.5f / width;
+            float addY = 1.5f / height;
+#else
+            float mulX = (float)(faceWidth - 4) / width;
+            float mulY = (float)(faceHeight - 4) / height;
+            float addX = 2.5f / width;
+            float addY = 2.5f / height;
+#endif
+            // If using 4 shadow samples, offset the position diagonally by half pixel
+            if (renderer->GetShadowQuality() & SHADOWQUALITY_HIGH_16BIT)
+            {
+                addX -= 0.5f / width;
+                addY -= 0.5f / height;
+            }
+            shaderParameters_.Add(PSP_SHADOWCUBEADJUST, Vector4(mulX, mulY, addX, addY));
+        }
+
+        {
+            // Calculate shadow camera depth parameters for point light shadows and shadow fade parameters for
+            //  directional light shadows, stored in the same uniform
+            Camera* shadowCamera = shadowSplits_[0].shadowCamera_;
+            float nearClip = shadowCamera->GetNearClip();
+            float farClip = shadowCamera->GetFarClip();
+            float q = farClip / (farClip - nearClip);
+            float r = -q * nearClip;
+
+            const CascadeParameters& parameters = light->GetShadowCascade();
+            float viewFarClip = camera->GetFarClip();
+            float shadowRange = parameters.GetShadowRange();
+            float fadeStart = parameters.fadeStart_ * shadowRange / viewFarClip;
+            float fadeEnd = shadowRange / viewFarClip;
+            float fadeRange = fadeEnd - fadeStart;
+
+            shaderParameters_.Add(PSP_SHADOWDEPTHFADE, Vector4(q, r, fadeStart, 1.0f / fadeRange));
+        }
+
+        {
+            float intensity = light->GetShadowIntensity();
+            float fadeStart = light->GetShadowFadeDistance();
+            float fadeEnd = light->GetShadowDistance();
+            if (fadeStart > 0.0f && fadeEnd > 0.0f && fadeEnd > fadeStart)
+                intensity = Lerp(intensity, 1.0f, Clamp((light->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 0.0f, 1.0f));
+            float pcfValues = (1.0f - intensity);
+            float samples = renderer->GetShadowQuality() >= SHADOWQUALITY_HIGH_16BIT ? 4.0f : 1.0f;
+
+            shaderParameters_.Add(PSP_SHADOWINTENSITY, Vector4(pcfValues / samples, intensity, 0.0f, 0.0f));
+        }
+
+        float sizeX = 1.0f / (float)shadowMap->GetWidth();
+        float sizeY = 1.0f / (float)shadowMap->GetHeight();
+        shaderParameters_.Add(PSP_SHADOWMAPINVSIZE, Vector4(sizeX, sizeY, 0.0f, 0.0f));
+
+        Vector4 lightSplits(M_LARGE_VALUE, M_LARGE_VALUE, M_LARGE_VALUE, M_LARGE_VALUE);
+        if (shadowSplits_.Size() > 1)
+            lightSplits.x_ = shadowSplits_[0].farSplit_ / camera->GetFarClip();
+        if (shadowSplits_.Size() > 2)
+            lightSplits.y_ = shadowSplits_[1].farSplit_ / camera->GetFarClip();
+        if (shadowSplits_.Size() > 3)
+            lightSplits.z_ = shadowSplits_[2].farSplit_ / camera->GetFarClip();
+
+        shaderParameters_.Add(PSP_SHADOWSPLITS, lightSplits);
+    }
+}
+
 }
@@ -22,7 +22,10 @@
 
 #pragma once
 
+#include "../Container/FlatHashMap.h"
 #include "../Container/Ptr.h"
+#include "../Container/Sort.h"
+#include "../Core/FrameAllocator.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Material.h"
 #include "../Math/MathDefs.h"
@@ -35,10 +38,12 @@ namespace Urho3D
 class Camera;
 class Drawable;
 class Geometry;
+class Graphics;
 class Light;
 class Material;
 class Matrix3x4;
 class Pass;
+class Renderer;
 class ShaderVariation;
 class Texture2D;
 class VertexBuffer;
@@ -165,11 +170,15 @@ struct BatchGroup : public Batch
 
     /// Pre-set the instance transforms. Buffer must be big enough to hold all transforms.
     void SetTransforms(void* lockedData, unsigned& freeIndex);
+    /// Assign the instance stream start index without copying the transforms yet.
+    void SetInstanceIndex(unsigned& freeIndex);
+    /// Copy the instance transforms to the range assigned by SetInstanceIndex(). Can be called from worker threads.
+    void CopyTransforms(void* lockedData) const;
     /// Prepare and draw.
     void Draw(View* view, Camera* camera, bool allowDepthWrite) const;
 
-    /// Instance data.
-    PODVector<InstanceData> instances_;
+    /// Instance data. Allocated from the frame allocator, so only valid until the end of the frame.
+    FrameVector<InstanceData> instances_;
     /// Instance stream start index, or M_MAX_UNSIGNED if transforms not pre-set.
     unsigned startIndex_;
 };
@@ -230,14 +239,24 @@ struct BatchQueue
 public:
     /// Clear for new frame by clearing all groups and batches.
     void Clear(int maxSortedInstances);
+    /// Clear for new frame by clearing batches and the instances of groups, but keep the groups themselves for reuse. Groups that receive no instances should be removed with RemoveUnusedGroups() before sorting.
+    void ClearInstances(int maxSortedInstances);
+    /// Remove groups that have not received instances since the last ClearInstances().
+    void RemoveUnusedGroups();
     /// Sort non-instanced draw calls back to front.
     void SortBackToFront();
     /// Sort instanced and non-instanced draw calls front to back.
     void SortFrontToBack();
     /// Sort batches front to back while also maintaining state sorting.
     void SortFrontToBack2Pass(PODVector<Batch*>& batches);
+    /// Sort batches by the keys in sortItems_.
+    void SortByKeys(PODVector<Batch*>& batches);
     /// Pre-set instance transforms of all groups. The vertex buffer must be big enough to hold all transforms.
     void SetTransforms(void* lockedData, unsigned& freeIndex);
+    /// Assign the instance stream start indices of all groups without copying the transforms yet.
+    void SetInstanceIndices(unsigned& freeIndex);
+    /// Copy instance transforms of all groups to the ranges assigned by SetInstanceIndices(). Can be called from worker threads.
+    void CopyTransforms(void* lockedData) const;
     /// Draw.
     void Draw(View* view, Camera* camera, bool markToStencil, bool usingLightOptimization, bool allowDepthWrite) const;
     /// Return the combined amount of instances.
@@ -247,13 +266,17 @@ public:
     bool IsEmpty() const { return batches_.Empty() && batchGroups_.Empty(); }
 
     /// Instanced draw calls.
-    HashMap<BatchGroupKey, BatchGroup> batchGroups_;
-    /// Shader remapping table for 2-pass state and distance sort.
-    HashMap<unsigned, unsigned> shaderRemapping_;
-    /// Material remapping table for 2-pass state and distance sort.
-    HashMap<unsigned short, unsigned short> materialRemapping_;
-    /// Geometry remapping table for 2-pass state and distance sort.
-    HashMap<unsigned short, unsigned short> geometryRemapping_;
+    FlatHashMap<BatchGroupKey, BatchGroup> batchGroups_;
+    /// Shader remapping table for 2-pass state and distance sort, indexed by the shader bits of the sort key. Zero when not remapped.
+    PODVector<unsigned short> shaderRemapping_;
+    /// Material remapping table for 2-pass state and distance sort, indexed by material sort ID. Zero when not remapped.
+    PODVector<unsigned short> materialRemapping_;
+    /// Geometry remapping table for 2-pass state and distance sort, indexed by geometry sort ID. Zero when not remapped.
+    PODVector<unsigned short> geometryRemapping_;
+    /// Radix sort keys.
+    PODVector<RadixSortItem<Batch*> > sortItems_;
+    /// Radix sort temporary buffer.
+    PODVector<RadixSortItem<Batch*> > sortTemp_;
 
     /// Unsorted non-instanced draw calls.
     PODVector<Batch> batches_;
@@ -265,6 +288,41 @@ public:
     unsigned maxSortedInstances_;
 };
 
+/// Shader parameter values recorded ahead of rendering, possibly in a worker thread, to be set on the main thread later.
+struct URHO3D_API ShaderParameterBlock
+{
+    /// Recorded parameter.
+    struct Entry
+    {
+        /// Parameter name.
+        StringHash name_;
+        /// Value type. VAR_BUFFER for a float array.
+        VariantType type_;
+        /// Offset to the float data.
+        unsigned offset_;
+        /// Number of floats.
+        unsigned count_;
+    };
+
+    /// Remove all recorded parameters.
+    void Clear();
+    /// Record a float array parameter.
+    void Add(StringHash param, const float* data, unsigned count);
+    /// Record a Vector3 parameter.
+    void Add(StringHash param, const Vector3& vector);
+    /// Record a Vector4 parameter.
+    void Add(StringHash param, const Vector4& vector);
+    /// Record a color parameter.
+    void Add(StringHash param, const Color& color);
+    /// Set the recorded parameters to the current shader program. Parameters it does not use are skipped.
+    void Apply(Graphics* graphics) const;
+
+    /// Recorded parameters.
+    PODVector<Entry> entries_;
+    /// Parameter values.
+    PODVector<float> data_;
+};
+
 /// Queue for shadow map draw calls
 struct ShadowBatchQueue
 {
@@ -299,6 +357,17 @@ struct LightBatchQueue
     PODVector<Light*> vertexLights_;
     /// Light volume draw calls.
     PODVector<Batch> volumeBatches_;
+    /// Light or vertex light shader parameters recorded ahead of rendering.
+    ShaderParameterBlock shaderParameters_;
+    /// Light position and matrix shader parameters for light volumes, which are relative to the camera. Applied after shaderParameters_.
+    ShaderParameterBlock volumeShaderParameters_;
+    /// Vertex shader light matrices for a shadowed spot light when the shader samples the shadow map. Applied after shaderParameters_.
+    ShaderParameterBlock shadowedSpotShaderParameters_;
+    /// Camera the shader parameters were recorded for. Null if not recorded yet.
+    Camera* parameterCamera_;
+
+    /// Record the shader parameters for rendering with a camera. Can be called from worker threads.
+    void RecordShaderParameters(Camera* camera, Renderer* renderer);
 };
 
 }
@@ -25,6 +25,7 @@
 #include "../../Graphics/Graphics.h"
 #include "../../Graphics/GraphicsImpl.h"
 #include "../../Graphics/Shader.h"
+#include "../../Graphics/SortIDPool.h"
 #include "../../Graphics/VertexBuffer.h"
 #include "../../IO/File.h"
 #include "../../IO/FileSystem.h"
@@ -38,11 +39,14 @@
 namespace Urho3D
 {
 
+static SortIDPool shaderSortIDs;
+
 ShaderVariation::ShaderVariation(Shader* owner, ShaderType type) :
     GPUObject(owner->GetSubsystem<Graphics>()),
     owner_(owner),
     type_(type),
-    elementMask_(0)
+    elementMask_(0),
+    sortID_(shaderSortIDs.Allocate())
 {
     for (unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
         useTextureUnit_[i] = false;
@@ -53,6 +57,7 @@ ShaderVariation::ShaderVariation(Shader* owner, ShaderType type) :
 ShaderVariation::~ShaderVariation()
 {
     Release();
+    shaderSortIDs.Release(sortID_);
 }
 
 bool ShaderVariation::Create()
@@ -124,6 +124,9 @@ public:
     /// Return compile error/warning string.
     const String& GetCompilerOutput() const { return compilerOutput_; }
 
+    /// Return small integer ID used for batch sorting. Unique among the live shader variations.
+    unsigned GetSortID() const { return sortID_; }
+
     /// Return constant buffer data sizes.
     const unsigned* GetConstantBufferSizes() const { return &constantBufferSizes_[0]; }
 
@@ -159,6 +162,8 @@ private:
     String defines_;
     /// Shader compile error string.
     String compilerOutput_;
+    /// Batch sorting ID.
+    unsigned sortID_;
 };
 
 }
@@ -22,6 +22,7 @@
 
 #include "../../Precompiled.h"
 
+#include "../../Core/MemoryTracker.h"
 #include "../../Graphics/Graphics.h"
 #include "../../Graphics/GraphicsImpl.h"
 #include "../../Graphics/VertexBuffer.h"
@@ -146,6 +147,8 @@ void VertexBuffer::Release()
 
 void VertexBuffer::SetShadowed(bool enable)
 {
+    URHO3D_MEMORY_CATEGORY(MEMCAT_GRAPHICS);
+
     // If no graphics subsystem, can not disable shadowing
     if (!graphics_)
         enable = true;
@@ -163,6 +166,8 @@ void VertexBuffer::SetShadowed(bool enable)
 
 bool VertexBuffer::SetSize(unsigned vertexCount, unsigned elementMask, bool dynamic)
 {
+    URHO3D_MEMORY_CATEGORY(MEMCAT_GRAPHICS);
+
     Unlock();
 
     dynamic_ = dynamic;
@@ -26,6 +26,7 @@
 #include "../../Graphics/GraphicsImpl.h"
 #include "../../Graphics/Shader.h"
 #include "../../Graphics/ShaderVariation.h"
+#include "../../Graphics/SortIDPool.h"
 #include "../../IO/File.h"
 #include "../../IO/FileSystem.h"
 #include "../../IO/Log.h"
@@ -39,10 +40,13 @@
 namespace Urho3D
 {
 
+static SortIDPool shaderSortIDs;
+
 ShaderVariation::ShaderVariation(Shader* owner, ShaderType type) :
     GPUObject(owner->GetSubsystem<Graphics>()),
     owner_(owner),
-    type_(type)
+    type_(type),
+    sortID_(shaderSortIDs.Allocate())
 {
     for (unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
         useTextureUnit_[i] = false;
@@ -51,6 +55,7 @@ ShaderVariation::ShaderVariation(Shader* owner, ShaderType type) :
 ShaderVariation::~ShaderVariation()
 {
     Release();
+    shaderSortIDs.Release(sortID_);
 }
 
 bool ShaderVariation::Create()
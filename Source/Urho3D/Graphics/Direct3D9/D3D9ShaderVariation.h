@@ -100,6 +100,9 @@ public:
     /// Return compile error/warning string.
     const String& GetCompilerOutput() const { return compilerOutput_; }
 
+    /// Return small integer ID used for batch sorting. Unique among the live shader variations.
+    unsigned GetSortID() const { return sortID_; }
+
     /// Return whether uses a parameter.
     bool HasParameter(StringHash param) const { return parameters_.Contains(param); }
 
@@ -135,6 +138,8 @@ private:
     HashMap<StringHash, ShaderParameter> parameters_;
     /// Texture unit use flags.
     bool useTextureUnit_[MAX_TEXTURE_UNITS];
+    /// Batch sorting ID.
+    unsigned sortID_;
 };
 
 }
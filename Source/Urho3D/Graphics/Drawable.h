@@ -109,6 +109,7 @@ class URHO3D_API Drawable : public Component
     friend class Octant;
     friend class Octree;
     friend void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex);
+    friend void ReinsertDrawablesWork(const WorkItem* item, unsigned threadIndex);
 
 public:
     /// Construct.
@@ -263,6 +264,9 @@ public:
     /// Return whether is in view on the current frame. Called by View.
     bool IsInView(const FrameInfo& frame, bool anyCamera = false) const;
 
+    /// Return the frame number on which was last in view. Called by View.
+    unsigned GetViewFrameNumber() const { return viewFrameNumber_; }
+
     /// Return whether has a base pass.
     bool HasBasePass(unsigned batchIndex) const { return (basePassFlags_ & (1 << batchIndex)) != 0; }
 
@@ -342,6 +346,10 @@ protected:
     bool zoneDirty_;
     /// Octree octant.
     Octant* octant_;
+    /// Index in the octree octant's drawable list.
+    unsigned octantIndex_;
+    /// Leaf node index in the octree's bounding volume hierarchy, or M_MAX_UNSIGNED if not stored there.
+    unsigned bvhLeaf_;
     /// Current zone.
     Zone* zone_;
     /// View mask.
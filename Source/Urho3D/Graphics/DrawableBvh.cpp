@@ -0,0 +1,309 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/DrawableBvh.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Leaf bounding box enlargement relative to the drawable's bounding box size.
+static const float BVH_LEAF_MARGIN = 0.1f;
+
+static inline BoundingBox CombineBoxes(const BoundingBox& lhs, const BoundingBox& rhs)
+{
+    BoundingBox result(lhs);
+    result.Merge(rhs);
+    return result;
+}
+
+static inline float SurfaceArea(const BoundingBox& box)
+{
+    Vector3 size = box.Size();
+    return 2.0f * (size.x_ * size.y_ + size.y_ * size.z_ + size.z_ * size.x_);
+}
+
+static inline BoundingBox EnlargeBox(const BoundingBox& box)
+{
+    Vector3 margin = BVH_LEAF_MARGIN * box.Size();
+    return BoundingBox(box.min_ - margin, box.max_ + margin);
+}
+
+DrawableBvh::DrawableBvh() :
+    root_(BVH_NULL_NODE),
+    freeList_(BVH_NULL_NODE),
+    numLeaves_(0)
+{
+}
+
+unsigned DrawableBvh::Insert(Drawable* drawable, const BoundingBox& box)
+{
+    unsigned leaf = AllocateNode();
+    BvhNode& node = nodes_[leaf];
+    node.box_ = EnlargeBox(box);
+    node.drawable_ = drawable;
+    node.height_ = 0;
+
+    InsertLeaf(leaf);
+    ++numLeaves_;
+    return leaf;
+}
+
+void DrawableBvh::Remove(unsigned leaf)
+{
+    assert(leaf < nodes_.Size() && nodes_[leaf].IsLeaf());
+
+    RemoveLeaf(leaf);
+    FreeNode(leaf);
+    --numLeaves_;
+}
+
+bool DrawableBvh::Move(unsigned leaf, const BoundingBox& box)
+{
+    assert(leaf < nodes_.Size() && nodes_[leaf].IsLeaf());
+
+    if (nodes_[leaf].box_.IsInside(box) == INSIDE)
+        return false;
+
+    RemoveLeaf(leaf);
+    nodes_[leaf].box_ = EnlargeBox(box);
+    InsertLeaf(leaf);
+    return true;
+}
+
+void DrawableBvh::Clear()
+{
+    nodes_.Clear();
+    root_ = BVH_NULL_NODE;
+    freeList_ = BVH_NULL_NODE;
+    numLeaves_ = 0;
+}
+
+unsigned DrawableBvh::AllocateNode()
+{
+    unsigned index;
+    if (freeList_ != BVH_NULL_NODE)
+    {
+        index = freeList_;
+        freeList_ = nodes_[index].parent_;
+    }
+    else
+    {
+        index = nodes_.Size();
+        nodes_.Resize(index + 1);
+    }
+
+    BvhNode& node = nodes_[index];
+    node.drawable_ = 0;
+    node.parent_ = BVH_NULL_NODE;
+    node.children_[0] = BVH_NULL_NODE;
+    node.children_[1] = BVH_NULL_NODE;
+    node.height_ = 0;
+    return index;
+}
+
+void DrawableBvh::FreeNode(unsigned index)
+{
+    BvhNode& node = nodes_[index];
+    node.drawable_ = 0;
+    node.parent_ = freeList_;
+    node.children_[0] = BVH_NULL_NODE;
+    node.children_[1] = BVH_NULL_NODE;
+    node.height_ = -1;
+    freeList_ = index;
+}
+
+void DrawableBvh::InsertLeaf(unsigned leaf)
+{
+    if (root_ == BVH_NULL_NODE)
+    {
+        root_ = leaf;
+        nodes_[leaf].parent_ = BVH_NULL_NODE;
+        return;
+    }
+
+    // Descend to the sibling that gives the least surface area increase
+    BoundingBox leafBox = nodes_[leaf].box_;
+    unsigned index = root_;
+    while (!nodes_[index].IsLeaf())
+    {
+        const BvhNode& node = nodes_[index];
+        float area = SurfaceArea(node.box_);
+        float combinedArea = SurfaceArea(CombineBoxes(node.box_, leafBox));
+
+        // Cost of creating a new parent for this node and the new leaf, and the minimum cost of pushing the leaf further down
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        float childCosts[2];
+        for (unsigned i = 0; i < 2; ++i)
+        {
+            const BvhNode& child = nodes_[node.children_[i]];
+            float childArea = SurfaceArea(CombineBoxes(child.box_, leafBox));
+            childCosts[i] = (child.IsLeaf() ? childArea : childArea - SurfaceArea(child.box_)) + inheritanceCost;
+        }
+
+        if (cost < childCosts[0] && cost < childCosts[1])
+            break;
+
+        index = childCosts[0] < childCosts[1] ? node.children_[0] : node.children_[1];
+    }
+
+    // Create a new parent for the sibling and the leaf. Note that allocation may move the nodes in memory
+    unsigned sibling = index;
+    unsigned oldParent = nodes_[sibling].parent_;
+    unsigned newParent = AllocateNode();
+    BvhNode& parentNode = nodes_[newParent];
+    parentNode.parent_ = oldParent;
+    parentNode.box_ = CombineBoxes(leafBox, nodes_[sibling].box_);
+    parentNode.height_ = nodes_[sibling].height_ + 1;
+    parentNode.children_[0] = sibling;
+    parentNode.children_[1] = leaf;
+    nodes_[sibling].parent_ = newParent;
+    nodes_[leaf].parent_ = newParent;
+
+    if (oldParent != BVH_NULL_NODE)
+    {
+        BvhNode& oldParentNode = nodes_[oldParent];
+        if (oldParentNode.children_[0] == sibling)
+            oldParentNode.children_[0] = newParent;
+        else
+            oldParentNode.children_[1] = newParent;
+    }
+    else
+        root_ = newParent;
+
+    RefitAncestors(newParent);
+}
+
+void DrawableBvh::RemoveLeaf(unsigned leaf)
+{
+    if (leaf == root_)
+    {
+        root_ = BVH_NULL_NODE;
+        return;
+    }
+
+    // Replace the parent with the sibling
+    unsigned parent = nodes_[leaf].parent_;
+    unsigned grandParent = nodes_[parent].parent_;
+    unsigned sibling = nodes_[parent].children_[0] == leaf ? nodes_[parent].children_[1] : nodes_[parent].children_[0];
+
+    nodes_[sibling].parent_ = grandParent;
+    nodes_[leaf].parent_ = BVH_NULL_NODE;
+    FreeNode(parent);
+
+    if (grandParent != BVH_NULL_NODE)
+    {
+        BvhNode& grandParentNode = nodes_[grandParent];
+        if (grandParentNode.children_[0] == parent)
+            grandParentNode.children_[0] = sibling;
+        else
+            grandParentNode.children_[1] = sibling;
+
+        RefitAncestors(grandParent);
+    }
+    else
+        root_ = sibling;
+}
+
+void DrawableBvh::RefitAncestors(unsigned index)
+{
+    while (index != BVH_NULL_NODE)
+    {
+        index = Balance(index);
+
+        BvhNode& node = nodes_[index];
+        const BvhNode& child0 = nodes_[node.children_[0]];
+        const BvhNode& child1 = nodes_[node.children_[1]];
+        node.height_ = 1 + Max(child0.height_, child1.height_);
+        node.box_ = CombineBoxes(child0.box_, child1.box_);
+
+        index = node.parent_;
+    }
+}
+
+unsigned DrawableBvh::Balance(unsigned indexA)
+{
+    BvhNode& a = nodes_[indexA];
+    if (a.IsLeaf() || a.height_ < 2)
+        return indexA;
+
+    unsigned indexB = a.children_[0];
+    unsigned indexC = a.children_[1];
+    BvhNode& b = nodes_[indexB];
+    BvhNode& c = nodes_[indexC];
+    int balance = c.height_ - b.height_;
+
+    if (balance > 1 || balance < -1)
+    {
+        // Rotate the taller child up: it takes A's place and A takes the taller child's shorter grandchild
+        unsigned indexUp = balance > 1 ? indexC : indexB;
+        unsigned indexOther = balance > 1 ? indexB : indexC;
+        unsigned upSlot = balance > 1 ? 1 : 0;
+        BvhNode& up = nodes_[indexUp];
+        BvhNode& other = nodes_[indexOther];
+        unsigned indexF = up.children_[0];
+        unsigned indexG = up.children_[1];
+        BvhNode& f = nodes_[indexF];
+        BvhNode& g = nodes_[indexG];
+
+        up.children_[0] = indexA;
+        up.parent_ = a.parent_;
+        a.parent_ = indexUp;
+
+        if (up.parent_ != BVH_NULL_NODE)
+        {
+            BvhNode& parentNode = nodes_[up.parent_];
+            if (parentNode.children_[0] == indexA)
+                parentNode.children_[0] = indexUp;
+            else
+                parentNode.children_[1] = indexUp;
+        }
+        else
+            root_ = indexUp;
+
+        // Keep the taller grandchild under the rotated node
+        unsigned indexTall = f.height_ > g.height_ ? indexF : indexG;
+        unsigned indexShort = f.height_ > g.height_ ? indexG : indexF;
+        BvhNode& tall = nodes_[indexTall];
+        BvhNode& shortNode = nodes_[indexShort];
+
+        up.children_[1] = indexTall;
+        a.children_[upSlot] = indexShort;
+        shortNode.parent_ = indexA;
+
+        a.box_ = CombineBoxes(other.box_, shortNode.box_);
+        a.height_ = 1 + Max(other.height_, shortNode.height_);
+        up.box_ = CombineBoxes(a.box_, tall.box_);
+        up.height_ = 1 + Max(a.height_, tall.height_);
+
+        return indexUp;
+    }
+
+    return indexA;
+}
+
+}
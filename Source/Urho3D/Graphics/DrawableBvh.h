@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Math/BoundingBox.h"
+
+namespace Urho3D
+{
+
+class Drawable;
+
+/// Null node index for the bounding volume hierarchy.
+static const unsigned BVH_NULL_NODE = M_MAX_UNSIGNED;
+
+/// %Node of a dynamic bounding volume hierarchy.
+struct BvhNode
+{
+    /// Return whether is a leaf node.
+    bool IsLeaf() const { return children_[0] == BVH_NULL_NODE; }
+
+    /// Bounding box. For leaf nodes this is the drawable's bounding box enlarged by a margin.
+    BoundingBox box_;
+    /// Drawable object in a leaf node, null in a branch node.
+    Drawable* drawable_;
+    /// Parent node index. For unused nodes the next free node index.
+    unsigned parent_;
+    /// Child node indices.
+    unsigned children_[2];
+    /// Height of the subtree, 0 for a leaf node and -1 for an unused node.
+    int height_;
+};
+
+/// Dynamic bounding volume hierarchy of drawable objects. Leaves store an enlarged bounding box, so that small movements do not require reinsertion, and the tree is kept balanced with rotations.
+class URHO3D_API DrawableBvh
+{
+public:
+    /// Construct empty.
+    DrawableBvh();
+
+    /// Insert a drawable object with its world bounding box. Return the leaf node index, which stays valid until the leaf is removed.
+    unsigned Insert(Drawable* drawable, const BoundingBox& box);
+    /// Remove a leaf node.
+    void Remove(unsigned leaf);
+    /// Update the bounding box of a leaf node. The leaf is reinserted only if the box is no longer inside the enlarged box. Return true if reinserted.
+    bool Move(unsigned leaf, const BoundingBox& box);
+    /// Remove all nodes.
+    void Clear();
+
+    /// Return root node index, or BVH_NULL_NODE if empty.
+    unsigned GetRoot() const { return root_; }
+
+    /// Return a node by index.
+    const BvhNode& GetNode(unsigned index) const { return nodes_[index]; }
+
+    /// Return all nodes, including unused ones.
+    const PODVector<BvhNode>& GetNodes() const { return nodes_; }
+
+    /// Return number of leaf nodes.
+    unsigned GetNumLeaves() const { return numLeaves_; }
+
+    /// Return height of the tree.
+    int GetHeight() const { return root_ != BVH_NULL_NODE ? nodes_[root_].height_ : 0; }
+
+private:
+    /// Take a node from the free list or allocate a new one.
+    unsigned AllocateNode();
+    /// Return a node to the free list.
+    void FreeNode(unsigned index);
+    /// Link a leaf node into the tree at the position of least surface area increase.
+    void InsertLeaf(unsigned leaf);
+    /// Unlink a leaf node from the tree.
+    void RemoveLeaf(unsigned leaf);
+    /// Refit the bounding boxes and heights of the ancestors of a node, rebalancing on the way up.
+    void RefitAncestors(unsigned index);
+    /// Rotate a subtree if it is imbalanced. Return the index of the new subtree root.
+    unsigned Balance(unsigned index);
+
+    /// Nodes.
+    PODVector<BvhNode> nodes_;
+    /// Root node index.
+    unsigned root_;
+    /// First free node index.
+    unsigned freeList_;
+    /// Number of leaf nodes.
+    unsigned numLeaves_;
+};
+
+}
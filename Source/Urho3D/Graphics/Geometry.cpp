@@ -25,6 +25,7 @@
 #include "../Graphics/Geometry.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/IndexBuffer.h"
+#include "../Graphics/SortIDPool.h"
 #include "../Graphics/VertexBuffer.h"
 #include "../IO/Log.h"
 #include "../Math/Ray.h"
@@ -34,6 +35,8 @@
 namespace Urho3D
 {
 
+static SortIDPool geometrySortIDs;
+
 Geometry::Geometry(Context* context) :
     Object(context),
     primitiveType_(TRIANGLE_LIST),
@@ -45,13 +48,15 @@ Geometry::Geometry(Context* context) :
     rawVertexSize_(0),
     rawElementMask_(0),
     rawIndexSize_(0),
-    lodDistance_(0.0f)
+    lodDistance_(0.0f),
+    sortID_(geometrySortIDs.Allocate())
 {
     SetNumVertexBuffers(1);
 }
 
 Geometry::~Geometry()
 {
+    geometrySortIDs.Release(sortID_);
 }
 
 bool Geometry::SetNumVertexBuffers(unsigned num)
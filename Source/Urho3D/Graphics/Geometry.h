@@ -100,6 +100,9 @@ public:
     /// Return LOD distance.
     float GetLodDistance() const { return lodDistance_; }
 
+    /// Return small integer ID used for batch sorting. Unique among the live geometries.
+    unsigned GetSortID() const { return sortID_; }
+
     /// Return buffers' combined hash value for state sorting.
     unsigned short GetBufferHash() const;
     /// Return raw vertex and index data for CPU operations, or null pointers if not available.
@@ -150,6 +153,8 @@ private:
     unsigned rawIndexSize_;
     /// LOD distance.
     float lodDistance_;
+    /// Batch sorting ID.
+    unsigned sortID_;
 };
 
 }
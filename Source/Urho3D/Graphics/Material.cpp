@@ -27,6 +27,7 @@
 #include "../Core/Profiler.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/Material.h"
+#include "../Graphics/SortIDPool.h"
 #include "../Graphics/Technique.h"
 #include "../Graphics/Texture2D.h"
 #include "../Graphics/Texture3D.h"
@@ -47,6 +48,8 @@ namespace Urho3D
 
 extern const char* wrapModeNames[];
 
+static SortIDPool materialSortIDs;
+
 static const char* textureUnitNames[] =
 {
     "diffuse",
@@ -172,6 +175,7 @@ void ShaderParameterAnimationInfo::ApplyValue(const Variant& newValue)
 Material::Material(Context* context) :
     Resource(context),
     auxViewFrameNumber_(0),
+    sortID_(materialSortIDs.Allocate()),
     shaderParameterHash_(0),
     occlusion_(true),
     specular_(false),
@@ -183,6 +187,7 @@ Material::Material(Context* context) :
 
 Material::~Material()
 {
+    materialSortIDs.Release(sortID_);
 }
 
 void Material::RegisterObject(Context* context)
@@ -213,6 +213,9 @@ public:
     /// Return last auxiliary view rendered frame number.
     unsigned GetAuxViewFrameNumber() const { return auxViewFrameNumber_; }
 
+    /// Return small integer ID used for batch sorting. Unique among the live materials.
+    unsigned GetSortID() const { return sortID_; }
+
     /// Return whether should render occlusion.
     bool GetOcclusion() const { return occlusion_; }
 
@@ -266,6 +269,8 @@ private:
     unsigned char renderOrder_;
     /// Last auxiliary view rendered frame number.
     unsigned auxViewFrameNumber_;
+    /// Batch sorting ID.
+    unsigned sortID_;
     /// Shader parameter hash value.
     unsigned shaderParameterHash_;
     /// Render occlusion flag.
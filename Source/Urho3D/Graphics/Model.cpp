@@ -82,6 +82,7 @@ bool Model::BeginLoad(Deserializer& source)
     geometries_.Clear();
     geometryBoneMappings_.Clear();
     geometryCenters_.Clear();
+    occluderGeometry_.Reset();
     morphs_.Clear();
     vertexBuffers_.Clear();
     indexBuffers_.Clear();
@@ -284,6 +285,28 @@ bool Model::BeginLoad(Deserializer& source)
         geometryCenters_.Push(Vector3::ZERO);
     memoryUse += sizeof(Vector3) * geometries_.Size();
 
+    // Read optional dedicated occluder geometry
+    if (!source.IsEof())
+    {
+        loadOccluderGeometry_.type_ = TRIANGLE_LIST;
+        loadOccluderGeometry_.vbRef_ = source.ReadUInt();
+        loadOccluderGeometry_.ibRef_ = source.ReadUInt();
+        loadOccluderGeometry_.indexStart_ = source.ReadUInt();
+        loadOccluderGeometry_.indexCount_ = source.ReadUInt();
+
+        if (loadOccluderGeometry_.vbRef_ >= vertexBuffers_.Size() || loadOccluderGeometry_.ibRef_ >= indexBuffers_.Size())
+        {
+            URHO3D_LOGERROR("Occluder geometry buffer index out of bounds");
+            loadVBData_.Clear();
+            loadIBData_.Clear();
+            loadGeometries_.Clear();
+            return false;
+        }
+
+        occluderGeometry_ = new Geometry(context_);
+        memoryUse += sizeof(Geometry);
+    }
+
     SetMemoryUse(memoryUse);
     return true;
 }
@@ -329,6 +352,14 @@ bool Model::EndLoad()
         }
     }
 
+    if (occluderGeometry_)
+    {
+        occluderGeometry_->SetVertexBuffer(0, vertexBuffers_[loadOccluderGeometry_.vbRef_]);
+        occluderGeometry_->SetIndexBuffer(indexBuffers_[loadOccluderGeometry_.ibRef_]);
+        occluderGeometry_->SetDrawRange(loadOccluderGeometry_.type_, loadOccluderGeometry_.indexStart_,
+            loadOccluderGeometry_.indexCount_);
+    }
+
     loadVBData_.Clear();
     loadIBData_.Clear();
     loadGeometries_.Clear();
@@ -423,6 +454,23 @@ bool Model::Save(Serializer& dest) const
     for (unsigned i = 0; i < geometryCenters_.Size(); ++i)
         dest.WriteVector3(geometryCenters_[i]);
 
+    // Write dedicated occluder geometry. It can only follow a complete set of geometry centers
+    if (occluderGeometry_ && geometryCenters_.Size() == geometries_.Size())
+    {
+        VertexBuffer* vertexBuffer = occluderGeometry_->GetVertexBuffer(0);
+        IndexBuffer* indexBuffer = occluderGeometry_->GetIndexBuffer();
+        if (vertexBuffers_.Contains(SharedPtr<VertexBuffer>(vertexBuffer)) &&
+            indexBuffers_.Contains(SharedPtr<IndexBuffer>(indexBuffer)))
+        {
+            dest.WriteUInt(LookupVertexBuffer(vertexBuffer, vertexBuffers_));
+            dest.WriteUInt(LookupIndexBuffer(indexBuffer, indexBuffers_));
+            dest.WriteUInt(occluderGeometry_->GetIndexStart());
+            dest.WriteUInt(occluderGeometry_->GetIndexCount());
+        }
+        else
+            URHO3D_LOGWARNING("Occluder geometry does not use the model's own buffers, not saving it");
+    }
+
     return true;
 }
 
@@ -557,6 +605,18 @@ void Model::SetMorphs(const Vector<ModelMorph>& morphs)
     morphs_ = morphs;
 }
 
+bool Model::SetOccluderGeometry(Geometry* geometry)
+{
+    if (geometry && geometry->GetPrimitiveType() != TRIANGLE_LIST)
+    {
+        URHO3D_LOGERROR("Occluder geometry must be a triangle list");
+        return false;
+    }
+
+    occluderGeometry_ = geometry;
+    return true;
+}
+
 SharedPtr<Model> Model::Clone(const String& cloneName) const
 {
     SharedPtr<Model> ret(new Model(context_));
@@ -655,6 +715,15 @@ SharedPtr<Model> Model::Clone(const String& cloneName) const
         }
     }
 
+    if (occluderGeometry_)
+    {
+        ret->occluderGeometry_ = new Geometry(context_);
+        ret->occluderGeometry_->SetIndexBuffer(ibMapping[occluderGeometry_->GetIndexBuffer()]);
+        ret->occluderGeometry_->SetVertexBuffer(0, vbMapping[occluderGeometry_->GetVertexBuffer(0)]);
+        ret->occluderGeometry_->SetDrawRange(TRIANGLE_LIST, occluderGeometry_->GetIndexStart(),
+            occluderGeometry_->GetIndexCount(), occluderGeometry_->GetVertexStart(), occluderGeometry_->GetVertexCount(), false);
+    }
+
 
     // Deep copy the morph data (if any) to allow modifying it
     for (Vector<ModelMorph>::Iterator i = ret->morphs_.Begin(); i != ret->morphs_.End(); ++i)
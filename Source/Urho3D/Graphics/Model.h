@@ -145,6 +145,8 @@ public:
     void SetGeometryBoneMappings(const Vector<PODVector<unsigned> >& mappings);
     /// Set vertex morphs.
     void SetMorphs(const Vector<ModelMorph>& morphs);
+    /// Set dedicated low-poly occluder geometry, which is drawn to the occlusion buffer instead of the visible geometries. Must be a triangle list that uses the model's own vertex and index buffers. Null to disable.
+    bool SetOccluderGeometry(Geometry* geometry);
     /// Clone the model. The geometry data is deep-copied and can be modified in the clone without affecting the original.
     SharedPtr<Model> Clone(const String& cloneName = String::EMPTY) const;
 
@@ -181,6 +183,9 @@ public:
         return index < geometryCenters_.Size() ? geometryCenters_[index] : Vector3::ZERO;
     }
 
+    /// Return dedicated occluder geometry, or null if not defined.
+    Geometry* GetOccluderGeometry() const { return occluderGeometry_; }
+
     /// Return geometery bone mappings.
     const Vector<PODVector<unsigned> >& GetGeometryBoneMappings() const { return geometryBoneMappings_; }
 
@@ -216,6 +221,8 @@ private:
     Vector<PODVector<unsigned> > geometryBoneMappings_;
     /// Geometry centers.
     PODVector<Vector3> geometryCenters_;
+    /// Dedicated occluder geometry.
+    SharedPtr<Geometry> occluderGeometry_;
     /// Vertex morphs.
     Vector<ModelMorph> morphs_;
     /// Vertex buffer morph range start.
@@ -228,6 +235,8 @@ private:
     Vector<IndexBufferDesc> loadIBData_;
     /// Geometry definitions for asynchronous loading.
     Vector<PODVector<GeometryDesc> > loadGeometries_;
+    /// Occluder geometry definition for asynchronous loading.
+    GeometryDesc loadOccluderGeometry_;
 };
 
 }
@@ -28,6 +28,10 @@
 #include "../Graphics/OcclusionBuffer.h"
 #include "../IO/Log.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -40,22 +44,40 @@ static const unsigned CLIPMASK_Y_NEG = 0x8;
 static const unsigned CLIPMASK_Z_POS = 0x10;
 static const unsigned CLIPMASK_Z_NEG = 0x20;
 
+static const int OCCLUSION_TILE_WIDTH = 128;
+static const int OCCLUSION_TILE_HEIGHT = 32;
+
 void DrawOcclusionBatchWork(const WorkItem* item, unsigned threadIndex)
 {
     OcclusionBuffer* buffer = reinterpret_cast<OcclusionBuffer*>(item->aux_);
-    OcclusionBatch& batch = *reinterpret_cast<OcclusionBatch*>(item->start_);
-    buffer->DrawBatch(batch, threadIndex);
+    OcclusionBatch* start = reinterpret_cast<OcclusionBatch*>(item->start_);
+    OcclusionBatch* end = reinterpret_cast<OcclusionBatch*>(item->end_);
+
+    while (start != end)
+        buffer->DrawBatch(*start++, threadIndex);
+}
+
+void RasterizeOcclusionTilesWork(const WorkItem* item, unsigned threadIndex)
+{
+    OcclusionBuffer* buffer = reinterpret_cast<OcclusionBuffer*>(item->aux_);
+    IntRect* start = reinterpret_cast<IntRect*>(item->start_);
+    IntRect* end = reinterpret_cast<IntRect*>(item->end_);
+
+    while (start != end)
+        buffer->RasterizeTile((unsigned)(start++ - buffer->tiles_.Begin().ptr_));
 }
 
 OcclusionBuffer::OcclusionBuffer(Context* context) :
     Object(context),
     width_(0),
     height_(0),
+    tilesX_(0),
     numTriangles_(0),
     maxTriangles_(OCCLUSION_DEFAULT_MAX_TRIANGLES),
     cullMode_(CULL_CCW),
     depthHierarchyDirty_(true),
     reverseCulling_(false),
+    threaded_(false),
     nearClip_(0.0f),
     farClip_(0.0f)
 {
@@ -71,7 +93,10 @@ bool OcclusionBuffer::SetSize(int width, int height, bool threaded)
     if (height & 1)
         ++height;
 
-    if (width == width_ && height == height_)
+    // Each thread bins the triangles it sets up separately to avoid locking. Rebuild also if the threading mode or the number
+    // of threads has changed
+    unsigned numThreads = threaded ? GetSubsystem<WorkQueue>()->GetNumThreads() : 0;
+    if (width == width_ && height == height_ && binData_.Size() == numThreads + 1)
         return true;
 
     if (width <= 0 || height <= 0)
@@ -85,17 +110,28 @@ bool OcclusionBuffer::SetSize(int width, int height, bool threaded)
 
     width_ = width;
     height_ = height;
+    buffer_ = new int[width * height];
 
-    // Build work buffers for threading
-    unsigned numThreadBuffers = threaded ? GetSubsystem<WorkQueue>()->GetNumThreads() + 1 : 1;
-    buffers_.Resize(numThreadBuffers);
-    for (unsigned i = 0; i < numThreadBuffers; ++i)
+    // Split the buffer into tiles, which can be rasterized in parallel without a merge step
+    tilesX_ = (width + OCCLUSION_TILE_WIDTH - 1) / OCCLUSION_TILE_WIDTH;
+    int tilesY = (height + OCCLUSION_TILE_HEIGHT - 1) / OCCLUSION_TILE_HEIGHT;
+    tiles_.Clear();
+    for (int y = 0; y < tilesY; ++y)
     {
-        // Reserve extra memory in case 3D clipping is not exact
-        OcclusionBufferData& buffer = buffers_[i];
-        buffer.dataWithSafety_ = new int[width * (height + 2) + 2];
-        buffer.data_ = buffer.dataWithSafety_.Get() + width + 1;
-        buffer.used_ = false;
+        for (int x = 0; x < tilesX_; ++x)
+        {
+            tiles_.Push(IntRect(x * OCCLUSION_TILE_WIDTH, y * OCCLUSION_TILE_HEIGHT,
+                Min((x + 1) * OCCLUSION_TILE_WIDTH, width) - 1, Min((y + 1) * OCCLUSION_TILE_HEIGHT, height) - 1));
+        }
+    }
+
+    threaded_ = numThreads > 0;
+    binData_.Resize(numThreads + 1);
+    for (unsigned i = 0; i < binData_.Size(); ++i)
+    {
+        binData_[i].triangles_.Clear();
+        binData_[i].bins_.Clear();
+        binData_[i].bins_.Resize(tiles_.Size());
     }
 
     mipBuffers_.Clear();
@@ -113,7 +149,7 @@ bool OcclusionBuffer::SetSize(int width, int height, bool threaded)
     }
 
     URHO3D_LOGDEBUG("Set occlusion buffer size " + String(width_) + "x" + String(height_) + " with " +
-             String(mipBuffers_.Size()) + " mip levels and " + String(numThreadBuffers) + " thread buffers");
+             String(mipBuffers_.Size()) + " mip levels and " + String(tiles_.Size()) + " tiles");
 
     CalculateViewport();
     return true;
@@ -160,10 +196,12 @@ void OcclusionBuffer::Clear()
 {
     Reset();
 
-    // Only clear the main thread buffer. Rest are cleared on-demand when drawing the first batch
-    ClearBuffer(0);
-    for (unsigned i = 1; i < buffers_.Size(); ++i)
-        buffers_[i].used_ = false;
+    int* dest = buffer_.Get();
+    int count = width_ * height_;
+    int fillValue = (int)OCCLUSION_Z_SCALE;
+
+    while (count--)
+        *dest++ = fillValue;
 
     depthHierarchyDirty_ = true;
 }
@@ -206,41 +244,34 @@ bool OcclusionBuffer::AddTriangles(const Matrix3x4& model, const void* vertexDat
 
 void OcclusionBuffer::DrawTriangles()
 {
-    if (buffers_.Size() == 1)
+    if (!buffer_)
+        return;
+
+    if (!threaded_)
     {
-        // Not threaded
         for (Vector<OcclusionBatch>::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
             DrawBatch(*i, 0);
-
-        depthHierarchyDirty_ = true;
+        for (unsigned i = 0; i < tiles_.Size(); ++i)
+            RasterizeTile(i);
     }
-    else if (buffers_.Size() > 1)
+    else
     {
-        // Threaded
+        // Threaded. First set up and bin the triangles, then rasterize the tiles, each of which is written by one thread only
         WorkQueue* queue = GetSubsystem<WorkQueue>();
-
-        for (Vector<OcclusionBatch>::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = DrawOcclusionBatchWork;
-            item->aux_ = this;
-            item->start_ = &(*i);
-            queue->AddWorkItem(item);
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
-
-        MergeBuffers();
-        depthHierarchyDirty_ = true;
+        queue->ParallelFor(DrawOcclusionBatchWork, batches_, this);
+        queue->ParallelFor(RasterizeOcclusionTilesWork, tiles_, this);
     }
 
+    for (unsigned i = 0; i < binData_.Size(); ++i)
+        binData_[i].triangles_.Clear();
+
+    depthHierarchyDirty_ = true;
     batches_.Clear();
 }
 
 void OcclusionBuffer::BuildDepthHierarchy()
 {
-    if (buffers_.Empty() || !depthHierarchyDirty_)
+    if (!buffer_ || !depthHierarchyDirty_)
         return;
 
     URHO3D_PROFILE(BuildDepthHierarchy);
@@ -252,7 +283,7 @@ void OcclusionBuffer::BuildDepthHierarchy()
     {
         for (int y = 0; y < height; ++y)
         {
-            int* src = buffers_[0].data_ + (y * 2) * width_;
+            int* src = buffer_.Get() + (y * 2) * width_;
             DepthValue* dest = mipBuffers_[0].Get() + y * width;
             DepthValue* end = dest + width;
 
@@ -342,7 +373,7 @@ void OcclusionBuffer::ResetUseTimer()
 
 bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
 {
-    if (buffers_.Empty())
+    if (!buffer_)
         return true;
 
     // Transform corners to projection space
@@ -386,6 +417,85 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
         if (projected.z_ < minZ) minZ = projected.z_;
     }
 
+    return IsScreenRectVisible(minX, minY, maxX, maxY, minZ);
+}
+
+unsigned OcclusionBuffer::IsVisibleMask(const BoundingBoxBlock& worldSpaceBoxes) const
+{
+    const unsigned allVisible = (1 << BOUNDING_BOX_BLOCK_SIZE) - 1;
+
+    if (!buffer_)
+        return allVisible;
+
+#ifdef URHO3D_SSE
+    // Transform the corners of all four boxes at once, one corner at a time
+    const Matrix4& m = viewProj_;
+    __m128 minX = _mm_set1_ps(M_INFINITY);
+    __m128 maxX = _mm_set1_ps(-M_INFINITY);
+    __m128 minY = _mm_set1_ps(M_INFINITY);
+    __m128 maxY = _mm_set1_ps(-M_INFINITY);
+    __m128 minZ = _mm_set1_ps(M_INFINITY);
+    __m128 nearClipped = _mm_setzero_ps();
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        __m128 x = _mm_loadu_ps((i & 1) ? worldSpaceBoxes.maxX_ : worldSpaceBoxes.minX_);
+        __m128 y = _mm_loadu_ps((i & 2) ? worldSpaceBoxes.maxY_ : worldSpaceBoxes.minY_);
+        __m128 z = _mm_loadu_ps((i & 4) ? worldSpaceBoxes.maxZ_ : worldSpaceBoxes.minZ_);
+
+        __m128 projX = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m00_), x), _mm_mul_ps(_mm_set1_ps(m.m01_), y)),
+            _mm_mul_ps(_mm_set1_ps(m.m02_), z)), _mm_set1_ps(m.m03_));
+        __m128 projY = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m10_), x), _mm_mul_ps(_mm_set1_ps(m.m11_), y)),
+            _mm_mul_ps(_mm_set1_ps(m.m12_), z)), _mm_set1_ps(m.m13_));
+        __m128 projZ = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m20_), x), _mm_mul_ps(_mm_set1_ps(m.m21_), y)),
+            _mm_mul_ps(_mm_set1_ps(m.m22_), z)), _mm_set1_ps(m.m23_));
+        __m128 projW = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m30_), x), _mm_mul_ps(_mm_set1_ps(m.m31_), y)),
+            _mm_mul_ps(_mm_set1_ps(m.m32_), z)), _mm_set1_ps(m.m33_));
+
+        // Apply a far clip relative bias. Boxes with any corner crossing the near plane are assumed visible
+        projZ = _mm_sub_ps(projZ, _mm_set1_ps(OCCLUSION_RELATIVE_BIAS));
+        nearClipped = _mm_or_ps(nearClipped, _mm_cmple_ps(projZ, _mm_setzero_ps()));
+
+        __m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), projW);
+        __m128 screenX = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(invW, projX), _mm_set1_ps(scaleX_)), _mm_set1_ps(offsetX_));
+        __m128 screenY = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(invW, projY), _mm_set1_ps(scaleY_)), _mm_set1_ps(offsetY_));
+        __m128 screenZ = _mm_mul_ps(_mm_mul_ps(invW, projZ), _mm_set1_ps(OCCLUSION_Z_SCALE));
+
+        minX = _mm_min_ps(minX, screenX);
+        maxX = _mm_max_ps(maxX, screenX);
+        minY = _mm_min_ps(minY, screenY);
+        maxY = _mm_max_ps(maxY, screenY);
+        minZ = _mm_min_ps(minZ, screenZ);
+    }
+
+    float minXs[BOUNDING_BOX_BLOCK_SIZE], maxXs[BOUNDING_BOX_BLOCK_SIZE], minYs[BOUNDING_BOX_BLOCK_SIZE],
+        maxYs[BOUNDING_BOX_BLOCK_SIZE], minZs[BOUNDING_BOX_BLOCK_SIZE];
+    _mm_storeu_ps(minXs, minX);
+    _mm_storeu_ps(maxXs, maxX);
+    _mm_storeu_ps(minYs, minY);
+    _mm_storeu_ps(maxYs, maxY);
+    _mm_storeu_ps(minZs, minZ);
+
+    unsigned mask = (unsigned)_mm_movemask_ps(nearClipped);
+    for (unsigned i = 0; i < BOUNDING_BOX_BLOCK_SIZE; ++i)
+    {
+        if (!(mask & (1 << i)) && IsScreenRectVisible(minXs[i], minYs[i], maxXs[i], maxYs[i], minZs[i]))
+            mask |= 1 << i;
+    }
+    return mask;
+#else
+    unsigned mask = 0;
+    for (unsigned i = 0; i < BOUNDING_BOX_BLOCK_SIZE; ++i)
+    {
+        if (IsVisible(worldSpaceBoxes.Get(i)))
+            mask |= 1 << i;
+    }
+    return mask;
+#endif
+}
+
+bool OcclusionBuffer::IsScreenRectVisible(float minX, float minY, float maxX, float maxY, float minZ) const
+{
     // Expand the bounding box 1 pixel in each direction to be conservative and correct rasterization offset
     IntRect rect(
         (int)(minX - 1.5f), (int)(minY - 1.5f),
@@ -447,8 +557,8 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
     }
 
     // If no conclusive result, finally check the pixel-level data
-    int* row = buffers_[0].data_ + rect.top_ * width_;
-    int* endRow = buffers_[0].data_ + rect.bottom_ * width_;
+    int* row = buffer_.Get() + rect.top_ * width_;
+    int* endRow = buffer_.Get() + rect.bottom_ * width_;
     while (row <= endRow)
     {
         int* src = row + rect.left_;
@@ -473,13 +583,6 @@ unsigned OcclusionBuffer::GetUseTimer()
 
 void OcclusionBuffer::DrawBatch(const OcclusionBatch& batch, unsigned threadIndex)
 {
-    // If buffer not yet used, clear it
-    if (threadIndex > 0 && !buffers_[threadIndex].used_)
-    {
-        ClearBuffer(threadIndex);
-        buffers_[threadIndex].used_ = true;
-    }
-
     Matrix4 modelViewProj = viewProj_ * batch.model_;
 
     // Theoretical max. amount of vertices if each of the 6 clipping planes doubles the triangle count
@@ -643,7 +746,7 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices, unsigned threadIndex)
         bool clockwise = SignedArea(projected[0], projected[1], projected[2]) < 0.0f;
         if (cullMode_ == CULL_NONE || (cullMode_ == CULL_CCW && clockwise) || (cullMode_ == CULL_CW && !clockwise))
         {
-            DrawTriangle2D(projected, clockwise, threadIndex);
+            BinTriangle(projected, threadIndex);
             drawOk = true;
         }
     }
@@ -681,7 +784,7 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices, unsigned threadIndex)
                 bool clockwise = SignedArea(projected[0], projected[1], projected[2]) < 0.0f;
                 if (cullMode_ == CULL_NONE || (cullMode_ == CULL_CCW && clockwise) || (cullMode_ == CULL_CW && !clockwise))
                 {
-                    DrawTriangle2D(projected, clockwise, threadIndex);
+                    BinTriangle(projected, threadIndex);
                     drawOk = true;
                 }
             }
@@ -762,273 +865,206 @@ void OcclusionBuffer::ClipVertices(const Vector4& plane, Vector4* vertices, bool
     }
 }
 
-// Code based on Chris Hecker's Perspective Texture Mapping series in the Game Developer magazine
-// Also available online at http://chrishecker.com/Miscellaneous_Technical_Articles
-
-/// %Gradients of a software rasterized triangle.
-struct Gradients
+void OcclusionBuffer::BinTriangle(const Vector3* vertices, unsigned threadIndex)
 {
-    /// Construct from vertices.
-    Gradients(const Vector3* vertices)
-    {
-        float invdX = 1.0f / (((vertices[1].x_ - vertices[2].x_) *
-                               (vertices[0].y_ - vertices[2].y_)) -
-                              ((vertices[0].x_ - vertices[2].x_) *
-                               (vertices[1].y_ - vertices[2].y_)));
-
-        float invdY = -invdX;
-
-        dInvZdX_ = invdX * (((vertices[1].z_ - vertices[2].z_) * (vertices[0].y_ - vertices[2].y_)) -
-                            ((vertices[0].z_ - vertices[2].z_) * (vertices[1].y_ - vertices[2].y_)));
+    const Vector3& v0 = vertices[0];
+    const Vector3& v1 = vertices[1];
+    const Vector3& v2 = vertices[2];
+
+    float x1 = v1.x_ - v0.x_;
+    float y1 = v1.y_ - v0.y_;
+    float z1 = v1.z_ - v0.z_;
+    float x2 = v2.x_ - v0.x_;
+    float y2 = v2.y_ - v0.y_;
+    float z2 = v2.z_ - v0.z_;
+
+    // Twice the signed area. Reject degenerate triangles
+    float area = x1 * y2 - y1 * x2;
+    if (area == 0.0f)
+        return;
 
-        dInvZdY_ = invdY * (((vertices[1].z_ - vertices[2].z_) * (vertices[0].x_ - vertices[2].x_)) -
-                            ((vertices[0].z_ - vertices[2].z_) * (vertices[1].x_ - vertices[2].x_)));
+    // Pixel centers are at integer coordinate + 1 due to the half pixel offset in the viewport transform
+    IntRect rect(
+        Max((int)Min(Min(v0.x_, v1.x_), v2.x_) - 1, 0),
+        Max((int)Min(Min(v0.y_, v1.y_), v2.y_) - 1, 0),
+        Min((int)Max(Max(v0.x_, v1.x_), v2.x_), width_ - 1),
+        Min((int)Max(Max(v0.y_, v1.y_), v2.y_), height_ - 1)
+    );
+    if (rect.left_ > rect.right_ || rect.top_ > rect.bottom_)
+        return;
 
-        dInvZdXInt_ = (int)dInvZdX_;
+    OcclusionBinData& binData = binData_[threadIndex];
+    unsigned index = binData.triangles_.Size();
+    binData.triangles_.Resize(index + 1);
+    OcclusionTriangle& triangle = binData.triangles_[index];
+
+    // Orient the edge functions so that they are positive inside regardless of winding. They are evaluated relative to the
+    // first vertex for better precision
+    float sign = area > 0.0f ? 1.0f : -1.0f;
+    triangle.edgeX_[0] = -y1 * sign;
+    triangle.edgeY_[0] = x1 * sign;
+    triangle.edgeOffset_[0] = 0.0f;
+    triangle.edgeX_[1] = (v1.y_ - v2.y_) * sign;
+    triangle.edgeY_[1] = (v2.x_ - v1.x_) * sign;
+    triangle.edgeOffset_[1] = area * sign;
+    triangle.edgeX_[2] = y2 * sign;
+    triangle.edgeY_[2] = -x2 * sign;
+    triangle.edgeOffset_[2] = 0.0f;
+
+    float invArea = 1.0f / area;
+    triangle.originX_ = v0.x_;
+    triangle.originY_ = v0.y_;
+    triangle.originZ_ = v0.z_;
+    triangle.depthX_ = (z1 * y2 - z2 * y1) * invArea;
+    triangle.depthY_ = (z2 * x1 - z1 * x2) * invArea;
+    triangle.rect_ = rect;
+
+    int tileLeft = rect.left_ / OCCLUSION_TILE_WIDTH;
+    int tileRight = rect.right_ / OCCLUSION_TILE_WIDTH;
+    int tileTop = rect.top_ / OCCLUSION_TILE_HEIGHT;
+    int tileBottom = rect.bottom_ / OCCLUSION_TILE_HEIGHT;
+
+    for (int y = tileTop; y <= tileBottom; ++y)
+    {
+        for (int x = tileLeft; x <= tileRight; ++x)
+            binData.bins_[y * tilesX_ + x].Push(index);
     }
+}
 
-    /// Integer horizontal gradient.
-    int dInvZdXInt_;
-    /// Horizontal gradient.
-    float dInvZdX_;
-    /// Vertical gradient.
-    float dInvZdY_;
-};
-
-/// %Edge of a software rasterized triangle.
-struct Edge
+void OcclusionBuffer::RasterizeTile(unsigned index)
 {
-    /// Construct from gradients and top & bottom vertices.
-    Edge(const Gradients& gradients, const Vector3& top, const Vector3& bottom, int topY)
+    const IntRect& tile = tiles_[index];
+
+    // The depth test is order-independent, so the bins of each thread can be processed in turn
+    for (unsigned i = 0; i < binData_.Size(); ++i)
     {
-        float height = (bottom.y_ - top.y_);
-        float slope = (height != 0.0f) ? (bottom.x_ - top.x_) / height : 0.0f;
-        float yPreStep = (float)(topY + 1) - top.y_;
-        float xPreStep = slope * yPreStep;
-
-        x_ = (int)((xPreStep + top.x_) * OCCLUSION_X_SCALE + 0.5f);
-        xStep_ = (int)(slope * OCCLUSION_X_SCALE + 0.5f);
-        invZ_ = (int)(top.z_ + xPreStep * gradients.dInvZdX_ + yPreStep * gradients.dInvZdY_ + 0.5f);
-        invZStep_ = (int)(slope * gradients.dInvZdX_ + gradients.dInvZdY_ + 0.5f);
+        OcclusionBinData& binData = binData_[i];
+        PODVector<unsigned>& bin = binData.bins_[index];
+
+        for (unsigned j = 0; j < bin.Size(); ++j)
+            RasterizeTriangle(binData.triangles_[bin[j]], tile);
+
+        bin.Clear();
     }
+}
 
-    /// X coordinate.
-    int x_;
-    /// X coordinate step.
-    int xStep_;
-    /// Inverse Z.
-    int invZ_;
-    /// Inverse Z step.
-    int invZStep_;
-};
-
-void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, unsigned threadIndex)
+void OcclusionBuffer::RasterizeTriangle(const OcclusionTriangle& triangle, const IntRect& tile)
 {
-    int top, middle, bottom;
-    bool middleIsRight;
+    int left = Max(triangle.rect_.left_, tile.left_);
+    int top = Max(triangle.rect_.top_, tile.top_);
+    int right = Min(triangle.rect_.right_, tile.right_);
+    int bottom = Min(triangle.rect_.bottom_, tile.bottom_);
 
-    // Sort vertices in Y-direction
-    if (vertices[0].y_ < vertices[1].y_)
-    {
-        if (vertices[2].y_ < vertices[0].y_)
-        {
-            top = 2;
-            middle = 0;
-            bottom = 1;
-            middleIsRight = true;
-        }
-        else
-        {
-            top = 0;
-            if (vertices[1].y_ < vertices[2].y_)
-            {
-                middle = 1;
-                bottom = 2;
-                middleIsRight = true;
-            }
-            else
-            {
-                middle = 2;
-                bottom = 1;
-                middleIsRight = false;
-            }
-        }
-    }
-    else
+    // Horizontal edges only restrict the rows
+    for (unsigned i = 0; i < 3; ++i)
     {
-        if (vertices[2].y_ < vertices[1].y_)
-        {
-            top = 2;
-            middle = 1;
-            bottom = 0;
-            middleIsRight = false;
-        }
+        if (triangle.edgeX_[i] != 0.0f)
+            continue;
+
+        float edgeY = triangle.edgeY_[i];
+        float crossY = triangle.originY_ - triangle.edgeOffset_[i] / edgeY - 1.0f;
+        if (edgeY > 0.0f)
+            top = Max(top, (int)ceilf(Min(crossY, (float)bottom + 1.0f)));
         else
-        {
-            top = 1;
-            if (vertices[0].y_ < vertices[2].y_)
-            {
-                middle = 0;
-                bottom = 2;
-                middleIsRight = false;
-            }
-            else
-            {
-                middle = 2;
-                bottom = 0;
-                middleIsRight = true;
-            }
-        }
+            bottom = Min(bottom, (int)floorf(Max(crossY, (float)top - 1.0f)));
     }
 
-    int topY = (int)vertices[top].y_;
-    int middleY = (int)vertices[middle].y_;
-    int bottomY = (int)vertices[bottom].y_;
-
-    // Check for degenerate triangle
-    if (topY == bottomY)
+    if (left > right || top > bottom)
         return;
 
-    // Reverse middleIsRight test if triangle is counterclockwise
-    if (!clockwise)
-        middleIsRight = !middleIsRight;
-
-    Gradients gradients(vertices);
-    Edge topToMiddle(gradients, vertices[top], vertices[middle], topY);
-    Edge topToBottom(gradients, vertices[top], vertices[bottom], topY);
-    Edge middleToBottom(gradients, vertices[middle], vertices[bottom], middleY);
-
-    int* bufferData = buffers_[threadIndex].data_;
-
-    if (middleIsRight)
+    // Solve where the other edges cross the first row at the pixel centers, and how much the crossings move per row. Edges
+    // with a positive X coefficient bound the row span from the left, negative from the right
+    float dy = (float)(top + 1) - triangle.originY_;
+    float spanMins[3];
+    float spanMaxs[3];
+    float spanMinSteps[3];
+    float spanMaxSteps[3];
+    for (unsigned i = 0; i < 3; ++i)
     {
-        // Top half
-        int* row = bufferData + topY * width_;
-        int* endRow = bufferData + middleY * width_;
-        while (row < endRow)
-        {
-            int invZ = topToBottom.invZ_;
-            int* dest = row + (topToBottom.x_ >> 16);
-            int* end = row + (topToMiddle.x_ >> 16);
-            while (dest < end)
-            {
-                if (invZ < *dest)
-                    *dest = invZ;
-                invZ += gradients.dInvZdXInt_;
-                ++dest;
-            }
-
-            topToBottom.x_ += topToBottom.xStep_;
-            topToBottom.invZ_ += topToBottom.invZStep_;
-            topToMiddle.x_ += topToMiddle.xStep_;
-            row += width_;
-        }
-
-        // Bottom half
-        row = bufferData + middleY * width_;
-        endRow = bufferData + bottomY * width_;
-        while (row < endRow)
+        float edgeX = triangle.edgeX_[i];
+        float cross = 0.0f;
+        float crossStep = 0.0f;
+        if (edgeX != 0.0f)
         {
-            int invZ = topToBottom.invZ_;
-            int* dest = row + (topToBottom.x_ >> 16);
-            int* end = row + (middleToBottom.x_ >> 16);
-            while (dest < end)
-            {
-                if (invZ < *dest)
-                    *dest = invZ;
-                invZ += gradients.dInvZdXInt_;
-                ++dest;
-            }
-
-            topToBottom.x_ += topToBottom.xStep_;
-            topToBottom.invZ_ += topToBottom.invZStep_;
-            middleToBottom.x_ += middleToBottom.xStep_;
-            row += width_;
+            cross = triangle.originX_ - 1.0f - (triangle.edgeOffset_[i] + triangle.edgeY_[i] * dy) / edgeX;
+            crossStep = -triangle.edgeY_[i] / edgeX;
         }
+        spanMins[i] = edgeX > 0.0f ? cross : (float)left;
+        spanMinSteps[i] = edgeX > 0.0f ? crossStep : 0.0f;
+        spanMaxs[i] = edgeX < 0.0f ? cross : (float)right;
+        spanMaxSteps[i] = edgeX < 0.0f ? crossStep : 0.0f;
     }
-    else
+
+    // Depth at the center of the first row's leftmost pixel
+    float depthLeft = triangle.originZ_ + triangle.depthX_ * ((float)(left + 1) - triangle.originX_) + triangle.depthY_ * dy +
+        0.5f;
+    int* row = buffer_.Get() + top * width_;
+
+#ifdef URHO3D_SSE
+    // Pixels past this are handled one at a time, which only happens when the tile width is not a multiple of 4
+    int groupRight = tile.right_ - 3;
+    __m128 depthOffsets = _mm_mul_ps(_mm_set1_ps(triangle.depthX_), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+    __m128 depthStep = _mm_set1_ps(triangle.depthX_ * 4.0f);
+    __m128i pixelOffsets = _mm_set_epi32(3, 2, 1, 0);
+    __m128i pixelStep = _mm_set1_epi32(4);
+#endif
+
+    for (int y = top; y <= bottom; ++y)
     {
-        // Top half
-        int* row = bufferData + topY * width_;
-        int* endRow = bufferData + middleY * width_;
-        while (row < endRow)
+        float spanMin = Max(Max(spanMins[0], spanMins[1]), spanMins[2]);
+        float spanMax = Min(Min(spanMaxs[0], spanMaxs[1]), spanMaxs[2]);
+        for (unsigned i = 0; i < 3; ++i)
         {
-            int invZ = topToMiddle.invZ_;
-            int* dest = row + (topToMiddle.x_ >> 16);
-            int* end = row + (topToBottom.x_ >> 16);
-            while (dest < end)
-            {
-                if (invZ < *dest)
-                    *dest = invZ;
-                invZ += gradients.dInvZdXInt_;
-                ++dest;
-            }
-
-            topToMiddle.x_ += topToMiddle.xStep_;
-            topToMiddle.invZ_ += topToMiddle.invZStep_;
-            topToBottom.x_ += topToBottom.xStep_;
-            row += width_;
+            spanMins[i] += spanMinSteps[i];
+            spanMaxs[i] += spanMaxSteps[i];
         }
 
-        // Bottom half
-        row = bufferData + middleY * width_;
-        endRow = bufferData + bottomY * width_;
-        while (row < endRow)
+        // Clamp before the integer conversion, as the crossings of nearly horizontal edges can be very far away. The values
+        // are then non-negative after adding one, so truncation can be used for rounding
+        int spanLeft = (int)(Clamp(spanMin, (float)left, (float)right + 1.0f) + 1.0f);
+        spanLeft -= (float)(spanLeft - 1) >= spanMin;
+        int spanRight = (int)(Clamp(spanMax, (float)left - 1.0f, (float)right) + 1.0f) - 1;
+        int x = spanLeft;
+
+#ifdef URHO3D_SSE
+        if (spanLeft <= spanRight)
         {
-            int invZ = middleToBottom.invZ_;
-            int* dest = row + (middleToBottom.x_ >> 16);
-            int* end = row + (topToBottom.x_ >> 16);
-            while (dest < end)
+            // Start from the group of 4 pixels containing the first pixel, and mask the pixels outside the span
+            x = tile.left_ + ((spanLeft - tile.left_) & ~3);
+            __m128 depth4 = _mm_add_ps(_mm_set1_ps(depthLeft + triangle.depthX_ * (float)(x - left)), depthOffsets);
+            __m128i pixels = _mm_add_epi32(_mm_set1_epi32(x), pixelOffsets);
+            __m128i first = _mm_set1_epi32(spanLeft - 1);
+            __m128i last = _mm_set1_epi32(spanRight + 1);
+            int groupEnd = Min(spanRight, groupRight);
+
+            for (; x <= groupEnd; x += 4)
             {
-                if (invZ < *dest)
-                    *dest = invZ;
-                invZ += gradients.dInvZdXInt_;
-                ++dest;
+                __m128i z = _mm_cvttps_epi32(depth4);
+                __m128i dest = _mm_loadu_si128((__m128i*)(row + x));
+                __m128i inside = _mm_and_si128(_mm_cmpgt_epi32(pixels, first), _mm_cmplt_epi32(pixels, last));
+                __m128i closer = _mm_and_si128(inside, _mm_cmplt_epi32(z, dest));
+                _mm_storeu_si128((__m128i*)(row + x), _mm_or_si128(_mm_and_si128(closer, z), _mm_andnot_si128(closer, dest)));
+
+                depth4 = _mm_add_ps(depth4, depthStep);
+                pixels = _mm_add_epi32(pixels, pixelStep);
             }
 
-            middleToBottom.x_ += middleToBottom.xStep_;
-            middleToBottom.invZ_ += middleToBottom.invZStep_;
-            topToBottom.x_ += topToBottom.xStep_;
-            row += width_;
+            x = Max(x, spanLeft);
         }
-    }
-}
-
-void OcclusionBuffer::MergeBuffers()
-{
-    URHO3D_PROFILE(MergeBuffers);
+#endif
 
-    for (unsigned i = 1; i < buffers_.Size(); ++i)
-    {
-        if (!buffers_[i].used_)
-            continue;
-
-        int* src = buffers_[i].data_;
-        int* dest = buffers_[0].data_;
-        int count = width_ * height_;
-
-        while (count--)
+        float depth = depthLeft + triangle.depthX_ * (float)(x - left);
+        for (; x <= spanRight; ++x)
         {
-            // If thread buffer's depth value is closer, overwrite the original
-            if (*src < *dest)
-                *dest = *src;
-            ++src;
-            ++dest;
+            int z = (int)depth;
+            if (z < row[x])
+                row[x] = z;
+            depth += triangle.depthX_;
         }
-    }
-}
-
-void OcclusionBuffer::ClearBuffer(unsigned threadIndex)
-{
-    if (threadIndex >= buffers_.Size())
-        return;
-
-    int* dest = buffers_[threadIndex].data_;
-    int count = width_ * height_;
-    int fillValue = (int)OCCLUSION_Z_SCALE;
 
-    while (count--)
-        *dest++ = fillValue;
+        depthLeft += triangle.depthY_;
+        row += width_;
+    }
 }
 
 }
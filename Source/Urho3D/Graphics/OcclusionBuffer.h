@@ -27,6 +27,7 @@
 #include "../Container/ArrayPtr.h"
 #include "../Graphics/GraphicsDefs.h"
 #include "../Math/Frustum.h"
+#include "../Math/Rect.h"
 
 namespace Urho3D
 {
@@ -34,10 +35,8 @@ namespace Urho3D
 class BoundingBox;
 class Camera;
 class IndexBuffer;
-class IntRect;
 class VertexBuffer;
-struct Edge;
-struct Gradients;
+struct WorkItem;
 
 /// Occlusion hierarchy depth value.
 struct DepthValue
@@ -48,15 +47,36 @@ struct DepthValue
     int max_;
 };
 
-/// Per-thread occlusion buffer data.
-struct OcclusionBufferData
+/// Screen-space triangle set up for edge function rasterization.
+struct OcclusionTriangle
 {
-    /// Full buffer data with safety padding.
-    SharedArrayPtr<int> dataWithSafety_;
-    /// Buffer data.
-    int* data_;
-    /// Use flag.
-    bool used_;
+    /// Edge function X coefficients. The edge functions are non-negative inside the triangle.
+    float edgeX_[3];
+    /// Edge function Y coefficients.
+    float edgeY_[3];
+    /// Edge function values at the origin.
+    float edgeOffset_[3];
+    /// Origin (first vertex) X coordinate.
+    float originX_;
+    /// Origin Y coordinate.
+    float originY_;
+    /// Depth at the origin.
+    float originZ_;
+    /// Depth X gradient.
+    float depthX_;
+    /// Depth Y gradient.
+    float depthY_;
+    /// Bounding rectangle in pixels, inclusive.
+    IntRect rect_;
+};
+
+/// Per-thread triangles and their screen tile bins.
+struct OcclusionBinData
+{
+    /// Set up triangles.
+    PODVector<OcclusionTriangle> triangles_;
+    /// Triangle indices per screen tile.
+    Vector<PODVector<unsigned> > bins_;
 };
 
 /// Stored occlusion render job.
@@ -90,13 +110,15 @@ class URHO3D_API OcclusionBuffer : public Object
 {
     URHO3D_OBJECT(OcclusionBuffer, Object);
 
+    friend void RasterizeOcclusionTilesWork(const WorkItem* item, unsigned threadIndex);
+
 public:
     /// Construct.
     OcclusionBuffer(Context* context);
     /// Destruct.
     virtual ~OcclusionBuffer();
 
-    /// Set occlusion buffer size and whether to reserve multiple buffers for threading optimization.
+    /// Set occlusion buffer size and whether to use worker threads for triangle setup and tile rasterization.
     bool SetSize(int width, int height, bool threaded);
     /// Set camera view to render from.
     void SetView(Camera* camera);
@@ -121,7 +143,7 @@ public:
     void ResetUseTimer();
 
     /// Return highest level depth values.
-    int* GetBuffer() const { return buffers_.Size() ? buffers_[0].data_ : (int*)0; }
+    int* GetBuffer() const { return buffer_.Get(); }
 
     /// Return view transform matrix.
     const Matrix3x4& GetView() const { return view_; }
@@ -145,15 +167,19 @@ public:
     CullMode GetCullMode() const { return cullMode_; }
 
     /// Return whether is using threads to speed up rendering.
-    bool IsThreaded() const { return buffers_.Size() > 1; }
+    bool IsThreaded() const { return threaded_; }
 
     /// Test a bounding box for visibility. For best performance, build depth hierarchy first.
     bool IsVisible(const BoundingBox& worldSpaceBox) const;
+    /// Test the bounding boxes of a block for visibility. Return a bit mask of the visible boxes, the lowest bit being the first box.
+    unsigned IsVisibleMask(const BoundingBoxBlock& worldSpaceBoxes) const;
     /// Return time since last use in milliseconds.
     unsigned GetUseTimer();
 
-    /// Draw a batch. Called internally.
+    /// Transform, clip and bin the triangles of a batch. Called internally.
     void DrawBatch(const OcclusionBatch& batch, unsigned threadIndex);
+    /// Rasterize the binned triangles of a screen tile. Called internally.
+    void RasterizeTile(unsigned index);
 
 private:
     /// Apply modelview transform to vertex.
@@ -166,19 +192,23 @@ private:
     inline float SignedArea(const Vector3& v0, const Vector3& v1, const Vector3& v2) const;
     /// Calculate viewport transform.
     void CalculateViewport();
+    /// Test a projected screen space rectangle with its minimum depth for visibility.
+    bool IsScreenRectVisible(float minX, float minY, float maxX, float maxY, float minZ) const;
     /// Draw a triangle.
     void DrawTriangle(Vector4* vertices, unsigned threadIndex);
     /// Clip vertices against a plane.
     void ClipVertices(const Vector4& plane, Vector4* vertices, bool* triangles, unsigned& numTriangles);
-    /// Draw a clipped triangle.
-    void DrawTriangle2D(const Vector3* vertices, bool clockwise, unsigned threadIndex);
-    /// Clear a thread work buffer.
-    void ClearBuffer(unsigned threadIndex);
-    /// Merge thread work buffers into the first buffer.
-    void MergeBuffers();
-
-    /// Highest-level buffer data per thread.
-    Vector<OcclusionBufferData> buffers_;
+    /// Set up a clipped triangle and add it to the bins of the screen tiles it overlaps.
+    void BinTriangle(const Vector3* vertices, unsigned threadIndex);
+    /// Rasterize a triangle within a screen tile.
+    void RasterizeTriangle(const OcclusionTriangle& triangle, const IntRect& tile);
+
+    /// Highest-level buffer data.
+    SharedArrayPtr<int> buffer_;
+    /// Triangles and tile bins per thread.
+    Vector<OcclusionBinData> binData_;
+    /// Screen tile rectangles in pixels, inclusive.
+    PODVector<IntRect> tiles_;
     /// Reduced size depth buffers.
     Vector<SharedArrayPtr<DepthValue> > mipBuffers_;
     /// Submitted render jobs.
@@ -187,6 +217,8 @@ private:
     int width_;
     /// Buffer height.
     int height_;
+    /// Number of screen tiles horizontally.
+    int tilesX_;
     /// Number of rendered triangles.
     unsigned numTriangles_;
     /// Maximum number of triangles.
@@ -197,6 +229,8 @@ private:
     bool depthHierarchyDirty_;
     /// Culling reverse flag.
     bool reverseCulling_;
+    /// Threaded rendering flag.
+    bool threaded_;
     /// View transform matrix.
     Matrix3x4 view_;
     /// Projection matrix.
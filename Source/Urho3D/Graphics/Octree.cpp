@@ -45,6 +45,15 @@ namespace Urho3D
 
 static const float DEFAULT_OCTREE_SIZE = 1000.0f;
 static const int DEFAULT_OCTREE_LEVELS = 8;
+static const unsigned BVH_QUERY_BATCH_SIZE = 64;
+static const unsigned REINSERTION_CHUNK_SIZE = 64;
+
+static const char* spatialIndexNames[] =
+{
+    "Octants",
+    "BVH",
+    0
+};
 
 extern const char* SUBSYSTEM_CATEGORY;
 
@@ -63,11 +72,121 @@ void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex)
     }
 }
 
+void ReinsertDrawablesWork(const WorkItem* item, unsigned threadIndex)
+{
+    Octree* octree = reinterpret_cast<Octree*>(item->aux_);
+    Drawable** start = reinterpret_cast<Drawable**>(item->start_);
+    Drawable** end = reinterpret_cast<Drawable**>(item->end_);
+    PODVector<Drawable*>& reinsertions = octree->drawableReinsertions_[threadIndex];
+
+    while (start != end)
+    {
+        Drawable* drawable = *start++;
+        drawable->updateQueued_ = false;
+        Octant* octant = drawable->GetOctant();
+
+        // Skip if no octant or does not belong to this octree anymore
+        if (!octant || octant->GetRoot() != octree)
+            continue;
+
+        if (!octree->RefitDrawable(drawable))
+            reinsertions.Push(drawable);
+    }
+}
+
 inline bool CompareRayQueryResults(const RayQueryResult& lhs, const RayQueryResult& rhs)
 {
     return lhs.distance_ < rhs.distance_;
 }
 
+/// Drawable objects found from the bounding volume hierarchy, passed to the query in batches separately for the inside and intersecting cases.
+struct BvhQueryBatch
+{
+    /// Construct.
+    BvhQueryBatch(OctreeQuery& query) :
+        query_(query)
+    {
+        numDrawables_[0] = numDrawables_[1] = 0;
+    }
+
+    /// Add a drawable object, and test the batch if it becomes full.
+    void Add(Drawable* drawable, bool inside)
+    {
+        unsigned batch = inside ? 1 : 0;
+        drawables_[batch][numDrawables_[batch]++] = drawable;
+        if (numDrawables_[batch] == BVH_QUERY_BATCH_SIZE)
+            Flush(batch);
+    }
+
+    /// Test the drawable objects of a batch.
+    void Flush(unsigned batch)
+    {
+        if (numDrawables_[batch])
+        {
+            query_.TestDrawables(&drawables_[batch][0], &drawables_[batch][0] + numDrawables_[batch], batch != 0);
+            numDrawables_[batch] = 0;
+        }
+    }
+
+    /// Query.
+    OctreeQuery& query_;
+    /// Drawable objects in the intersecting and inside batches.
+    Drawable* drawables_[2][BVH_QUERY_BATCH_SIZE];
+    /// Number of drawable objects in each batch.
+    unsigned numDrawables_[2];
+};
+
+static void GetBvhDrawables(const DrawableBvh& bvh, unsigned index, BvhQueryBatch& batch, bool inside)
+{
+    const BvhNode& node = bvh.GetNode(index);
+
+    // The query tests the drawable's own bounding box, so leaves need no test against the enlarged box
+    if (node.IsLeaf())
+    {
+        batch.Add(node.drawable_, inside);
+        return;
+    }
+
+    Intersection res = batch.query_.TestOctant(node.box_, inside);
+    if (res == INSIDE)
+        inside = true;
+    else if (res == OUTSIDE)
+        return;
+
+    GetBvhDrawables(bvh, node.children_[0], batch, inside);
+    GetBvhDrawables(bvh, node.children_[1], batch, inside);
+}
+
+static void GetBvhDrawables(const DrawableBvh& bvh, unsigned index, RayOctreeQuery& query, PODVector<Drawable*>& drawables)
+{
+    const BvhNode& node = bvh.GetNode(index);
+    if (query.ray_.HitDistance(node.box_) >= query.maxDistance_)
+        return;
+
+    if (node.IsLeaf())
+    {
+        Drawable* drawable = node.drawable_;
+        if ((drawable->GetDrawableFlags() & query.drawableFlags_) && (drawable->GetViewMask() & query.viewMask_))
+            drawables.Push(drawable);
+    }
+    else
+    {
+        GetBvhDrawables(bvh, node.children_[0], query, drawables);
+        GetBvhDrawables(bvh, node.children_[1], query, drawables);
+    }
+}
+
+static void DrawBvhDebugGeometry(const DrawableBvh& bvh, unsigned index, DebugRenderer* debug, bool depthTest)
+{
+    const BvhNode& node = bvh.GetNode(index);
+    if (node.IsLeaf() || !debug->IsInside(node.box_))
+        return;
+
+    debug->AddBoundingBox(node.box_, Color(0.25f, 0.25f, 0.25f), depthTest);
+    DrawBvhDebugGeometry(bvh, node.children_[0], debug, depthTest);
+    DrawBvhDebugGeometry(bvh, node.children_[1], debug, depthTest);
+}
+
 Octant::Octant(const BoundingBox& box, unsigned level, Octant* parent, Octree* root, unsigned index) :
     level_(level),
     numDrawables_(0),
@@ -88,11 +207,12 @@ Octant::~Octant()
         // Remove the drawables (if any) from this octant to the root octant
         for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
         {
-            (*i)->SetOctant(root_);
-            root_->drawables_.Push(*i);
-            root_->QueueUpdate(*i);
+            root_->PushDrawable(*i);
+            if (!(*i)->updateQueued_)
+                root_->QueueUpdate(*i);
         }
         drawables_.Clear();
+        drawableBounds_.Clear();
         numDrawables_ = 0;
     }
 
@@ -140,10 +260,14 @@ void Octant::InsertDrawable(Drawable* drawable)
     const BoundingBox& box = drawable->GetWorldBoundingBox();
 
     // If root octant, insert all non-occludees here, so that octant occlusion does not hide the drawable.
-    // Also if drawable is outside the root octant bounds, insert to root
+    // Also if drawable is outside the root octant bounds, insert to root. When the octree uses a bounding volume
+    // hierarchy, the root stores occludees in it
     bool insertHere;
     if (this == root_)
-        insertHere = !drawable->IsOccludee() || cullingBox_.IsInside(box) != INSIDE || CheckDrawableFit(box);
+    {
+        insertHere = root_->GetSpatialIndex() == SI_BVH || !drawable->IsOccludee() || cullingBox_.IsInside(box) != INSIDE ||
+            CheckDrawableFit(box);
+    }
     else
         insertHere = CheckDrawableFit(box);
 
@@ -153,9 +277,10 @@ void Octant::InsertDrawable(Drawable* drawable)
         if (oldOctant != this)
         {
             // Add first, then remove, because drawable count going to zero deletes the octree branch in question
+            unsigned oldIndex = drawable->octantIndex_;
             AddDrawable(drawable);
-            if (oldOctant)
-                oldOctant->RemoveDrawable(drawable, false);
+            if (oldOctant && oldOctant->EraseDrawable(drawable, oldIndex))
+                oldOctant->DecDrawableCount();
         }
     }
     else
@@ -193,6 +318,40 @@ bool Octant::CheckDrawableFit(const BoundingBox& box) const
     return false;
 }
 
+void Octant::PushDrawable(Drawable* drawable)
+{
+    unsigned index = drawables_.Size();
+    drawable->SetOctant(this);
+    drawable->octantIndex_ = index;
+    drawables_.Push(drawable);
+
+    if (index % BOUNDING_BOX_BLOCK_SIZE == 0)
+        drawableBounds_.Resize(drawableBounds_.Size() + 1);
+    drawableBounds_.Back().Set(index % BOUNDING_BOX_BLOCK_SIZE, drawable->GetWorldBoundingBox());
+}
+
+bool Octant::EraseDrawable(Drawable* drawable, unsigned index)
+{
+    if (index >= drawables_.Size() || drawables_[index] != drawable)
+        return false;
+
+    unsigned last = drawables_.Size() - 1;
+    if (index != last)
+    {
+        Drawable* moved = drawables_[last];
+        drawables_[index] = moved;
+        moved->octantIndex_ = index;
+        drawableBounds_[index / BOUNDING_BOX_BLOCK_SIZE].Copy(index % BOUNDING_BOX_BLOCK_SIZE,
+            drawableBounds_[last / BOUNDING_BOX_BLOCK_SIZE], last % BOUNDING_BOX_BLOCK_SIZE);
+    }
+
+    drawables_.Pop();
+    if (last % BOUNDING_BOX_BLOCK_SIZE == 0)
+        drawableBounds_.Pop();
+
+    return true;
+}
+
 void Octant::ResetRoot()
 {
     root_ = 0;
@@ -248,7 +407,9 @@ void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
     {
         Drawable** start = const_cast<Drawable**>(&drawables_[0]);
         Drawable** end = start + drawables_.Size();
+        query.drawableBounds_ = &drawableBounds_[0];
         query.TestDrawables(start, end, inside);
+        query.drawableBounds_ = 0;
     }
 
     for (unsigned i = 0; i < NUM_OCTANTS; ++i)
@@ -315,8 +476,11 @@ void Octant::GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*
 Octree::Octree(Context* context) :
     Component(context),
     Octant(BoundingBox(-DEFAULT_OCTREE_SIZE, DEFAULT_OCTREE_SIZE), 0, 0, this),
-    numLevels_(DEFAULT_OCTREE_LEVELS)
+    numLevels_(DEFAULT_OCTREE_LEVELS),
+    spatialIndex_(SI_OCTANTS)
 {
+    SDL_AtomicSet(&numThreadedDrawableUpdates_, 0);
+
     // If the engine is running headless, subscribe to RenderUpdate events for manually updating the octree
     // to allow raycasts and animation update
     if (!GetSubsystem<Graphics>())
@@ -329,6 +493,11 @@ Octree::~Octree()
     drawableUpdates_.Clear();
     drawableReinsertions_.Clear();
     ResetRoot();
+
+    PODVector<Drawable*> bvhDrawables;
+    ClearBvh(bvhDrawables);
+    for (PODVector<Drawable*>::Iterator i = bvhDrawables.Begin(); i != bvhDrawables.End(); ++i)
+        (*i)->SetOctant(0);
 }
 
 void Octree::RegisterObject(Context* context)
@@ -341,6 +510,8 @@ void Octree::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Bounding Box Min", Vector3, worldBoundingBox_.min_, defaultBoundsMin, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Bounding Box Max", Vector3, worldBoundingBox_.max_, defaultBoundsMax, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Number of Levels", int, numLevels_, DEFAULT_OCTREE_LEVELS, AM_DEFAULT);
+    URHO3D_ENUM_ACCESSOR_ATTRIBUTE("Spatial Index", GetSpatialIndex, SetSpatialIndex, SpatialIndex, spatialIndexNames, SI_OCTANTS,
+        AM_DEFAULT);
 }
 
 void Octree::OnSetAttribute(const AttributeInfo& attr, const Variant& src)
@@ -357,6 +528,8 @@ void Octree::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
         URHO3D_PROFILE(OctreeDrawDebug);
 
         Octant::DrawDebugGeometry(debug, depthTest);
+        if (bvh_.GetRoot() != BVH_NULL_NODE)
+            DrawBvhDebugGeometry(bvh_, bvh_.GetRoot(), debug, depthTest);
     }
 }
 
@@ -369,10 +542,40 @@ void Octree::SetSize(const BoundingBox& box, unsigned numLevels)
         DeleteChild(i);
 
     Initialize(box);
-    numDrawables_ = drawables_.Size();
+    numDrawables_ = drawables_.Size() + bvh_.GetNumLeaves();
     numLevels_ = (unsigned)Max((int)numLevels, 1);
 }
 
+void Octree::SetSpatialIndex(SpatialIndex index)
+{
+    if (index == spatialIndex_)
+        return;
+
+    URHO3D_PROFILE(ChangeSpatialIndex);
+
+    // Collect all drawables to the root octant, then take them out and push them again to the new index. The drawable
+    // count does not change
+    for (unsigned i = 0; i < NUM_OCTANTS; ++i)
+        DeleteChild(i);
+
+    PODVector<Drawable*> drawables;
+    ClearBvh(drawables);
+    drawables.Push(drawables_);
+    drawables_.Clear();
+    drawableBounds_.Clear();
+
+    spatialIndex_ = index;
+
+    for (PODVector<Drawable*>::Iterator i = drawables.Begin(); i != drawables.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        PushDrawable(drawable);
+        // Octants need reinsertion to move the drawables from the root to their proper octants
+        if (spatialIndex_ == SI_OCTANTS && !drawable->updateQueued_)
+            QueueUpdate(drawable);
+    }
+}
+
 void Octree::Update(const FrameInfo& frame)
 {
     // Let drawables update themselves before reinsertion. This can be used for animation
@@ -384,33 +587,18 @@ void Octree::Update(const FrameInfo& frame)
         // (for example physics objects) should not perform non-threadsafe work when marked dirty
         Scene* scene = GetScene();
         WorkQueue* queue = GetSubsystem<WorkQueue>();
-        scene->BeginThreadedUpdate();
-
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = Max((int)(drawableUpdates_.Size() / numWorkItems), 1);
 
-        PODVector<Drawable*>::Iterator start = drawableUpdates_.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = UpdateDrawablesWork;
-            item->aux_ = const_cast<FrameInfo*>(&frame);
-
-            PODVector<Drawable*>::Iterator end = drawableUpdates_.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
+        // Drawables marked dirty by the updates claim these slots. The update list itself must not grow while the
+        // worker threads are reading it
+        if (threadedDrawableUpdates_.Size() < drawableUpdates_.Size())
+            threadedDrawableUpdates_.Resize(drawableUpdates_.Size());
+        SDL_AtomicSet(&numThreadedDrawableUpdates_, 0);
 
-        queue->Complete(M_MAX_UNSIGNED);
+        scene->BeginThreadedUpdate();
+        queue->ParallelFor(UpdateDrawablesWork, drawableUpdates_, const_cast<FrameInfo*>(&frame));
         scene->EndThreadedUpdate();
+
+        MergeThreadedUpdates();
     }
 
     // Notify drawable update being finished. Custom animation (eg. IK) can be done at this point
@@ -431,31 +619,41 @@ void Octree::Update(const FrameInfo& frame)
     {
         URHO3D_PROFILE(ReinsertToOctree);
 
-        for (PODVector<Drawable*>::Iterator i = drawableUpdates_.Begin(); i != drawableUpdates_.End(); ++i)
+        // Check in worker threads which drawables still fit their octant or hierarchy leaf, which is the common case for
+        // small movements. The rest are collected per thread and moved in the main thread
+        WorkQueue* queue = GetSubsystem<WorkQueue>();
+        drawableReinsertions_.Resize(queue->GetNumThreads() + 1);
+        queue->ParallelFor(ReinsertDrawablesWork, drawableUpdates_, this, REINSERTION_CHUNK_SIZE);
+
+        for (Vector<PODVector<Drawable*> >::Iterator i = drawableReinsertions_.Begin(); i != drawableReinsertions_.End(); ++i)
         {
-            Drawable* drawable = *i;
-            drawable->updateQueued_ = false;
-            Octant* octant = drawable->GetOctant();
-            const BoundingBox& box = drawable->GetWorldBoundingBox();
+            for (PODVector<Drawable*>::Iterator j = i->Begin(); j != i->End(); ++j)
+            {
+                Drawable* drawable = *j;
 
-            // Skip if no octant or does not belong to this octree anymore
-            if (!octant || octant->GetRoot() != this)
-                continue;
-            // Skip if still fits the current octant
-            if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
-                continue;
+                // With the bounding volume hierarchy all drawables stay in the root, only the hierarchy needs updating
+                if (spatialIndex_ == SI_BVH)
+                {
+                    UpdateBvhDrawable(drawable);
+                    continue;
+                }
 
-            InsertDrawable(drawable);
+                InsertDrawable(drawable);
+                drawable->GetOctant()->UpdateDrawableBounds(drawable);
 
 #ifdef _DEBUG
-            // Verify that the drawable will be culled correctly
-            octant = drawable->GetOctant();
-            if (octant != this && octant->GetCullingBox().IsInside(box) != INSIDE)
-            {
-                URHO3D_LOGERROR("Drawable is not fully inside its octant's culling bounds: drawable box " + box.ToString() +
-                         " octant box " + octant->GetCullingBox().ToString());
-            }
+                // Verify that the drawable will be culled correctly
+                const BoundingBox& box = drawable->GetWorldBoundingBox();
+                Octant* octant = drawable->GetOctant();
+                if (octant != this && octant->GetCullingBox().IsInside(box) != INSIDE)
+                {
+                    URHO3D_LOGERROR("Drawable is not fully inside its octant's culling bounds: drawable box " + box.ToString() +
+                             " octant box " + octant->GetCullingBox().ToString());
+                }
 #endif
+            }
+
+            i->Clear();
         }
     }
 
@@ -484,6 +682,14 @@ void Octree::GetDrawables(OctreeQuery& query) const
 {
     query.result_.Clear();
     GetDrawablesInternal(query, false);
+
+    if (bvh_.GetRoot() != BVH_NULL_NODE)
+    {
+        BvhQueryBatch batch(query);
+        GetBvhDrawables(bvh_, bvh_.GetRoot(), batch, false);
+        batch.Flush(0);
+        batch.Flush(1);
+    }
 }
 
 void Octree::Raycast(RayOctreeQuery& query) const
@@ -492,6 +698,15 @@ void Octree::Raycast(RayOctreeQuery& query) const
 
     query.result_.Clear();
     GetDrawablesInternal(query);
+
+    if (bvh_.GetRoot() != BVH_NULL_NODE)
+    {
+        rayQueryDrawables_.Clear();
+        GetBvhDrawables(bvh_, bvh_.GetRoot(), query, rayQueryDrawables_);
+        for (PODVector<Drawable*>::Iterator i = rayQueryDrawables_.Begin(); i != rayQueryDrawables_.End(); ++i)
+            (*i)->ProcessRayQuery(query, query.result_);
+    }
+
     Sort(query.result_.Begin(), query.result_.End(), CompareRayQueryResults);
 }
 
@@ -502,6 +717,8 @@ void Octree::RaycastSingle(RayOctreeQuery& query) const
     query.result_.Clear();
     rayQueryDrawables_.Clear();
     GetDrawablesOnlyInternal(query, rayQueryDrawables_);
+    if (bvh_.GetRoot() != BVH_NULL_NODE)
+        GetBvhDrawables(bvh_, bvh_.GetRoot(), query, rayQueryDrawables_);
 
     // Sort by increasing hit distance to AABB
     for (PODVector<Drawable*>::Iterator i = rayQueryDrawables_.Begin(); i != rayQueryDrawables_.End(); ++i)
@@ -540,8 +757,15 @@ void Octree::QueueUpdate(Drawable* drawable)
     Scene* scene = GetScene();
     if (scene && scene->IsThreadedUpdate())
     {
-        MutexLock lock(octreeMutex_);
-        drawableUpdates_.Push(drawable);
+        // Claim a slot without locking. Only if the slots have run out, fall back to the mutex
+        unsigned index = (unsigned)SDL_AtomicAdd(&numThreadedDrawableUpdates_, 1);
+        if (index < threadedDrawableUpdates_.Size())
+            threadedDrawableUpdates_[index] = drawable;
+        else
+        {
+            MutexLock lock(octreeMutex_);
+            overflowDrawableUpdates_.Push(drawable);
+        }
     }
     else
         drawableUpdates_.Push(drawable);
@@ -561,6 +785,116 @@ void Octree::DrawDebugGeometry(bool depthTest)
     DrawDebugGeometry(debug, depthTest);
 }
 
+void Octree::PushDrawable(Drawable* drawable)
+{
+    if (spatialIndex_ == SI_BVH && drawable->IsOccludee())
+    {
+        drawable->SetOctant(this);
+        drawable->octantIndex_ = M_MAX_UNSIGNED;
+        drawable->bvhLeaf_ = bvh_.Insert(drawable, drawable->GetWorldBoundingBox());
+    }
+    else
+        Octant::PushDrawable(drawable);
+}
+
+bool Octree::EraseDrawable(Drawable* drawable, unsigned index)
+{
+    unsigned leaf = drawable->bvhLeaf_;
+    if (leaf == BVH_NULL_NODE)
+        return Octant::EraseDrawable(drawable, index);
+
+    if (leaf >= bvh_.GetNodes().Size() || bvh_.GetNode(leaf).drawable_ != drawable)
+        return false;
+
+    bvh_.Remove(leaf);
+    drawable->bvhLeaf_ = BVH_NULL_NODE;
+    return true;
+}
+
+void Octree::UpdateBvhDrawable(Drawable* drawable)
+{
+    bool inBvh = drawable->bvhLeaf_ != BVH_NULL_NODE;
+    if (inBvh != drawable->IsOccludee())
+    {
+        // Non-occludees are kept out of the hierarchy, so that node occlusion does not hide them
+        EraseDrawable(drawable, drawable->octantIndex_);
+        PushDrawable(drawable);
+    }
+    else if (inBvh)
+        bvh_.Move(drawable->bvhLeaf_, drawable->GetWorldBoundingBox());
+    else
+        UpdateDrawableBounds(drawable);
+}
+
+bool Octree::RefitDrawable(Drawable* drawable)
+{
+    Octant* octant = drawable->GetOctant();
+    const BoundingBox& box = drawable->GetWorldBoundingBox();
+
+    if (spatialIndex_ == SI_BVH)
+    {
+        // Hierarchy leaves can not be changed from worker threads, but usually the enlarged leaf box still fits
+        unsigned leaf = drawable->bvhLeaf_;
+        if (leaf != BVH_NULL_NODE)
+            return drawable->IsOccludee() && bvh_.GetNode(leaf).box_.IsInside(box) == INSIDE;
+        else if (drawable->IsOccludee())
+            return false;
+    }
+    else if (!drawable->IsOccludee() || octant->GetCullingBox().IsInside(box) != INSIDE || !octant->CheckDrawableFit(box))
+        return false;
+
+    octant->UpdateDrawableBounds(drawable);
+    return true;
+}
+
+void Octree::MergeThreadedUpdates()
+{
+    unsigned numQueued = (unsigned)SDL_AtomicGet(&numThreadedDrawableUpdates_);
+    if (!numQueued)
+        return;
+
+    // Gather the overflow after the slots, growing the slots for the next frame
+    unsigned numSlots = threadedDrawableUpdates_.Size();
+    if (numQueued > numSlots)
+    {
+        threadedDrawableUpdates_.Resize(numQueued);
+        for (unsigned i = 0; i < overflowDrawableUpdates_.Size(); ++i)
+            threadedDrawableUpdates_[numSlots + i] = overflowDrawableUpdates_[i];
+        overflowDrawableUpdates_.Clear();
+    }
+
+    // Two threads may have queued the same drawable at the same time, so skip duplicates
+    PODVector<Drawable*>::Iterator begin = threadedDrawableUpdates_.Begin();
+    Sort(begin, begin + numQueued);
+    Drawable* last = 0;
+    for (PODVector<Drawable*>::Iterator i = begin; i != begin + numQueued; ++i)
+    {
+        if (*i != last)
+        {
+            drawableUpdates_.Push(*i);
+            last = *i;
+        }
+    }
+
+    SDL_AtomicSet(&numThreadedDrawableUpdates_, 0);
+}
+
+void Octree::ClearBvh(PODVector<Drawable*>& drawables)
+{
+    const PODVector<BvhNode>& nodes = bvh_.GetNodes();
+    for (PODVector<BvhNode>::ConstIterator i = nodes.Begin(); i != nodes.End(); ++i)
+    {
+        // Leaf nodes have zero height, unused nodes negative
+        if (!i->height_ && i->drawable_)
+        {
+            i->drawable_->bvhLeaf_ = BVH_NULL_NODE;
+            drawables.Push(i->drawable_);
+        }
+    }
+
+    bvh_.Clear();
+}
+
 void Octree::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
 {
     // When running in headless mode, update the Octree manually during the RenderUpdate event
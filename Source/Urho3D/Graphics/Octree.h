@@ -25,8 +25,11 @@
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
 #include "../Graphics/Drawable.h"
+#include "../Graphics/DrawableBvh.h"
 #include "../Graphics/OctreeQuery.h"
 
+#include <SDL/SDL_atomic.h>
+
 namespace Urho3D
 {
 
@@ -35,6 +38,13 @@ class Octree;
 static const int NUM_OCTANTS = 8;
 static const unsigned ROOT_INDEX = M_MAX_UNSIGNED;
 
+/// Spatial index used by the octree component for occludee drawables.
+enum SpatialIndex
+{
+    SI_OCTANTS = 0,
+    SI_BVH
+};
+
 /// %Octree octant
 class URHO3D_API Octant
 {
@@ -56,15 +66,14 @@ public:
     /// Add a drawable object to this octant.
     void AddDrawable(Drawable* drawable)
     {
-        drawable->SetOctant(this);
-        drawables_.Push(drawable);
+        PushDrawable(drawable);
         IncDrawableCount();
     }
 
     /// Remove a drawable object from this octant.
     void RemoveDrawable(Drawable* drawable, bool resetOctant = true)
     {
-        if (drawables_.Remove(drawable))
+        if (EraseDrawable(drawable, drawable->octantIndex_))
         {
             if (resetOctant)
                 drawable->SetOctant(0);
@@ -72,6 +81,17 @@ public:
         }
     }
 
+    /// Store the current world bounding box of a drawable object in this octant.
+    void UpdateDrawableBounds(Drawable* drawable)
+    {
+        unsigned index = drawable->octantIndex_;
+        if (index < drawables_.Size() && drawables_[index] == drawable)
+        {
+            drawableBounds_[index / BOUNDING_BOX_BLOCK_SIZE].Set(index % BOUNDING_BOX_BLOCK_SIZE,
+                drawable->GetWorldBoundingBox());
+        }
+    }
+
     /// Return world-space bounding box.
     const BoundingBox& GetWorldBoundingBox() const { return worldBoundingBox_; }
 
@@ -107,6 +127,10 @@ protected:
     void GetDrawablesInternal(RayOctreeQuery& query) const;
     /// Return drawable objects only for a threaded ray query, called internally.
     void GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*>& drawables) const;
+    /// Append a drawable object and its world bounding box without changing the drawable counts.
+    virtual void PushDrawable(Drawable* drawable);
+    /// Remove a drawable object at an index by moving the last drawable object in its place, without changing the drawable counts. Return true if the drawable was found at the index.
+    virtual bool EraseDrawable(Drawable* drawable, unsigned index);
 
     /// Increase drawable object count recursively.
     void IncDrawableCount()
@@ -138,6 +162,8 @@ protected:
     BoundingBox cullingBox_;
     /// Drawable objects.
     PODVector<Drawable*> drawables_;
+    /// World bounding boxes of the drawable objects in structure-of-arrays form, in the same order.
+    PODVector<BoundingBoxBlock> drawableBounds_;
     /// Child octants.
     Octant* children_[NUM_OCTANTS];
     /// World bounding box center.
@@ -159,7 +185,9 @@ protected:
 /// %Octree component. Should be added only to the root scene node
 class URHO3D_API Octree : public Component, public Octant
 {
+    friend class Octant;
     friend void RaycastDrawablesWork(const WorkItem* item, unsigned threadIndex);
+    friend void ReinsertDrawablesWork(const WorkItem* item, unsigned threadIndex);
 
     URHO3D_OBJECT(Octree, Component);
 
@@ -178,6 +206,8 @@ public:
 
     /// Set size and maximum subdivision levels. If octree is not empty, drawable objects will be temporarily moved to the root.
     void SetSize(const BoundingBox& box, unsigned numLevels);
+    /// Set spatial index for occludee drawables: octants, or a dynamic bounding volume hierarchy that has no size limits. Drawable objects are moved to the new index.
+    void SetSpatialIndex(SpatialIndex index);
     /// Update and reinsert drawable objects.
     void Update(const FrameInfo& frame);
     /// Add a drawable manually.
@@ -195,27 +225,57 @@ public:
     /// Return subdivision levels.
     unsigned GetNumLevels() const { return numLevels_; }
 
-    /// Mark drawable object as requiring an update and a reinsertion.
+    /// Return spatial index for occludee drawables.
+    SpatialIndex GetSpatialIndex() const { return spatialIndex_; }
+
+    /// Return the bounding volume hierarchy. Empty unless the spatial index is SI_BVH.
+    const DrawableBvh& GetBvh() const { return bvh_; }
+
+    /// Mark drawable object as requiring an update and a reinsertion. Can be called from worker threads during the threaded drawable update without locking.
     void QueueUpdate(Drawable* drawable);
     /// Cancel drawable object's update.
     void CancelUpdate(Drawable* drawable);
     /// Visualize the component as debug geometry.
     void DrawDebugGeometry(bool depthTest);
 
+protected:
+    /// Append a drawable object to the bounding volume hierarchy if in use and the drawable is an occludee, otherwise to the root octant.
+    virtual void PushDrawable(Drawable* drawable);
+    /// Remove a drawable object from the bounding volume hierarchy or the root octant. Return true if the drawable was found.
+    virtual bool EraseDrawable(Drawable* drawable, unsigned index);
+
 private:
     /// Handle render update in case of headless execution.
     void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    /// Update a drawable object's bounding box in the bounding volume hierarchy, or move it between the hierarchy and the root octant if its occludee flag has changed.
+    void UpdateBvhDrawable(Drawable* drawable);
+    /// Store the new bounding box of a drawable object if it still fits its current octant or hierarchy leaf. Return false if it needs reinsertion. Can be called from worker threads for different drawables.
+    bool RefitDrawable(Drawable* drawable);
+    /// Move the drawable objects queued from worker threads to the update list.
+    void MergeThreadedUpdates();
+    /// Remove all drawable objects from the bounding volume hierarchy and return them.
+    void ClearBvh(PODVector<Drawable*>& drawables);
 
     /// Drawable objects that require update.
     PODVector<Drawable*> drawableUpdates_;
-    /// Drawable objects that require reinsertion.
-    PODVector<Drawable*> drawableReinsertions_;
-    /// Mutex for octree reinsertions.
+    /// Drawable objects that require reinsertion, per thread.
+    Vector<PODVector<Drawable*> > drawableReinsertions_;
+    /// Slots for drawable objects queued for update from worker threads.
+    PODVector<Drawable*> threadedDrawableUpdates_;
+    /// Drawable objects queued for update from worker threads after the slots ran out.
+    PODVector<Drawable*> overflowDrawableUpdates_;
+    /// Number of drawable objects queued for update from worker threads, used to claim slots.
+    SDL_atomic_t numThreadedDrawableUpdates_;
+    /// Mutex for drawable objects queued after the slots ran out.
     Mutex octreeMutex_;
     /// Ray query temporary list of drawables.
     mutable PODVector<Drawable*> rayQueryDrawables_;
+    /// Bounding volume hierarchy for occludee drawables.
+    DrawableBvh bvh_;
     /// Subdivision level.
     unsigned numLevels_;
+    /// Spatial index for occludee drawables.
+    SpatialIndex spatialIndex_;
 };
 
 }
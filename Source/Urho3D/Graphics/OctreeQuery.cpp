@@ -105,13 +105,46 @@ Intersection FrustumOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 
 void FrustumOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool inside)
 {
-    while (start != end)
-    {
-        Drawable* drawable = *start++;
+    unsigned first = result_.Size();
+    PushInsideDrawables(start, end, inside);
 
+    // Then keep only the drawables with matching flags, so that culled drawables are never accessed
+    unsigned last = first;
+    for (unsigned i = first; i < result_.Size(); ++i)
+    {
+        Drawable* drawable = result_[i];
         if ((drawable->GetDrawableFlags() & drawableFlags_) && (drawable->GetViewMask() & viewMask_))
+            result_[last++] = drawable;
+    }
+    result_.Resize(last);
+}
+
+void FrustumOctreeQuery::PushInsideDrawables(Drawable** start, Drawable** end, bool inside)
+{
+    if (inside)
+    {
+        while (start != end)
+            result_.Push(*start++);
+    }
+    else if (drawableBounds_)
+    {
+        unsigned count = (unsigned)(end - start);
+        for (unsigned i = 0; i < count; i += BOUNDING_BOX_BLOCK_SIZE)
+        {
+            unsigned mask = frustum_.IsInsideFastMask(drawableBounds_[i / BOUNDING_BOX_BLOCK_SIZE]);
+            for (unsigned j = 0; j < BOUNDING_BOX_BLOCK_SIZE && i + j < count; ++j)
+            {
+                if (mask & (1 << j))
+                    result_.Push(start[i + j]);
+            }
+        }
+    }
+    else
+    {
+        while (start != end)
         {
-            if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
+            Drawable* drawable = *start++;
+            if (frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
                 result_.Push(drawable);
         }
     }
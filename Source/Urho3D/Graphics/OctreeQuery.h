@@ -42,7 +42,8 @@ public:
     OctreeQuery(PODVector<Drawable*>& result, unsigned char drawableFlags, unsigned viewMask) :
         result_(result),
         drawableFlags_(drawableFlags),
-        viewMask_(viewMask)
+        viewMask_(viewMask),
+        drawableBounds_(0)
     {
     }
 
@@ -62,6 +63,8 @@ public:
     unsigned char drawableFlags_;
     /// Drawable layers to include.
     unsigned viewMask_;
+    /// World bounding boxes of the drawables passed to TestDrawables() in structure-of-arrays form, one block per four drawables. Set by the octree for the duration of the call, null otherwise.
+    const BoundingBoxBlock* drawableBounds_;
 
 private:
     /// Prevent copy construction.
@@ -152,6 +155,10 @@ public:
 
     /// Frustum.
     Frustum frustum_;
+
+protected:
+    /// Add the drawables that are inside or intersect the frustum to the result without checking their flags. Tests four bounding boxes at a time if the octree has supplied them.
+    void PushInsideDrawables(Drawable** start, Drawable** end, bool inside);
 };
 
 /// General octree query result. Used for Lua bindings only.
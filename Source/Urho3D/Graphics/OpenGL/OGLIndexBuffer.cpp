@@ -23,6 +23,7 @@
 #include "../../Precompiled.h"
 
 #include "../../Core/Context.h"
+#include "../../Core/MemoryTracker.h"
 #include "../../Graphics/Graphics.h"
 #include "../../Graphics/GraphicsImpl.h"
 #include "../../Graphics/IndexBuffer.h"
@@ -91,6 +92,8 @@ void IndexBuffer::Release()
 
 void IndexBuffer::SetShadowed(bool enable)
 {
+    URHO3D_MEMORY_CATEGORY(MEMCAT_GRAPHICS);
+
     // If no graphics subsystem, can not disable shadowing
     if (!graphics_)
         enable = true;
@@ -108,6 +111,8 @@ void IndexBuffer::SetShadowed(bool enable)
 
 bool IndexBuffer::SetSize(unsigned indexCount, bool largeIndices, bool dynamic)
 {
+    URHO3D_MEMORY_CATEGORY(MEMCAT_GRAPHICS);
+
     Unlock();
 
     dynamic_ = dynamic;
@@ -27,6 +27,7 @@
 #include "../../Graphics/Shader.h"
 #include "../../Graphics/ShaderProgram.h"
 #include "../../Graphics/ShaderVariation.h"
+#include "../../Graphics/SortIDPool.h"
 #include "../../IO/Log.h"
 
 #include "../../DebugNew.h"
@@ -34,16 +35,20 @@
 namespace Urho3D
 {
 
+static SortIDPool shaderSortIDs;
+
 ShaderVariation::ShaderVariation(Shader* owner, ShaderType type) :
     GPUObject(owner->GetSubsystem<Graphics>()),
     owner_(owner),
-    type_(type)
+    type_(type),
+    sortID_(shaderSortIDs.Allocate())
 {
 }
 
 ShaderVariation::~ShaderVariation()
 {
     Release();
+    shaderSortIDs.Release(sortID_);
 }
 
 void ShaderVariation::OnDeviceLost()
@@ -72,6 +72,9 @@ public:
     /// Return compile error/warning string.
     const String& GetCompilerOutput() const { return compilerOutput_; }
 
+    /// Return small integer ID used for batch sorting. Unique among the live shader variations.
+    unsigned GetSortID() const { return sortID_; }
+
 private:
     /// Shader this variation belongs to.
     WeakPtr<Shader> owner_;
@@ -83,6 +86,8 @@ private:
     String defines_;
     /// Shader compile error string.
     String compilerOutput_;
+    /// Batch sorting ID.
+    unsigned sortID_;
 };
 
 }
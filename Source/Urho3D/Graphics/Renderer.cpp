@@ -22,7 +22,9 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/FrameAllocator.h"
 #include "../Core/Profiler.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/DebugRenderer.h"
@@ -275,18 +277,24 @@ Renderer::Renderer(Context* context) :
     numOcclusionBuffers_(0),
     numShadowCameras_(0),
     shadersChangedFrameNumber_(M_MAX_UNSIGNED),
+    shadersVersion_(0),
     hdrRendering_(false),
     specularLighting_(true),
     drawShadows_(true),
     reuseShadowMaps_(true),
     dynamicInstancing_(true),
     threadedOcclusion_(false),
+    temporalOcclusion_(true),
     shadersDirty_(true),
     initialized_(false),
     resetViews_(false)
 {
     SubscribeToEvent(E_SCREENMODE, URHO3D_HANDLER(Renderer, HandleScreenMode));
 
+    // Views allocate batch instance data from the frame allocator. Create it if the application has not
+    if (!GetSubsystem<FrameAllocator>())
+        context_->RegisterSubsystem(new FrameAllocator(context_));
+
     // Try to initialize right now, but skip if screen mode is not yet set
     Initialize();
 }
@@ -435,7 +443,11 @@ void Renderer::SetDynamicInstancing(bool enable)
     if (!instancingBuffer_)
         enable = false;
 
-    dynamicInstancing_ = enable;
+    if (enable != dynamicInstancing_)
+    {
+        dynamicInstancing_ = enable;
+        ++shadersVersion_;
+    }
 }
 
 void Renderer::SetMinInstances(int instances)
@@ -483,6 +495,11 @@ void Renderer::SetThreadedOcclusion(bool enable)
     }
 }
 
+void Renderer::SetTemporalOcclusion(bool enable)
+{
+    temporalOcclusion_ = enable;
+}
+
 void Renderer::ReloadShaders()
 {
     shadersDirty_ = true;
@@ -1604,6 +1621,7 @@ void Renderer::LoadPassShaders(Pass* pass)
     }
 
     pass->MarkShadersLoaded(shadersChangedFrameNumber_);
+    ++shadersVersion_;
 }
 
 void Renderer::ReleaseMaterialShaders()
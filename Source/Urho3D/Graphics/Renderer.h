@@ -202,6 +202,8 @@ public:
     void SetOccluderSizeThreshold(float screenSize);
     /// Set whether to thread occluder rendering. Default false.
     void SetThreadedOcclusion(bool enable);
+    /// Set whether to draw occluders that were visible on the previous frame before those that were hidden. Default true.
+    void SetTemporalOcclusion(bool enable);
     /// Set shadow depth bias multiplier for mobile platforms (OpenGL ES.) No effect on desktops. Default 2.
     void SetMobileShadowBiasMul(float mul);
     /// Set shadow depth bias addition for mobile platforms (OpenGL ES.)  No effect on desktops. Default 0.0001.
@@ -253,6 +255,9 @@ public:
     /// Return whether dynamic instancing is in use.
     bool GetDynamicInstancing() const { return dynamicInstancing_; }
 
+    /// Return a counter that changes whenever shaders are loaded for a pass or dynamic instancing is toggled. Shader variations chosen for batches earlier may be stale after a change.
+    unsigned GetShadersVersion() const { return shadersVersion_; }
+
     /// Return minimum number of instances required in a batch group to render as instanced.
     int GetMinInstances() const { return minInstances_; }
 
@@ -271,6 +276,9 @@ public:
     /// Return whether occlusion rendering is threaded.
     bool GetThreadedOcclusion() const { return threadedOcclusion_; }
 
+    /// Return whether occluders visible on the previous frame are drawn first.
+    bool GetTemporalOcclusion() const { return temporalOcclusion_; }
+
     /// Return shadow depth bias multiplier for mobile platforms.
     float GetMobileShadowBiasMul() const { return mobileShadowBiasMul_; }
 
@@ -504,6 +512,8 @@ private:
     unsigned numBatches_;
     /// Frame number on which shaders last changed.
     unsigned shadersChangedFrameNumber_;
+    /// Counter incremented whenever shaders are loaded for a pass or dynamic instancing is toggled.
+    unsigned shadersVersion_;
     /// Current stencil value for light optimization.
     unsigned char lightStencilValue_;
     /// HDR rendering flag.
@@ -518,6 +528,8 @@ private:
     bool dynamicInstancing_;
     /// Threaded occlusion rendering flag.
     bool threadedOcclusion_;
+    /// Temporal occluder ordering flag.
+    bool temporalOcclusion_;
     /// Shaders need reloading flag.
     bool shadersDirty_;
     /// Initialized flag.
@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/SortIDPool.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+SortIDPool::SortIDPool() :
+    nextID_(1)
+{
+}
+
+unsigned SortIDPool::Allocate()
+{
+    MutexLock lock(mutex_);
+
+    if (freeIDs_.Empty())
+        return nextID_++;
+
+    unsigned id = freeIDs_.Back();
+    freeIDs_.Pop();
+    return id;
+}
+
+void SortIDPool::Release(unsigned id)
+{
+    if (!id)
+        return;
+
+    MutexLock lock(mutex_);
+    freeIDs_.Push(id);
+}
+
+}
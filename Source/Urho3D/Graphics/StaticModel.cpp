@@ -168,6 +168,11 @@ Geometry* StaticModel::GetLodGeometry(unsigned batchIndex, unsigned level)
 
 unsigned StaticModel::GetNumOccluderTriangles()
 {
+    // Dedicated occluder geometry replaces the visible geometries
+    Geometry* occluderGeometry = model_ ? model_->GetOccluderGeometry() : 0;
+    if (occluderGeometry)
+        return occluderGeometry->GetIndexCount() / 3;
+
     unsigned triangles = 0;
 
     for (unsigned i = 0; i < batches_.Size(); ++i)
@@ -189,6 +194,13 @@ unsigned StaticModel::GetNumOccluderTriangles()
 
 bool StaticModel::DrawOcclusion(OcclusionBuffer* buffer)
 {
+    Geometry* occluderGeometry = model_ ? model_->GetOccluderGeometry() : 0;
+    if (occluderGeometry)
+    {
+        buffer->SetCullMode(CULL_CCW);
+        return DrawOcclusionGeometry(buffer, occluderGeometry, node_->GetWorldTransform());
+    }
+
     for (unsigned i = 0; i < batches_.Size(); ++i)
     {
         Geometry* geometry = GetLodGeometry(i, occlusionLodLevel_);
@@ -206,28 +218,31 @@ bool StaticModel::DrawOcclusion(OcclusionBuffer* buffer)
         else
             buffer->SetCullMode(CULL_CCW);
 
-        const unsigned char* vertexData;
-        unsigned vertexSize;
-        const unsigned char* indexData;
-        unsigned indexSize;
-        unsigned elementMask;
-
-        geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elementMask);
-        // Check for valid geometry data
-        if (!vertexData || !indexData)
-            continue;
-
-        unsigned indexStart = geometry->GetIndexStart();
-        unsigned indexCount = geometry->GetIndexCount();
-
         // Draw and check for running out of triangles
-        if (!buffer->AddTriangles(node_->GetWorldTransform(), vertexData, vertexSize, indexData, indexSize, indexStart, indexCount))
+        if (!DrawOcclusionGeometry(buffer, geometry, node_->GetWorldTransform()))
             return false;
     }
 
     return true;
 }
 
+bool StaticModel::DrawOcclusionGeometry(OcclusionBuffer* buffer, Geometry* geometry, const Matrix3x4& transform)
+{
+    const unsigned char* vertexData;
+    unsigned vertexSize;
+    const unsigned char* indexData;
+    unsigned indexSize;
+    unsigned elementMask;
+
+    geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elementMask);
+    // Check for valid geometry data
+    if (!vertexData || !indexData)
+        return true;
+
+    return buffer->AddTriangles(transform, vertexData, vertexSize, indexData, indexSize, geometry->GetIndexStart(),
+        geometry->GetIndexCount());
+}
+
 void StaticModel::SetModel(Model* model)
 {
     if (model == model_)
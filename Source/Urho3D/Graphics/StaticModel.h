@@ -68,7 +68,7 @@ public:
     void SetMaterial(Material* material);
     /// Set material on one geometry. Return true if successful.
     bool SetMaterial(unsigned index, Material* material);
-    /// Set occlusion LOD level. By default (M_MAX_UNSIGNED) same as visible.
+    /// Set occlusion LOD level. By default (M_MAX_UNSIGNED) same as visible. Ignored if the model defines dedicated occluder geometry.
     void SetOcclusionLodLevel(unsigned level);
     /// Apply default materials from a material list file. If filename is empty (default), the model's resource name with extension .txt will be used.
     void ApplyMaterialList(const String& fileName = String::EMPTY);
@@ -110,6 +110,8 @@ protected:
     void ResetLodLevels();
     /// Choose LOD levels based on distance.
     void CalculateLodLevels();
+    /// Submit one geometry's triangles to the occlusion buffer. Return true if did not run out of triangles.
+    bool DrawOcclusionGeometry(OcclusionBuffer* buffer, Geometry* geometry, const Matrix3x4& transform);
 
     /// Extra per-geometry data.
     PODVector<StaticModelGeometryData> geometryData_;
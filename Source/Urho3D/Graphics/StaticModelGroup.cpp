@@ -26,10 +26,13 @@
 #include "../Graphics/Batch.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/Geometry.h"
+#include "../Graphics/IndexBuffer.h"
 #include "../Graphics/Material.h"
+#include "../Graphics/Model.h"
 #include "../Graphics/OcclusionBuffer.h"
 #include "../Graphics/OctreeQuery.h"
 #include "../Graphics/StaticModelGroup.h"
+#include "../Graphics/VertexBuffer.h"
 #include "../Scene/Scene.h"
 
 #include "../DebugNew.h"
@@ -41,6 +44,9 @@ extern const char* GEOMETRY_CATEGORY;
 
 StaticModelGroup::StaticModelGroup(Context* context) :
     StaticModel(context),
+    proxyDistance_(0.0f),
+    proxiesDirty_(true),
+    proxyUpdatePending_(false),
     nodeIDsDirty_(false)
 {
     // Initialize the default node IDs attribute
@@ -58,6 +64,7 @@ void StaticModelGroup::RegisterObject(Context* context)
     URHO3D_COPY_BASE_ATTRIBUTES(StaticModel);
     URHO3D_ACCESSOR_ATTRIBUTE("Instance Nodes", GetNodeIDsAttr, SetNodeIDsAttr, VariantVector, Variant::emptyVariantVector,
         AM_DEFAULT | AM_NODEIDVECTOR);
+    URHO3D_ACCESSOR_ATTRIBUTE("Proxy Distance", GetProxyDistance, SetProxyDistance, float, 0.0f, AM_DEFAULT);
 }
 
 void StaticModelGroup::ApplyAttributes()
@@ -132,7 +139,7 @@ void StaticModelGroup::ProcessRayQuery(const RayOctreeQuery& query, PODVector<Ra
 
                 for (unsigned j = 0; j < batches_.Size(); ++j)
                 {
-                    Geometry* geometry = batches_[j].geometry_;
+                    Geometry* geometry = GetLodGeometry(j, M_MAX_UNSIGNED);
                     if (geometry)
                     {
                         Vector3 geometryNormal;
@@ -168,6 +175,14 @@ void StaticModelGroup::UpdateBatches(const FrameInfo& frame)
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
     distance_ = frame.camera_->GetDistance(worldBoundingBox.Center());
 
+    // Past the proxy distance use the merged geometries, but only once they have been built on the main thread
+    bool useProxies = proxyDistance_ > 0.0f && distance_ >= proxyDistance_;
+    if (useProxies && proxiesDirty_)
+    {
+        proxyUpdatePending_ = true;
+        useProxies = false;
+    }
+
     if (batches_.Size() > 1)
     {
         for (unsigned i = 0; i < batches_.Size(); ++i)
@@ -192,6 +207,49 @@ void StaticModelGroup::UpdateBatches(const FrameInfo& frame)
         lodDistance_ = newLodDistance;
         CalculateLodLevels();
     }
+
+    // Switch between the proxies and the current LOD level geometries. CalculateLodLevels() only assigns on LOD change
+    if (proxyDistance_ > 0.0f)
+    {
+        for (unsigned i = 0; i < batches_.Size(); ++i)
+        {
+            Geometry* proxy = useProxies && i < proxyGeometries_.Size() ? proxyGeometries_[i].Get() : (Geometry*)0;
+            if (proxy)
+            {
+                batches_[i].geometry_ = proxy;
+                batches_[i].worldTransform_ = &Matrix3x4::IDENTITY;
+                batches_[i].numWorldTransforms_ = 1;
+            }
+            else
+                batches_[i].geometry_ = geometries_[i][geometryData_[i].lodLevel_];
+        }
+    }
+}
+
+void StaticModelGroup::UpdateGeometry(const FrameInfo& frame)
+{
+    if (proxyUpdatePending_)
+    {
+        UpdateProxyGeometries();
+        proxyUpdatePending_ = false;
+    }
+}
+
+UpdateGeometryType StaticModelGroup::GetUpdateGeometryType()
+{
+    // Creating the proxy vertex and index buffers requires the main thread
+    return proxyUpdatePending_ ? UPDATE_MAIN_THREAD : UPDATE_NONE;
+}
+
+Geometry* StaticModelGroup::GetLodGeometry(unsigned batchIndex, unsigned level)
+{
+    if (batchIndex >= geometries_.Size())
+        return 0;
+
+    // If level is out of range, use the current LOD level instead of the batch geometry, which may be a proxy
+    if (level >= geometries_[batchIndex].Size())
+        level = geometryData_[batchIndex].lodLevel_;
+    return geometries_[batchIndex][level];
 }
 
 unsigned StaticModelGroup::GetNumOccluderTriangles()
@@ -199,6 +257,11 @@ unsigned StaticModelGroup::GetNumOccluderTriangles()
     // Make sure instance transforms are up-to-date
     GetWorldBoundingBox();
 
+    // Dedicated occluder geometry replaces the visible geometries
+    Geometry* occluderGeometry = model_ ? model_->GetOccluderGeometry() : 0;
+    if (occluderGeometry)
+        return numWorldTransforms_ * occluderGeometry->GetIndexCount() / 3;
+
     unsigned triangles = 0;
 
     for (unsigned i = 0; i < batches_.Size(); ++i)
@@ -223,6 +286,19 @@ bool StaticModelGroup::DrawOcclusion(OcclusionBuffer* buffer)
     // Make sure instance transforms are up-to-date
     GetWorldBoundingBox();
 
+    Geometry* occluderGeometry = model_ ? model_->GetOccluderGeometry() : 0;
+    if (occluderGeometry)
+    {
+        buffer->SetCullMode(CULL_CCW);
+        for (unsigned i = 0; i < numWorldTransforms_; ++i)
+        {
+            if (!DrawOcclusionGeometry(buffer, occluderGeometry, worldTransforms_[i]))
+                return false;
+        }
+
+        return true;
+    }
+
     for (unsigned i = 0; i < numWorldTransforms_; ++i)
     {
         for (unsigned j = 0; j < batches_.Size(); ++j)
@@ -242,22 +318,8 @@ bool StaticModelGroup::DrawOcclusion(OcclusionBuffer* buffer)
             else
                 buffer->SetCullMode(CULL_CCW);
 
-            const unsigned char* vertexData;
-            unsigned vertexSize;
-            const unsigned char* indexData;
-            unsigned indexSize;
-            unsigned elementMask;
-
-            geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elementMask);
-            // Check for valid geometry data
-            if (!vertexData || !indexData)
-                continue;
-
-            unsigned indexStart = geometry->GetIndexStart();
-            unsigned indexCount = geometry->GetIndexCount();
-
             // Draw and check for running out of triangles
-            if (!buffer->AddTriangles(worldTransforms_[i], vertexData, vertexSize, indexData, indexSize, indexStart, indexCount))
+            if (!DrawOcclusionGeometry(buffer, geometry, worldTransforms_[i]))
                 return false;
         }
     }
@@ -313,6 +375,26 @@ void StaticModelGroup::RemoveAllInstanceNodes()
     MarkNetworkUpdate();
 }
 
+void StaticModelGroup::SetProxyDistance(float distance)
+{
+    distance = Max(distance, 0.0f);
+    if (distance == proxyDistance_)
+        return;
+
+    proxyDistance_ = distance;
+
+    // When disabled, restore the normal geometries and release the proxies
+    if (proxyDistance_ == 0.0f)
+    {
+        for (unsigned i = 0; i < batches_.Size(); ++i)
+            batches_[i].geometry_ = geometries_[i][geometryData_[i].lodLevel_];
+        proxyGeometries_.Clear();
+        proxiesDirty_ = true;
+    }
+
+    MarkNetworkUpdate();
+}
+
 Node* StaticModelGroup::GetInstanceNode(unsigned index) const
 {
     return index < instanceNodes_.Size() ? instanceNodes_[index] : (Node*)0;
@@ -374,6 +456,7 @@ void StaticModelGroup::OnWorldBoundingBoxUpdate()
     }
 
     worldBoundingBox_ = worldBox;
+    proxiesDirty_ = true;
 
     // Store the amount of valid instances we found instead of resizing worldTransforms_. This is because this function may be 
     // called from multiple worker threads simultaneously
@@ -396,4 +479,110 @@ void StaticModelGroup::UpdateNodeIDs()
     }
 }
 
+void StaticModelGroup::UpdateProxyGeometries()
+{
+    // Make sure instance transforms are up-to-date
+    GetWorldBoundingBox();
+
+    proxyGeometries_.Clear();
+    proxyGeometries_.Resize(batches_.Size());
+    proxiesDirty_ = false;
+    if (!numWorldTransforms_)
+        return;
+
+    for (unsigned i = 0; i < batches_.Size(); ++i)
+    {
+        // The proxy is only seen from far away, so merge the lowest LOD level
+        Geometry* geometry = geometries_[i].Back();
+        if (!geometry || geometry->GetNumVertexBuffers() != 1 || geometry->GetPrimitiveType() != TRIANGLE_LIST)
+            continue;
+
+        const unsigned char* vertexData;
+        unsigned vertexSize;
+        const unsigned char* indexData;
+        unsigned indexSize;
+        unsigned elementMask;
+
+        geometry->GetRawData(vertexData, vertexSize, indexData, indexSize, elementMask);
+        // Check for valid geometry data
+        if (!vertexData || !indexData || !(elementMask & MASK_POSITION))
+            continue;
+
+        unsigned vertexStart = geometry->GetVertexStart();
+        unsigned vertexCount = geometry->GetVertexCount();
+        unsigned indexStart = geometry->GetIndexStart();
+        unsigned indexCount = geometry->GetIndexCount();
+        if (!vertexCount || !indexCount)
+            continue;
+
+        unsigned totalVertices = vertexCount * numWorldTransforms_;
+        unsigned totalIndices = indexCount * numWorldTransforms_;
+        bool largeIndices = totalVertices > 0xffff;
+        unsigned positionOffset = VertexBuffer::GetElementOffset(elementMask, ELEMENT_POSITION);
+        unsigned normalOffset = VertexBuffer::GetElementOffset(elementMask, ELEMENT_NORMAL);
+        unsigned tangentOffset = VertexBuffer::GetElementOffset(elementMask, ELEMENT_TANGENT);
+
+        PODVector<unsigned char> vertices(totalVertices * vertexSize);
+        PODVector<unsigned char> indices(totalIndices * (largeIndices ? sizeof(unsigned) : sizeof(unsigned short)));
+        unsigned char* vertexDest = &vertices[0];
+        unsigned short* shortIndexDest = (unsigned short*)&indices[0];
+        unsigned* largeIndexDest = (unsigned*)&indices[0];
+
+        for (unsigned j = 0; j < numWorldTransforms_; ++j)
+        {
+            const Matrix3x4& transform = worldTransforms_[j];
+            Matrix3 rotation = transform.ToMatrix3();
+            Matrix3 normalTransform = rotation.Inverse().Transpose();
+
+            // Copy the used vertex range and transform positions, normals and tangents to world space
+            memcpy(vertexDest, vertexData + vertexStart * vertexSize, vertexCount * vertexSize);
+            for (unsigned k = 0; k < vertexCount; ++k)
+            {
+                Vector3& position = *reinterpret_cast<Vector3*>(vertexDest + positionOffset);
+                position = transform * position;
+                if (elementMask & MASK_NORMAL)
+                {
+                    Vector3& normal = *reinterpret_cast<Vector3*>(vertexDest + normalOffset);
+                    normal = (normalTransform * normal).Normalized();
+                }
+                if (elementMask & MASK_TANGENT)
+                {
+                    // Tangent w (handedness) is left unchanged
+                    Vector3& tangent = *reinterpret_cast<Vector3*>(vertexDest + tangentOffset);
+                    tangent = (rotation * tangent).Normalized();
+                }
+                vertexDest += vertexSize;
+            }
+
+            // Rebase the indices to the instance's vertex range
+            unsigned baseVertex = j * vertexCount;
+            for (unsigned k = indexStart; k < indexStart + indexCount; ++k)
+            {
+                unsigned index = indexSize == sizeof(unsigned) ? ((const unsigned*)indexData)[k] :
+                    ((const unsigned short*)indexData)[k];
+                index = index - vertexStart + baseVertex;
+                if (largeIndices)
+                    *largeIndexDest++ = index;
+                else
+                    *shortIndexDest++ = (unsigned short)index;
+            }
+        }
+
+        SharedPtr<VertexBuffer> vertexBuffer(new VertexBuffer(context_));
+        SharedPtr<IndexBuffer> indexBuffer(new IndexBuffer(context_));
+        // Keep CPU-side copies so that the buffers can be restored after device loss
+        vertexBuffer->SetShadowed(true);
+        indexBuffer->SetShadowed(true);
+        if (!vertexBuffer->SetSize(totalVertices, elementMask) || !vertexBuffer->SetData(&vertices[0]) ||
+            !indexBuffer->SetSize(totalIndices, largeIndices) || !indexBuffer->SetData(&indices[0]))
+            continue;
+
+        SharedPtr<Geometry> proxy(new Geometry(context_));
+        proxy->SetVertexBuffer(0, vertexBuffer, elementMask);
+        proxy->SetIndexBuffer(indexBuffer);
+        proxy->SetDrawRange(TRIANGLE_LIST, 0, totalIndices, 0, totalVertices);
+        proxyGeometries_[i] = proxy;
+    }
+}
+
 }
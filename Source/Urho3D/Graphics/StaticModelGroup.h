@@ -46,6 +46,12 @@ public:
     virtual void ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results);
     /// Calculate distance and prepare batches for rendering. May be called from worker thread(s), possibly re-entrantly.
     virtual void UpdateBatches(const FrameInfo& frame);
+    /// Prepare geometry for rendering. Called from a worker thread if possible (no GPU update.)
+    virtual void UpdateGeometry(const FrameInfo& frame);
+    /// Return whether a geometry update is necessary, and if it can happen in a worker thread.
+    virtual UpdateGeometryType GetUpdateGeometryType();
+    /// Return the geometry for a specific LOD level. Never returns the proxy geometry.
+    virtual Geometry* GetLodGeometry(unsigned batchIndex, unsigned level);
     /// Return number of occlusion geometry triangles.
     virtual unsigned GetNumOccluderTriangles();
     /// Draw to occlusion buffer. Return true if did not run out of triangles.
@@ -57,6 +63,8 @@ public:
     void RemoveInstanceNode(Node* node);
     /// Remove all instance scene nodes.
     void RemoveAllInstanceNodes();
+    /// Set distance beyond which the instances are drawn as one merged proxy geometry per material (hierarchical LOD.) 0 disables (default.)
+    void SetProxyDistance(float distance);
 
     /// Return number of instance nodes.
     unsigned GetNumInstanceNodes() const { return instanceNodes_.Size(); }
@@ -64,6 +72,9 @@ public:
     /// Return instance node by index.
     Node* GetInstanceNode(unsigned index) const;
 
+    /// Return proxy distance.
+    float GetProxyDistance() const { return proxyDistance_; }
+
     /// Set node IDs attribute.
     void SetNodeIDsAttr(const VariantVector& value);
 
@@ -79,6 +90,8 @@ protected:
 private:
     /// Update node IDs attribute and ensure the transforms vector has the right size.
     void UpdateNodeIDs();
+    /// Merge the lowest LOD level of all instances into the proxy geometries.
+    void UpdateProxyGeometries();
 
     /// Instance nodes.
     Vector<WeakPtr<Node> > instanceNodes_;
@@ -86,8 +99,16 @@ private:
     PODVector<Matrix3x4> worldTransforms_;
     /// IDs of instance nodes for serialization.
     mutable VariantVector nodeIDsAttr_;
+    /// Merged world-space proxy geometries, one per batch. Null if the batch could not be merged.
+    Vector<SharedPtr<Geometry> > proxyGeometries_;
     /// Number of valid instance node transforms.
     unsigned numWorldTransforms_;
+    /// Proxy distance.
+    float proxyDistance_;
+    /// Proxy geometries need rebuilding due to instance or model change.
+    bool proxiesDirty_;
+    /// Proxy geometry rebuild requested from UpdateBatches.
+    bool proxyUpdatePending_;
     /// Whether node IDs have been set and nodes should be searched for during ApplyAttributes.
     bool nodeIDsDirty_;
 };
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/FrameAllocator.h"
 #include "../Core/Profiler.h"
 #include "../Core/WorkQueue.h"
 #include "../Graphics/Camera.h"
@@ -78,17 +79,18 @@ public:
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside)
     {
-        while (start != end)
-        {
-            Drawable* drawable = *start++;
+        unsigned first = result_.Size();
+        PushInsideDrawables(start, end, inside);
 
+        unsigned last = first;
+        for (unsigned i = first; i < result_.Size(); ++i)
+        {
+            Drawable* drawable = result_[i];
             if (drawable->GetCastShadows() && (drawable->GetDrawableFlags() & drawableFlags_) &&
                 (drawable->GetViewMask() & viewMask_))
-            {
-                if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                    result_.Push(drawable);
-            }
+                result_[last++] = drawable;
         }
+        result_.Resize(last);
     }
 };
 
@@ -106,22 +108,23 @@ public:
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside)
     {
-        while (start != end)
+        unsigned first = result_.Size();
+        PushInsideDrawables(start, end, inside);
+
+        unsigned last = first;
+        for (unsigned i = first; i < result_.Size(); ++i)
         {
-            Drawable* drawable = *start++;
+            Drawable* drawable = result_[i];
             unsigned char flags = drawable->GetDrawableFlags();
-
             if ((flags == DRAWABLE_ZONE || (flags == DRAWABLE_GEOMETRY && drawable->IsOccluder())) &&
                 (drawable->GetViewMask() & viewMask_))
-            {
-                if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                    result_.Push(drawable);
-            }
+                result_[last++] = drawable;
         }
+        result_.Resize(last);
     }
 };
 
-/// %Frustum octree query with occlusion.
+/// %Frustum octree query with occlusion. Drawable occlusion is performed later in worker threads.
 class OccludedFrustumOctreeQuery : public FrustumOctreeQuery
 {
 public:
@@ -147,28 +150,20 @@ public:
         }
     }
 
-    /// Intersection test for drawables. Note: drawable occlusion is performed later in worker threads.
-    virtual void TestDrawables(Drawable** start, Drawable** end, bool inside)
-    {
-        while (start != end)
-        {
-            Drawable* drawable = *start++;
-
-            if ((drawable->GetDrawableFlags() & drawableFlags_) && (drawable->GetViewMask() & viewMask_))
-            {
-                if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                    result_.Push(drawable);
-            }
-        }
-    }
-
     /// Occlusion buffer.
     OcclusionBuffer* buffer_;
 };
 
+/// Combine two scene Z ranges.
+static SceneZRange CombineSceneZRanges(const SceneZRange& lhs, const SceneZRange& rhs)
+{
+    return SceneZRange(Min(lhs.minZ_, rhs.minZ_), Max(lhs.maxZ_, rhs.maxZ_));
+}
+
 void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
 {
-    View* view = reinterpret_cast<View*>(item->aux_);
+    ParallelAccumulator<SceneZRange>* zRanges = reinterpret_cast<ParallelAccumulator<SceneZRange>*>(item->aux_);
+    View* view = reinterpret_cast<View*>(zRanges->aux_);
     Drawable** start = reinterpret_cast<Drawable**>(item->start_);
     Drawable** end = reinterpret_cast<Drawable**>(item->end_);
     OcclusionBuffer* buffer = view->occlusionBuffer_;
@@ -178,13 +173,36 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
     unsigned cameraViewMask = view->cullCamera_->GetViewMask();
     bool cameraZoneOverride = view->cameraZoneOverride_;
     PerThreadSceneResult& result = view->sceneResults_[threadIndex];
+    SceneZRange& zRange = zRanges->values_[threadIndex];
 
     while (start != end)
     {
-        Drawable* drawable = *start++;
+        // Test the occludees of up to four drawables against the occlusion buffer at once
+        Drawable* drawables[BOUNDING_BOX_BLOCK_SIZE];
+        BoundingBoxBlock boxes;
+        unsigned count = 0;
+        unsigned occludeeMask = 0;
 
-        if (!buffer || !drawable->IsOccludee() || buffer->IsVisible(drawable->GetWorldBoundingBox()))
+        while (start != end && count < BOUNDING_BOX_BLOCK_SIZE)
         {
+            Drawable* drawable = *start++;
+            drawables[count] = drawable;
+            boxes.Set(count, drawable->GetWorldBoundingBox());
+            if (buffer && drawable->IsOccludee())
+                occludeeMask |= 1 << count;
+            ++count;
+        }
+        for (unsigned i = count; i < BOUNDING_BOX_BLOCK_SIZE; ++i)
+            boxes.Copy(i, boxes, 0);
+
+        unsigned visibleMask = occludeeMask ? (buffer->IsVisibleMask(boxes) | ~occludeeMask) : M_MAX_UNSIGNED;
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            if (!(visibleMask & (1 << i)))
+                continue;
+
+            Drawable* drawable = drawables[i];
             drawable->UpdateBatches(view->frame_);
             // If draw distance non-zero, update and check it
             float maxDistance = drawable->GetDrawDistance();
@@ -216,8 +234,8 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
                     float minZ = viewCenterZ - viewEdgeZ;
                     float maxZ = viewCenterZ + viewEdgeZ;
                     drawable->SetMinMaxZ(viewCenterZ - viewEdgeZ, viewCenterZ + viewEdgeZ);
-                    result.minZ_ = Min(result.minZ_, minZ);
-                    result.maxZ_ = Max(result.maxZ_, maxZ);
+                    zRange.minZ_ = Min(zRange.minZ_, minZ);
+                    zRange.maxZ_ = Max(zRange.maxZ_, maxZ);
                 }
                 else
                     drawable->SetMinMaxZ(M_LARGE_VALUE, M_LARGE_VALUE);
@@ -286,10 +304,27 @@ void SortShadowQueueWork(const WorkItem* item, unsigned threadIndex)
         start->shadowSplits_[i].shadowBatches_.SortFrontToBack();
 }
 
+void RecordLightShaderParametersWork(const WorkItem* item, unsigned threadIndex)
+{
+    View* view = reinterpret_cast<View*>(item->aux_);
+    LightBatchQueue* start = reinterpret_cast<LightBatchQueue*>(item->start_);
+    start->RecordShaderParameters(view->GetCamera(), view->GetRenderer());
+}
+
+void CopyInstanceTransformsWork(const WorkItem* item, unsigned threadIndex)
+{
+    BatchQueue** start = reinterpret_cast<BatchQueue**>(item->start_);
+    BatchQueue** end = reinterpret_cast<BatchQueue**>(item->end_);
+
+    while (start != end)
+        (*start++)->CopyTransforms(item->aux_);
+}
+
 View::View(Context* context) :
     Object(context),
     graphics_(GetSubsystem<Graphics>()),
     renderer_(GetSubsystem<Renderer>()),
+    frameAllocator_(GetSubsystem<FrameAllocator>()),
     scene_(0),
     octree_(0),
     cullCamera_(0),
@@ -299,7 +334,8 @@ View::View(Context* context) :
     farClipZone_(0),
     occlusionBuffer_(0),
     renderTarget_(0),
-    substituteRenderTarget_(0)
+    substituteRenderTarget_(0),
+    shadersVersion_(M_MAX_UNSIGNED)
 {
     // Create octree query and scene results vector for each thread
     unsigned numThreads = GetSubsystem<WorkQueue>()->GetNumThreads() + 1; // Worker threads + main thread
@@ -310,6 +346,7 @@ View::View(Context* context) :
 
 View::~View()
 {
+    ClearBaseBatchCache();
 }
 
 bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
@@ -451,10 +488,8 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
                 }
             }
 
-            HashMap<unsigned, BatchQueue>::Iterator j = batchQueues_.Find(info.passIndex_);
-            if (j == batchQueues_.End())
-                j = batchQueues_.Insert(Pair<unsigned, BatchQueue>(info.passIndex_, BatchQueue()));
-            info.batchQueue_ = &j->second_;
+            if (!batchQueues_.Contains(info.passIndex_))
+                batchQueues_.Insert(Pair<unsigned, BatchQueue>(info.passIndex_, BatchQueue()));
 
             scenePasses_.Push(info);
         }
@@ -463,6 +498,10 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
             lightPassIndex_ = command.passIndex_ = Technique::GetPassIndex(command.pass_);
     }
 
+    // Inserting into the flat batch queue map may move the queues, so take pointers only after all have been created
+    for (unsigned i = 0; i < scenePasses_.Size(); ++i)
+        scenePasses_[i].batchQueue_ = &batchQueues_[scenePasses_[i].passIndex_];
+
     octree_ = 0;
     // Get default zone first in case we do not have zones defined
     cameraZone_ = farClipZone_ = renderer_->GetDefaultZone();
@@ -562,11 +601,26 @@ void View::Update(const FrameInfo& frame)
     occluders_.Clear();
     activeOccluders_ = 0;
     vertexLightQueues_.Clear();
-    for (HashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
-        i->second_.Clear(maxSortedInstances);
+
+    // Scene pass batch groups and the base batch cache persist across frames, but their shaders become stale when shaders
+    // are reloaded or dynamic instancing is toggled. Start over in that case
+    if (shadersVersion_ != renderer_->GetShadersVersion())
+    {
+        for (FlatHashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
+            i->second_.Clear(maxSortedInstances);
+        ClearBaseBatchCache();
+        shadersVersion_ = renderer_->GetShadersVersion();
+    }
+    else
+    {
+        for (FlatHashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
+            i->second_.ClearInstances(maxSortedInstances);
+    }
 
     if (hasScenePasses_ && (!cullCamera_ || !octree_))
     {
+        for (FlatHashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
+            i->second_.Clear(maxSortedInstances);
         renderer_->SendEvent(E_ENDVIEWUPDATE, eventData);
         return;
     }
@@ -875,7 +929,8 @@ void View::GetDrawables()
         octree_->GetDrawables(query);
     }
 
-    // Check drawable occlusion, find zones for moved drawables and collect geometries & lights in worker threads
+    // Check drawable occlusion, find zones for moved drawables and collect geometries & lights in worker threads. The scene
+    // Z range is reduced from per-thread accumulators
     {
         for (unsigned i = 0; i < sceneResults_.Size(); ++i)
         {
@@ -883,41 +938,18 @@ void View::GetDrawables()
 
             result.geometries_.Clear();
             result.lights_.Clear();
-            result.minZ_ = M_INFINITY;
-            result.maxZ_ = 0.0f;
         }
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = tempDrawables.Size() / numWorkItems;
-
-        PODVector<Drawable*>::Iterator start = tempDrawables.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = CheckVisibilityWork;
-            item->aux_ = this;
-
-            PODVector<Drawable*>::Iterator end = tempDrawables.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
+        sceneZRanges_.aux_ = this;
+        SceneZRange zRange = queue->ParallelReduce(CheckVisibilityWork, tempDrawables, sceneZRanges_,
+            SceneZRange(M_INFINITY, 0.0f), CombineSceneZRanges);
+        minZ_ = zRange.minZ_;
+        maxZ_ = zRange.maxZ_;
     }
 
-    // Combine lights, geometries & scene Z range from the threads
+    // Combine lights & geometries from the threads
     geometries_.Clear();
     lights_.Clear();
-    minZ_ = M_INFINITY;
-    maxZ_ = 0.0f;
 
     if (sceneResults_.Size() > 1)
     {
@@ -926,16 +958,12 @@ void View::GetDrawables()
             PerThreadSceneResult& result = sceneResults_[i];
             geometries_.Push(result.geometries_);
             lights_.Push(result.lights_);
-            minZ_ = Min(minZ_, result.minZ_);
-            maxZ_ = Max(maxZ_, result.maxZ_);
         }
     }
     else
     {
         // If just 1 thread, copy the results directly
         PerThreadSceneResult& result = sceneResults_[0];
-        minZ_ = result.minZ_;
-        maxZ_ = result.maxZ_;
         Swap(geometries_, result.geometries_);
         Swap(lights_, result.lights_);
     }
@@ -965,6 +993,10 @@ void View::GetBatches()
     ProcessLights();
     GetLightBatches();
     GetBaseBatches();
+
+    // Drop the reused batch groups that received no instances this frame
+    for (FlatHashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
+        i->second_.RemoveUnusedGroups();
 }
 
 void View::ProcessLights()
@@ -1035,6 +1067,7 @@ void View::GetLightBatches()
                 lightQueue.light_ = light;
                 lightQueue.negative_ = light->IsNegative();
                 lightQueue.shadowMap_ = 0;
+                lightQueue.parameterCamera_ = 0;
                 lightQueue.litBaseBatches_.Clear(maxSortedInstances);
                 lightQueue.litBatches_.Clear(maxSortedInstances);
                 lightQueue.volumeBatches_.Clear();
@@ -1176,6 +1209,8 @@ void View::GetBaseBatches()
 {
     URHO3D_PROFILE(GetBaseBatches);
 
+    unsigned numScenePasses = scenePasses_.Size();
+
     for (PODVector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
     {
         Drawable* drawable = *i;
@@ -1188,6 +1223,21 @@ void View::GetBaseBatches()
         const Vector<SourceBatch>& batches = drawable->GetBatches();
         bool vertexLightsProcessed = false;
 
+        // Get the batches prepared for the drawable on previous frames. AddBatchToQueue() checks them against the current
+        // geometry, material, pass, zone and light mask, so a change in any of them only causes the batch to be prepared again
+        BaseBatchCacheEntry& cacheEntry = baseBatchCache_[drawable];
+        cacheEntry.frameNumber_ = frame_.frameNumber_;
+        unsigned numCachedBatches = batches.Size() * numScenePasses;
+        if (cacheEntry.numBatches_ != numCachedBatches)
+        {
+            baseBatchCachePool_.Free(cacheEntry.batches_, cacheEntry.numBatches_ * sizeof(CachedBaseBatch));
+            cacheEntry.batches_ = static_cast<CachedBaseBatch*>(baseBatchCachePool_.Allocate(numCachedBatches *
+                sizeof(CachedBaseBatch)));
+            cacheEntry.numBatches_ = numCachedBatches;
+            for (unsigned j = 0; j < numCachedBatches; ++j)
+                cacheEntry.batches_[j].valid_ = false;
+        }
+
         for (unsigned j = 0; j < batches.Size(); ++j)
         {
             const SourceBatch& srcBatch = batches[j];
@@ -1241,6 +1291,7 @@ void View::GetBaseBatches()
                             i = vertexLightQueues_.Insert(MakePair(hash, LightBatchQueue()));
                             i->second_.light_ = 0;
                             i->second_.shadowMap_ = 0;
+                            i->second_.parameterCamera_ = 0;
                             i->second_.vertexLights_ = drawableVertexLights;
                         }
 
@@ -1254,8 +1305,24 @@ void View::GetBaseBatches()
                 if (allowInstancing && info.markToStencil_ && destBatch.lightMask_ != (destBatch.zone_->GetLightMask() & 0xff))
                     allowInstancing = false;
 
-                AddBatchToQueue(*info.batchQueue_, destBatch, tech, allowInstancing);
+                AddBatchToQueue(*info.batchQueue_, destBatch, tech, allowInstancing, true,
+                    &cacheEntry.batches_[j * numScenePasses + k]);
+            }
+        }
+    }
+
+    // Forget drawables that have not been visible for a while once the cache has grown well beyond the visible set
+    if (baseBatchCache_.Size() > geometries_.Size() * 2 + 64)
+    {
+        for (FlatHashMap<Drawable*, BaseBatchCacheEntry>::Iterator i = baseBatchCache_.Begin(); i != baseBatchCache_.End();)
+        {
+            if (i->second_.frameNumber_ != frame_.frameNumber_)
+            {
+                baseBatchCachePool_.Free(i->second_.batches_, i->second_.numBatches_ * sizeof(CachedBaseBatch));
+                i = baseBatchCache_.Erase(i);
             }
+            else
+                ++i;
         }
     }
 }
@@ -1311,6 +1378,30 @@ void View::UpdateGeometries()
         }
     }
 
+    // Record the light shader parameters ahead of rendering, so that drawing only needs to set them
+    if (camera_)
+    {
+        for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = RecordLightShaderParametersWork;
+            item->start_ = &(*i);
+            item->aux_ = this;
+            queue->AddWorkItem(item);
+        }
+
+        for (HashMap<unsigned long long, LightBatchQueue>::Iterator i = vertexLightQueues_.Begin(); i != vertexLightQueues_.End(); ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = RecordLightShaderParametersWork;
+            item->start_ = &i->second_;
+            item->aux_ = this;
+            queue->AddWorkItem(item);
+        }
+    }
+
     // Update geometries. Split into threaded and non-threaded updates.
     {
         if (threadedGeometries_.Size())
@@ -1327,26 +1418,8 @@ void View::UpdateGeometries()
                 }
             }
 
-            int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-            int drawablesPerItem = threadedGeometries_.Size() / numWorkItems;
-
-            PODVector<Drawable*>::Iterator start = threadedGeometries_.Begin();
-            for (int i = 0; i < numWorkItems; ++i)
-            {
-                PODVector<Drawable*>::Iterator end = threadedGeometries_.End();
-                if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                    end = start + drawablesPerItem;
-
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ = UpdateDrawableGeometriesWork;
-                item->aux_ = const_cast<FrameInfo*>(&frame_);
-                item->start_ = &(*start);
-                item->end_ = &(*end);
-                queue->AddWorkItem(item);
-
-                start = end;
-            }
+            queue->AddParallelWork(UpdateDrawableGeometriesWork, threadedGeometries_.Begin().ptr_, threadedGeometries_.Size(),
+                sizeof(Drawable*), const_cast<FrameInfo*>(&frame_));
         }
 
         // While the work queue is processed, update non-threaded geometries
@@ -2149,6 +2222,28 @@ void View::UpdateOccluders(PODVector<Drawable*>& occluders, Camera* camera)
     // Sort occluders so that if triangle budget is exceeded, best occluders have been drawn
     if (occluders.Size())
         Sort(occluders.Begin(), occluders.End(), CompareDrawables);
+
+    // Draw the occluders that were visible on the previous frame first. Occluders that were hidden are likely still behind
+    // them, so the triangle budget is better spent on the visible set. Keep the sorted order within both groups
+    if (renderer_->GetTemporalOcclusion() && occluders.Size() > 1)
+    {
+        unsigned visibleFrameNumber = frame_.frameNumber_ - 1;
+        unsigned last = 0;
+        hiddenOccluders_.Clear();
+
+        for (unsigned i = 0; i < occluders.Size(); ++i)
+        {
+            Drawable* occluder = occluders[i];
+            unsigned viewFrameNumber = occluder->GetViewFrameNumber();
+            if (viewFrameNumber == visibleFrameNumber || viewFrameNumber == frame_.frameNumber_)
+                occluders[last++] = occluder;
+            else
+                hiddenOccluders_.Push(occluder);
+        }
+
+        for (unsigned i = 0; i < hiddenOccluders_.Size(); ++i)
+            occluders[last++] = hiddenOccluders_[i];
+    }
 }
 
 void View::DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& occluders)
@@ -2786,11 +2881,44 @@ void View::CheckMaterialForAuxView(Material* material)
     material->MarkForAuxView(frame_.frameNumber_);
 }
 
-void View::AddBatchToQueue(BatchQueue& batchQueue, Batch& batch, Technique* tech, bool allowInstancing, bool allowShadows)
+void View::ClearBaseBatchCache()
+{
+    for (FlatHashMap<Drawable*, BaseBatchCacheEntry>::Iterator i = baseBatchCache_.Begin(); i != baseBatchCache_.End(); ++i)
+        baseBatchCachePool_.Free(i->second_.batches_, i->second_.numBatches_ * sizeof(CachedBaseBatch));
+    baseBatchCache_.Clear();
+}
+
+void View::AddBatchToQueue(BatchQueue& batchQueue, Batch& batch, Technique* tech, bool allowInstancing, bool allowShadows,
+    CachedBaseBatch* cachedBatch)
 {
     if (!batch.material_)
         batch.material_ = renderer_->GetDefaultMaterial();
 
+    // The shaders prepared on a previous frame can be reused if nothing they depend on has changed. Batches with vertex lights
+    // are always prepared anew, as the vertex light queues are rebuilt each frame. Released pass shaders must be reloaded
+    bool heightFog = batch.zone_ && batch.zone_->GetHeightFog();
+    bool useCache = cachedBatch && !batch.lightQueue_;
+    bool cacheHit = useCache && cachedBatch->valid_ && cachedBatch->geometry_ == batch.geometry_ &&
+        cachedBatch->material_ == batch.material_ && cachedBatch->pass_ == batch.pass_ && cachedBatch->zone_ == batch.zone_ &&
+        cachedBatch->sourceGeometryType_ == batch.geometryType_ && cachedBatch->lightMask_ == batch.lightMask_ &&
+        cachedBatch->allowInstancing_ == allowInstancing && cachedBatch->heightFog_ == heightFog &&
+        shadersVersion_ == renderer_->GetShadersVersion() && batch.pass_->GetVertexShaders().Size() &&
+        batch.pass_->GetPixelShaders().Size();
+
+    if (useCache && !cacheHit)
+    {
+        cachedBatch->geometry_ = batch.geometry_;
+        cachedBatch->material_ = batch.material_;
+        cachedBatch->pass_ = batch.pass_;
+        cachedBatch->zone_ = batch.zone_;
+        cachedBatch->sourceGeometryType_ = batch.geometryType_;
+        cachedBatch->lightMask_ = batch.lightMask_;
+        cachedBatch->allowInstancing_ = allowInstancing;
+        cachedBatch->heightFog_ = heightFog;
+        cachedBatch->groupIndex_ = M_MAX_UNSIGNED;
+        cachedBatch->valid_ = false;
+    }
+
     // Convert to instanced if possible
     if (allowInstancing && batch.geometryType_ == GEOM_STATIC && batch.geometry_->GetIndexBuffer())
         batch.geometryType_ = GEOM_INSTANCED;
@@ -2798,33 +2926,80 @@ void View::AddBatchToQueue(BatchQueue& batchQueue, Batch& batch, Technique* tech
     if (batch.geometryType_ == GEOM_INSTANCED)
     {
         BatchGroupKey key(batch);
+        FlatHashMap<BatchGroupKey, BatchGroup>& groups = batchQueue.batchGroups_;
+        FlatHashMap<BatchGroupKey, BatchGroup>::Iterator i;
+        bool newGroup = false;
 
-        HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchQueue.batchGroups_.Find(key);
-        if (i == batchQueue.batchGroups_.End())
+        // Try the group index remembered from a previous frame first to avoid the hash lookup
+        if (cacheHit && cachedBatch->groupIndex_ < groups.Size() && (groups.Begin() + cachedBatch->groupIndex_)->first_ == key)
+            i = groups.Begin() + cachedBatch->groupIndex_;
+        else
         {
-            // Create a new group based on the batch
-            // In case the group remains below the instancing limit, do not enable instancing shaders yet
-            BatchGroup newGroup(batch);
-            newGroup.geometryType_ = GEOM_STATIC;
-            renderer_->SetBatchShaders(newGroup, tech, allowShadows);
-            newGroup.CalculateSortKey();
-            i = batchQueue.batchGroups_.Insert(MakePair(key, newGroup));
+            i = groups.Find(key);
+            if (i == groups.End())
+            {
+                i = groups.Insert(MakePair(key, BatchGroup(batch)));
+                newGroup = true;
+            }
+            if (useCache)
+                cachedBatch->groupIndex_ = (unsigned)(i - groups.Begin());
         }
 
-        int oldSize = i->second_.instances_.Size();
-        i->second_.AddTransforms(batch);
-        // Convert to using instancing shaders when the instancing limit is reached
-        if (oldSize < minInstances_ && (int)i->second_.instances_.Size() >= minInstances_)
+        BatchGroup& group = i->second_;
+        if (group.instances_.Empty())
         {
-            i->second_.geometryType_ = GEOM_INSTANCED;
-            renderer_->SetBatchShaders(i->second_, tech, allowShadows);
-            i->second_.CalculateSortKey();
+            group.instances_.SetArena(frameAllocator_->GetArena());
+            group.startIndex_ = M_MAX_UNSIGNED;
+
+            // A group kept from the previous frame keeps its shaders and sort key when the batch is unchanged. Otherwise set
+            // it up based on the batch. In case the group remains below the instancing limit, do not enable instancing
+            // shaders yet
+            if (newGroup || !cacheHit)
+            {
+                static_cast<Batch&>(group) = batch;
+                group.geometryType_ = GEOM_STATIC;
+                renderer_->SetBatchShaders(group, tech, allowShadows);
+                group.CalculateSortKey();
+            }
+        }
+
+        int oldSize = group.instances_.Size();
+        group.AddTransforms(batch);
+        // Convert to using instancing shaders when the instancing limit is reached. A kept group stays instanced
+        if (group.geometryType_ != GEOM_INSTANCED && renderer_->GetDynamicInstancing() && oldSize < minInstances_ &&
+            (int)group.instances_.Size() >= minInstances_)
+        {
+            group.geometryType_ = GEOM_INSTANCED;
+            renderer_->SetBatchShaders(group, tech, allowShadows);
+            group.CalculateSortKey();
         }
+
+        if (useCache)
+            cachedBatch->valid_ = true;
     }
     else
     {
-        renderer_->SetBatchShaders(batch, tech, allowShadows);
-        batch.CalculateSortKey();
+        if (cacheHit)
+        {
+            batch.geometryType_ = cachedBatch->geometryType_;
+            batch.vertexShader_ = cachedBatch->vertexShader_;
+            batch.pixelShader_ = cachedBatch->pixelShader_;
+            batch.sortKey_ = cachedBatch->sortKey_;
+        }
+        else
+        {
+            renderer_->SetBatchShaders(batch, tech, allowShadows);
+            batch.CalculateSortKey();
+
+            if (useCache)
+            {
+                cachedBatch->geometryType_ = batch.geometryType_;
+                cachedBatch->vertexShader_ = batch.vertexShader_;
+                cachedBatch->pixelShader_ = batch.pixelShader_;
+                cachedBatch->sortKey_ = batch.sortKey_;
+                cachedBatch->valid_ = true;
+            }
+        }
 
         // If batch is static with multiple world transforms and cannot instance, we must push copies of the batch individually
         if (batch.geometryType_ == GEOM_STATIC && batch.numWorldTransforms_ > 1)
@@ -2857,7 +3032,7 @@ void View::PrepareInstancingBuffer()
 
     unsigned totalInstances = 0;
 
-    for (HashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
+    for (FlatHashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
         totalInstances += i->second_.GetNumInstances();
 
     for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
@@ -2877,17 +3052,24 @@ void View::PrepareInstancingBuffer()
     if (!dest)
         return;
 
-    for (HashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
-        i->second_.SetTransforms(dest, freeIndex);
+    // Assign the buffer ranges first, then copy the transforms of each queue in parallel
+    instancingQueues_.Clear();
+    for (FlatHashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
+        instancingQueues_.Push(&i->second_);
 
     for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
     {
         for (unsigned j = 0; j < i->shadowSplits_.Size(); ++j)
-            i->shadowSplits_[j].shadowBatches_.SetTransforms(dest, freeIndex);
-        i->litBaseBatches_.SetTransforms(dest, freeIndex);
-        i->litBatches_.SetTransforms(dest, freeIndex);
+            instancingQueues_.Push(&i->shadowSplits_[j].shadowBatches_);
+        instancingQueues_.Push(&i->litBaseBatches_);
+        instancingQueues_.Push(&i->litBatches_);
     }
 
+    for (PODVector<BatchQueue*>::Iterator i = instancingQueues_.Begin(); i != instancingQueues_.End(); ++i)
+        (*i)->SetInstanceIndices(freeIndex);
+
+    GetSubsystem<WorkQueue>()->ParallelFor(CopyInstanceTransformsWork, instancingQueues_, dest);
+
     instancingBuffer->Unlock();
 }
 
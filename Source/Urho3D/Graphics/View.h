@@ -25,6 +25,8 @@
 #include "../Container/HashSet.h"
 #include "../Container/List.h"
 #include "../Core/Object.h"
+#include "../Core/PoolAllocator.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/Batch.h"
 #include "../Graphics/Light.h"
 #include "../Graphics/Zone.h"
@@ -91,16 +93,85 @@ struct ScenePassInfo
     BatchQueue* batchQueue_;
 };
 
-/// Per-thread geometry, light and scene range collection structure.
+/// Base batch of a drawable for one scene pass, as prepared on a previous frame. Reused as long as the inputs of the batch stay the same.
+struct CachedBaseBatch
+{
+    /// Geometry.
+    Geometry* geometry_;
+    /// Material.
+    Material* material_;
+    /// Material pass.
+    Pass* pass_;
+    /// Zone.
+    Zone* zone_;
+    /// Geometry type of the source batch.
+    GeometryType sourceGeometryType_;
+    /// Geometry type chosen when setting the shaders.
+    GeometryType geometryType_;
+    /// Vertex shader.
+    ShaderVariation* vertexShader_;
+    /// Pixel shader.
+    ShaderVariation* pixelShader_;
+    /// State sorting key.
+    unsigned long long sortKey_;
+    /// Batch group index in the batch queue, or M_MAX_UNSIGNED if not known. Only a hint, which is verified against the group key.
+    unsigned groupIndex_;
+    /// Light mask.
+    unsigned char lightMask_;
+    /// Instancing allowed flag.
+    bool allowInstancing_;
+    /// Zone height fog flag.
+    bool heightFog_;
+    /// Valid flag.
+    bool valid_;
+};
+
+/// Cached base batches of a drawable.
+struct BaseBatchCacheEntry
+{
+    /// Construct.
+    BaseBatchCacheEntry() :
+        frameNumber_(0),
+        batches_(0),
+        numBatches_(0)
+    {
+    }
+
+    /// Frame number on which the entry was last used.
+    unsigned frameNumber_;
+    /// Cached batch for each source batch and scene pass. Allocated from the view's batch cache pool.
+    CachedBaseBatch* batches_;
+    /// Number of cached batches.
+    unsigned numBatches_;
+};
+
+/// Per-thread geometry and light collection structure.
 struct PerThreadSceneResult
 {
     /// Geometry objects.
     PODVector<Drawable*> geometries_;
     /// Lights.
     PODVector<Light*> lights_;
-    /// Scene minimum Z value.
+};
+
+/// View space Z range of visible geometry.
+struct SceneZRange
+{
+    /// Construct undefined.
+    SceneZRange()
+    {
+    }
+
+    /// Construct from minimum and maximum Z values.
+    SceneZRange(float minZ, float maxZ) :
+        minZ_(minZ),
+        maxZ_(maxZ)
+    {
+    }
+
+    /// Minimum Z value.
     float minZ_;
-    /// Scene maximum Z value.
+    /// Maximum Z value.
     float maxZ_;
 };
 
@@ -247,8 +318,11 @@ private:
     Technique* GetTechnique(Drawable* drawable, Material* material);
     /// Check if material should render an auxiliary view (if it has a camera attached.)
     void CheckMaterialForAuxView(Material* material);
+    /// Free the cached base batches of all drawables.
+    void ClearBaseBatchCache();
     /// Choose shaders for a batch and add it to queue.
-    void AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing = true, bool allowShadows = true);
+    void AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing = true, bool allowShadows = true,
+        CachedBaseBatch* cachedBatch = 0);
     /// Prepare instancing buffer by filling it with all instance transforms.
     void PrepareInstancingBuffer();
     /// Set up a light volume rendering batch.
@@ -296,6 +370,8 @@ private:
     WeakPtr<Graphics> graphics_;
     /// Renderer subsystem.
     WeakPtr<Renderer> renderer_;
+    /// Frame allocator subsystem.
+    WeakPtr<FrameAllocator> frameAllocator_;
     /// Scene to use.
     Scene* scene_;
     /// Octree to use.
@@ -368,8 +444,10 @@ private:
     RenderPath* renderPath_;
     /// Per-thread octree query results.
     Vector<PODVector<Drawable*> > tempDrawables_;
-    /// Per-thread geometries, lights and Z range collection results.
+    /// Per-thread geometries and lights collection results.
     Vector<PerThreadSceneResult> sceneResults_;
+    /// Per-thread scene Z range accumulators.
+    ParallelAccumulator<SceneZRange> sceneZRanges_;
     /// Visible zones.
     PODVector<Zone*> zones_;
     /// Visible geometry objects.
@@ -380,6 +458,8 @@ private:
     PODVector<Drawable*> threadedGeometries_;
     /// Occluder objects.
     PODVector<Drawable*> occluders_;
+    /// Occluders that were hidden on the previous frame, used when ordering occluders.
+    PODVector<Drawable*> hiddenOccluders_;
     /// Lights.
     PODVector<Light*> lights_;
     /// Number of active occluders.
@@ -397,8 +477,16 @@ private:
     Vector<LightBatchQueue> lightQueues_;
     /// Per-vertex light queues.
     HashMap<unsigned long long, LightBatchQueue> vertexLightQueues_;
+    /// Batch queues whose instance transforms are copied to the instancing buffer.
+    PODVector<BatchQueue*> instancingQueues_;
     /// Batch queues by pass index.
-    HashMap<unsigned, BatchQueue> batchQueues_;
+    FlatHashMap<unsigned, BatchQueue> batchQueues_;
+    /// Base batches prepared on previous frames by drawable.
+    FlatHashMap<Drawable*, BaseBatchCacheEntry> baseBatchCache_;
+    /// Pool for the cached base batch arrays, which come and go as drawables enter and leave the view.
+    PoolAllocator baseBatchCachePool_;
+    /// Renderer shaders version the base batch cache and batch groups were built with.
+    unsigned shadersVersion_;
     /// Index of the GBuffer pass.
     unsigned gBufferPassIndex_;
     /// Index of the opaque forward base pass.
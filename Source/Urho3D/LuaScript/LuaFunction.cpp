@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/MemoryTracker.h"
 #include "../IO/Log.h"
 #include "../IO/VectorBuffer.h"
 #include "../LuaScript/LuaFunction.h"
@@ -84,6 +85,8 @@ bool LuaFunction::BeginCall(const LuaScriptInstance* instance)
 
 bool LuaFunction::EndCall(int numReturns)
 {
+    URHO3D_MEMORY_CATEGORY(MEMCAT_SCRIPT);
+
     assert(numArguments_ >= 0);
     int numArguments = numArguments_;
     numArguments_ = -1;
@@ -323,4 +323,52 @@ public:
     float dummyMax_; // This is never used, but exists to pad the max_ value to four floats.
 };
 
+/// Number of bounding boxes in a bounding box block.
+static const unsigned BOUNDING_BOX_BLOCK_SIZE = 4;
+
+/// Block of axis-aligned bounding boxes in structure-of-arrays form, for testing several boxes at once with SIMD instructions.
+struct URHO3D_API BoundingBoxBlock
+{
+    /// Set a bounding box.
+    void Set(unsigned index, const BoundingBox& box)
+    {
+        minX_[index] = box.min_.x_;
+        minY_[index] = box.min_.y_;
+        minZ_[index] = box.min_.z_;
+        maxX_[index] = box.max_.x_;
+        maxY_[index] = box.max_.y_;
+        maxZ_[index] = box.max_.z_;
+    }
+
+    /// Copy a bounding box from another index.
+    void Copy(unsigned index, const BoundingBoxBlock& block, unsigned srcIndex)
+    {
+        minX_[index] = block.minX_[srcIndex];
+        minY_[index] = block.minY_[srcIndex];
+        minZ_[index] = block.minZ_[srcIndex];
+        maxX_[index] = block.maxX_[srcIndex];
+        maxY_[index] = block.maxY_[srcIndex];
+        maxZ_[index] = block.maxZ_[srcIndex];
+    }
+
+    /// Return a bounding box.
+    BoundingBox Get(unsigned index) const
+    {
+        return BoundingBox(Vector3(minX_[index], minY_[index], minZ_[index]), Vector3(maxX_[index], maxY_[index], maxZ_[index]));
+    }
+
+    /// Minimum X coordinates.
+    float minX_[BOUNDING_BOX_BLOCK_SIZE];
+    /// Minimum Y coordinates.
+    float minY_[BOUNDING_BOX_BLOCK_SIZE];
+    /// Minimum Z coordinates.
+    float minZ_[BOUNDING_BOX_BLOCK_SIZE];
+    /// Maximum X coordinates.
+    float maxX_[BOUNDING_BOX_BLOCK_SIZE];
+    /// Maximum Y coordinates.
+    float maxY_[BOUNDING_BOX_BLOCK_SIZE];
+    /// Maximum Z coordinates.
+    float maxZ_[BOUNDING_BOX_BLOCK_SIZE];
+};
+
 }
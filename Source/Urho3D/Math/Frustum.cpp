@@ -189,6 +189,45 @@ Rect Frustum::Projected(const Matrix4& projection) const
     return rect;
 }
 
+unsigned Frustum::IsInsideFastMask(const BoundingBoxBlock& boxes) const
+{
+#ifdef URHO3D_SSE
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 minX = _mm_loadu_ps(boxes.minX_);
+    __m128 minY = _mm_loadu_ps(boxes.minY_);
+    __m128 minZ = _mm_loadu_ps(boxes.minZ_);
+    __m128 centerX = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(boxes.maxX_), minX), half);
+    __m128 centerY = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(boxes.maxY_), minY), half);
+    __m128 centerZ = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(boxes.maxZ_), minZ), half);
+    __m128 edgeX = _mm_sub_ps(centerX, minX);
+    __m128 edgeY = _mm_sub_ps(centerY, minY);
+    __m128 edgeZ = _mm_sub_ps(centerZ, minZ);
+    __m128 zero = _mm_setzero_ps();
+    __m128 outside = zero;
+
+    for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+    {
+        const Plane& plane = planes_[i];
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.normal_.x_), centerX),
+            _mm_mul_ps(_mm_set1_ps(plane.normal_.y_), centerY)), _mm_mul_ps(_mm_set1_ps(plane.normal_.z_), centerZ)),
+            _mm_set1_ps(plane.d_));
+        __m128 absDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.absNormal_.x_), edgeX),
+            _mm_mul_ps(_mm_set1_ps(plane.absNormal_.y_), edgeY)), _mm_mul_ps(_mm_set1_ps(plane.absNormal_.z_), edgeZ));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_sub_ps(zero, absDist)));
+    }
+
+    return ~(unsigned)_mm_movemask_ps(outside) & ((1 << BOUNDING_BOX_BLOCK_SIZE) - 1);
+#else
+    unsigned mask = 0;
+    for (unsigned i = 0; i < BOUNDING_BOX_BLOCK_SIZE; ++i)
+    {
+        if (IsInsideFast(boxes.Get(i)) != OUTSIDE)
+            mask |= 1 << i;
+    }
+    return mask;
+#endif
+}
+
 void Frustum::UpdatePlanes()
 {
     planes_[PLANE_NEAR].Define(vertices_[2], vertices_[1], vertices_[0]);
@@ -153,6 +153,9 @@ public:
         return INSIDE;
     }
 
+    /// Test if the bounding boxes of a block are (partially) inside or outside. Return a bit mask of the boxes that are not outside, the lowest bit being the first box.
+    unsigned IsInsideFastMask(const BoundingBoxBlock& boxes) const;
+
     /// Return distance of a point to the frustum, or 0 if inside.
     float Distance(const Vector3& point) const
     {
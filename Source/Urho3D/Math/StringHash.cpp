@@ -22,6 +22,8 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/HashMap.h"
+#include "../Core/Mutex.h"
 #include "../Math/MathDefs.h"
 #include "../Math/StringHash.h"
 
@@ -34,6 +36,20 @@ namespace Urho3D
 
 const StringHash StringHash::ZERO;
 
+/// Return the intern table. Constructed on first use, so that strings can be interned during static initialization.
+static HashMap<StringHash, String>& GetInternedStrings()
+{
+    static HashMap<StringHash, String> internedStrings;
+    return internedStrings;
+}
+
+/// Return the intern table mutex.
+static Mutex& GetInternMutex()
+{
+    static Mutex internMutex;
+    return internMutex;
+}
+
 StringHash::StringHash(const char* str) :
     value_(Calculate(str))
 {
@@ -62,6 +78,24 @@ unsigned StringHash::Calculate(const char* str)
     return hash;
 }
 
+StringHash StringHash::Intern(const String& str)
+{
+    StringHash hash(str);
+
+    MutexLock lock(GetInternMutex());
+    HashMap<StringHash, String>& internedStrings = GetInternedStrings();
+    if (!internedStrings.Contains(hash))
+        internedStrings[hash] = str;
+
+    return hash;
+}
+
+unsigned StringHash::GetNumInterned()
+{
+    MutexLock lock(GetInternMutex());
+    return GetInternedStrings().Size();
+}
+
 String StringHash::ToString() const
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
@@ -69,4 +103,13 @@ String StringHash::ToString() const
     return String(tempBuffer);
 }
 
+const String& StringHash::Reverse() const
+{
+    // Interned strings are never removed and the hash map nodes do not move, so the reference stays valid after unlocking
+    MutexLock lock(GetInternMutex());
+    HashMap<StringHash, String>& internedStrings = GetInternedStrings();
+    HashMap<StringHash, String>::ConstIterator i = internedStrings.Find(*this);
+    return i != internedStrings.End() ? i->second_ : String::EMPTY;
+}
+
 }
@@ -97,11 +97,18 @@ public:
     /// Return as string.
     String ToString() const;
 
+    /// Return the interned string that produced this hash, or empty if none has been interned.
+    const String& Reverse() const;
+
     /// Return hash value for HashSet & HashMap.
     unsigned ToHash() const { return value_; }
 
     /// Calculate hash value case-insensitively from a C string.
     static unsigned Calculate(const char* str);
+    /// Calculate the hash of a string and store the string for reverse lookup. If a different string with the same hash has already been interned, it is kept. Thread-safe.
+    static StringHash Intern(const String& str);
+    /// Return number of interned strings.
+    static unsigned GetNumInterned();
 
     /// Zero hash.
     static const StringHash ZERO;
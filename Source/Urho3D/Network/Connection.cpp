@@ -23,12 +23,14 @@
 #include "../Precompiled.h"
 
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../IO/PackageFile.h"
 #include "../Network/Connection.h"
+#include "../Network/InterestGrid.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkEvents.h"
 #include "../Network/NetworkPriority.h"
@@ -60,11 +62,100 @@ PackageUpload::PackageUpload() :
 {
 }
 
+static void EncodeSharedReplicationUpdate(SharedReplicationUpdate& update)
+{
+    const SharedReplicationKey& key = update.key_;
+    update.data_.Clear();
+    if (key.msgID_ == MSG_NODELATESTDATA || key.msgID_ == MSG_COMPONENTLATESTDATA)
+        key.serializable_->WriteLatestDataUpdate(update.data_, 0);
+    else
+        key.serializable_->WriteDeltaUpdate(update.data_, key.dirtyAttributes_, 0);
+}
+
+void EncodeSharedReplicationUpdatesWork(const WorkItem* item, unsigned threadIndex)
+{
+    SharedReplicationUpdate** start = reinterpret_cast<SharedReplicationUpdate**>(item->start_);
+    SharedReplicationUpdate** end = reinterpret_cast<SharedReplicationUpdate**>(item->end_);
+
+    while (start != end)
+    {
+        EncodeSharedReplicationUpdate(**start);
+        ++start;
+    }
+}
+
+ReplicationUpdateCache::ReplicationUpdateCache() :
+    numUpdates_(0)
+{
+}
+
+void ReplicationUpdateCache::Clear()
+{
+    indices_.Clear();
+    sharedUpdates_.Clear();
+    numUpdates_ = 0;
+}
+
+unsigned ReplicationUpdateCache::Add(int msgID, Serializable* serializable, const DirtyBits& dirtyAttributes)
+{
+    SharedReplicationKey key(msgID, serializable, dirtyAttributes);
+    HashMap<SharedReplicationKey, unsigned>::ConstIterator i = indices_.Find(key);
+    if (i != indices_.End())
+    {
+        ++updates_[i->second_].numConnections_;
+        return i->second_;
+    }
+
+    if (numUpdates_ >= updates_.Size())
+        updates_.Resize(numUpdates_ + 1);
+    updates_[numUpdates_].key_ = key;
+    updates_[numUpdates_].numConnections_ = 1;
+    indices_[key] = numUpdates_;
+    return numUpdates_++;
+}
+
+void ReplicationUpdateCache::Encode(WorkQueue* queue)
+{
+    // Only updates sent by more than one connection are worth encoding here; the others are encoded directly into the
+    // message of their connection
+    sharedUpdates_.Clear();
+    for (unsigned i = 0; i < numUpdates_; ++i)
+    {
+        if (updates_[i].numConnections_ > 1)
+            sharedUpdates_.Push(&updates_[i]);
+    }
+
+    if (sharedUpdates_.Empty())
+        return;
+
+    if (queue)
+        queue->ParallelFor(EncodeSharedReplicationUpdatesWork, sharedUpdates_, 0);
+    else
+    {
+        for (unsigned i = 0; i < sharedUpdates_.Size(); ++i)
+            EncodeSharedReplicationUpdate(*sharedUpdates_[i]);
+    }
+}
+
+/// Maximum number of sent controls to keep for client-side prediction.
+static const unsigned MAX_SENT_CONTROLS = 128;
+
+/// Return whether a controls timestamp is newer than another, allowing wraparound.
+static inline bool IsTimeStampNewer(unsigned char timeStamp, unsigned char other)
+{
+    unsigned char difference = (unsigned char)(timeStamp - other);
+    return difference != 0 && difference < 128;
+}
+
 Connection::Connection(Context* context, bool isClient, kNet::SharedPtr<kNet::MessageConnection> connection) :
     Object(context),
     timeStamp_(0),
     connection_(connection),
     sendMode_(OPSM_NONE),
+    ackedTimeStamp_(0),
+    interestRadius_(0.0f),
+    interestExitFactor_(DEFAULT_INTEREST_EXIT_FACTOR),
+    interestActive_(false),
     isClient_(isClient),
     connectPending_(false),
     sceneLoaded_(false),
@@ -170,6 +261,9 @@ void Connection::SetScene(Scene* newScene)
 
     scene_ = newScene;
     sceneLoaded_ = false;
+    relevantNodes_.Clear();
+    sentControls_.Clear();
+    interestActive_ = false;
     UnsubscribeFromEvent(E_ASYNCLOADFINISHED);
 
     if (!scene_)
@@ -226,6 +320,16 @@ void Connection::SetRotation(const Quaternion& rotation)
         sendMode_ = OPSM_POSITION_ROTATION;
 }
 
+void Connection::SetInterestRadius(float radius)
+{
+    interestRadius_ = Max(radius, 0.0f);
+}
+
+void Connection::SetInterestExitFactor(float factor)
+{
+    interestExitFactor_ = Max(factor, 1.0f);
+}
+
 void Connection::SetConnectPending(bool connectPending)
 {
     connectPending_ = connectPending;
@@ -243,9 +347,21 @@ void Connection::Disconnect(int waitMSec)
 
 void Connection::SendServerUpdate()
 {
+    CollectServerUpdate();
+    EncodeServerUpdate();
+    FlushServerUpdate();
+}
+
+void Connection::CollectServerUpdate(const InterestGrid* grid)
+{
+    replicationMessages_.Clear();
+
     if (!scene_ || !sceneLoaded_)
         return;
 
+    // Mark nodes entering or leaving the interest area dirty, so that they get created or removed
+    UpdateInterest(grid);
+
     // Always check the root node (scene) first so that the scene-wide components get sent first,
     // and all other replicated nodes get added to the dirty set for sending the initial state
     unsigned sceneID = scene_->GetID();
@@ -263,6 +379,53 @@ void Connection::SendServerUpdate()
     }
 }
 
+void Connection::ShareServerUpdate(ReplicationUpdateCache& cache)
+{
+    for (PODVector<ReplicationMessage>::Iterator i = replicationMessages_.Begin(); i != replicationMessages_.End(); ++i)
+    {
+        switch (i->msgID_)
+        {
+        case MSG_NODEDELTAUPDATE:
+        case MSG_COMPONENTDELTAUPDATE:
+        case MSG_NODELATESTDATA:
+        case MSG_COMPONENTLATESTDATA:
+            i->sharedIndex_ = cache.Add(i->msgID_, i->serializable_, i->dirtyAttributes_);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+void Connection::EncodeServerUpdate(const ReplicationUpdateCache* cache)
+{
+    replicationData_.Clear();
+
+    for (PODVector<ReplicationMessage>::Iterator i = replicationMessages_.Begin(); i != replicationMessages_.End(); ++i)
+    {
+        i->dataStart_ = replicationData_.GetSize();
+        EncodeReplicationMessage(*i, cache);
+        i->dataSize_ = replicationData_.GetSize() - i->dataStart_;
+    }
+}
+
+void Connection::FlushServerUpdate()
+{
+    const unsigned char* data = replicationData_.GetData();
+
+    for (PODVector<ReplicationMessage>::ConstIterator i = replicationMessages_.Begin(); i != replicationMessages_.End(); ++i)
+    {
+        // Latest data messages replace each other per node or component, and do not need to be in order
+        if (i->msgID_ == MSG_NODELATESTDATA || i->msgID_ == MSG_COMPONENTLATESTDATA)
+            SendMessage(i->msgID_, true, false, data + i->dataStart_, i->dataSize_, i->id_);
+        else
+            SendMessage(i->msgID_, true, true, data + i->dataStart_, i->dataSize_);
+    }
+
+    replicationMessages_.Clear();
+}
+
 void Connection::SendClientUpdate()
 {
     if (!scene_ || !sceneLoaded_)
@@ -280,6 +443,14 @@ void Connection::SendClientUpdate()
         msg_.WritePackedQuaternion(rotation_);
     SendMessage(MSG_CONTROLS, false, false, msg_, CONTROLS_CONTENT_ID);
 
+    // Keep the sent controls for replaying client-side prediction
+    if (sentControls_.Size() >= MAX_SENT_CONTROLS)
+        sentControls_.Erase(0);
+    sentControls_.Resize(sentControls_.Size() + 1);
+    SentControls& sent = sentControls_.Back();
+    sent.timeStamp_ = timeStamp_;
+    sent.controls_ = controls_;
+
     ++timeStamp_;
 }
 
@@ -446,6 +617,35 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& msg)
     return processed;
 }
 
+unsigned Connection::ReplayControls(unsigned char timeStamp)
+{
+    using namespace ControlsReplay;
+
+    Network* network = GetSubsystem<Network>();
+    float timeStep = network && network->GetUpdateFps() > 0 ? 1.0f / (float)network->GetUpdateFps() : 0.0f;
+    unsigned numReplayed = 0;
+
+    VariantMap& eventData = GetEventDataMap();
+    for (unsigned i = 0; i < sentControls_.Size(); ++i)
+    {
+        const SentControls& sent = sentControls_[i];
+        if (!IsTimeStampNewer(sent.timeStamp_, timeStamp))
+            continue;
+
+        eventData[P_CONNECTION] = this;
+        eventData[P_TIMESTAMP] = (unsigned)sent.timeStamp_;
+        eventData[P_BUTTONS] = sent.controls_.buttons_;
+        eventData[P_YAW] = sent.controls_.yaw_;
+        eventData[P_PITCH] = sent.controls_.pitch_;
+        eventData[P_DATA] = sent.controls_.extraData_;
+        eventData[P_TIMESTEP] = timeStep;
+        SendEvent(E_CONTROLSREPLAY, eventData);
+        ++numReplayed;
+    }
+
+    return numReplayed;
+}
+
 void Connection::ProcessLoadScene(int msgID, MemoryBuffer& msg)
 {
     if (IsClient())
@@ -584,6 +784,8 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
     case MSG_NODEDELTAUPDATE:
         {
             unsigned nodeID = msg.ReadNetID();
+            if (!msg.IsEof())
+                AcknowledgeControls(msg.GetData()[msg.GetPosition()]);
             Node* node = scene_->GetNode(nodeID);
             if (node)
             {
@@ -606,6 +808,8 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
     case MSG_NODELATESTDATA:
         {
             unsigned nodeID = msg.ReadNetID();
+            if (!msg.IsEof())
+                AcknowledgeControls(msg.GetData()[msg.GetPosition()]);
             Node* node = scene_->GetNode(nodeID);
             if (node)
             {
@@ -670,6 +874,8 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
     case MSG_COMPONENTDELTAUPDATE:
         {
             unsigned componentID = msg.ReadNetID();
+            if (!msg.IsEof())
+                AcknowledgeControls(msg.GetData()[msg.GetPosition()]);
             Component* component = scene_->GetComponent(componentID);
             if (component)
             {
@@ -684,6 +890,8 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
     case MSG_COMPONENTLATESTDATA:
         {
             unsigned componentID = msg.ReadNetID();
+            if (!msg.IsEof())
+                AcknowledgeControls(msg.GetData()[msg.GetPosition()]);
             Component* component = scene_->GetComponent(componentID);
             if (component)
             {
@@ -981,6 +1189,21 @@ void Connection::ProcessRemoteEvent(int msgID, MemoryBuffer& msg)
     }
 }
 
+void Connection::AcknowledgeControls(unsigned char timeStamp)
+{
+    // Scene updates may arrive out of order, so only move the acknowledgement forward
+    if (!IsTimeStampNewer(timeStamp, ackedTimeStamp_))
+        return;
+
+    ackedTimeStamp_ = timeStamp;
+
+    unsigned numAcked = 0;
+    while (numAcked < sentControls_.Size() && !IsTimeStampNewer(sentControls_[numAcked].timeStamp_, ackedTimeStamp_))
+        ++numAcked;
+    if (numAcked)
+        sentControls_.Erase(0, numAcked);
+}
+
 kNet::MessageConnection* Connection::GetMessageConnection() const
 {
     return const_cast<kNet::MessageConnection*>(connection_.ptr());
@@ -1113,15 +1336,14 @@ void Connection::ProcessNode(unsigned nodeID)
     {
         // Replication state found: the node is either be existing or removed
         Node* node = i->second_.node_;
-        if (!node)
+        if (node && !IsNodeRelevant(node))
+            ProcessIrrelevantNode(nodeID, i->second_);
+        else if (!node)
         {
-            msg_.Clear();
-            msg_.WriteNetID(nodeID);
-
             // Note: we will send MSG_REMOVENODE redundantly for each node in the hierarchy, even if removing the root node
             // would be enough. However, this may be better due to the client not possibly having updated parenting
             // information at the time of receiving this message
-            SendMessage(MSG_REMOVENODE, true, true, msg_);
+            QueueReplicationMessage(MSG_REMOVENODE, nodeID, 0);
             sceneState_.nodeStates_.Erase(nodeID);
         }
         else
@@ -1131,11 +1353,12 @@ void Connection::ProcessNode(unsigned nodeID)
     {
         // Replication state not found: this is a new node
         Node* node = scene_->GetNode(nodeID);
-        if (node)
+        if (node && IsNodeRelevant(node))
             ProcessNewNode(node);
         else
         {
-            // Did not find the new node (may have been created, then removed immediately): erase from dirty set.
+            // Did not find the new node (may have been created, then removed immediately), or it is outside the interest
+            // area: erase from dirty set. It will be marked dirty again when entering the area
             sceneState_.dirtyNodes_.Erase(nodeID);
         }
     }
@@ -1152,29 +1375,13 @@ void Connection::ProcessNewNode(Node* node)
             ProcessNode(nodeID);
     }
 
-    msg_.Clear();
-    msg_.WriteNetID(node->GetID());
-
     NodeReplicationState& nodeState = sceneState_.nodeStates_[node->GetID()];
     nodeState.connection_ = this;
     nodeState.sceneState_ = &sceneState_;
     nodeState.node_ = node;
     node->AddReplicationState(&nodeState);
 
-    // Write node's attributes
-    node->WriteInitialDeltaUpdate(msg_, timeStamp_);
-
-    // Write node's user variables
-    const VariantMap& vars = node->GetVars();
-    msg_.WriteVLE(vars.Size());
-    for (VariantMap::ConstIterator i = vars.Begin(); i != vars.End(); ++i)
-    {
-        msg_.WriteStringHash(i->first_);
-        msg_.WriteVariant(i->second_);
-    }
-
-    // Write node's components
-    msg_.WriteVLE(node->GetNumNetworkComponents());
+    // Create the replication states of the node's components. The components are written when the message is encoded
     const Vector<SharedPtr<Component> >& components = node->GetComponents();
     for (unsigned i = 0; i < components.Size(); ++i)
     {
@@ -1188,13 +1395,9 @@ void Connection::ProcessNewNode(Node* node)
         componentState.nodeState_ = &nodeState;
         componentState.component_ = component;
         component->AddReplicationState(&componentState);
-
-        msg_.WriteStringHash(component->GetType());
-        msg_.WriteNetID(component->GetID());
-        component->WriteInitialDeltaUpdate(msg_, timeStamp_);
     }
 
-    SendMessage(MSG_CREATENODE, true, true, msg_);
+    QueueReplicationMessage(MSG_CREATENODE, node->GetID(), node);
 
     nodeState.markedDirty_ = false;
     sceneState_.dirtyNodes_.Erase(node->GetID());
@@ -1239,45 +1442,16 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
 
         // Send latestdata message if necessary
         if (hasLatestData)
-        {
-            msg_.Clear();
-            msg_.WriteNetID(node->GetID());
-            node->WriteLatestDataUpdate(msg_, timeStamp_);
-
-            SendMessage(MSG_NODELATESTDATA, true, false, msg_, node->GetID());
-        }
+            QueueReplicationMessage(MSG_NODELATESTDATA, node->GetID(), node);
 
-        // Send deltaupdate if remaining dirty bits, or vars have changed
+        // Send deltaupdate if remaining dirty bits, or vars have changed. The dirty vars are cleared once encoded
         if (nodeState.dirtyAttributes_.Count() || nodeState.dirtyVars_.Size())
         {
-            msg_.Clear();
-            msg_.WriteNetID(node->GetID());
-            node->WriteDeltaUpdate(msg_, nodeState.dirtyAttributes_, timeStamp_);
-
-            // Write changed variables
-            msg_.WriteVLE(nodeState.dirtyVars_.Size());
-            const VariantMap& vars = node->GetVars();
-            for (HashSet<StringHash>::ConstIterator i = nodeState.dirtyVars_.Begin(); i != nodeState.dirtyVars_.End(); ++i)
-            {
-                VariantMap::ConstIterator j = vars.Find(*i);
-                if (j != vars.End())
-                {
-                    msg_.WriteStringHash(j->first_);
-                    msg_.WriteVariant(j->second_);
-                }
-                else
-                {
-                    // Variable has been marked dirty, but is removed (which is unsupported): send a dummy variable in place
-                    URHO3D_LOGWARNING("Sending dummy user variable as original value was removed");
-                    msg_.WriteStringHash(StringHash());
-                    msg_.WriteVariant(Variant::EMPTY);
-                }
-            }
-
-            SendMessage(MSG_NODEDELTAUPDATE, true, true, msg_);
+            ReplicationMessage& message = QueueReplicationMessage(MSG_NODEDELTAUPDATE, node->GetID(), node);
+            message.nodeState_ = &nodeState;
+            message.dirtyAttributes_ = nodeState.dirtyAttributes_;
 
             nodeState.dirtyAttributes_.ClearAll();
-            nodeState.dirtyVars_.Clear();
         }
     }
 
@@ -1291,10 +1465,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
         if (!component)
         {
             // Removed component
-            msg_.Clear();
-            msg_.WriteNetID(current->first_);
-
-            SendMessage(MSG_REMOVECOMPONENT, true, true, msg_);
+            QueueReplicationMessage(MSG_REMOVECOMPONENT, current->first_, 0);
             nodeState.componentStates_.Erase(current);
         }
         else
@@ -1317,22 +1488,13 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
 
                 // Send latestdata message if necessary
                 if (hasLatestData)
-                {
-                    msg_.Clear();
-                    msg_.WriteNetID(component->GetID());
-                    component->WriteLatestDataUpdate(msg_, timeStamp_);
-
-                    SendMessage(MSG_COMPONENTLATESTDATA, true, false, msg_, component->GetID());
-                }
+                    QueueReplicationMessage(MSG_COMPONENTLATESTDATA, component->GetID(), component);
 
                 // Send deltaupdate if remaining dirty bits
                 if (componentState.dirtyAttributes_.Count())
                 {
-                    msg_.Clear();
-                    msg_.WriteNetID(component->GetID());
-                    component->WriteDeltaUpdate(msg_, componentState.dirtyAttributes_, timeStamp_);
-
-                    SendMessage(MSG_COMPONENTDELTAUPDATE, true, true, msg_);
+                    ReplicationMessage& message = QueueReplicationMessage(MSG_COMPONENTDELTAUPDATE, component->GetID(), component);
+                    message.dirtyAttributes_ = componentState.dirtyAttributes_;
 
                     componentState.dirtyAttributes_.ClearAll();
                 }
@@ -1361,13 +1523,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 componentState.component_ = component;
                 component->AddReplicationState(&componentState);
 
-                msg_.Clear();
-                msg_.WriteNetID(node->GetID());
-                msg_.WriteStringHash(component->GetType());
-                msg_.WriteNetID(component->GetID());
-                component->WriteInitialDeltaUpdate(msg_, timeStamp_);
-
-                SendMessage(MSG_CREATECOMPONENT, true, true, msg_);
+                QueueReplicationMessage(MSG_CREATECOMPONENT, node->GetID(), component);
             }
         }
     }
@@ -1376,6 +1532,271 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
     sceneState_.dirtyNodes_.Erase(node->GetID());
 }
 
+void Connection::ProcessIrrelevantNode(unsigned nodeID, NodeReplicationState& nodeState)
+{
+    // Remove the node from the client and stop tracking it, as if it had not been received yet
+    QueueReplicationMessage(MSG_REMOVENODE, nodeID, 0);
+
+    for (HashMap<unsigned, ComponentReplicationState>::Iterator i = nodeState.componentStates_.Begin();
+         i != nodeState.componentStates_.End(); ++i)
+    {
+        Component* component = i->second_.component_;
+        if (component)
+            component->RemoveReplicationState(&i->second_);
+    }
+
+    nodeState.node_->RemoveReplicationState(&nodeState);
+    sceneState_.nodeStates_.Erase(nodeID);
+    sceneState_.dirtyNodes_.Erase(nodeID);
+}
+
+bool Connection::IsNodeRelevant(Node* node) const
+{
+    if (interestRadius_ <= 0.0f || !node)
+        return true;
+
+    // Relevance is decided by the root-level ancestor, so that hierarchies are always replicated whole
+    Node* root = node;
+    while (root->GetParent() && root->GetParent() != scene_)
+    {
+        if (root->GetOwner() == this)
+            return true;
+        root = root->GetParent();
+    }
+
+    // The scene itself is always relevant
+    if (!root->GetParent())
+        return true;
+
+    return root->GetOwner() == this || relevantNodes_.Contains(root->GetID());
+}
+
+void Connection::UpdateInterest(const InterestGrid* grid)
+{
+    const Vector<SharedPtr<Node> >& children = scene_->GetChildren();
+
+    if (interestRadius_ <= 0.0f)
+    {
+        // Interest management was disabled: send the nodes that were outside the area
+        if (interestActive_)
+        {
+            for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+            {
+                if (!relevantNodes_.Contains((*i)->GetID()))
+                    MarkHierarchyDirty(*i);
+            }
+
+            relevantNodes_.Clear();
+            interestActive_ = false;
+        }
+        return;
+    }
+
+    // Nodes enter the area within the interest radius, but are only removed once they move beyond the larger exit radius, so
+    // that nodes moving around the edge are not removed and recreated on the client over and over
+    float exitRadius = interestRadius_ * interestExitFactor_;
+    interestNodes_.Clear();
+    if (grid && grid->GetScene() == scene_)
+        grid->GetNodes(interestNodes_, position_, exitRadius);
+    else
+    {
+        float exitRadiusSquared = exitRadius * exitRadius;
+        for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+        {
+            if (((*i)->GetWorldPosition() - position_).LengthSquared() <= exitRadiusSquared)
+                interestNodes_.Push(*i);
+        }
+    }
+
+    float radiusSquared = interestRadius_ * interestRadius_;
+    newRelevantNodes_.Clear();
+    unsigned numInterestNodes = 0;
+    for (unsigned i = 0; i < interestNodes_.Size(); ++i)
+    {
+        Node* node = interestNodes_[i];
+        if ((interestActive_ && relevantNodes_.Contains(node->GetID())) || (node->GetWorldPosition() -
+            position_).LengthSquared() <= radiusSquared)
+        {
+            newRelevantNodes_.Insert(node->GetID());
+            interestNodes_[numInterestNodes++] = node;
+        }
+    }
+    interestNodes_.Resize(numInterestNodes);
+
+    if (interestActive_)
+    {
+        // Nodes leaving the area get removed, and nodes entering it get created
+        for (HashSet<unsigned>::ConstIterator i = relevantNodes_.Begin(); i != relevantNodes_.End(); ++i)
+        {
+            if (!newRelevantNodes_.Contains(*i))
+                MarkHierarchyDirty(scene_->GetNode(*i));
+        }
+        for (PODVector<Node*>::ConstIterator i = interestNodes_.Begin(); i != interestNodes_.End(); ++i)
+        {
+            if (!relevantNodes_.Contains((*i)->GetID()))
+                MarkHierarchyDirty(*i);
+        }
+    }
+    else
+    {
+        // Interest management was enabled: check all nodes the client may have received
+        for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+            MarkHierarchyDirty(*i);
+        interestActive_ = true;
+    }
+
+    relevantNodes_.Swap(newRelevantNodes_);
+}
+
+void Connection::MarkHierarchyDirty(Node* node)
+{
+    if (!node)
+        return;
+
+    if (node->GetID() < FIRST_LOCAL_ID)
+        sceneState_.dirtyNodes_.Insert(node->GetID());
+
+    PODVector<Node*> children;
+    node->GetChildren(children, true);
+    for (PODVector<Node*>::ConstIterator i = children.Begin(); i != children.End(); ++i)
+    {
+        if ((*i)->GetID() < FIRST_LOCAL_ID)
+            sceneState_.dirtyNodes_.Insert((*i)->GetID());
+    }
+}
+
+ReplicationMessage& Connection::QueueReplicationMessage(int msgID, unsigned id, Serializable* serializable)
+{
+    replicationMessages_.Resize(replicationMessages_.Size() + 1);
+    ReplicationMessage& message = replicationMessages_.Back();
+    message.msgID_ = msgID;
+    message.id_ = id;
+    message.serializable_ = serializable;
+    message.nodeState_ = 0;
+    message.dirtyAttributes_.ClearAll();
+    message.sharedIndex_ = M_MAX_UNSIGNED;
+    message.dataStart_ = 0;
+    message.dataSize_ = 0;
+    return message;
+}
+
+void Connection::EncodeReplicationMessage(const ReplicationMessage& message, const ReplicationUpdateCache* cache)
+{
+    // Only the attribute values copied by the scene's network update preparation and the node user variables are read
+    // here, so that the messages of different connections can be encoded in parallel
+    VectorBuffer& dest = replicationData_;
+
+    switch (message.msgID_)
+    {
+    case MSG_CREATENODE:
+        {
+            Node* node = static_cast<Node*>(message.serializable_);
+            dest.WriteNetID(message.id_);
+
+            // Write node's attributes
+            node->WriteInitialDeltaUpdate(dest, timeStamp_);
+
+            // Write node's user variables
+            const VariantMap& vars = node->GetVars();
+            dest.WriteVLE(vars.Size());
+            for (VariantMap::ConstIterator i = vars.Begin(); i != vars.End(); ++i)
+            {
+                dest.WriteStringHash(i->first_);
+                dest.WriteVariant(i->second_);
+            }
+
+            // Write node's components
+            dest.WriteVLE(node->GetNumNetworkComponents());
+            const Vector<SharedPtr<Component> >& components = node->GetComponents();
+            for (unsigned i = 0; i < components.Size(); ++i)
+            {
+                Component* component = components[i];
+                // Check if component is not to be replicated
+                if (component->GetID() >= FIRST_LOCAL_ID)
+                    continue;
+
+                dest.WriteStringHash(component->GetType());
+                dest.WriteNetID(component->GetID());
+                component->WriteInitialDeltaUpdate(dest, timeStamp_);
+            }
+        }
+        break;
+
+    case MSG_NODEDELTAUPDATE:
+        {
+            Node* node = static_cast<Node*>(message.serializable_);
+            HashSet<StringHash>& dirtyVars = message.nodeState_->dirtyVars_;
+            dest.WriteNetID(message.id_);
+            WriteAttributeUpdate(message, cache);
+
+            // Write changed variables
+            dest.WriteVLE(dirtyVars.Size());
+            const VariantMap& vars = node->GetVars();
+            for (HashSet<StringHash>::ConstIterator i = dirtyVars.Begin(); i != dirtyVars.End(); ++i)
+            {
+                VariantMap::ConstIterator j = vars.Find(*i);
+                if (j != vars.End())
+                {
+                    dest.WriteStringHash(j->first_);
+                    dest.WriteVariant(j->second_);
+                }
+                else
+                {
+                    // Variable has been marked dirty, but is removed (which is unsupported): send a dummy variable in place
+                    URHO3D_LOGWARNING("Sending dummy user variable as original value was removed");
+                    dest.WriteStringHash(StringHash());
+                    dest.WriteVariant(Variant::EMPTY);
+                }
+            }
+
+            dirtyVars.Clear();
+        }
+        break;
+
+    case MSG_COMPONENTDELTAUPDATE:
+    case MSG_NODELATESTDATA:
+    case MSG_COMPONENTLATESTDATA:
+        dest.WriteNetID(message.id_);
+        WriteAttributeUpdate(message, cache);
+        break;
+
+    case MSG_CREATECOMPONENT:
+        {
+            Component* component = static_cast<Component*>(message.serializable_);
+            dest.WriteNetID(message.id_);
+            dest.WriteStringHash(component->GetType());
+            dest.WriteNetID(component->GetID());
+            component->WriteInitialDeltaUpdate(dest, timeStamp_);
+        }
+        break;
+
+    default:
+        // Removal messages only contain the ID
+        dest.WriteNetID(message.id_);
+        break;
+    }
+}
+
+void Connection::WriteAttributeUpdate(const ReplicationMessage& message, const ReplicationUpdateCache* cache)
+{
+    VectorBuffer& dest = replicationData_;
+
+    if (cache && message.sharedIndex_ != M_MAX_UNSIGNED && cache->IsShared(message.sharedIndex_))
+    {
+        // The shared update was encoded with a placeholder timestamp, as the timestamp differs per connection
+        const VectorBuffer& data = cache->GetData(message.sharedIndex_);
+        if (data.GetSize())
+        {
+            dest.WriteUByte(timeStamp_);
+            dest.Write(data.GetData() + 1, data.GetSize() - 1);
+        }
+    }
+    else if (message.msgID_ == MSG_NODELATESTDATA || message.msgID_ == MSG_COMPONENTLATESTDATA)
+        message.serializable_->WriteLatestDataUpdate(dest, timeStamp_);
+    else
+        message.serializable_->WriteDeltaUpdate(dest, message.dirtyAttributes_, timeStamp_);
+}
+
 bool Connection::RequestNeededPackages(unsigned numPackages, MemoryBuffer& msg)
 {
     ResourceCache* cache = GetSubsystem<ResourceCache>();
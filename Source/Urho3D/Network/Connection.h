@@ -40,11 +40,16 @@ namespace Urho3D
 {
 
 class File;
+class InterestGrid;
 class MemoryBuffer;
 class Node;
 class Scene;
 class Serializable;
 class PackageFile;
+class WorkQueue;
+
+/// Default factor of the interest radius that nodes within the interest area must move beyond before they are removed from the client.
+static const float DEFAULT_INTEREST_EXIT_FACTOR = 1.1f;
 
 /// Queued remote event.
 struct RemoteEvent
@@ -93,6 +98,123 @@ struct PackageUpload
     unsigned totalFragments_;
 };
 
+/// Controls sent to the server, kept for client-side prediction until acknowledged.
+struct SentControls
+{
+    /// Controls timestamp.
+    unsigned char timeStamp_;
+    /// Controls.
+    Controls controls_;
+};
+
+/// Scene replication message queued for encoding.
+struct ReplicationMessage
+{
+    /// Message ID.
+    int msgID_;
+    /// Node or component ID.
+    unsigned id_;
+    /// Node or component to encode, or null for a removal message.
+    Serializable* serializable_;
+    /// Node replication state for writing the changed user variables of a node delta update.
+    NodeReplicationState* nodeState_;
+    /// Attributes to write in a delta update.
+    DirtyBits dirtyAttributes_;
+    /// Index of the shared encoded attribute update, or M_MAX_UNSIGNED if not shared.
+    unsigned sharedIndex_;
+    /// Start of the encoded message data.
+    unsigned dataStart_;
+    /// Size of the encoded message data.
+    unsigned dataSize_;
+};
+
+/// Key of a shared attribute update.
+struct SharedReplicationKey
+{
+    /// Construct undefined.
+    SharedReplicationKey()
+    {
+    }
+
+    /// Construct with values.
+    SharedReplicationKey(int msgID, Serializable* serializable, const DirtyBits& dirtyAttributes) :
+        msgID_(msgID),
+        serializable_(serializable),
+        dirtyAttributes_(dirtyAttributes)
+    {
+    }
+
+    /// Test for equality with another key.
+    bool operator ==(const SharedReplicationKey& rhs) const
+    {
+        return msgID_ == rhs.msgID_ && serializable_ == rhs.serializable_ &&
+               !memcmp(dirtyAttributes_.data_, rhs.dirtyAttributes_.data_, MAX_NETWORK_ATTRIBUTES / 8);
+    }
+
+    /// Return hash value for HashSet & HashMap.
+    unsigned ToHash() const
+    {
+        unsigned hash = MakeHash((void*)serializable_) * 31 + (unsigned)msgID_;
+        for (unsigned i = 0; i < MAX_NETWORK_ATTRIBUTES / 8; ++i)
+            hash = hash * 31 + dirtyAttributes_.data_[i];
+        return hash;
+    }
+
+    /// Message ID.
+    int msgID_;
+    /// Node or component.
+    Serializable* serializable_;
+    /// Attributes to write in a delta update.
+    DirtyBits dirtyAttributes_;
+};
+
+/// Attribute update encoded once per network update and shared by all connections sending it.
+struct SharedReplicationUpdate
+{
+    /// Key identifying the update.
+    SharedReplicationKey key_;
+    /// Number of connections sending the update.
+    unsigned numConnections_;
+    /// Encoded attribute data following the timestamp. Only encoded if more than one connection sends the update.
+    VectorBuffer data_;
+};
+
+/// Cache of attribute updates shared between connections during one network update.
+class URHO3D_API ReplicationUpdateCache
+{
+public:
+    /// Construct.
+    ReplicationUpdateCache();
+
+    /// Remove all updates.
+    void Clear();
+    /// Return the index of an update, adding it if not yet cached. Called by Connection.
+    unsigned Add(int msgID, Serializable* serializable, const DirtyBits& dirtyAttributes);
+    /// Encode the updates sent by more than one connection, in worker threads if a work queue is given.
+    void Encode(WorkQueue* queue);
+
+    /// Return number of updates.
+    unsigned GetNumUpdates() const { return numUpdates_; }
+    /// Return number of updates sent by more than one connection.
+    unsigned GetNumSharedUpdates() const { return sharedUpdates_.Size(); }
+
+    /// Return whether an update is sent by more than one connection and has been encoded.
+    bool IsShared(unsigned index) const { return updates_[index].numConnections_ > 1; }
+
+    /// Return an encoded update.
+    const VectorBuffer& GetData(unsigned index) const { return updates_[index].data_; }
+
+private:
+    /// Update indices by key.
+    HashMap<SharedReplicationKey, unsigned> indices_;
+    /// Updates. Kept allocated between network updates to reuse the buffers.
+    Vector<SharedReplicationUpdate> updates_;
+    /// Updates sent by more than one connection.
+    PODVector<SharedReplicationUpdate*> sharedUpdates_;
+    /// Number of updates in use.
+    unsigned numUpdates_;
+};
+
 /// Send modes for observer position/rotation. Activated by the client setting either position or rotation.
 enum ObserverPositionSendMode
 {
@@ -130,6 +252,10 @@ public:
     void SetPosition(const Vector3& position);
     /// Set the observer rotation for interest management, to be sent to the server. Note: not used by the NetworkPriority component.
     void SetRotation(const Quaternion& rotation);
+    /// Set the interest radius around the observer position. Root-level nodes farther away are not replicated to the client along with their children, and are removed from the client when they leave the area. Default 0 (replicate all nodes.)
+    void SetInterestRadius(float radius);
+    /// Set the factor of the interest radius that root-level nodes within the interest area must move beyond before they are removed from the client. Keeps nodes near the edge from being removed and recreated repeatedly. Clamped to at least 1. Default 1.1.
+    void SetInterestExitFactor(float factor);
     /// Set the connection pending status. Called by Network.
     void SetConnectPending(bool connectPending);
     /// Set whether to log data in/out statistics.
@@ -138,6 +264,14 @@ public:
     void Disconnect(int waitMSec = 0);
     /// Send scene update messages. Called by Network.
     void SendServerUpdate();
+    /// Process the dirty scene nodes and queue the scene update messages. Uses the interest grid of the scene if given. Called by Network.
+    void CollectServerUpdate(const InterestGrid* grid = 0);
+    /// Add the queued attribute updates to a cache shared with other connections. Called by Network.
+    void ShareServerUpdate(ReplicationUpdateCache& cache);
+    /// Encode the queued scene update messages, copying attribute updates shared with other connections from the cache if given. Can be called from a worker thread. Called by Network.
+    void EncodeServerUpdate(const ReplicationUpdateCache* cache = 0);
+    /// Send the encoded scene update messages. Called by Network.
+    void FlushServerUpdate();
     /// Send latest controls from the client. Called by Network.
     void SendClientUpdate();
     /// Send queued remote events. Called by Network.
@@ -148,6 +282,8 @@ public:
     void ProcessPendingLatestData();
     /// Process a message from the server or client. Called by Network.
     bool ProcessMessage(int msgID, MemoryBuffer& msg);
+    /// Send an E_CONTROLSREPLAY event for each sent controls newer than the timestamp, oldest first, for re-simulating client-side prediction from an authoritative server state. Return number of controls replayed.
+    unsigned ReplayControls(unsigned char timeStamp);
 
     /// Return the kNet message connection.
     kNet::MessageConnection* GetMessageConnection() const;
@@ -164,12 +300,26 @@ public:
     /// Return the controls timestamp, sent from client to server along each control update.
     unsigned char GetTimeStamp() const { return timeStamp_; }
 
+    /// Return the latest controls timestamp acknowledged by the server in scene updates.
+    unsigned char GetAckedTimeStamp() const { return ackedTimeStamp_; }
+
+    /// Return number of sent controls not yet acknowledged by the server.
+    unsigned GetNumPendingControls() const { return sentControls_.Size(); }
+
     /// Return the observer position sent by the client for interest management.
     const Vector3& GetPosition() const { return position_; }
 
     /// Return the observer rotation sent by the client for interest management.
     const Quaternion& GetRotation() const { return rotation_; }
 
+    /// Return the interest radius around the observer position.
+    float GetInterestRadius() const { return interestRadius_; }
+    /// Return the factor of the interest radius beyond which nodes are removed from the client.
+    float GetInterestExitFactor() const { return interestExitFactor_; }
+
+    /// Return whether a node is within the interest area of the client, or is owned by it. Always true when interest radius is zero.
+    bool IsNodeRelevant(Node* node) const;
+
     /// Return whether is a client connection.
     bool IsClient() const { return isClient_; }
 
@@ -249,12 +399,26 @@ private:
     void ProcessSceneLoaded(int msgID, MemoryBuffer& msg);
     /// Process a remote event message from the client or server. Called by Network.
     void ProcessRemoteEvent(int msgID, MemoryBuffer& msg);
+    /// Acknowledge sent controls by the timestamp of a scene update from the server.
+    void AcknowledgeControls(unsigned char timeStamp);
     /// Process a node for sending a network update. Recurses to process depended on node(s) first.
     void ProcessNode(unsigned nodeID);
     /// Process a node that the client has not yet received.
     void ProcessNewNode(Node* node);
     /// Process a node that the client has already received.
     void ProcessExistingNode(Node* node, NodeReplicationState& nodeState);
+    /// Process a node that the client has received, but is no longer relevant to it.
+    void ProcessIrrelevantNode(unsigned nodeID, NodeReplicationState& nodeState);
+    /// Update the root-level nodes within the interest area and mark the nodes entering or leaving it dirty.
+    void UpdateInterest(const InterestGrid* grid);
+    /// Mark a node and its replicated children dirty.
+    void MarkHierarchyDirty(Node* node);
+    /// Queue a scene update message for encoding and return it.
+    ReplicationMessage& QueueReplicationMessage(int msgID, unsigned id, Serializable* serializable);
+    /// Encode a queued scene update message.
+    void EncodeReplicationMessage(const ReplicationMessage& message, const ReplicationUpdateCache* cache);
+    /// Write the attribute update of a queued scene update message, copying it from the cache if shared.
+    void WriteAttributeUpdate(const ReplicationMessage& message, const ReplicationUpdateCache* cache);
     /// Process a SyncPackagesInfo message from server.
     void ProcessPackageInfo(int msgID, MemoryBuffer& msg);
     /// Check a package list received from server and initiate package downloads as necessary. Return true on success, or false if failed to initialze downloads (cache dir not set)
@@ -286,10 +450,22 @@ private:
     HashMap<unsigned, PODVector<unsigned char> > componentLatestData_;
     /// Node ID's to process during a replication update.
     HashSet<unsigned> nodesToProcess_;
+    /// IDs of the root-level nodes within the interest area.
+    HashSet<unsigned> relevantNodes_;
+    /// IDs of the root-level nodes within the interest area during the update.
+    HashSet<unsigned> newRelevantNodes_;
+    /// Root-level nodes within the interest area during the update.
+    PODVector<Node*> interestNodes_;
     /// Reusable message buffer.
     VectorBuffer msg_;
+    /// Scene update messages queued for encoding.
+    PODVector<ReplicationMessage> replicationMessages_;
+    /// Encoded scene update message data.
+    VectorBuffer replicationData_;
     /// Queued remote events.
     Vector<RemoteEvent> remoteEvents_;
+    /// Sent controls not yet acknowledged by the server, oldest first.
+    Vector<SentControls> sentControls_;
     /// Scene file to load once all packages (if any) have been downloaded.
     String sceneFileName_;
     /// Statistics timer.
@@ -304,6 +480,14 @@ private:
     Quaternion rotation_;
     /// Send mode for the observer position & rotation.
     ObserverPositionSendMode sendMode_;
+    /// Latest controls timestamp acknowledged by the server.
+    unsigned char ackedTimeStamp_;
+    /// Interest radius.
+    float interestRadius_;
+    /// Factor of the interest radius beyond which nodes are removed.
+    float interestExitFactor_;
+    /// Interest management active flag.
+    bool interestActive_;
     /// Client connection flag.
     bool isClient_;
     /// Connection pending flag.
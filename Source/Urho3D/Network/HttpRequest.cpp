@@ -22,9 +22,11 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/Object.h"
 #include "../Core/Profiler.h"
 #include "../IO/Log.h"
 #include "../Network/HttpRequest.h"
+#include "../Network/NetworkEvents.h"
 
 #include <Civetweb/civetweb.h>
 
@@ -36,11 +38,13 @@ namespace Urho3D
 static const unsigned ERROR_BUFFER_SIZE = 256;
 static const unsigned READ_BUFFER_SIZE = 65536; // Must be a power of two
 
-HttpRequest::HttpRequest(const String& url, const String& verb, const Vector<String>& headers, const String& postData) :
+HttpRequest::HttpRequest(const String& url, const String& verb, const Vector<String>& headers, const String& postData,
+    Object* notifier) :
     url_(url.Trimmed()),
     verb_(!verb.Empty() ? verb : "GET"),
     headers_(headers),
     postData_(postData),
+    notifier_(notifier),
     state_(HTTP_INITIALIZING),
     httpReadBuffer_(new unsigned char[READ_BUFFER_SIZE]),
     readBuffer_(new unsigned char[READ_BUFFER_SIZE]),
@@ -134,14 +138,15 @@ void HttpRequest::ThreadFunction()
         MutexLock lock(mutex_);
         state_ = connection ? HTTP_OPEN : HTTP_ERROR;
 
-        // If no connection could be made, store the error and exit
+        // If no connection could be made, store the error
         if (state_ == HTTP_ERROR)
-        {
             error_ = String(&errorBuffer[0]);
-            return;
-        }
     }
 
+    PostStateChanged(connection ? HTTP_OPEN : HTTP_ERROR);
+    if (!connection)
+        return;
+
     // Loop while should run, read data from the connection, copy to the main thread buffer if there is space
     while (shouldRun_)
     {
@@ -194,6 +199,8 @@ void HttpRequest::ThreadFunction()
         MutexLock lock(mutex_);
         state_ = HTTP_CLOSED;
     }
+
+    PostStateChanged(HTTP_CLOSED);
 }
 
 unsigned HttpRequest::Read(void* dest, unsigned size)
@@ -290,4 +297,19 @@ unsigned HttpRequest::CheckEofAndAvailableSize()
     return bytesAvailable;
 }
 
+void HttpRequest::PostStateChanged(HttpRequestState state)
+{
+    if (!notifier_)
+        return;
+
+    using namespace HttpRequestStateChanged;
+
+    // The request is passed as a void pointer, as RefCounted pointers can not be stored in a Variant outside the main thread
+    VariantMap eventData;
+    eventData[P_REQUEST] = (void*)this;
+    eventData[P_URL] = url_;
+    eventData[P_STATE] = (int)state;
+    notifier_->PostEvent(E_HTTPREQUESTSTATECHANGED, eventData);
+}
+
 }
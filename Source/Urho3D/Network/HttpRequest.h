@@ -31,6 +31,8 @@
 namespace Urho3D
 {
 
+class Object;
+
 /// HTTP connection state
 enum HttpRequestState
 {
@@ -44,8 +46,8 @@ enum HttpRequestState
 class URHO3D_API HttpRequest : public RefCounted, public Deserializer, public Thread
 {
 public:
-    /// Construct with parameters.
-    HttpRequest(const String& url, const String& verb, const Vector<String>& headers, const String& postData);
+    /// Construct with parameters. If a notifier object is given, it posts E_HTTPREQUESTSTATECHANGED from the worker thread on state changes and must outlive the request.
+    HttpRequest(const String& url, const String& verb, const Vector<String>& headers, const String& postData, Object* notifier = 0);
     /// Destruct. Release the connection object.
     ~HttpRequest();
 
@@ -76,6 +78,8 @@ public:
 private:
     /// Check for end of the data stream and return available size in buffer. Must only be called when the mutex is held by the main thread.
     unsigned CheckEofAndAvailableSize();
+    /// Post the state changed event through the notifier. Called from the worker thread.
+    void PostStateChanged(HttpRequestState state);
 
     /// URL.
     String url_;
@@ -87,6 +91,8 @@ private:
     Vector<String> headers_;
     /// POST data.
     String postData_;
+    /// Object to post state changes through.
+    Object* notifier_;
     /// Connection state.
     HttpRequestState state_;
     /// Mutex for synchronizing the worker and the main thread.
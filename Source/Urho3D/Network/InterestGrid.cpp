@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Network/InterestGrid.h"
+#include "../Scene/Scene.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Cell coordinates are clamped to 21 bits per axis to fit the cell key.
+static const int MAX_CELL_COORDINATE = (1 << 20) - 1;
+
+InterestGrid::InterestGrid() :
+    scene_(0),
+    cellSize_(1.0f)
+{
+}
+
+void InterestGrid::Build(Scene* scene, float cellSize)
+{
+    Clear();
+
+    scene_ = scene;
+    cellSize_ = Max(cellSize, M_EPSILON);
+    if (!scene_)
+        return;
+
+    const Vector<SharedPtr<Node> >& children = scene_->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+    {
+        InterestGridEntry entry;
+        entry.node_ = *i;
+        entry.position_ = entry.node_->GetWorldPosition();
+
+        int x, y, z;
+        GetCellCoordinates(entry.position_, x, y, z);
+        cells_[GetCellKey(x, y, z)].Push(entry);
+    }
+}
+
+void InterestGrid::Clear()
+{
+    cells_.Clear();
+    scene_ = 0;
+}
+
+void InterestGrid::GetNodes(PODVector<Node*>& dest, const Vector3& position, float radius) const
+{
+    float radiusSquared = radius * radius;
+
+    int minX, minY, minZ, maxX, maxY, maxZ;
+    GetCellCoordinates(position - Vector3(radius, radius, radius), minX, minY, minZ);
+    GetCellCoordinates(position + Vector3(radius, radius, radius), maxX, maxY, maxZ);
+
+    unsigned long long numCells = (unsigned long long)(maxX - minX + 1) * (maxY - minY + 1) * (maxZ - minZ + 1);
+    if (numCells > cells_.Size())
+    {
+        // The area covers more cells than are occupied: check the occupied cells instead
+        for (HashMap<unsigned long long, PODVector<InterestGridEntry> >::ConstIterator i = cells_.Begin(); i != cells_.End(); ++i)
+        {
+            const PODVector<InterestGridEntry>& entries = i->second_;
+            for (PODVector<InterestGridEntry>::ConstIterator j = entries.Begin(); j != entries.End(); ++j)
+            {
+                if ((j->position_ - position).LengthSquared() <= radiusSquared)
+                    dest.Push(j->node_);
+            }
+        }
+        return;
+    }
+
+    for (int z = minZ; z <= maxZ; ++z)
+    {
+        for (int y = minY; y <= maxY; ++y)
+        {
+            for (int x = minX; x <= maxX; ++x)
+            {
+                HashMap<unsigned long long, PODVector<InterestGridEntry> >::ConstIterator i = cells_.Find(GetCellKey(x, y, z));
+                if (i == cells_.End())
+                    continue;
+
+                const PODVector<InterestGridEntry>& entries = i->second_;
+                for (PODVector<InterestGridEntry>::ConstIterator j = entries.Begin(); j != entries.End(); ++j)
+                {
+                    if ((j->position_ - position).LengthSquared() <= radiusSquared)
+                        dest.Push(j->node_);
+                }
+            }
+        }
+    }
+}
+
+void InterestGrid::GetCellCoordinates(const Vector3& position, int& x, int& y, int& z) const
+{
+    x = (int)Clamp(floorf(position.x_ / cellSize_), (float)-MAX_CELL_COORDINATE, (float)MAX_CELL_COORDINATE);
+    y = (int)Clamp(floorf(position.y_ / cellSize_), (float)-MAX_CELL_COORDINATE, (float)MAX_CELL_COORDINATE);
+    z = (int)Clamp(floorf(position.z_ / cellSize_), (float)-MAX_CELL_COORDINATE, (float)MAX_CELL_COORDINATE);
+}
+
+unsigned long long InterestGrid::GetCellKey(int x, int y, int z) const
+{
+    const unsigned long long mask = (1ULL << 21) - 1;
+    return ((unsigned long long)(x + MAX_CELL_COORDINATE) & mask) | (((unsigned long long)(y + MAX_CELL_COORDINATE) & mask) << 21) |
+           (((unsigned long long)(z + MAX_CELL_COORDINATE) & mask) << 42);
+}
+
+}
@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Math/Vector3.h"
+
+namespace Urho3D
+{
+
+class Node;
+class Scene;
+
+/// Root-level scene node with its world position in an interest grid cell.
+struct InterestGridEntry
+{
+    /// Node.
+    Node* node_;
+    /// World position.
+    Vector3 position_;
+};
+
+/// Spatial grid of the root-level scene nodes for finding the nodes within the interest area of a client connection.
+class URHO3D_API InterestGrid
+{
+public:
+    /// Construct.
+    InterestGrid();
+
+    /// Rebuild from the root-level nodes of a scene with the given cell size.
+    void Build(Scene* scene, float cellSize);
+    /// Remove all nodes.
+    void Clear();
+    /// Return the root-level nodes within a distance of a position.
+    void GetNodes(PODVector<Node*>& dest, const Vector3& position, float radius) const;
+
+    /// Return the scene the grid was built from.
+    Scene* GetScene() const { return scene_; }
+
+    /// Return cell size.
+    float GetCellSize() const { return cellSize_; }
+
+private:
+    /// Return the cell coordinates of a position.
+    void GetCellCoordinates(const Vector3& position, int& x, int& y, int& z) const;
+    /// Return the key of a cell.
+    unsigned long long GetCellKey(int x, int y, int z) const;
+
+    /// Nodes by cell key.
+    HashMap<unsigned long long, PODVector<InterestGridEntry> > cells_;
+    /// Scene.
+    Scene* scene_;
+    /// Cell size.
+    float cellSize_;
+};
+
+}
@@ -24,7 +24,9 @@
 
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/MemoryTracker.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Engine/EngineEvents.h"
 #include "../IO/FileSystem.h"
 #include "../Input/InputEvents.h"
@@ -46,6 +48,7 @@ namespace Urho3D
 {
 
 static const int DEFAULT_UPDATE_FPS = 30;
+static const float DEFAULT_INTEREST_CELL_SIZE = 50.0f;
 
 Network::Network(Context* context) :
     Object(context),
@@ -53,7 +56,9 @@ Network::Network(Context* context) :
     simulatedLatency_(0),
     simulatedPacketLoss_(0.0f),
     updateInterval_(1.0f / (float)DEFAULT_UPDATE_FPS),
-    updateAcc_(0.0f)
+    updateAcc_(0.0f),
+    interestCellSize_(DEFAULT_INTEREST_CELL_SIZE),
+    checkServerState_(false)
 {
     network_ = new kNet::Network();
 
@@ -62,6 +67,7 @@ Network::Network(Context* context) :
 
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(Network, HandleBeginFrame));
     SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(Network, HandleRenderUpdate));
+    SubscribeToEvent(this, E_CONNECTIONSTATECHANGED, URHO3D_HANDLER(Network, HandleConnectionStateChanged));
 
     // Blacklist remote events which are not to be allowed to be registered in any case
     blacklistedRemoteEvents_.Insert(E_CONSOLECOMMAND);
@@ -105,6 +111,7 @@ Network::Network(Context* context) :
     blacklistedRemoteEvents_.Insert(E_NETWORKUPDATE);
     blacklistedRemoteEvents_.Insert(E_NETWORKUPDATESENT);
     blacklistedRemoteEvents_.Insert(E_NETWORKSCENELOADFAILED);
+    blacklistedRemoteEvents_.Insert(E_HTTPREQUESTSTATECHANGED);
 }
 
 Network::~Network()
@@ -131,13 +138,31 @@ void Network::HandleMessage(kNet::MessageConnection* source, kNet::packet_id_t p
             return;
 
         // If message was not handled internally, forward as an event
-        using namespace NetworkMessage;
+        if (connection->HasTypedEventReceivers<NetworkMessageEvent>())
+        {
+            WeakPtr<Connection> connectionWeak(connection);
 
-        VariantMap& eventData = GetEventDataMap();
-        eventData[P_CONNECTION] = connection;
-        eventData[P_MESSAGEID] = (int)msgId;
-        eventData[P_DATA].SetBuffer(msg.GetData(), msg.GetSize());
-        connection->SendEvent(E_NETWORKMESSAGE, eventData);
+            NetworkMessageEvent messageEvent;
+            messageEvent.connection_ = connection;
+            messageEvent.messageId_ = (int)msgId;
+            messageEvent.data_ = msg.GetData();
+            messageEvent.size_ = msg.GetSize();
+            connection->SendTypedEvent(messageEvent);
+
+            if (connectionWeak.Expired())
+                return;
+        }
+
+        if (connection->HasEventReceivers(E_NETWORKMESSAGE))
+        {
+            using namespace NetworkMessage;
+
+            VariantMap& eventData = GetEventDataMap();
+            eventData[P_CONNECTION] = connection;
+            eventData[P_MESSAGEID] = (int)msgId;
+            eventData[P_DATA].SetBuffer(msg.GetData(), msg.GetSize());
+            connection->SendEvent(E_NETWORKMESSAGE, eventData);
+        }
     }
     else
         URHO3D_LOGWARNING("Discarding message from unknown MessageConnection " + ToString((void*)source));
@@ -203,6 +228,12 @@ void Network::ClientDisconnected(kNet::MessageConnection* connection)
     }
 }
 
+void Network::ConnectionStateChanged(kNet::MessageConnection* connection)
+{
+    // Called from the kNet worker thread, so only post an event to check the state in the main thread
+    PostEvent(E_CONNECTIONSTATECHANGED, true);
+}
+
 bool Network::Connect(const String& address, unsigned short port, Scene* scene, const VariantMap& identity)
 {
     URHO3D_PROFILE(Connect);
@@ -222,6 +253,8 @@ bool Network::Connect(const String& address, unsigned short port, Scene* scene,
         serverConnection_->SetIdentity(identity);
         serverConnection_->SetConnectPending(true);
         serverConnection_->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
+        // The state may have changed before the connection was stored
+        checkServerState_ = true;
 
         URHO3D_LOGINFO("Connecting to server " + serverConnection_->ToString());
         return true;
@@ -342,6 +375,11 @@ void Network::SetUpdateFps(int fps)
     updateAcc_ = 0.0f;
 }
 
+void Network::SetInterestCellSize(float size)
+{
+    interestCellSize_ = Max(size, M_EPSILON);
+}
+
 void Network::SetSimulatedLatency(int ms)
 {
     simulatedLatency_ = Max(ms, 0);
@@ -407,7 +445,7 @@ SharedPtr<HttpRequest> Network::MakeHttpRequest(const String& url, const String&
     URHO3D_PROFILE(MakeHttpRequest);
 
     // The initialization of the request will take time, can not know at this point if it has an error or not
-    SharedPtr<HttpRequest> request(new HttpRequest(url, verb, headers, postData));
+    SharedPtr<HttpRequest> request(new HttpRequest(url, verb, headers, postData, this));
     return request;
 }
 
@@ -453,6 +491,7 @@ bool Network::CheckRemoteEvent(StringHash eventType) const
 void Network::Update(float timeStep)
 {
     URHO3D_PROFILE(UpdateNetwork);
+    URHO3D_MEMORY_CATEGORY(MEMCAT_NETWORK);
 
     // Process server connection if it exists
     if (serverConnection_)
@@ -465,14 +504,19 @@ void Network::Update(float timeStep)
         // Process latest data messages waiting for the correct nodes or components to be created
         serverConnection_->ProcessPendingLatestData();
 
-        // Check for state transitions
-        kNet::ConnectionState state = connection->GetConnectionState();
-        if (serverConnection_->IsConnectPending() && state == kNet::ConnectionOK)
-            OnServerConnected();
-        else if (state == kNet::ConnectionPeerClosed)
-            serverConnection_->Disconnect();
-        else if (state == kNet::ConnectionClosed)
-            OnServerDisconnected();
+        // Check for state transitions when kNet has signaled a state change
+        if (checkServerState_)
+        {
+            checkServerState_ = false;
+
+            kNet::ConnectionState state = connection->GetConnectionState();
+            if (serverConnection_->IsConnectPending() && state == kNet::ConnectionOK)
+                OnServerConnected();
+            else if (state == kNet::ConnectionPeerClosed)
+                serverConnection_->Disconnect();
+            else if (state == kNet::ConnectionClosed)
+                OnServerDisconnected();
+        }
     }
 
     // Process the network server if started
@@ -481,9 +525,23 @@ void Network::Update(float timeStep)
         server->Process();
 }
 
+void EncodeServerUpdateWork(const WorkItem* item, unsigned threadIndex)
+{
+    const ReplicationUpdateCache* cache = reinterpret_cast<ReplicationUpdateCache*>(item->aux_);
+    Connection** start = reinterpret_cast<Connection**>(item->start_);
+    Connection** end = reinterpret_cast<Connection**>(item->end_);
+
+    while (start != end)
+    {
+        (*start)->EncodeServerUpdate(cache);
+        ++start;
+    }
+}
+
 void Network::PostUpdate(float timeStep)
 {
     URHO3D_PROFILE(PostUpdateNetwork);
+    URHO3D_MEMORY_CATEGORY(MEMCAT_NETWORK);
 
     // Check if periodic update should happen now
     updateAcc_ += timeStep;
@@ -512,18 +570,63 @@ void Network::PostUpdate(float timeStep)
 
                 for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
                     (*i)->PrepareNetworkUpdate();
+
+                // Build the interest grids of scenes that have connections using interest management
+                interestGrids_.Clear();
+                for (HashMap<kNet::MessageConnection*, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
+                     i != clientConnections_.End(); ++i)
+                {
+                    Scene* scene = i->second_->GetScene();
+                    if (scene && i->second_->GetInterestRadius() > 0.0f && !interestGrids_.Contains(scene))
+                        interestGrids_[scene].Build(scene, interestCellSize_);
+                }
             }
 
             {
                 URHO3D_PROFILE(SendServerUpdate);
 
-                // Then send server updates for each client connection
+                // Then collect server updates for each client connection. Replication states are created and destroyed
+                // only here in the main thread
+                updateConnections_.Clear();
                 for (HashMap<kNet::MessageConnection*, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
                      i != clientConnections_.End(); ++i)
                 {
-                    i->second_->SendServerUpdate();
-                    i->second_->SendRemoteEvents();
-                    i->second_->SendPackages();
+                    HashMap<Scene*, InterestGrid>::ConstIterator j = interestGrids_.Find(i->second_->GetScene());
+                    i->second_->CollectServerUpdate(j != interestGrids_.End() ? &j->second_ : 0);
+                    updateConnections_.Push(i->second_);
+                }
+
+                // Encode the updates in worker threads. The attribute values have been copied by the scene preparation
+                // above and are not modified until the next update
+                WorkQueue* queue = GetSubsystem<WorkQueue>();
+                if (updateConnections_.Size() > 1)
+                {
+                    // Attribute updates sent to several clients are encoded only once and copied into each message
+                    replicationCache_.Clear();
+                    for (unsigned i = 0; i < updateConnections_.Size(); ++i)
+                        updateConnections_[i]->ShareServerUpdate(replicationCache_);
+                    replicationCache_.Encode(queue);
+
+                    if (queue)
+                        queue->ParallelFor(EncodeServerUpdateWork, updateConnections_, &replicationCache_);
+                    else
+                    {
+                        for (unsigned i = 0; i < updateConnections_.Size(); ++i)
+                            updateConnections_[i]->EncodeServerUpdate(&replicationCache_);
+                    }
+                }
+                else
+                {
+                    for (unsigned i = 0; i < updateConnections_.Size(); ++i)
+                        updateConnections_[i]->EncodeServerUpdate();
+                }
+
+                // Finally send the messages in the main thread
+                for (unsigned i = 0; i < updateConnections_.Size(); ++i)
+                {
+                    updateConnections_[i]->FlushServerUpdate();
+                    updateConnections_[i]->SendRemoteEvents();
+                    updateConnections_[i]->SendPackages();
                 }
             }
         }
@@ -554,6 +657,12 @@ void Network::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
     PostUpdate(eventData[P_TIMESTEP].GetFloat());
 }
 
+void Network::HandleConnectionStateChanged(StringHash eventType, VariantMap& eventData)
+{
+    // The state is checked after processing the received messages in Update(), so that no messages are lost on disconnection
+    checkServerState_ = true;
+}
+
 void Network::OnServerConnected()
 {
     serverConnection_->SetConnectPending(false);
@@ -26,6 +26,7 @@
 #include "../Core/Object.h"
 #include "../IO/VectorBuffer.h"
 #include "../Network/Connection.h"
+#include "../Network/InterestGrid.h"
 
 #include <kNet/IMessageHandler.h>
 #include <kNet/INetworkServerListener.h>
@@ -63,6 +64,8 @@ public:
     virtual void NewConnectionEstablished(kNet::MessageConnection* connection);
     /// Handle a client disconnection.
     virtual void ClientDisconnected(kNet::MessageConnection* connection);
+    /// Handle a connection state change. Called from the kNet worker thread.
+    virtual void ConnectionStateChanged(kNet::MessageConnection* connection);
 
     /// Connect to a server using UDP protocol. Return true if connection process successfully started.
     bool Connect(const String& address, unsigned short port, Scene* scene, const VariantMap& identity = Variant::emptyVariantMap);
@@ -87,6 +90,8 @@ public:
         (Node* node, StringHash eventType, bool inOrder, const VariantMap& eventData = Variant::emptyVariantMap);
     /// Set network update FPS.
     void SetUpdateFps(int fps);
+    /// Set the cell size of the spatial grids used for finding the nodes within the interest radius of client connections. Default 50.
+    void SetInterestCellSize(float size);
     /// Set simulated latency in milliseconds. This adds a fixed delay before sending each packet.
     void SetSimulatedLatency(int ms);
     /// Set simulated packet loss probability between 0.0 - 1.0.
@@ -109,6 +114,9 @@ public:
     /// Return network update FPS.
     int GetUpdateFps() const { return updateFps_; }
 
+    /// Return the cell size of the interest grids.
+    float GetInterestCellSize() const { return interestCellSize_; }
+
     /// Return simulated latency in milliseconds.
     int GetSimulatedLatency() const { return simulatedLatency_; }
 
@@ -139,6 +147,8 @@ private:
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
     /// Handle render update frame event.
     void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle connection state change posted from the kNet worker thread.
+    void HandleConnectionStateChanged(StringHash eventType, VariantMap& eventData);
     /// Handle server connection.
     void OnServerConnected();
     /// Handle server disconnection.
@@ -158,6 +168,12 @@ private:
     HashSet<StringHash> blacklistedRemoteEvents_;
     /// Networked scenes.
     HashSet<Scene*> networkScenes_;
+    /// Client connections being updated.
+    PODVector<Connection*> updateConnections_;
+    /// Attribute updates shared between client connections during an update.
+    ReplicationUpdateCache replicationCache_;
+    /// Interest grids of the scenes with client connections using interest management.
+    HashMap<Scene*, InterestGrid> interestGrids_;
     /// Update FPS.
     int updateFps_;
     /// Simulated latency (send delay) in milliseconds.
@@ -168,6 +184,10 @@ private:
     float updateInterval_;
     /// Update time accumulator.
     float updateAcc_;
+    /// Interest grid cell size.
+    float interestCellSize_;
+    /// Server connection state check needed flag.
+    bool checkServerState_;
     /// Package cache directory.
     String packageCacheDir_;
 };
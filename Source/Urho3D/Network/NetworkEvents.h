@@ -27,6 +27,8 @@
 namespace Urho3D
 {
 
+class Connection;
+
 /// Server connection established.
 URHO3D_EVENT(E_SERVERCONNECTED, ServerConnected)
 {
@@ -75,6 +77,26 @@ URHO3D_EVENT(E_NETWORKMESSAGE, NetworkMessage)
     URHO3D_PARAM(P_DATA, Data);                    // Buffer
 }
 
+/// Unhandled network message received, typed event sent by the connection before E_NETWORKMESSAGE. The data is not copied and is only valid during the event.
+struct NetworkMessageEvent
+{
+    URHO3D_TYPED_EVENT(NetworkMessageEvent);
+
+    /// Connection the message was received from.
+    Connection* connection_;
+    /// Message ID.
+    int messageId_;
+    /// Message data.
+    const unsigned char* data_;
+    /// Message data size in bytes.
+    unsigned size_;
+};
+
+/// Connection state changed in the network library, posted from its worker thread. Handled by Network to check the server connection state.
+URHO3D_EVENT(E_CONNECTIONSTATECHANGED, ConnectionStateChanged)
+{
+}
+
 /// About to send network update on the client or server.
 URHO3D_EVENT(E_NETWORKUPDATE, NetworkUpdate)
 {
@@ -85,12 +107,32 @@ URHO3D_EVENT(E_NETWORKUPDATESENT, NetworkUpdateSent)
 {
 }
 
+/// Client-side prediction: sent by Connection::ReplayControls() for each sent controls not yet acknowledged by the server, oldest first. Apply the controls and step the predicted simulation by the timestep.
+URHO3D_EVENT(E_CONTROLSREPLAY, ControlsReplay)
+{
+    URHO3D_PARAM(P_CONNECTION, Connection);        // Connection pointer
+    URHO3D_PARAM(P_TIMESTAMP, TimeStamp);          // unsigned (0-255)
+    URHO3D_PARAM(P_BUTTONS, Buttons);              // unsigned
+    URHO3D_PARAM(P_YAW, Yaw);                      // float
+    URHO3D_PARAM(P_PITCH, Pitch);                  // float
+    URHO3D_PARAM(P_DATA, Data);                    // VariantMap
+    URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+}
+
 /// Scene load failed, either due to file not found or checksum error.
 URHO3D_EVENT(E_NETWORKSCENELOADFAILED, NetworkSceneLoadFailed)
 {
     URHO3D_PARAM(P_CONNECTION, Connection);      // Connection pointer
 }
 
+/// HTTP request made through the Network subsystem has changed its state to open, error or closed. Posted from the request's worker thread and sent at the beginning of the next frame.
+URHO3D_EVENT(E_HTTPREQUESTSTATECHANGED, HttpRequestStateChanged)
+{
+    URHO3D_PARAM(P_REQUEST, Request);              // HttpRequest void pointer, only valid if the request is still referenced
+    URHO3D_PARAM(P_URL, URL);                      // String
+    URHO3D_PARAM(P_STATE, State);                  // int (HttpRequestState)
+}
+
 /// Remote event: adds Connection parameter to the event data
 URHO3D_EVENT(E_REMOTEEVENTDATA, RemoteEventData)
 {
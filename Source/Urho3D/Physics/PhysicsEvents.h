@@ -27,6 +27,10 @@
 namespace Urho3D
 {
 
+class Node;
+class PhysicsWorld;
+class RigidBody;
+
 /// Physics world is about to be stepped.
 URHO3D_EVENT(E_PHYSICSPRESTEP, PhysicsPreStep)
 {
@@ -65,6 +69,31 @@ URHO3D_EVENT(E_PHYSICSCOLLISION, PhysicsCollision)
     URHO3D_PARAM(P_CONTACTS, Contacts);            // Buffer containing position (Vector3), normal (Vector3), distance (float), impulse (float) for each contact
 }
 
+/// Physics collision started or ongoing, typed event sent before E_PHYSICSCOLLISION. Avoids filling an event data map for each collision.
+struct PhysicsCollisionEvent
+{
+    URHO3D_TYPED_EVENT(PhysicsCollisionEvent);
+
+    /// Physics world.
+    PhysicsWorld* world_;
+    /// First node.
+    Node* nodeA_;
+    /// Second node.
+    Node* nodeB_;
+    /// First rigid body.
+    RigidBody* bodyA_;
+    /// Second rigid body.
+    RigidBody* bodyB_;
+    /// Trigger flag.
+    bool trigger_;
+    /// Whether the collision started during this physics step.
+    bool newCollision_;
+    /// Contact data, position (Vector3), normal (Vector3), distance (float) and impulse (float) for each contact.
+    const unsigned char* contacts_;
+    /// Number of contacts.
+    unsigned numContacts_;
+};
+
 /// Physics collision ended.
 URHO3D_EVENT(E_PHYSICSCOLLISIONEND, PhysicsCollisionEnd)
 {
@@ -819,12 +819,6 @@ void PhysicsWorld::SendCollisionEvents()
             bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
             bool newCollision = !previousCollisions_.Contains(i->first_);
 
-            physicsCollisionData_[PhysicsCollision::P_NODEA] = nodeA;
-            physicsCollisionData_[PhysicsCollision::P_NODEB] = nodeB;
-            physicsCollisionData_[PhysicsCollision::P_BODYA] = bodyA;
-            physicsCollisionData_[PhysicsCollision::P_BODYB] = bodyB;
-            physicsCollisionData_[PhysicsCollision::P_TRIGGER] = trigger;
-
             contacts_.Clear();
 
             for (int j = 0; j < contactManifold->getNumContacts(); ++j)
@@ -836,62 +830,97 @@ void PhysicsWorld::SendCollisionEvents()
                 contacts_.WriteFloat(point.m_appliedImpulse);
             }
 
-            physicsCollisionData_[PhysicsCollision::P_CONTACTS] = contacts_.GetBuffer();
-
-            // Send separate collision start event if collision is new
-            if (newCollision)
+            // Send the typed event first, as it needs no event data map
+            if (HasTypedEventReceivers<PhysicsCollisionEvent>())
             {
-                SendEvent(E_PHYSICSCOLLISIONSTART, physicsCollisionData_);
+                PhysicsCollisionEvent collisionEvent;
+                collisionEvent.world_ = this;
+                collisionEvent.nodeA_ = nodeA;
+                collisionEvent.nodeB_ = nodeB;
+                collisionEvent.bodyA_ = bodyA;
+                collisionEvent.bodyB_ = bodyB;
+                collisionEvent.trigger_ = trigger;
+                collisionEvent.newCollision_ = newCollision;
+                collisionEvent.contacts_ = contacts_.GetData();
+                collisionEvent.numContacts_ = (unsigned)contactManifold->getNumContacts();
+
+                SendTypedEvent(collisionEvent);
                 // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
             }
 
-            // Then send the ongoing collision event
-            SendEvent(E_PHYSICSCOLLISION, physicsCollisionData_);
-            if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                continue;
-
-            nodeCollisionData_[NodeCollision::P_BODY] = bodyA;
-            nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeB;
-            nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyB;
-            nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
-            nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
-
-            if (newCollision)
+            // Fill the event data maps only for the events that are subscribed to
+            if (HasEventReceivers(E_PHYSICSCOLLISION) || (newCollision && HasEventReceivers(E_PHYSICSCOLLISIONSTART)))
             {
-                nodeA->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
+                physicsCollisionData_[PhysicsCollision::P_NODEA] = nodeA;
+                physicsCollisionData_[PhysicsCollision::P_NODEB] = nodeB;
+                physicsCollisionData_[PhysicsCollision::P_BODYA] = bodyA;
+                physicsCollisionData_[PhysicsCollision::P_BODYB] = bodyB;
+                physicsCollisionData_[PhysicsCollision::P_TRIGGER] = trigger;
+                physicsCollisionData_[PhysicsCollision::P_CONTACTS] = contacts_.GetBuffer();
+
+                // Send separate collision start event if collision is new
+                if (newCollision)
+                {
+                    SendEvent(E_PHYSICSCOLLISIONSTART, physicsCollisionData_);
+                    if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                        continue;
+                }
+
+                // Then send the ongoing collision event
+                SendEvent(E_PHYSICSCOLLISION, physicsCollisionData_);
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
             }
 
-            nodeA->SendEvent(E_NODECOLLISION, nodeCollisionData_);
-            if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                continue;
-
-            contacts_.Clear();
-            for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+            if (nodeA->HasEventReceivers(E_NODECOLLISION) || (newCollision && nodeA->HasEventReceivers(E_NODECOLLISIONSTART)))
             {
-                btManifoldPoint& point = contactManifold->getContactPoint(j);
-                contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                contacts_.WriteVector3(-ToVector3(point.m_normalWorldOnB));
-                contacts_.WriteFloat(point.m_distance1);
-                contacts_.WriteFloat(point.m_appliedImpulse);
-            }
-
-            nodeCollisionData_[NodeCollision::P_BODY] = bodyB;
-            nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeA;
-            nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyA;
-            nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
-
-            if (newCollision)
-            {
-                nodeB->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
+                nodeCollisionData_[NodeCollision::P_BODY] = bodyA;
+                nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeB;
+                nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyB;
+                nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
+                nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
+
+                if (newCollision)
+                {
+                    nodeA->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
+                    if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                        continue;
+                }
+
+                nodeA->SendEvent(E_NODECOLLISION, nodeCollisionData_);
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
             }
 
-            nodeB->SendEvent(E_NODECOLLISION, nodeCollisionData_);
+            if (nodeB->HasEventReceivers(E_NODECOLLISION) || (newCollision && nodeB->HasEventReceivers(E_NODECOLLISIONSTART)))
+            {
+                contacts_.Clear();
+                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+                {
+                    btManifoldPoint& point = contactManifold->getContactPoint(j);
+                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
+                    contacts_.WriteVector3(-ToVector3(point.m_normalWorldOnB));
+                    contacts_.WriteFloat(point.m_distance1);
+                    contacts_.WriteFloat(point.m_appliedImpulse);
+                }
+
+                nodeCollisionData_[NodeCollision::P_BODY] = bodyB;
+                nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeA;
+                nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyA;
+                nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
+                nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
+
+                if (newCollision)
+                {
+                    nodeB->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
+                    if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                        continue;
+                }
+
+                nodeB->SendEvent(E_NODECOLLISION, nodeCollisionData_);
+            }
         }
     }
 
@@ -925,31 +954,41 @@ void PhysicsWorld::SendCollisionEvents()
                 WeakPtr<Node> nodeWeakA(nodeA);
                 WeakPtr<Node> nodeWeakB(nodeB);
 
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYA] = bodyA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYB] = bodyB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEA] = nodeA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEB] = nodeB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_TRIGGER] = trigger;
-
-                SendEvent(E_PHYSICSCOLLISIONEND, physicsCollisionData_);
-                // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                    continue;
-
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_TRIGGER] = trigger;
-
-                nodeA->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                    continue;
-
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyA;
-
-                nodeB->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
+                if (HasEventReceivers(E_PHYSICSCOLLISIONEND))
+                {
+                    physicsCollisionData_[PhysicsCollisionEnd::P_BODYA] = bodyA;
+                    physicsCollisionData_[PhysicsCollisionEnd::P_BODYB] = bodyB;
+                    physicsCollisionData_[PhysicsCollisionEnd::P_NODEA] = nodeA;
+                    physicsCollisionData_[PhysicsCollisionEnd::P_NODEB] = nodeB;
+                    physicsCollisionData_[PhysicsCollisionEnd::P_TRIGGER] = trigger;
+
+                    SendEvent(E_PHYSICSCOLLISIONEND, physicsCollisionData_);
+                    // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
+                    if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                        continue;
+                }
+
+                if (nodeA->HasEventReceivers(E_NODECOLLISIONEND))
+                {
+                    nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyA;
+                    nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeB;
+                    nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyB;
+                    nodeCollisionData_[NodeCollisionEnd::P_TRIGGER] = trigger;
+
+                    nodeA->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
+                    if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                        continue;
+                }
+
+                if (nodeB->HasEventReceivers(E_NODECOLLISIONEND))
+                {
+                    nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyB;
+                    nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeA;
+                    nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyA;
+                    nodeCollisionData_[NodeCollisionEnd::P_TRIGGER] = trigger;
+
+                    nodeB->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
+                }
             }
         }
     }
@@ -25,6 +25,7 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/MemoryTracker.h"
 #include "../Core/Profiler.h"
 #include "../IO/Log.h"
 #include "../Resource/BackgroundLoader.h"
@@ -43,6 +44,8 @@ BackgroundLoader::BackgroundLoader(ResourceCache* owner) :
 
 void BackgroundLoader::ThreadFunction()
 {
+    URHO3D_MEMORY_CATEGORY(MEMCAT_RESOURCE);
+
     while (shouldRun_)
     {
         backgroundLoadMutex_.Acquire();
@@ -90,13 +93,23 @@ void BackgroundLoader::ThreadFunction()
                 {
                     HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(*i);
                     if (j != backgroundLoadQueue_.End())
-                        j->second_.dependencies_.Erase(key);
+                    {
+                        BackgroundLoadItem& dependent = j->second_;
+                        dependent.dependencies_.Erase(key);
+
+                        // If the dependent already finished its own loading and was only waiting for dependencies, it is ready now
+                        AsyncLoadState state = dependent.resource_->GetAsyncLoadState();
+                        if (dependent.dependencies_.Empty() && (state == ASYNC_SUCCESS || state == ASYNC_FAIL))
+                            PostResourceReady(*i);
+                    }
                 }
 
                 item.dependents_.Clear();
             }
 
             resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
+            if (item.dependencies_.Empty())
+                PostResourceReady(key);
             backgroundLoadMutex_.Release();
         }
     }
@@ -210,37 +223,66 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
 
 void BackgroundLoader::FinishResources(int maxMs)
 {
-    if (IsStarted())
+    URHO3D_MEMORY_CATEGORY(MEMCAT_RESOURCE);
+
+    if (readyResources_.Empty())
+        return;
+
+    HiresTimer timer;
+    unsigned numProcessed = 0;
+
+    while (numProcessed < readyResources_.Size())
     {
-        HiresTimer timer;
+        const Pair<StringHash, StringHash>& key = readyResources_[numProcessed++];
 
         backgroundLoadMutex_.Acquire();
 
-        for (HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Begin();
-             i != backgroundLoadQueue_.End();)
+        // The resource may have been finished already by WaitForResource(), and possibly queued again after that
+        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(key);
+        if (i == backgroundLoadQueue_.End())
         {
-            Resource* resource = i->second_.resource_;
-            unsigned numDeps = i->second_.dependencies_.Size();
-            AsyncLoadState state = resource->GetAsyncLoadState();
-            if (numDeps > 0 || state == ASYNC_QUEUED || state == ASYNC_LOADING)
-                ++i;
-            else
-            {
-                // Finishing a resource may need it to wait for other resources to load, in which case we can not
-                // hold on to the mutex
-                backgroundLoadMutex_.Release();
-                FinishBackgroundLoading(i->second_);
-                backgroundLoadMutex_.Acquire();
-                i = backgroundLoadQueue_.Erase(i);
-            }
+            backgroundLoadMutex_.Release();
+            continue;
+        }
 
-            // Break when the time limit passed so that we keep sufficient FPS
-            if (timer.GetUSec(false) >= maxMs * 1000)
-                break;
+        unsigned numDeps = i->second_.dependencies_.Size();
+        AsyncLoadState state = i->second_.resource_->GetAsyncLoadState();
+        if (numDeps > 0 || state == ASYNC_QUEUED || state == ASYNC_LOADING)
+        {
+            backgroundLoadMutex_.Release();
+            continue;
         }
 
+        // Finishing a resource may need it to wait for other resources to load, in which case we can not
+        // hold on to the mutex
         backgroundLoadMutex_.Release();
+        FinishBackgroundLoading(i->second_);
+        backgroundLoadMutex_.Acquire();
+        backgroundLoadQueue_.Erase(i);
+        backgroundLoadMutex_.Release();
+
+        // Break when the time limit passed so that we keep sufficient FPS
+        if (timer.GetUSec(false) >= maxMs * 1000)
+            break;
     }
+
+    readyResources_.Erase(0, numProcessed);
+}
+
+void BackgroundLoader::SetResourceReady(StringHash type, StringHash nameHash)
+{
+    readyResources_.Push(MakePair(type, nameHash));
+}
+
+void BackgroundLoader::PostResourceReady(const Pair<StringHash, StringHash>& key)
+{
+    using namespace ResourceBackgroundReady;
+
+    // The event data must not contain RefCounted pointers, as it is created outside the main thread
+    VariantMap eventData;
+    eventData[P_RESOURCETYPE] = key.first_;
+    eventData[P_RESOURCENAMEHASH] = key.second_;
+    owner_->PostEvent(E_RESOURCEBACKGROUNDREADY, eventData);
 }
 
 unsigned BackgroundLoader::GetNumQueuedResources() const
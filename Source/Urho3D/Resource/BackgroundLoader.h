@@ -63,6 +63,8 @@ public:
     bool QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller);
     /// Wait and finish possible loading of a resource when being requested from the cache.
     void WaitForResource(StringHash type, StringHash nameHash);
+    /// Mark a resource ready to finish. Called in the main thread when the ready event posted by the loader thread is sent.
+    void SetResourceReady(StringHash type, StringHash nameHash);
     /// Process resources that are ready to finish.
     void FinishResources(int maxMs);
 
@@ -72,6 +74,8 @@ public:
 private:
     /// Finish one background loaded resource.
     void FinishBackgroundLoading(BackgroundLoadItem& item);
+    /// Post an event to finish a resource in the main thread. Called with the mutex held.
+    void PostResourceReady(const Pair<StringHash, StringHash>& key);
 
     /// Resource cache.
     ResourceCache* owner_;
@@ -79,6 +83,8 @@ private:
     mutable Mutex backgroundLoadMutex_;
     /// Resources that are queued for background loading.
     HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem> backgroundLoadQueue_;
+    /// Resources that are ready to finish in the main thread, in order of completion. Only accessed from the main thread.
+    Vector<Pair<StringHash, StringHash> > readyResources_;
 };
 
 }
@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/MemoryTracker.h"
 #include "../Core/Profiler.h"
 #include "../Core/WorkQueue.h"
 #include "../IO/FileSystem.h"
@@ -85,6 +86,9 @@ ResourceCache::ResourceCache(Context* context) :
 
     // Subscribe BeginFrame for handling directory watchers and background loaded resource finalization
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(ResourceCache, HandleBeginFrame));
+#ifdef URHO3D_THREADING
+    SubscribeToEvent(this, E_RESOURCEBACKGROUNDREADY, URHO3D_HANDLER(ResourceCache, HandleResourceBackgroundReady));
+#endif
 }
 
 ResourceCache::~ResourceCache()
@@ -561,6 +565,8 @@ Resource* ResourceCache::GetExistingResource(StringHash type, const String& name
 
 Resource* ResourceCache::GetResource(StringHash type, const String& nameIn, bool sendEventOnFailure)
 {
+    URHO3D_MEMORY_CATEGORY(MEMCAT_RESOURCE);
+
     String name = SanitateResourceName(nameIn);
 
     if (!Thread::IsMainThread())
@@ -657,6 +663,8 @@ bool ResourceCache::BackgroundLoadResource(StringHash type, const String& nameIn
 
 SharedPtr<Resource> ResourceCache::GetTempResource(StringHash type, const String& nameIn, bool sendEventOnFailure)
 {
+    URHO3D_MEMORY_CATEGORY(MEMCAT_RESOURCE);
+
     String name = SanitateResourceName(nameIn);
 
     // If empty name, return null pointer immediately
@@ -1088,7 +1096,7 @@ void ResourceCache::HandleBeginFrame(StringHash eventType, VariantMap& eventData
         }
     }
 
-    // Check for background loaded resources that can be finished
+    // Finish background loaded resources that have been reported ready
 #ifdef URHO3D_THREADING
     {
         URHO3D_PROFILE(FinishBackgroundResources);
@@ -1097,6 +1105,15 @@ void ResourceCache::HandleBeginFrame(StringHash eventType, VariantMap& eventData
 #endif
 }
 
+void ResourceCache::HandleResourceBackgroundReady(StringHash eventType, VariantMap& eventData)
+{
+#ifdef URHO3D_THREADING
+    using namespace ResourceBackgroundReady;
+
+    backgroundLoader_->SetResourceReady(eventData[P_RESOURCETYPE].GetStringHash(), eventData[P_RESOURCENAMEHASH].GetStringHash());
+#endif
+}
+
 File* ResourceCache::SearchResourceDirs(const String& nameIn)
 {
     FileSystem* fileSystem = GetSubsystem<FileSystem>();
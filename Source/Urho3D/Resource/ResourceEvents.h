@@ -67,6 +67,13 @@ URHO3D_EVENT(E_UNKNOWNRESOURCETYPE, UnknownResourceType)
     URHO3D_PARAM(P_RESOURCETYPE, ResourceType);            // StringHash
 }
 
+/// Background loaded resource is ready to be finished in the main thread. Posted by the background loader thread.
+URHO3D_EVENT(E_RESOURCEBACKGROUNDREADY, ResourceBackgroundReady)
+{
+    URHO3D_PARAM(P_RESOURCETYPE, ResourceType);            // StringHash
+    URHO3D_PARAM(P_RESOURCENAMEHASH, ResourceNameHash);    // StringHash
+}
+
 /// Resource background loading finished.
 URHO3D_EVENT(E_RESOURCEBACKGROUNDLOADED, ResourceBackgroundLoaded)
 {
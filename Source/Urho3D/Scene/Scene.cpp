@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/MemoryTracker.h"
 #include "../Core/Profiler.h"
 #include "../Core/WorkQueue.h"
 #include "../IO/File.h"
@@ -577,11 +578,13 @@ float Scene::GetAsyncProgress() const
 const String& Scene::GetVarName(StringHash hash) const
 {
     HashMap<StringHash, String>::ConstIterator i = varNames_.Find(hash);
-    return i != varNames_.End() ? i->second_ : String::EMPTY;
+    return i != varNames_.End() ? i->second_ : hash.Reverse();
 }
 
 void Scene::Update(float timeStep)
 {
+    URHO3D_MEMORY_CATEGORY(MEMCAT_SCENE);
+
     if (asyncLoading_)
     {
         UpdateAsyncLoading();
@@ -620,6 +623,7 @@ void Scene::Update(float timeStep)
 
         smoothingData_[P_CONSTANT] = constant;
         smoothingData_[P_SQUAREDSNAPTHRESHOLD] = squaredSnapThreshold;
+        smoothingData_[UpdateSmoothing::P_TIMESTEP] = timeStep;
         SendEvent(E_UPDATESMOOTHING, smoothingData_);
     }
 
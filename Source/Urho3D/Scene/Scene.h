@@ -183,7 +183,7 @@ public:
     /// Return required package files.
     const Vector<SharedPtr<PackageFile> >& GetRequiredPackageFiles() const { return requiredPackageFiles_; }
 
-    /// Return a node user variable name, or empty if not registered.
+    /// Return a node user variable name, or empty if not registered. Falls back to the globally interned strings.
     const String& GetVarName(StringHash hash) const;
 
     /// Update scene. Called by HandleUpdate.
@@ -46,6 +46,7 @@ URHO3D_EVENT(E_UPDATESMOOTHING, UpdateSmoothing)
 {
     URHO3D_PARAM(P_CONSTANT, Constant);            // float
     URHO3D_PARAM(P_SQUAREDSNAPTHRESHOLD, SquaredSnapThreshold);  // float
+    URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
 /// Scene drawable update finished. Custom animation (eg. IK) can be done at this point.
@@ -54,6 +54,233 @@ static unsigned RemapAttributeIndex(const Vector<AttributeInfo>* attributes, con
     return netAttrIndex; // Could not remap
 }
 
+/// Largest magnitude of the three smallest components of a normalized quaternion.
+static const float SMALLEST_THREE_RANGE = 0.70710678f;
+/// Maximum bits per quantized component. More would exceed float precision.
+static const unsigned MAX_QUANTIZED_BITS = 24;
+
+/// Bit stream writer for packing quantized network values. Each value starts from a byte boundary.
+class NetworkBitWriter
+{
+public:
+    /// Construct with destination.
+    NetworkBitWriter(Serializer& dest) :
+        dest_(dest),
+        bits_(0),
+        numBits_(0)
+    {
+    }
+
+    /// Destruct. Write the remaining bits.
+    ~NetworkBitWriter()
+    {
+        if (numBits_)
+            dest_.WriteUByte((unsigned char)bits_);
+    }
+
+    /// Write the lowest bits of a value.
+    void Write(unsigned value, unsigned numBits)
+    {
+        bits_ |= (unsigned long long)value << numBits_;
+        numBits_ += numBits;
+        while (numBits_ >= 8)
+        {
+            dest_.WriteUByte((unsigned char)bits_);
+            bits_ >>= 8;
+            numBits_ -= 8;
+        }
+    }
+
+private:
+    /// Destination.
+    Serializer& dest_;
+    /// Pending bits.
+    unsigned long long bits_;
+    /// Number of pending bits.
+    unsigned numBits_;
+};
+
+/// Bit stream reader for unpacking quantized network values.
+class NetworkBitReader
+{
+public:
+    /// Construct with source.
+    NetworkBitReader(Deserializer& source) :
+        source_(source),
+        bits_(0),
+        numBits_(0)
+    {
+    }
+
+    /// Read a value of the given number of bits.
+    unsigned Read(unsigned numBits)
+    {
+        while (numBits_ < numBits)
+        {
+            bits_ |= (unsigned long long)source_.ReadUByte() << numBits_;
+            numBits_ += 8;
+        }
+
+        unsigned value = (unsigned)(bits_ & ((1ULL << numBits) - 1));
+        bits_ >>= numBits;
+        numBits_ -= numBits;
+        return value;
+    }
+
+private:
+    /// Source.
+    Deserializer& source_;
+    /// Pending bits.
+    unsigned long long bits_;
+    /// Number of pending bits.
+    unsigned numBits_;
+};
+
+static unsigned QuantizeFloat(float value, float minValue, float maxValue, unsigned bits)
+{
+    unsigned maxSteps = (1u << bits) - 1;
+    float t = (Clamp(value, minValue, maxValue) - minValue) / (maxValue - minValue);
+    unsigned steps = (unsigned)(t * (float)maxSteps + 0.5f);
+    return steps < maxSteps ? steps : maxSteps;
+}
+
+static float DequantizeFloat(unsigned value, float minValue, float maxValue, unsigned bits)
+{
+    unsigned maxSteps = (1u << bits) - 1;
+    return minValue + (maxValue - minValue) * (float)value / (float)maxSteps;
+}
+
+/// Return number of quantized components for an attribute type, or 0 if quantization is not supported.
+static unsigned GetNumQuantizedComponents(VariantType type)
+{
+    switch (type)
+    {
+    case VAR_FLOAT:
+        return 1;
+    case VAR_VECTOR2:
+        return 2;
+    case VAR_VECTOR3:
+        return 3;
+    case VAR_VECTOR4:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+/// Return bits per quantized component of an encoding hint.
+static unsigned GetQuantizedBits(const NetworkEncodingHint& hint)
+{
+    if (hint.bits_ < 1)
+        return 1;
+    return hint.bits_ < MAX_QUANTIZED_BITS ? hint.bits_ : MAX_QUANTIZED_BITS;
+}
+
+/// Write an attribute value for network replication according to its encoding hint.
+static void WriteNetworkValue(Serializer& dest, const AttributeInfo& attr, const Variant& value)
+{
+    const NetworkEncodingHint& hint = attr.networkHint_;
+    unsigned bits = GetQuantizedBits(hint);
+
+    if (hint.encoding_ == NE_QUANTIZED && GetNumQuantizedComponents(attr.type_) && hint.maxValue_ > hint.minValue_)
+    {
+        Vector4 components;
+        switch (attr.type_)
+        {
+        case VAR_FLOAT:
+            components.x_ = value.GetFloat();
+            break;
+        case VAR_VECTOR2:
+            components = Vector4(value.GetVector2().x_, value.GetVector2().y_, 0.0f, 0.0f);
+            break;
+        case VAR_VECTOR3:
+            components = Vector4(value.GetVector3(), 0.0f);
+            break;
+        default:
+            components = value.GetVector4();
+            break;
+        }
+
+        NetworkBitWriter writer(dest);
+        unsigned numComponents = GetNumQuantizedComponents(attr.type_);
+        for (unsigned i = 0; i < numComponents; ++i)
+            writer.Write(QuantizeFloat(components.Data()[i], hint.minValue_, hint.maxValue_, bits), bits);
+    }
+    else if (hint.encoding_ == NE_SMALLEST_THREE && attr.type_ == VAR_QUATERNION)
+    {
+        Quaternion rotation = value.GetQuaternion().Normalized();
+        const float* components = rotation.Data();
+
+        // Leave out the largest component, which can be reconstructed from the others. Negating the quaternion does not
+        // change the rotation, so the largest component can be made positive
+        unsigned largest = 0;
+        for (unsigned i = 1; i < 4; ++i)
+        {
+            if (Abs(components[i]) > Abs(components[largest]))
+                largest = i;
+        }
+        float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+        NetworkBitWriter writer(dest);
+        writer.Write(largest, 2);
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            if (i != largest)
+                writer.Write(QuantizeFloat(sign * components[i], -SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE, bits), bits);
+        }
+    }
+    else
+        dest.WriteVariantData(value);
+}
+
+/// Read an attribute value for network replication according to its encoding hint.
+static Variant ReadNetworkValue(Deserializer& source, const AttributeInfo& attr)
+{
+    const NetworkEncodingHint& hint = attr.networkHint_;
+    unsigned bits = GetQuantizedBits(hint);
+
+    if (hint.encoding_ == NE_QUANTIZED && GetNumQuantizedComponents(attr.type_) && hint.maxValue_ > hint.minValue_)
+    {
+        float components[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        NetworkBitReader reader(source);
+        unsigned numComponents = GetNumQuantizedComponents(attr.type_);
+        for (unsigned i = 0; i < numComponents; ++i)
+            components[i] = DequantizeFloat(reader.Read(bits), hint.minValue_, hint.maxValue_, bits);
+
+        switch (attr.type_)
+        {
+        case VAR_FLOAT:
+            return Variant(components[0]);
+        case VAR_VECTOR2:
+            return Variant(Vector2(components));
+        case VAR_VECTOR3:
+            return Variant(Vector3(components));
+        default:
+            return Variant(Vector4(components));
+        }
+    }
+    else if (hint.encoding_ == NE_SMALLEST_THREE && attr.type_ == VAR_QUATERNION)
+    {
+        float components[4];
+        NetworkBitReader reader(source);
+        unsigned largest = reader.Read(2);
+        float sumSquares = 0.0f;
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            if (i != largest)
+            {
+                components[i] = DequantizeFloat(reader.Read(bits), -SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE, bits);
+                sumSquares += components[i] * components[i];
+            }
+        }
+        components[largest] = sqrtf(Max(1.0f - sumSquares, 0.0f));
+
+        return Variant(Quaternion(components).Normalized());
+    }
+    else
+        return source.ReadVariant(attr.type_);
+}
+
 Serializable::Serializable(Context* context) :
     Object(context),
     networkState_(0),
@@ -617,7 +844,7 @@ void Serializable::WriteInitialDeltaUpdate(Serializer& dest, unsigned char timeS
     for (unsigned i = 0; i < numAttributes; ++i)
     {
         if (attributeBits.IsSet(i))
-            dest.WriteVariantData(networkState_->currentValues_[i]);
+            WriteNetworkValue(dest, attributes->At(i), networkState_->currentValues_[i]);
     }
 }
 
@@ -643,7 +870,7 @@ void Serializable::WriteDeltaUpdate(Serializer& dest, const DirtyBits& attribute
     for (unsigned i = 0; i < numAttributes; ++i)
     {
         if (attributeBits.IsSet(i))
-            dest.WriteVariantData(networkState_->currentValues_[i]);
+            WriteNetworkValue(dest, attributes->At(i), networkState_->currentValues_[i]);
     }
 }
 
@@ -666,7 +893,7 @@ void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeSta
     for (unsigned i = 0; i < numAttributes; ++i)
     {
         if (attributes->At(i).mode_ & AM_LATESTDATA)
-            dest.WriteVariantData(networkState_->currentValues_[i]);
+            WriteNetworkValue(dest, attributes->At(i), networkState_->currentValues_[i]);
     }
 }
 
@@ -691,7 +918,7 @@ bool Serializable::ReadDeltaUpdate(Deserializer& source)
             const AttributeInfo& attr = attributes->At(i);
             if (!(interceptMask & (1ULL << i)))
             {
-                OnSetAttribute(attr, source.ReadVariant(attr.type_));
+                OnSetAttribute(attr, ReadNetworkValue(source, attr));
                 changed = true;
             }
             else
@@ -703,7 +930,7 @@ bool Serializable::ReadDeltaUpdate(Deserializer& source)
                 eventData[P_TIMESTAMP] = (unsigned)timeStamp;
                 eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
                 eventData[P_NAME] = attr.name_;
-                eventData[P_VALUE] = source.ReadVariant(attr.type_);
+                eventData[P_VALUE] = ReadNetworkValue(source, attr);
                 SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
             }
         }
@@ -731,7 +958,7 @@ bool Serializable::ReadLatestDataUpdate(Deserializer& source)
         {
             if (!(interceptMask & (1ULL << i)))
             {
-                OnSetAttribute(attr, source.ReadVariant(attr.type_));
+                OnSetAttribute(attr, ReadNetworkValue(source, attr));
                 changed = true;
             }
             else
@@ -743,7 +970,7 @@ bool Serializable::ReadLatestDataUpdate(Deserializer& source)
                 eventData[P_TIMESTAMP] = (unsigned)timeStamp;
                 eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
                 eventData[P_NAME] = attr.name_;
-                eventData[P_VALUE] = source.ReadVariant(attr.type_);
+                eventData[P_VALUE] = ReadNetworkValue(source, attr);
                 SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
             }
         }
@@ -32,10 +32,15 @@
 namespace Urho3D
 {
 
+/// Maximum number of buffered snapshots.
+static const unsigned MAX_SNAPSHOTS = 32;
+
 SmoothedTransform::SmoothedTransform(Context* context) :
     Component(context),
     targetPosition_(Vector3::ZERO),
     targetRotation_(Quaternion::IDENTITY),
+    interpolationDelay_(0.0f),
+    interpolationTime_(0.0f),
     smoothingMask_(SMOOTH_NONE),
     subscribed_(false)
 {
@@ -102,14 +107,10 @@ void SmoothedTransform::SetTargetPosition(const Vector3& position)
 {
     targetPosition_ = position;
     smoothingMask_ |= SMOOTH_POSITION;
+    if (interpolationDelay_ > 0.0f)
+        AddSnapshot();
 
-    // Subscribe to smoothing update if not yet subscribed
-    if (!subscribed_)
-    {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
-    }
-
+    SubscribeToSmoothing();
     SendEvent(E_TARGETPOSITION);
 }
 
@@ -117,13 +118,10 @@ void SmoothedTransform::SetTargetRotation(const Quaternion& rotation)
 {
     targetRotation_ = rotation;
     smoothingMask_ |= SMOOTH_ROTATION;
+    if (interpolationDelay_ > 0.0f)
+        AddSnapshot();
 
-    if (!subscribed_)
-    {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
-    }
-
+    SubscribeToSmoothing();
     SendEvent(E_TARGETROTATION);
 }
 
@@ -143,6 +141,18 @@ void SmoothedTransform::SetTargetWorldRotation(const Quaternion& rotation)
         SetTargetRotation(rotation);
 }
 
+void SmoothedTransform::SetInterpolationDelay(float delay)
+{
+    interpolationDelay_ = Max(delay, 0.0f);
+
+    // When switching to exponential smoothing, continue from the latest target
+    if (interpolationDelay_ == 0.0f)
+    {
+        snapshots_.Clear();
+        interpolationTime_ = 0.0f;
+    }
+}
+
 Vector3 SmoothedTransform::GetTargetWorldPosition() const
 {
     if (node_ && node_->GetParent())
@@ -173,9 +183,99 @@ void SmoothedTransform::HandleUpdateSmoothing(StringHash eventType, VariantMap&
 {
     using namespace UpdateSmoothing;
 
-    float constant = eventData[P_CONSTANT].GetFloat();
     float squaredSnapThreshold = eventData[P_SQUAREDSNAPTHRESHOLD].GetFloat();
-    Update(constant, squaredSnapThreshold);
+    if (snapshots_.Size())
+        UpdateInterpolation(eventData[P_TIMESTEP].GetFloat(), squaredSnapThreshold);
+    else
+        Update(eventData[P_CONSTANT].GetFloat(), squaredSnapThreshold);
+}
+
+void SmoothedTransform::UpdateInterpolation(float timeStep, float squaredSnapThreshold)
+{
+    interpolationTime_ += timeStep;
+    float renderTime = interpolationTime_ - interpolationDelay_;
+
+    // Drop the snapshots that the render time has passed, keeping the one to interpolate from
+    unsigned numPassed = 0;
+    while (numPassed + 1 < snapshots_.Size() && snapshots_[numPassed + 1].time_ <= renderTime)
+        ++numPassed;
+    if (numPassed)
+        snapshots_.Erase(0, numPassed);
+
+    const TransformSnapshot& from = snapshots_[0];
+    Vector3 position = from.position_;
+    Quaternion rotation = from.rotation_;
+
+    if (snapshots_.Size() > 1)
+    {
+        // Interpolate towards the next snapshot, unless the distance is large enough to snap
+        const TransformSnapshot& to = snapshots_[1];
+        if ((to.position_ - from.position_).LengthSquared() <= squaredSnapThreshold && to.time_ > from.time_)
+        {
+            float t = Clamp((renderTime - from.time_) / (to.time_ - from.time_), 0.0f, 1.0f);
+            position = from.position_.Lerp(to.position_, t);
+            rotation = from.rotation_.Slerp(to.rotation_, t);
+        }
+    }
+    else if (renderTime >= from.time_)
+    {
+        // Reached the latest snapshot: interpolation has finished until more are received
+        snapshots_.Clear();
+        interpolationTime_ = 0.0f;
+        smoothingMask_ = SMOOTH_NONE;
+    }
+
+    if (node_)
+    {
+        node_->SetPosition(position);
+        node_->SetRotation(rotation);
+    }
+
+    if (!smoothingMask_)
+    {
+        UnsubscribeFromEvent(GetScene(), E_UPDATESMOOTHING);
+        subscribed_ = false;
+    }
+}
+
+void SmoothedTransform::AddSnapshot()
+{
+    // When starting, interpolate from the current transform so that the first target is reached after the delay
+    if (snapshots_.Empty() && node_)
+    {
+        TransformSnapshot current;
+        current.time_ = interpolationTime_ - interpolationDelay_;
+        current.position_ = node_->GetPosition();
+        current.rotation_ = node_->GetRotation();
+        snapshots_.Push(current);
+    }
+
+    // Position and rotation received in the same frame belong to the same snapshot
+    if (snapshots_.Size() > 1 && snapshots_.Back().time_ == interpolationTime_)
+    {
+        snapshots_.Back().position_ = targetPosition_;
+        snapshots_.Back().rotation_ = targetRotation_;
+        return;
+    }
+
+    TransformSnapshot snapshot;
+    snapshot.time_ = interpolationTime_;
+    snapshot.position_ = targetPosition_;
+    snapshot.rotation_ = targetRotation_;
+    snapshots_.Push(snapshot);
+
+    if (snapshots_.Size() > MAX_SNAPSHOTS)
+        snapshots_.Erase(0, snapshots_.Size() - MAX_SNAPSHOTS);
+}
+
+void SmoothedTransform::SubscribeToSmoothing()
+{
+    // Subscribe to smoothing update if not yet subscribed
+    if (!subscribed_)
+    {
+        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
+        subscribed_ = true;
+    }
 }
 
 }
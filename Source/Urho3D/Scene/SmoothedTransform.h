@@ -34,6 +34,17 @@ static const unsigned SMOOTH_POSITION = 1;
 /// Ongoing rotation smoothing.
 static const unsigned SMOOTH_ROTATION = 2;
 
+/// Received transform for snapshot interpolation.
+struct TransformSnapshot
+{
+    /// Interpolation clock time when received.
+    float time_;
+    /// Position in parent space.
+    Vector3 position_;
+    /// Rotation in parent space.
+    Quaternion rotation_;
+};
+
 /// Transform smoothing component for network updates.
 class URHO3D_API SmoothedTransform : public Component
 {
@@ -57,6 +68,8 @@ public:
     void SetTargetWorldPosition(const Vector3& position);
     /// Set target rotation in world space.
     void SetTargetWorldRotation(const Quaternion& rotation);
+    /// Set snapshot interpolation delay in seconds. When nonzero, the received targets are buffered and interpolated between, this much behind the latest one, instead of exponential smoothing. Should cover a few network updates to hide jitter. Default 0.
+    void SetInterpolationDelay(float delay);
 
     /// Return target position in parent space.
     const Vector3& GetTargetPosition() const { return targetPosition_; }
@@ -69,6 +82,12 @@ public:
     /// Return target rotation in world space.
     Quaternion GetTargetWorldRotation() const;
 
+    /// Return snapshot interpolation delay in seconds.
+    float GetInterpolationDelay() const { return interpolationDelay_; }
+
+    /// Return number of buffered snapshots.
+    unsigned GetNumSnapshots() const { return snapshots_.Size(); }
+
     /// Return whether smoothing is in progress.
     bool IsInProgress() const { return smoothingMask_ != 0; }
 
@@ -79,11 +98,23 @@ protected:
 private:
     /// Handle smoothing update event.
     void HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData);
+    /// Update snapshot interpolation.
+    void UpdateInterpolation(float timeStep, float squaredSnapThreshold);
+    /// Buffer the current targets as a snapshot.
+    void AddSnapshot();
+    /// Subscribe to the smoothing update event if not yet subscribed.
+    void SubscribeToSmoothing();
 
     /// Target position.
     Vector3 targetPosition_;
     /// Target rotation.
     Quaternion targetRotation_;
+    /// Buffered snapshots for interpolation, oldest first.
+    PODVector<TransformSnapshot> snapshots_;
+    /// Snapshot interpolation delay.
+    float interpolationDelay_;
+    /// Snapshot interpolation clock. Runs while snapshots are buffered.
+    float interpolationTime_;
     /// Active smoothing operations bitmask.
     unsigned char smoothingMask_;
     /// Subscribed to smoothing update event flag.
@@ -115,7 +115,6 @@ void Text3D::UpdateBatches(const FrameInfo& frame)
         Vector3 worldPosition = node_->GetWorldPosition();
         customWorldTransform_ = Matrix3x4(worldPosition, frame.camera_->GetFaceCameraRotation(
             worldPosition, node_->GetWorldRotation(), faceCameraMode_), node_->GetWorldScale());
-        worldBoundingBoxDirty_ = true;
     }
 
     for (unsigned i = 0; i < batches_.Size(); ++i)
@@ -437,9 +436,20 @@ void Text3D::OnWorldBoundingBoxUpdate()
     if (textDirty_)
         UpdateTextBatches();
 
-    // In face camera mode, use the last camera rotation to build the world bounding box
-    worldBoundingBox_ = boundingBox_.Transformed(faceCameraMode_ != FC_NONE ? Matrix3x4(node_->GetWorldPosition(),
-        customWorldTransform_.Rotation(), node_->GetWorldScale()) : node_->GetWorldTransform());
+    // In face camera mode, use a world bounding box that encloses the text in any rotation, so that it does not depend
+    // on the camera and stays valid in the octree while the camera turns
+    if (faceCameraMode_ != FC_NONE && boundingBox_.Defined())
+    {
+        Vector3 extent(Max(Abs(boundingBox_.min_.x_), Abs(boundingBox_.max_.x_)), Max(Abs(boundingBox_.min_.y_),
+            Abs(boundingBox_.max_.y_)), Max(Abs(boundingBox_.min_.z_), Abs(boundingBox_.max_.z_)));
+        Vector3 worldScale = node_->GetWorldScale().Abs();
+        float radius = extent.Length() * Max(Max(worldScale.x_, worldScale.y_), worldScale.z_);
+        Vector3 worldPosition = node_->GetWorldPosition();
+        Vector3 halfSize(radius, radius, radius);
+        worldBoundingBox_.Define(worldPosition - halfSize, worldPosition + halfSize);
+    }
+    else
+        worldBoundingBox_ = boundingBox_.Transformed(node_->GetWorldTransform());
 }
 
 void Text3D::MarkTextDirty()
@@ -305,6 +305,7 @@ void AnimatedSprite2D::UpdateSpineAnimation(float timeStep)
 
     sourceBatchesDirty_ = true;
     worldBoundingBoxDirty_ = true;
+    MarkForUpdate();
 }
 
 void AnimatedSprite2D::UpdateSourceBatchesSpine()
@@ -433,6 +434,7 @@ void AnimatedSprite2D::UpdateSpriterAnimation(float timeStep)
     spriterInstance_->Update(timeStep * speed_);
     sourceBatchesDirty_ = true;
     worldBoundingBoxDirty_ = true;
+    MarkForUpdate();
 }
 
 void AnimatedSprite2D::UpdateSourceBatchesSpriter()